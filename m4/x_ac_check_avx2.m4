@@ -0,0 +1,28 @@
+###############################################################################
+# SYNOPSIS:
+#   X_AC_CHECK_AVX2
+#
+# DESCRIPTION:
+#   Check whether the compiler can build individual functions for AVX2
+#   via the "target" function attribute, and select them at runtime via
+#   __builtin_cpu_supports().
+###############################################################################
+
+AC_DEFUN_ONCE([X_AC_CHECK_AVX2],
+  [AC_MSG_CHECKING([whether the compiler supports AVX2 functions])
+  AC_LINK_IFELSE(
+    [AC_LANG_PROGRAM(
+      [[#include <immintrin.h>
+        __attribute__((target("avx2")))
+        static int f(const void *p) {
+          __m256i v = _mm256_loadu_si256((const __m256i *) p);
+          return(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, v)));
+        }]],
+      [[char buf[32] = { 0 };
+        return(__builtin_cpu_supports("avx2") ? f(buf) : 0);]])],
+    [x_ac_check_avx2=yes
+      AC_DEFINE([HAVE_AVX2_TARGET], [1],
+        [Define to 1 if the compiler supports AVX2 via the target attribute.])],
+    [x_ac_check_avx2=no])
+  AC_MSG_RESULT([${x_ac_check_avx2}])
+])
@@ -0,0 +1,34 @@
+###############################################################################
+# SYNOPSIS:
+#   X_AC_WITH_ZLIB
+#
+# DESCRIPTION:
+#   Check if zlib can/should be used for compressing console logs.
+#   Define ZLIBLIBS accordingly.
+###############################################################################
+
+AC_DEFUN_ONCE([X_AC_WITH_ZLIB],
+  [AC_ARG_WITH([zlib],
+    [AS_HELP_STRING([--with-zlib],
+      [use zlib for compressed console logs @{:@libz@:}@])])
+  AS_IF(
+    [test "x${with_zlib}" != xno],
+    [AC_CHECK_HEADER([zlib.h], [have_zlib_h=yes])
+      AC_CHECK_LIB([z], [deflateSetHeader], [have_libz=yes])
+      AS_IF(
+        [test "x${have_zlib_h}" = xyes && test "x${have_libz}" = xyes],
+        [have_zlib=yes])])
+  AS_IF(
+    [test "x${have_zlib}" = xyes],
+    [AC_SUBST([ZLIBLIBS], [-lz])
+      AC_DEFINE([HAVE_ZLIB_H], [1],
+        [Define to 1 if you have the <zlib.h> header file.])
+      AC_DEFINE([HAVE_LIBZ], [1],
+        [Define to 1 if you have the `z' library @{:@-lz@:}@.])
+      AC_DEFINE([WITH_ZLIB], [1],
+        [Define to 1 if using zlib for compressed console logs.])],
+    [test "x${with_zlib}" = xyes],
+    [AC_MSG_FAILURE([failed check for --with-zlib])])
+  AC_MSG_CHECKING([whether to use zlib])
+  AC_MSG_RESULT([${have_zlib=no}])
+])
@@ -36,6 +36,7 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 #include "client.h"
 #include "common.h"
@@ -47,6 +48,7 @@
 
 
 static void read_consoles_from_file(List consoles, char *file);
+static int parse_replay_opt(req_t *req, const char *str);
 static void display_client_help(client_conf_t *conf);
 
 
@@ -157,12 +159,14 @@ void process_client_cmd_line(int argc, char *argv[], client_conf_t *conf)
     int i;
     char *p;
     int gotHelp = 0;
+    overrun_policy_t policy;
+    char err[MAX_LINE];
 
     if (conf->prog == NULL)
         conf->prog = create_string(argv[0]);
 
     opterr = 0;
-    while ((c = getopt(argc, argv, "bd:e:fF:hjl:LmqQrvV")) != -1) {
+    while ((c = getopt(argc, argv, "bd:e:fF:hjl:LmO:qQrR:vV")) != -1) {
         switch(c) {
         case 'b':
             conf->req->enableBroadcast = 1;
@@ -207,6 +211,13 @@ void process_client_cmd_line(int argc, char *argv[], client_conf_t *conf)
         case 'm':
             conf->req->command = CONMAN_CMD_MONITOR;
             break;
+        case 'O':
+            if (parse_overrun_policy(optarg, &policy,
+                    &conf->req->overrunLimit, err, sizeof(err)) < 0)
+                log_err(0, "CMDLINE: %s", err);
+            conf->req->overrunPolicy = policy;
+            conf->req->gotOverrunPolicy = 1;
+            break;
         case 'q':
             conf->req->command = CONMAN_CMD_QUERY;
             break;
@@ -216,6 +227,10 @@ void process_client_cmd_line(int argc, char *argv[], client_conf_t *conf)
         case 'r':
             conf->req->enableRegex = 1;
             break;
+        case 'R':
+            if (parse_replay_opt(conf->req, optarg) < 0)
+                log_err(0, "CMDLINE: invalid replay spec \"%s\"", optarg);
+            break;
         case 'v':
             conf->enableVerbose = 1;
             break;
@@ -312,6 +327,43 @@ static void read_consoles_from_file(List consoles, char *file)
 }
 
 
+static int parse_replay_opt(req_t *req, const char *str)
+{
+/*  Parses the log replay spec 'str' given on the command-line into 'req'.
+ *    In addition to the forms accepted by parse_replay_spec(), the time
+ *    since which to replay can be given in the local time zone as
+ *    "@YYYY-MM-DD HH:MM[:SS]" (with the date and time optionally
+ *    separated by a 'T' instead).
+ *  Returns 0 on success, or -1 on error.
+ */
+    struct tm tm;
+    time_t t;
+    char buf[32];
+    char sep;
+    int n;
+
+    if ((str[0] != '@') || (strspn(str + 1, "0123456789") == strlen(str + 1)))
+        return(parse_replay_spec(req, str));
+
+    memset(&tm, 0, sizeof(tm));
+    n = sscanf(str + 1, "%4d-%2d-%2d%c%2d:%2d:%2d", &tm.tm_year, &tm.tm_mon,
+        &tm.tm_mday, &sep, &tm.tm_hour, &tm.tm_min, &tm.tm_sec);
+    if ((n < 6) || ((sep != ' ') && (sep != 'T')))
+        return(-1);
+    if ((tm.tm_mon < 1) || (tm.tm_mon > 12) || (tm.tm_mday < 1)
+            || (tm.tm_mday > 31) || (tm.tm_hour > 23) || (tm.tm_min > 59)
+            || (tm.tm_sec > 60))
+        return(-1);
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+    if ((t = mktime(&tm)) == (time_t) -1)
+        return(-1);
+    snprintf(buf, sizeof(buf), "@%ld", (long) t);
+    return(parse_replay_spec(req, buf));
+}
+
+
 static void display_client_help(client_conf_t *conf)
 {
     char esc[3];
@@ -331,9 +383,12 @@ static void display_client_help(client_conf_t *conf)
     printf("  -l FILE   Log connection output to file.\n");
     printf("  -L        Display license information.\n");
     printf("  -m        Monitor connection (read-only).\n");
+    printf("  -O POLICY Handle output overruns: marker, disconnect[:N],"
+           " or spool[:N].\n");
     printf("  -q        Query server about specified console(s).\n");
     printf("  -Q        Be quiet and suppress informational messages.\n");
     printf("  -r        Match console names via regex instead of globbing.\n");
+    printf("  -R SPEC   Replay console log: last N bytes, Nl lines, or @TIME.\n");
     printf("  -v        Be verbose.\n");
     printf("  -V        Display version information.\n");
     printf("\n");
@@ -184,6 +184,28 @@ int send_req(client_conf_t *conf)
             LEX_TOK2STR(proto_strs, CONMAN_TOK_OPTION),
             LEX_TOK2STR(proto_strs, CONMAN_TOK_REGEX));
     }
+    if ((conf->req->command != CONMAN_CMD_QUERY)
+            && (conf->req->replay != CONMAN_REPLAY_NONE)) {
+        n = append_format_string(buf, sizeof(buf), " %s='%s%ld%s'",
+            LEX_TOK2STR(proto_strs, CONMAN_TOK_REPLAY),
+            (conf->req->replay == CONMAN_REPLAY_TIME ? "@" : ""),
+            conf->req->replayArg,
+            (conf->req->replay == CONMAN_REPLAY_LINES ? "l" : ""));
+    }
+    if ((conf->req->command != CONMAN_CMD_QUERY)
+            && (conf->req->gotOverrunPolicy)) {
+        if (conf->req->overrunPolicy == CONMAN_OVERRUN_MARKER) {
+            n = append_format_string(buf, sizeof(buf), " %s='marker'",
+                LEX_TOK2STR(proto_strs, CONMAN_TOK_OVERRUN));
+        }
+        else {
+            n = append_format_string(buf, sizeof(buf), " %s='%s:%d'",
+                LEX_TOK2STR(proto_strs, CONMAN_TOK_OVERRUN),
+                (conf->req->overrunPolicy == CONMAN_OVERRUN_SPOOL
+                    ? "spool" : "disconnect"),
+                conf->req->overrunLimit);
+        }
+    }
     if (conf->req->command == CONMAN_CMD_CONNECT) {
         if (conf->req->enableForce) {
             n = append_format_string(buf, sizeof(buf), " %s=%s",
@@ -448,9 +448,16 @@ static int perform_help_esc(client_conf_t *conf, char c)
      */
     if (!conf->req->enableBroadcast) {
         write_esc_char(ESC_CHAR_REPLAY, tmp);
-        (void) append_format_string(buf, sizeof(buf),
-            "  %2s%-2s -  Replay up to the last %d bytes of the log.\r\n",
-            esc, tmp, LOG_REPLAY_LEN);
+        if (conf->req->replay != CONMAN_REPLAY_NONE) {
+            (void) append_format_string(buf, sizeof(buf),
+                "  %2s%-2s -  Replay the log as specified via -R.\r\n",
+                esc, tmp);
+        }
+        else {
+            (void) append_format_string(buf, sizeof(buf),
+                "  %2s%-2s -  Replay up to the last %d bytes of the log.\r\n",
+                esc, tmp, LOG_REPLAY_LEN);
+        }
     }
 
     if ((conf->req->command == CONMAN_CMD_CONNECT) &&
@@ -28,7 +28,9 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 #include <termios.h>
 #include <unistd.h>
 #include "common.h"
@@ -69,9 +71,11 @@ char *proto_strs[] = {
     "MONITOR",
     "OK",
     "OPTION",
+    "OVERRUN",
     "QUERY",
     "QUIET",
     "REGEX",
+    "REPLAY",
     "RESET",
     "TTY",
     "USER",
@@ -95,7 +99,12 @@ req_t * create_req(void)
     req->ip = NULL;
     req->port = 0;
     req->consoles = list_create((ListDelF) destroy_string);
+    req->replayArg = 0;
     req->command = CONMAN_CMD_NONE;
+    req->replay = CONMAN_REPLAY_NONE;
+    req->overrunPolicy = CONMAN_OVERRUN_MARKER;
+    req->overrunLimit = 0;
+    req->gotOverrunPolicy = 0;
     req->enableBroadcast = 0;
     req->enableEcho = 0;
     req->enableForce = 0;
@@ -137,6 +146,125 @@ void destroy_req(req_t *req)
 }
 
 
+int parse_replay_spec(req_t *req, const char *str)
+{
+/*  Parses the log replay spec 'str' into the request 'req'.
+ *    The spec is either "<N>" to replay the last N bytes (optionally with
+ *    a "k" or "m" suffix for KiB or MiB), "<N>l" to replay the last N lines,
+ *    or "@<T>" to replay everything since the time T (in seconds since the
+ *    epoch).  This is also the form in which the spec is sent to the server.
+ *  Returns 0 on success, or -1 on error.
+ */
+    long n;
+    char *p;
+    long scale = 1;
+    replay_t replay = CONMAN_REPLAY_BYTES;
+
+    assert(req != NULL);
+
+    if (!str) {
+        return(-1);
+    }
+    if (*str == '@') {
+        replay = CONMAN_REPLAY_TIME;
+        str++;
+    }
+    if ((*str < '0') || (*str > '9')) {
+        return(-1);
+    }
+    errno = 0;
+    n = strtol(str, &p, 10);
+    if ((p == str) || (errno == ERANGE)) {
+        return(-1);
+    }
+    if (replay == CONMAN_REPLAY_TIME) {
+        if (*p != '\0') {
+            return(-1);
+        }
+    }
+    else if (!strcasecmp(p, "l")) {
+        replay = CONMAN_REPLAY_LINES;
+    }
+    else if (!strcasecmp(p, "k")) {
+        scale = 1024;
+    }
+    else if (!strcasecmp(p, "m")) {
+        scale = 1024 * 1024;
+    }
+    else if (*p != '\0') {
+        return(-1);
+    }
+    if ((replay != CONMAN_REPLAY_TIME) && (n <= 0)) {
+        return(-1);
+    }
+    if (n > LONG_MAX / scale) {
+        return(-1);
+    }
+    req->replay = replay;
+    req->replayArg = n * scale;
+    return(0);
+}
+
+
+int parse_overrun_policy(const char *str, overrun_policy_t *policyp,
+    int *limitp, char *errbuf, int errlen)
+{
+/*  Parses 'str' for the policy applied to a client whose output cannot keep
+ *    up with its console.  The 'str' string is of the form
+ *    "(marker|disconnect[:<bytes>]|spool[:<bytes>])".
+ *  This is used both for the server's "overrun" keyword and for the policy
+ *    requested by a client.
+ *  Returns 0 and updates 'policyp' and 'limitp' on success; o/w, returns -1
+ *    (writing an error message into 'errbuf').
+ */
+    char buf[MAX_LINE];
+    char *p;
+    char *q;
+    long n = -1;
+    overrun_policy_t policy;
+
+    assert(policyp != NULL);
+    assert(limitp != NULL);
+    assert(str != NULL);
+
+    if (strlcpy(buf, str, sizeof(buf)) >= sizeof(buf)) {
+        snprintf(errbuf, errlen, "overrun string exceeded buffer size");
+        return(-1);
+    }
+    if ((p = strchr(buf, ':'))) {
+        *p++ = '\0';
+        errno = 0;
+        n = strtol(p, &q, 10);
+        if ((errno != 0) || (q == p) || (*q != '\0')
+                || (n < 0) || (n > MAX_OVERRUN_LIMIT)) {
+            snprintf(errbuf, errlen,
+                "invalid overrun limit \"%s\" (range is 0-%d)",
+                p, MAX_OVERRUN_LIMIT);
+            return(-1);
+        }
+    }
+    if (!strcasecmp(buf, "marker") && (n < 0)) {
+        policy = CONMAN_OVERRUN_MARKER;
+        n = 0;
+    }
+    else if (!strcasecmp(buf, "disconnect")) {
+        policy = CONMAN_OVERRUN_DISCONNECT;
+        n = MAX(n, 0);
+    }
+    else if (!strcasecmp(buf, "spool")) {
+        policy = CONMAN_OVERRUN_SPOOL;
+        n = (n < 0) ? DEFAULT_OVERRUN_SPOOL_SIZE : n;
+    }
+    else {
+        snprintf(errbuf, errlen, "invalid overrun policy \"%s\"", str);
+        return(-1);
+    }
+    *policyp = policy;
+    *limitp = n;
+    return(0);
+}
+
+
 void get_tty_mode(struct termios *tty, int fd)
 {
 /*  Gets the tty values associated with 'fd' and stores them in 'tty'.
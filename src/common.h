@@ -76,16 +76,25 @@
 /*  Notes regarding the recommended sizes of various constants:
  *
  *    - OBJ_BUF_SIZE >= LOG_REPLAY_LEN * 2
- *    - OBJ_BUF_SIZE >= MAX_LINE
+ *    - MIN_OBJ_BUF_SIZE >= MAX_LINE * 2
+ *    - OBJ_MSG_BUF_SIZE >= LOG_REPLAY_LEN * 2
  *    - MAX_BUF_SIZE >= MAX_LINE
  *    - MAX_SOCK_LINE >= MAX_LINE
  */
 #define OBJ_BUF_SIZE            16384
+#define MIN_OBJ_BUF_SIZE        2048
+#define MAX_OBJ_BUF_SIZE        16777216
+#define OBJ_MSG_BUF_SIZE        8192
 #define LOG_REPLAY_LEN          4096
 #define MAX_BUF_SIZE            4096
 #define MAX_SOCK_LINE           131072
 #define MAX_LINE                1024
 
+/*  Limits for the client buffer overrun policy (cf. parse_overrun_policy()).
+ */
+#define DEFAULT_OVERRUN_SPOOL_SIZE      1048576
+#define MAX_OVERRUN_LIMIT               1073741824
+
 /*  Escape codes used to send ctrl info 'tween client & server.
  */
 #define ESC_CHAR                0xFF
@@ -123,10 +132,16 @@
 #  define FEATURE_TCP_WRAPPERS ""
 #endif /* WITH_TCP_WRAPPERS */
 
+#if WITH_ZLIB
+#  define FEATURE_ZLIB " ZLIB"
+#else
+#  define FEATURE_ZLIB ""
+#endif /* WITH_ZLIB */
+
 #define CLIENT_FEATURES \
     (FEATURE_DEBUG)
 #define SERVER_FEATURES \
-    (FEATURE_DEBUG FEATURE_FREEIPMI FEATURE_TCP_WRAPPERS)
+    (FEATURE_DEBUG FEATURE_FREEIPMI FEATURE_TCP_WRAPPERS FEATURE_ZLIB)
 
 #if ! HAVE_SOCKLEN_T
 typedef int socklen_t;                  /* socklen_t is uint32_t in Posix.1g */
@@ -140,6 +155,19 @@ typedef enum cmd_type {                 /* ConMan command (2 bits)           */
     CONMAN_CMD_QUERY
 } cmd_t;
 
+typedef enum replay_type {              /* log replay requested (2 bits)     */
+    CONMAN_REPLAY_NONE,
+    CONMAN_REPLAY_BYTES,                /*  replay the last N bytes          */
+    CONMAN_REPLAY_LINES,                /*  replay the last N lines          */
+    CONMAN_REPLAY_TIME                  /*  replay everything since a time   */
+} replay_t;
+
+typedef enum overrun_policy {           /* client buffer overrun policy      */
+    CONMAN_OVERRUN_MARKER,              /*  drop data & inject a lost marker */
+    CONMAN_OVERRUN_DISCONNECT,          /*  disconnect after limit exceeded  */
+    CONMAN_OVERRUN_SPOOL                /*  spool data to a bounded tmpfile  */
+} overrun_policy_t;
+
 typedef struct request {
     int       sd;                       /* socket descriptor                 */
     char     *user;                     /* login name of client user         */
@@ -149,7 +177,12 @@ typedef struct request {
     char     *ip;                       /* queried remote ip addr string     */
     int       port;                     /* remote port number                */
     List      consoles;                 /* list of consoles affected by cmd  */
+    long      replayArg;                /* num bytes/lines, or time in secs  */
+    int       overrunLimit;             /* disconnect limit or spool size    */
     unsigned  command:2;                /* ConMan command to perform (cmd_t) */
+    unsigned  replay:2;                 /* log replay requested (replay_t)   */
+    unsigned  overrunPolicy:2;          /* overrun policy (overrun_policy_t) */
+    unsigned  gotOverrunPolicy:1;       /* true if overrun policy requested  */
     unsigned  enableBroadcast:1;        /* true if b-casting to >1 consoles  */
     unsigned  enableEcho:1;             /* true if echoing standard input    */
     unsigned  enableForce:1;            /* true if forcing console conn      */
@@ -187,9 +220,11 @@ enum proto_toks {
     CONMAN_TOK_MONITOR,
     CONMAN_TOK_OK,
     CONMAN_TOK_OPTION,
+    CONMAN_TOK_OVERRUN,
     CONMAN_TOK_QUERY,
     CONMAN_TOK_QUIET,
     CONMAN_TOK_REGEX,
+    CONMAN_TOK_REPLAY,
     CONMAN_TOK_RESET,
     CONMAN_TOK_TTY,
     CONMAN_TOK_USER
@@ -208,6 +243,11 @@ req_t * create_req(void);
 
 void destroy_req(req_t *req);
 
+int parse_replay_spec(req_t *req, const char *str);
+
+int parse_overrun_policy(const char *str, overrun_policy_t *policyp,
+    int *limitp, char *errbuf, int errlen);
+
 void get_tty_mode(struct termios *tty, int fd);
 
 void set_tty_mode(struct termios *tty, int fd);
@@ -60,8 +60,15 @@
 \***************/
 
 #define LIST_ALLOC 10
+#define LIST_ALLOC_MAX 1024
+#define LIST_CACHE_BATCH 32
+#define LIST_CACHE_MAX 128
 #define LIST_MAGIC 0xDEADBEEF
 
+#ifndef MIN
+#  define MIN(x,y) (((x) <= (y)) ? (x) : (y))
+#endif /* !MIN */
+
 
 /****************\
 **  Data Types  **
@@ -72,16 +79,6 @@ struct listNode {
     struct listNode      *next;         /* next node in list                 */
 };
 
-struct listIterator {
-    struct list          *list;         /* the list being iterated           */
-    struct listNode      *pos;          /* the next node to be iterated      */
-    struct listNode     **prev;         /* addr of 'next' ptr to prv It node */
-    struct listIterator  *iNext;        /* iterator chain for list_destroy() */
-#ifndef NDEBUG
-    unsigned int          magic;        /* sentinel for asserting validity   */
-#endif /* NDEBUG */
-};
-
 struct list {
     struct listNode      *head;         /* head of the list                  */
     struct listNode     **tail;         /* addr of last node's 'next' ptr    */
@@ -98,6 +95,33 @@ struct list {
 
 typedef struct listNode * ListNode;
 
+enum listPoolType {                     /* pools of free items by type:      */
+    LIST_POOL_LISTS,                    /*  struct list                      */
+    LIST_POOL_NODES,                    /*  struct listNode                  */
+    LIST_POOL_ITERATORS,                /*  struct listIterator              */
+    LIST_POOL_LAST                      /*  (number of pools)                */
+};
+
+/*  Free items are chained through their first ptr-sized word.
+ */
+struct listPool {
+    void                 *free;         /* global free list of items         */
+    size_t                size;         /* size of each item in bytes        */
+    int                   numNext;      /* num items in the next slab        */
+    unsigned long         numSlabs;     /* num slabs allocated (stats)       */
+    unsigned long         numItems;     /* num items in all slabs (stats)    */
+    unsigned long         numRefills;   /* num thread cache refills (stats)  */
+    unsigned long         numFlushes;   /* num thread cache flushes (stats)  */
+#if WITH_PTHREADS
+    pthread_mutex_t       mutex;        /* mutex to protect global free list */
+#endif /* WITH_PTHREADS */
+};
+
+struct listCache {
+    void                 *free[LIST_POOL_LAST];  /* thread's free items      */
+    int                   count[LIST_POOL_LAST]; /* num items in free lists  */
+};
+
 
 /****************\
 **  Prototypes  **
@@ -111,19 +135,37 @@ static ListIterator list_iterator_alloc(void);
 static void list_free(List l);
 static void list_node_free(ListNode p);
 static void list_iterator_free(ListIterator i);
+static void * list_pool_alloc(int n);
+static void list_pool_free(int n, void *x);
+static void list_pool_grow(struct listPool *pool);
+static struct listCache * list_cache_get(void);
+#if WITH_PTHREADS
+static void list_cache_init(void);
+static void list_cache_destroy(void *arg);
+#endif /* WITH_PTHREADS */
 
 
 /***************\
 **  Variables  **
 \***************/
 
-static List freeLists = NULL;
-static ListNode freeListNodes = NULL;
-static ListIterator freeListIterators = NULL;
 #if WITH_PTHREADS
-static pthread_mutex_t freeListsLock = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t freeListNodesLock = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t freeListIteratorsLock = PTHREAD_MUTEX_INITIALIZER;
+#  define LIST_POOL_INITIALIZER(type)                                         \
+     { NULL, sizeof(type), LIST_ALLOC, 0, 0, 0, 0, PTHREAD_MUTEX_INITIALIZER }
+#else /* !WITH_PTHREADS */
+#  define LIST_POOL_INITIALIZER(type)                                         \
+     { NULL, sizeof(type), LIST_ALLOC, 0, 0, 0, 0 }
+#endif /* WITH_PTHREADS */
+
+static struct listPool listPools[LIST_POOL_LAST] = {
+    LIST_POOL_INITIALIZER(struct list),
+    LIST_POOL_INITIALIZER(struct listNode),
+    LIST_POOL_INITIALIZER(struct listIterator),
+};
+#if WITH_PTHREADS
+static pthread_key_t listCacheKey;
+static pthread_once_t listCacheOnce = PTHREAD_ONCE_INIT;
+static int listCacheKeyValid = 0;
 #endif /* WITH_PTHREADS */
 
 
@@ -201,7 +243,8 @@ void list_destroy(List l)
         assert(i->magic == LIST_MAGIC);
         iTmp = i->iNext;
         assert((i->magic = 1));         /* clear magic via assert abuse */
-        list_iterator_free(i);
+        if (i->isAlloc)
+            list_iterator_free(i);
         i = iTmp;
     }
     p = l->head;
@@ -442,7 +485,18 @@ ListIterator list_iterator_create(List l)
     assert(l != NULL);
     if (!(i = list_iterator_alloc()))
         return(out_of_memory());
+    list_iterator_init(i, l);
+    i->isAlloc = 1;
+    return(i);
+}
+
+
+void list_iterator_init(ListIterator i, List l)
+{
+    assert(i != NULL);
+    assert(l != NULL);
     i->list = l;
+    i->isAlloc = 0;
     list_mutex_lock(&l->mutex);
     assert(l->magic == LIST_MAGIC);
     i->pos = l->head;
@@ -451,7 +505,7 @@ ListIterator list_iterator_create(List l)
     l->iNext = i;
     list_mutex_unlock(&l->mutex);
     assert((i->magic = LIST_MAGIC));    /* set magic via assert abuse */
-    return(i);
+    return;
 }
 
 
@@ -469,6 +523,16 @@ void list_iterator_reset(ListIterator i)
 
 
 void list_iterator_destroy(ListIterator i)
+{
+    assert(i != NULL);
+    assert(i->isAlloc);
+    list_iterator_fini(i);
+    list_iterator_free(i);
+    return;
+}
+
+
+void list_iterator_fini(ListIterator i)
 {
     ListIterator *pi;
 
@@ -485,7 +549,6 @@ void list_iterator_destroy(ListIterator i)
     }
     list_mutex_unlock(&i->list->mutex);
     assert((i->magic = 1));             /* clear magic via assert abuse */
-    list_iterator_free(i);
     return;
 }
 
@@ -565,6 +628,30 @@ int list_delete(ListIterator i)
 }
 
 
+void list_get_stats(ListStats *lists, ListStats *nodes, ListStats *iterators)
+{
+    ListStats *stats[LIST_POOL_LAST];
+    struct listPool *pool;
+    int n;
+
+    stats[LIST_POOL_LISTS] = lists;
+    stats[LIST_POOL_NODES] = nodes;
+    stats[LIST_POOL_ITERATORS] = iterators;
+    for (n=0; n<LIST_POOL_LAST; n++) {
+        if (!stats[n])
+            continue;
+        pool = &listPools[n];
+        list_mutex_lock(&pool->mutex);
+        stats[n]->numSlabs = pool->numSlabs;
+        stats[n]->numItems = pool->numItems;
+        stats[n]->numRefills = pool->numRefills;
+        stats[n]->numFlushes = pool->numFlushes;
+        list_mutex_unlock(&pool->mutex);
+    }
+    return;
+}
+
+
 static void * list_node_create(List l, ListNode *pp, void *x)
 {
 /*  Inserts data pointed to by (x) into list (l) after (pp),
@@ -634,95 +721,204 @@ static void * list_node_destroy(List l, ListNode *pp)
 
 static List list_alloc(void)
 {
-    List l;
-    List last;
-
-    list_mutex_lock(&freeListsLock);
-    if (!freeLists) {
-        freeLists = malloc(LIST_ALLOC * sizeof(struct list));
-        if (freeLists) {
-            last = freeLists + LIST_ALLOC - 1;
-            for (l=freeLists; l<last; l++)
-                l->iNext = (ListIterator) (l + 1);
-            last->iNext = NULL;
-        }
-    }
-    if ((l = freeLists))
-        freeLists = (List) freeLists->iNext;
-    list_mutex_unlock(&freeListsLock);
-    return(l);
+    return((List) list_pool_alloc(LIST_POOL_LISTS));
 }
 
 
 static ListNode list_node_alloc(void)
 {
-    ListNode p;
-    ListNode last;
-
-    list_mutex_lock(&freeListNodesLock);
-    if (!freeListNodes) {
-        freeListNodes = malloc(LIST_ALLOC * sizeof(struct listNode));
-        if (freeListNodes) {
-            last = freeListNodes + LIST_ALLOC - 1;
-            for (p=freeListNodes; p<last; p++)
-                p->next = p + 1;
-            last->next = NULL;
-        }
-    }
-    if ((p = freeListNodes))
-        freeListNodes = freeListNodes->next;
-    list_mutex_unlock(&freeListNodesLock);
-    return(p);
+    return((ListNode) list_pool_alloc(LIST_POOL_NODES));
 }
 
 
 static ListIterator list_iterator_alloc(void)
 {
-    ListIterator i;
-    ListIterator last;
-
-    list_mutex_lock(&freeListIteratorsLock);
-    if (!freeListIterators) {
-        freeListIterators = malloc(LIST_ALLOC * sizeof(struct listIterator));
-        if (freeListIterators) {
-            last = freeListIterators + LIST_ALLOC - 1;
-            for (i=freeListIterators; i<last; i++)
-                i->iNext = i + 1;
-            last->iNext = NULL;
-        }
-    }
-    if ((i = freeListIterators))
-        freeListIterators = freeListIterators->iNext;
-    list_mutex_unlock(&freeListIteratorsLock);
-    return(i);
+    return((ListIterator) list_pool_alloc(LIST_POOL_ITERATORS));
 }
 
 
 static void list_free(List l)
 {
-    list_mutex_lock(&freeListsLock);
-    l->iNext = (ListIterator) freeLists;
-    freeLists = l;
-    list_mutex_unlock(&freeListsLock);
+    list_pool_free(LIST_POOL_LISTS, l);
     return;
 }
 
 
 static void list_node_free(ListNode p)
 {
-    list_mutex_lock(&freeListNodesLock);
-    p->next = freeListNodes;
-    freeListNodes = p;
-    list_mutex_unlock(&freeListNodesLock);
+    list_pool_free(LIST_POOL_NODES, p);
     return;
 }
 
 
 static void list_iterator_free(ListIterator i)
 {
-    list_mutex_lock(&freeListIteratorsLock);
-    i->iNext = freeListIterators;
-    freeListIterators = i;
-    list_mutex_unlock(&freeListIteratorsLock);
+    list_pool_free(LIST_POOL_ITERATORS, i);
     return;
 }
+
+
+static void * list_pool_alloc(int n)
+{
+/*  Allocates an item from pool (n), taking it from the calling thread's
+ *    cache if possible.  Otherwise, the cache is refilled with a batch of
+ *    items from the pool's global free list (which grows by slabs of
+ *    geometrically-increasing size as needed).
+ *  Returns a ptr to the item, or NULL if memory could not be allocated.
+ */
+    struct listPool *pool = &listPools[n];
+    struct listCache *c;
+    void *x;
+    int k;
+
+    if ((c = list_cache_get()) && (x = c->free[n])) {
+        c->free[n] = *(void **) x;
+        c->count[n]--;
+        return(x);
+    }
+    list_mutex_lock(&pool->mutex);
+    if (!pool->free)
+        list_pool_grow(pool);
+    if ((x = pool->free)) {
+        pool->free = *(void **) x;
+        if (c) {
+            for (k=0; (k < LIST_CACHE_BATCH) && pool->free; k++) {
+                void *y = pool->free;
+                pool->free = *(void **) y;
+                *(void **) y = c->free[n];
+                c->free[n] = y;
+            }
+            c->count[n] += k;
+            pool->numRefills++;
+        }
+    }
+    list_mutex_unlock(&pool->mutex);
+    return(x);
+}
+
+
+static void list_pool_free(int n, void *x)
+{
+/*  Returns item (x) to pool (n) by way of the calling thread's cache.
+ *    Once the cache is full, a batch of items is moved from the cache
+ *    back to the pool's global free list for use by other threads.
+ */
+    struct listPool *pool = &listPools[n];
+    struct listCache *c;
+    int k;
+
+    assert(x != NULL);
+    if ((c = list_cache_get()) && (c->count[n] < LIST_CACHE_MAX)) {
+        *(void **) x = c->free[n];
+        c->free[n] = x;
+        c->count[n]++;
+        return;
+    }
+    list_mutex_lock(&pool->mutex);
+    *(void **) x = pool->free;
+    pool->free = x;
+    if (c) {
+        for (k=0; (k < LIST_CACHE_BATCH) && c->free[n]; k++) {
+            void *y = c->free[n];
+            c->free[n] = *(void **) y;
+            *(void **) y = pool->free;
+            pool->free = y;
+        }
+        c->count[n] -= k;
+        pool->numFlushes++;
+    }
+    list_mutex_unlock(&pool->mutex);
+    return;
+}
+
+
+static void list_pool_grow(struct listPool *pool)
+{
+/*  Adds a slab of items to the global free list of (pool).
+ *    Each slab is twice the size of the previous one (up to LIST_ALLOC_MAX
+ *    items) so a busy pool requires few slabs.
+ *  This routine assumes the pool is already locked upon entry.
+ */
+    char *slab;
+    char *last;
+    char *p;
+
+    if (!(slab = malloc(pool->numNext * pool->size)))
+        return;
+    last = slab + ((pool->numNext - 1) * pool->size);
+    for (p=slab; p<last; p+=pool->size)
+        *(void **) p = p + pool->size;
+    *(void **) last = pool->free;
+    pool->free = slab;
+    pool->numSlabs++;
+    pool->numItems += pool->numNext;
+    if (pool->numNext < LIST_ALLOC_MAX)
+        pool->numNext = MIN(pool->numNext * 2, LIST_ALLOC_MAX);
+    return;
+}
+
+
+static struct listCache * list_cache_get(void)
+{
+/*  Returns a ptr to the calling thread's cache of free items,
+ *    or NULL if the cache is unavailable.
+ */
+#if WITH_PTHREADS
+    struct listCache *c;
+
+    if ((errno = pthread_once(&listCacheOnce, list_cache_init)) != 0)
+        perror("ERROR: pthread_once() failed"), exit(1);
+    if (!listCacheKeyValid)
+        return(NULL);
+    if (!(c = pthread_getspecific(listCacheKey))) {
+        if (!(c = calloc(1, sizeof(struct listCache))))
+            return(NULL);
+        if (pthread_setspecific(listCacheKey, c) != 0) {
+            free(c);
+            return(NULL);
+        }
+    }
+    return(c);
+#else /* !WITH_PTHREADS */
+    return(NULL);
+#endif /* WITH_PTHREADS */
+}
+
+
+#if WITH_PTHREADS
+
+static void list_cache_init(void)
+{
+/*  Creates the key for each thread's cache of free items.
+ */
+    listCacheKeyValid =
+        (pthread_key_create(&listCacheKey, list_cache_destroy) == 0);
+    return;
+}
+
+
+static void list_cache_destroy(void *arg)
+{
+/*  Moves the free items remaining in an exiting thread's cache (arg)
+ *    back to the global free lists.
+ */
+    struct listCache *c = arg;
+    struct listPool *pool;
+    void *x;
+    int n;
+
+    for (n=0; n<LIST_POOL_LAST; n++) {
+        pool = &listPools[n];
+        list_mutex_lock(&pool->mutex);
+        while ((x = c->free[n])) {
+            c->free[n] = *(void **) x;
+            *(void **) x = pool->free;
+            pool->free = x;
+        }
+        list_mutex_unlock(&pool->mutex);
+    }
+    free(c);
+    return;
+}
+
+#endif /* WITH_PTHREADS */
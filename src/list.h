@@ -49,7 +49,33 @@ typedef struct list * List;
 
 typedef struct listIterator * ListIterator;
 /*
- *  List Iterator opaque data type.
+ *  List Iterator data type.
+ */
+
+struct listIterator {
+    struct list          *list;         /* the list being iterated           */
+    struct listNode      *pos;          /* the next node to be iterated      */
+    struct listNode     **prev;         /* addr of 'next' ptr to prv It node */
+    struct listIterator  *iNext;        /* iterator chain for list_destroy() */
+    int                   isAlloc;      /* true if via list_iterator_create  */
+#ifndef NDEBUG
+    unsigned int          magic;        /* sentinel for asserting validity   */
+#endif /* NDEBUG */
+};
+/*
+ *  The members of a list iterator are private, but its structure is exposed
+ *    so an iterator can be placed on the stack via list_iterator_init(),
+ *    thereby avoiding its allocation in frequently-called loops.
+ */
+
+typedef struct listStats {
+    unsigned long         numSlabs;     /* num slabs allocated from the heap */
+    unsigned long         numItems;     /* num items in all slabs            */
+    unsigned long         numRefills;   /* num thread cache refills          */
+    unsigned long         numFlushes;   /* num thread cache flushes          */
+} ListStats;
+/*
+ *  List allocator statistics for one type of item (cf. list_get_stats()).
  */
 
 typedef void (*ListDelF)(void *x);
@@ -199,6 +225,19 @@ ListIterator list_iterator_create(List l);
  *    list (l), or out_of_memory() on failure.
  */
 
+void list_iterator_init(ListIterator i, List l);
+/*
+ *  Initializes the caller-provided list iterator (i) for non-destructively
+ *    traversing list (l); the iterator must be finalized via
+ *    list_iterator_fini() before it goes out of scope.
+ *  Example: struct listIterator it; list_iterator_init(&it, l); ...
+ */
+
+void list_iterator_fini(ListIterator i);
+/*
+ *  Finalizes the list iterator (i) initialized via list_iterator_init().
+ */
+
 void list_iterator_reset(ListIterator i);
 /*
  *  Resets the list iterator (i) to start traversal at the beginning
@@ -253,4 +292,18 @@ int list_delete(ListIterator i);
  */
 
 
+
+/******************************\
+**  List Allocator Functions  **
+\******************************/
+
+void list_get_stats(ListStats *lists, ListStats *nodes, ListStats *iterators);
+/*
+ *  Copies the allocator statistics for lists, list nodes, and list iterators
+ *    into (lists), (nodes), and (iterators) respectively; any may be NULL.
+ *  Each thread caches the items it frees for reuse; a refill or flush occurs
+ *    when a thread's cache is exhausted or full and must access the shared
+ *    free list.
+ */
+
 #endif /* !_LIST_H */
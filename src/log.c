@@ -181,8 +181,6 @@ void log_msg(int priority, const char *format, ...)
 static void log_aux(int errnum, int priority, char *msgbuf, int msgbuflen,
     const char *format, va_list vargs)
 {
-    time_t t;
-    struct tm tm;
     const char *prefix;
     char buf[MAX_LINE];                 /* buf starting with timestamp       */
     char *pbuf;                         /* buf starting with priority string */
@@ -194,13 +192,9 @@ static void log_aux(int errnum, int priority, char *msgbuf, int msgbuflen,
     p = sbuf = pbuf = buf;
     len = sizeof(buf) - 1;              /* reserve char for trailing newline */
 
-    t = 0;
-    get_localtime(&t, &tm);
-    n = strftime(p, len, "%Y-%m-%d %H:%M:%S ", &tm);
-    if (n == 0) {
-        *p = '\0';
-        len = 0;
-    }
+    /*  If the timestamp cannot be formatted, the message is logged without it.
+     */
+    n = write_time_string(0, p, len);
     p = sbuf = pbuf += n;
     len -= n;
 
@@ -48,18 +48,21 @@
 #include "util-file.h"
 #include "util-str.h"
 #include "util.h"
+#include "wrapper.h"
 
 
 enum server_conf_toks {
 /*
  *  Keep enums in sync w/ server_conf_strs[].
  */
-    SERVER_CONF_CONSOLE = LEX_TOK_OFFSET,
+    SERVER_CONF_BUFSIZE = LEX_TOK_OFFSET,
+    SERVER_CONF_CONSOLE,
     SERVER_CONF_COREDUMP,
     SERVER_CONF_COREDUMPDIR,
     SERVER_CONF_DEV,
     SERVER_CONF_EXECPATH,
     SERVER_CONF_GLOBAL,
+    SERVER_CONF_IOURING,
 #if WITH_FREEIPMI
     SERVER_CONF_IPMIOPTS,
 #endif /* WITH_FREEIPMI */
@@ -68,19 +71,24 @@ enum server_conf_toks {
     SERVER_CONF_LOGDIR,
     SERVER_CONF_LOGFILE,
     SERVER_CONF_LOGOPTS,
+    SERVER_CONF_LOGWRITERS,
     SERVER_CONF_LOOPBACK,
     SERVER_CONF_NAME,
     SERVER_CONF_NOFILE,
     SERVER_CONF_OFF,
     SERVER_CONF_ON,
+    SERVER_CONF_OVERRUN,
     SERVER_CONF_PIDFILE,
     SERVER_CONF_PORT,
+    SERVER_CONF_READBUDGET,
     SERVER_CONF_RESETCMD,
     SERVER_CONF_SEROPTS,
     SERVER_CONF_SERVER,
+    SERVER_CONF_SPLICE,
     SERVER_CONF_SYSLOG,
     SERVER_CONF_TCPWRAPPERS,
     SERVER_CONF_TESTOPTS,
+    SERVER_CONF_THREADS,
     SERVER_CONF_TIMESTAMP
 };
 
@@ -89,12 +97,14 @@ static char *server_conf_strs[] = {
  *  Keep strings in sync w/ server_conf_toks enum.
  *  These must be sorted in a case-insensitive manner.
  */
+    "BUFSIZE",
     "CONSOLE",
     "COREDUMP",
     "COREDUMPDIR",
     "DEV",
     "EXECPATH",
     "GLOBAL",
+    "IOURING",
 #if WITH_FREEIPMI
     "IPMIOPTS",
 #endif /* WITH_FREEIPMI */
@@ -103,19 +113,24 @@ static char *server_conf_strs[] = {
     "LOGDIR",
     "LOGFILE",
     "LOGOPTS",
+    "LOGWRITERS",
     "LOOPBACK",
     "NAME",
     "NOFILE",
     "OFF",
     "ON",
+    "OVERRUN",
     "PIDFILE",
     "PORT",
+    "READBUDGET",
     "RESETCMD",
     "SEROPTS",
     "SERVER",
+    "SPLICE",
     "SYSLOG",
     "TCPWRAPPERS",
     "TESTOPTS",
+    "THREADS",
     "TIMESTAMP",
     NULL
 };
@@ -180,6 +195,7 @@ typedef struct console_strs {
     char *iopts;
 #endif /* WITH_FREEIPMI */
     char *topts;
+    int   bufSize;
 } console_strs_t;
 
 
@@ -192,6 +208,7 @@ static void parse_global_directive(server_conf_t *conf, Lex l);
 static void parse_server_directive(server_conf_t *conf, Lex l);
 static int read_pidfile(const char *pidfile);
 static int write_pidfile(const char *pidfile);
+static int get_max_threads(void);
 static int lookup_syslog_priority(const char *priority);
 static int lookup_syslog_facility(const char *facility);
 
@@ -229,15 +246,31 @@ server_conf_t * create_server_conf(void)
      */
     conf->fd = -1;
     conf->port = -1;
+    conf->readBudget = DEFAULT_READ_BUDGET;
+    conf->bufSize = OBJ_BUF_SIZE;
+    conf->overrunPolicy = CONMAN_OVERRUN_MARKER;
+    conf->overrunLimit = 0;
     conf->ld = -1;
     conf->objs = list_create((ListDelF) destroy_obj);
     if (!(conf->tp = tpoll_create(0))) {
         log_err(0, "Unable to create object for multiplexing I/O");
     }
+    conf->loops = NULL;
+    conf->numLoops = 1;
+    conf->logWriters = NULL;
+    conf->numLogWriters = 0;
     conf->globalLogName = NULL;
     conf->globalLogOpts.enableSanitize = DEFAULT_LOGOPT_SANITIZE;
     conf->globalLogOpts.enableTimestamp = DEFAULT_LOGOPT_TIMESTAMP;
     conf->globalLogOpts.enableLock = DEFAULT_LOGOPT_LOCK;
+    conf->globalLogOpts.enableSync = DEFAULT_LOGOPT_SYNC;
+    conf->globalLogOpts.flushBytes = 0;
+    conf->globalLogOpts.flushMsecs = 0;
+    conf->globalLogOpts.compress = CONMAN_LOG_COMPRESS_NONE;
+    conf->globalLogOpts.frameSecs = DEFAULT_LOG_FRAME_SECS;
+    conf->globalLogOpts.indexSecs = 0;
+    conf->globalLogOpts.maxSize = 0;
+    conf->globalLogOpts.numKeep = DEFAULT_LOG_KEEP;
     conf->globalSerOpts.bps = DEFAULT_SEROPT_BPS;
     conf->globalSerOpts.databits = DEFAULT_SEROPT_DATABITS;
     conf->globalSerOpts.parity = DEFAULT_SEROPT_PARITY;
@@ -260,6 +293,8 @@ server_conf_t * create_server_conf(void)
     conf->enableVerbose = 0;
     conf->enableZeroLogs = 0;
     conf->enableForeground = 0;
+    conf->enableIOUring = 0;
+    conf->enableSplice = 0;
     /*
      *  Copy the current working directory before we chdir() away.
      *  Since logfiles can be re-opened after the daemon has chdir()'d,
@@ -276,6 +311,8 @@ server_conf_t * create_server_conf(void)
 
 void destroy_server_conf(server_conf_t *conf)
 {
+    int i;
+
     if (!conf) {
         return;
     }
@@ -302,6 +339,27 @@ void destroy_server_conf(server_conf_t *conf)
     if (conf->objs) {
         list_destroy(conf->objs);
     }
+    destroy_log_writers(conf);
+    if (conf->loops) {
+        /*
+         *  The main event loop's tpoll obj is conf->tp.
+         */
+        for (i = 0; i < conf->numLoops; i++) {
+            while (conf->loops[i].clients) {
+                destroy_client_obj(conf->loops[i].clients);
+            }
+            x_pthread_mutex_destroy(&conf->loops[i].lock);
+            if (conf->loops[i].objs) {
+                list_destroy(conf->loops[i].objs);
+            }
+            if (conf->loops[i].tp && (conf->loops[i].tp != conf->tp)) {
+                tpoll_destroy(conf->loops[i].tp);
+            }
+            uring_destroy(conf->loops[i].uring);
+            free(conf->loops[i].fdObjs);
+        }
+        free(conf->loops);
+    }
     if (conf->tp) {
         tpoll_destroy(conf->tp);
     }
@@ -580,7 +638,7 @@ static void signal_daemon(server_conf_t *conf)
 
 static void parse_console_directive(server_conf_t *conf, Lex l)
 {
-/*  CONSOLE NAME="<str>" DEV="<file>" [LOG="<file>"]
+/*  CONSOLE NAME="<str>" DEV="<file>" [LOG="<file>"] [BUFSIZE=<int>]
  *    [LOGOPTS="<str>"] [SEROPTS="<str>"] [IPMIOPTS="<str>"] [TESTOPTS="<str>"]
  *  Note: IPMIOPTS is only available if WITH_FREEIPMI is defined.
  */
@@ -590,6 +648,7 @@ static void parse_console_directive(server_conf_t *conf, Lex l)
     int done = 0;
     char err[MAX_LINE] = "";
     console_strs_t con;
+    int n;
 
     memset(&con, 0, sizeof(con));
 
@@ -661,6 +720,26 @@ static void parse_console_directive(server_conf_t *conf, Lex l)
             }
             break;
 
+        case SERVER_CONF_BUFSIZE:
+            if (lex_next(l) != '=') {
+                snprintf(err, sizeof(err),
+                    "expected '=' after %s keyword", tokstr);
+            }
+            else if (lex_next(l) != LEX_INT) {
+                snprintf(err, sizeof(err),
+                    "expected INTEGER for %s value", tokstr);
+            }
+            else if (((n = atoi(lex_text(l))) < MIN_OBJ_BUF_SIZE)
+                    || (n > MAX_OBJ_BUF_SIZE)) {
+                snprintf(err, sizeof(err),
+                    "invalid %s value %d (range is %d-%d)",
+                    tokstr, n, MIN_OBJ_BUF_SIZE, MAX_OBJ_BUF_SIZE);
+            }
+            else {
+                con.bufSize = n;
+            }
+            break;
+
         case SERVER_CONF_LOGOPTS:
             if (lex_next(l) != '=') {
                 snprintf(err, sizeof(err),
@@ -920,6 +999,10 @@ static int process_console(server_conf_t *conf, console_strs_t *con_p,
             con_p->name, arg0);
         goto err;
     }
+    /*  A bufsize of 0 selects the server's default (cf. open_objs()).
+     */
+    console->bufSize = con_p->bufSize;
+
     if ((con_p->log && con_p->log[ 0 ] != '\0')
             || (!con_p->log && conf->globalLogName)) {
         if (con_p->log) {
@@ -942,6 +1025,12 @@ static int process_console(server_conf_t *conf, console_strs_t *con_p,
                 conf, buf, console, &logopts, errbuf, errbuflen))) {
             goto err;
         }
+        /*  Unless its data requires processing, the logfile writes out
+         *    console data from the console's fan-out ring, so its own
+         *    circular-buf only needs to hold messages.
+         */
+        logfile->bufSize = logfile->aux.logfile.gotProcessing
+            ? console->bufSize : OBJ_MSG_BUF_SIZE;
         link_objs(console, logfile);
     }
     list_destroy(args);
@@ -1125,6 +1214,26 @@ static void parse_server_directive(server_conf_t *conf, Lex l)
         tokstr = lex_tok_to_str(l, tok);
         switch(tok) {
 
+        case SERVER_CONF_BUFSIZE:
+            if (lex_next(l) != '=') {
+                snprintf(err, sizeof(err),
+                    "expected '=' after %s keyword", tokstr);
+            }
+            else if (lex_next(l) != LEX_INT) {
+                snprintf(err, sizeof(err),
+                    "expected INTEGER for %s value", tokstr);
+            }
+            else if (((n = atoi(lex_text(l))) < MIN_OBJ_BUF_SIZE)
+                    || (n > MAX_OBJ_BUF_SIZE)) {
+                snprintf(err, sizeof(err),
+                    "invalid %s value %d (range is %d-%d)",
+                    tokstr, n, MIN_OBJ_BUF_SIZE, MAX_OBJ_BUF_SIZE);
+            }
+            else {
+                conf->bufSize = n;
+            }
+            break;
+
         case SERVER_CONF_COREDUMP:
             if (lex_next(l) != '=') {
                 snprintf(err, sizeof(err),
@@ -1202,6 +1311,23 @@ static void parse_server_directive(server_conf_t *conf, Lex l)
             }
             break;
 
+        case SERVER_CONF_IOURING:
+            if (lex_next(l) != '=') {
+                snprintf(err, sizeof(err),
+                    "expected '=' after %s keyword", tokstr);
+            }
+            else if (lex_next(l) == SERVER_CONF_ON) {
+                conf->enableIOUring = 1;
+            }
+            else if (lex_prev(l) == SERVER_CONF_OFF) {
+                conf->enableIOUring = 0;
+            }
+            else {
+                snprintf(err, sizeof(err),
+                    "expected ON or OFF for %s value", tokstr);
+            }
+            break;
+
         case SERVER_CONF_KEEPALIVE:
             if (lex_next(l) != '=') {
                 snprintf(err, sizeof(err),
@@ -1273,6 +1399,26 @@ static void parse_server_directive(server_conf_t *conf, Lex l)
             }
             break;
 
+        case SERVER_CONF_LOGWRITERS:
+            if (lex_next(l) != '=') {
+                snprintf(err, sizeof(err),
+                    "expected '=' after %s keyword", tokstr);
+            }
+            else if (lex_next(l) != LEX_INT) {
+                snprintf(err, sizeof(err),
+                    "expected INTEGER for %s value", tokstr);
+            }
+            else if (((n = atoi(lex_text(l))) < 0)
+                    || (n > get_max_threads())) {
+                snprintf(err, sizeof(err),
+                    "invalid %s value %d (range is 0-%d)",
+                    tokstr, n, get_max_threads());
+            }
+            else {
+                conf->numLogWriters = n;
+            }
+            break;
+
         case SERVER_CONF_LOOPBACK:
             if (lex_next(l) != '=') {
                 snprintf(err, sizeof(err),
@@ -1305,6 +1451,23 @@ static void parse_server_directive(server_conf_t *conf, Lex l)
             }
             break;
 
+        case SERVER_CONF_OVERRUN:
+            if (lex_next(l) != '=') {
+                snprintf(err, sizeof(err),
+                    "expected '=' after %s keyword", tokstr);
+            }
+            else if ((lex_next(l) != LEX_STR)
+                    || is_empty_string(lex_text(l))) {
+                snprintf(err, sizeof(err),
+                    "expected STRING for %s value", tokstr);
+            }
+            else {
+                (void) parse_overrun_policy(lex_text(l),
+                    &conf->overrunPolicy, &conf->overrunLimit,
+                    err, sizeof(err));
+            }
+            break;
+
         case SERVER_CONF_PIDFILE:
             if (lex_next(l) != '=') {
                 snprintf(err, sizeof(err),
@@ -1345,6 +1508,24 @@ static void parse_server_directive(server_conf_t *conf, Lex l)
             }
             break;
 
+        case SERVER_CONF_READBUDGET:
+            if (lex_next(l) != '=') {
+                snprintf(err, sizeof(err),
+                    "expected '=' after %s keyword", tokstr);
+            }
+            else if (lex_next(l) != LEX_INT) {
+                snprintf(err, sizeof(err),
+                    "expected INTEGER for %s value", tokstr);
+            }
+            else if ((n = atoi(lex_text(l))) < 1) {
+                snprintf(err, sizeof(err),
+                    "invalid %s value %d", tokstr, n);
+            }
+            else {
+                conf->readBudget = n;
+            }
+            break;
+
         case SERVER_CONF_RESETCMD:
             if (lex_next(l) != '=') {
                 snprintf(err, sizeof(err),
@@ -1368,6 +1549,23 @@ static void parse_server_directive(server_conf_t *conf, Lex l)
             }
             break;
 
+        case SERVER_CONF_SPLICE:
+            if (lex_next(l) != '=') {
+                snprintf(err, sizeof(err),
+                    "expected '=' after %s keyword", tokstr);
+            }
+            else if (lex_next(l) == SERVER_CONF_ON) {
+                conf->enableSplice = 1;
+            }
+            else if (lex_prev(l) == SERVER_CONF_OFF) {
+                conf->enableSplice = 0;
+            }
+            else {
+                snprintf(err, sizeof(err),
+                    "expected ON or OFF for %s value", tokstr);
+            }
+            break;
+
         case SERVER_CONF_SYSLOG:
             if (lex_next(l) != '=') {
                 snprintf(err, sizeof(err),
@@ -1409,6 +1607,26 @@ static void parse_server_directive(server_conf_t *conf, Lex l)
 #endif /* WITH_TCP_WRAPPERS */
             break;
 
+        case SERVER_CONF_THREADS:
+            if (lex_next(l) != '=') {
+                snprintf(err, sizeof(err),
+                    "expected '=' after %s keyword", tokstr);
+            }
+            else if (lex_next(l) != LEX_INT) {
+                snprintf(err, sizeof(err),
+                    "expected INTEGER for %s value", tokstr);
+            }
+            else if (((n = atoi(lex_text(l))) < 1)
+                    || (n > get_max_threads())) {
+                snprintf(err, sizeof(err),
+                    "invalid %s value %d (range is 1-%d)",
+                    tokstr, n, get_max_threads());
+            }
+            else {
+                conf->numLoops = n;
+            }
+            break;
+
         case SERVER_CONF_TIMESTAMP:
             if (lex_next(l) != '=') {
                 snprintf(err, sizeof(err),
@@ -1574,6 +1792,21 @@ static int write_pidfile(const char *pidfile)
 }
 
 
+static int get_max_threads(void)
+{
+/*  Returns the max number of threads that can be requested for a pool,
+ *    which is a small multiple of the number of online CPUs.
+ */
+    long n;
+
+    n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) {
+        n = 1;
+    }
+    return(MIN(n, INT_MAX / MAX_THREADS_PER_CPU) * MAX_THREADS_PER_CPU);
+}
+
+
 static int lookup_syslog_priority(const char *priority)
 {
 /*  Returns the numeric id associated with the specified syslog priority,
@@ -43,8 +43,6 @@
 #include "util.h"
 #include "wrapper.h"
 
-extern tpoll_t tp_global;               /* defined in server.c */
-
 
 static void perform_serial_break(obj_t *client);
 static void perform_del_char_seq(obj_t *client);
@@ -137,13 +135,12 @@ static void perform_serial_break(obj_t *client)
 {
 /*  Transmits a serial-break to each of the consoles written to by the client.
  */
-    ListIterator i;
     obj_t *console;
+    int n;
 
     assert(is_client_obj(client));
 
-    i = list_iterator_create(client->readers);
-    while ((console = list_next(i))) {
+    for (n = 0; (console = get_obj_set(&client->readers, n)); n++) {
 
         assert(is_console_obj(console));
         DPRINTF((5, "Performing serial-break on console [%s].\n",
@@ -190,7 +187,6 @@ static void perform_serial_break(obj_t *client)
         /*  FIXME: How should serial-breaks be handled for unixsock objs?
          */
     }
-    list_iterator_destroy(i);
     return;
 }
 
@@ -201,14 +197,13 @@ static void perform_del_char_seq(obj_t *client)
  *
  *  XXX: gnats:100 del char kludge
  */
-    ListIterator i;
     obj_t *console;
+    int n;
     unsigned char del = 0x7F;
 
     assert(is_client_obj(client));
 
-    i = list_iterator_create(client->readers);
-    while ((console = list_next(i))) {
+    for (n = 0; (console = get_obj_set(&client->readers, n)); n++) {
 
         assert(is_console_obj(console));
         DPRINTF((5, "Performing DEL-char sequence on console [%s].\n",
@@ -216,7 +211,6 @@ static void perform_del_char_seq(obj_t *client)
 
         write_obj_data(console, &del, 1, 0);
     }
-    list_iterator_destroy(i);
     return;
 }
 
@@ -234,18 +228,18 @@ static void perform_console_writer_linkage(obj_t *client)
      */
     if (client->aux.client.req->enableBroadcast)
         return;
-    assert(list_count(client->readers) <= 1);
+    assert(count_obj_set(&client->readers) <= 1);
 
     /*  A R/O or R/W client will have exactly one console writer.
      */
-    assert(list_count(client->writers) == 1);
-    console = list_peek(client->writers);
+    assert(count_obj_set(&client->writers) == 1);
+    console = get_obj_set(&client->writers, 0);
     assert(is_console_obj(console));
 
     /*  A R/O client will have no readers,
      *    while a R/W client will have only one reader.
      */
-    gotWrite = list_count(client->readers);
+    gotWrite = count_obj_set(&client->readers);
 
     if (gotWrite) {
         client->aux.client.req->command = CONMAN_CMD_MONITOR;
@@ -266,30 +260,39 @@ static void perform_log_replay(obj_t *client)
  *    with this client (in either a R/O or R/W session, but not a B/C session).
  *
  *  The maximum amount of data that can be written into an object's
- *    circular-buffer via write_obj_data() is (OBJ_BUF_SIZE - 1) bytes.
+ *    circular-buffer via write_obj_data() is (bufSize - 1) bytes.
  *    But writing this much data may likely overwrite data in the buffer that
  *    has not been flushed to the object's file descriptor via write_to_obj().
- *    Therefore, it is recommended (LOG_REPLAY_LEN <= OBJ_BUF_SIZE / 2).
+ *    Therefore, the replay is bounded by half of the client's bufSize.
  */
     obj_t *console;
     obj_t *logfile;
     unsigned char buf[OBJ_BUF_SIZE - 1];
+    unsigned char * const bufLast =
+        buf + MIN((int) sizeof(buf), client->bufSize / 2);
     unsigned char *ptr = buf;
-    int len = sizeof(buf);
+    int len = bufLast - buf;
     unsigned char *p;
-    int n, m;
+    int n;
 
     assert(is_client_obj(client));
 
     /*  Broadcast sessions are "write-only", so the log-replay is a no-op.
      */
-    if (list_is_empty(client->writers))
+    if (count_obj_set(&client->writers) == 0)
         return;
 
+    /*  If the client requested a replay of a given extent, stream it
+     *    from the console's logfile on disk instead.
+     */
+    if (client->aux.client.req->replay != CONMAN_REPLAY_NONE) {
+        start_log_replay(client);
+        return;
+    }
     /*  The client will have exactly one writer in either a R/O or R/W session.
      */
-    assert(list_count(client->writers) == 1);
-    console = list_peek(client->writers);
+    assert(count_obj_set(&client->writers) == 1);
+    console = get_obj_set(&client->writers, 0);
     assert(is_console_obj(console));
     logfile = get_console_logfile_obj(console);
 
@@ -331,53 +334,65 @@ static void perform_log_replay(obj_t *client)
                 console->name, client->name);
             return;
         }
-        x_pthread_mutex_lock(&logfile->bufLock);
-
-        /*  Compute the number of bytes to replay.
-         *  If the console's circular-buffer has not yet wrapped around,
-         *    don't wrap back into uncharted buffer territory.
-         *  The result is bounded by the value of LOG_REPLAY_LEN and the
-         *    amount of buffer space remaining in 'buf'.
+        /*  The client is only connected to this console, so it runs on the
+         *    console's event loop along with the console's logfile.  As such,
+         *    the logfile's buffer and the console's fan-out ring can be read
+         *    here without further synchronization.
+         *
+         *  If the logfile writes out console data from the console's
+         *    fan-out ring, replay the most recent data from that ring.
+         *    But if console data has been spliced into the logfile past the
+         *    ring, the ring no longer holds the most recent data; that is
+         *    instead read back from the logfile itself.
          */
-        if (!logfile->gotBufWrap) {
-            n = logfile->bufInPtr - logfile->buf;
-        }
-        else {
-            n = OBJ_BUF_SIZE - 1;
-        }
-        if (n < 0) {
-            n = 0;
-        }
-        if (n > LOG_REPLAY_LEN) {
-            n = LOG_REPLAY_LEN;
+        if (logfile->fanSrc && logfile->fanSrc->fan
+                && (__atomic_load_n(&logfile->fanSrc->fan->numSpliced,
+                    __ATOMIC_RELAXED) > 0)
+                && ((n = read_logfile_tail(logfile, ptr,
+                    MIN(LOG_REPLAY_LEN, len))) >= 0)) {
+            ptr += n;
         }
-        if (n > len) {
-            n = len;
+        else if (logfile->fanSrc) {
+            n = MIN(LOG_REPLAY_LEN, len);
+            ptr += copy_obj_fan_history(logfile->fanSrc, ptr, n);
         }
+        else {
+            /*  Compute the number of bytes to replay.
+             *  If the console's circular-buffer has not yet wrapped around,
+             *    don't wrap back into uncharted buffer territory.
+             *  The result is bounded by the value of LOG_REPLAY_LEN and the
+             *    amount of buffer space remaining in 'buf'.
+             */
+            if (!logfile->gotBufWrap) {
+                n = logfile->bufInPtr - logfile->buf;
+            }
+            else {
+                n = logfile->bufSize - 1;
+            }
+            if (n < 0) {
+                n = 0;
+            }
+            if (n > LOG_REPLAY_LEN) {
+                n = LOG_REPLAY_LEN;
+            }
+            if (n > len) {
+                n = len;
+            }
 
-        p = logfile->bufInPtr - n;
-        if (p >= logfile->buf) {        /* no wrap needed */
-            assert(n > 0);
+            /*  The logfile's buffer is a vring, so the data preceding the
+             *    input ptr is contiguous when read from the buffer's mirror.
+             */
+            p = logfile->bufInPtr - n;
+            if (p < logfile->buf) {
+                p += logfile->bufSize;
+            }
             memcpy(ptr, p, n);
             ptr += n;
         }
-        else {                          /* wrap backwards */
-            m = logfile->buf - p;
-            assert(m > 0);
-            assert(m <= n);
-            p = &logfile->buf[OBJ_BUF_SIZE] - m;
-            memcpy(ptr, p, m);
-            ptr += m;
-            n -= m;
-            memcpy(ptr, logfile->buf, n);
-            ptr += n;
-        }
-
-        x_pthread_mutex_unlock(&logfile->bufLock);
 
         /*  Recompute 'len' since space was already reserved for it above.
          */
-        len = &buf[sizeof(buf)] - ptr;
+        len = bufLast - ptr;
         assert(len > 0);
         n = snprintf((char *) ptr, len, "%sEnd log replay of console [%s]%s",
             CONMAN_MSG_PREFIX, console->name, CONMAN_MSG_SUFFIX);
@@ -426,8 +441,8 @@ static void perform_reset(obj_t *client)
 /*  Resets all consoles for which this client has write-access.
  */
     int dev_null;
-    ListIterator i;
     obj_t *console;
+    int n;
     char cmd[MAX_LINE];
 
     assert(is_client_obj(client));
@@ -439,8 +454,7 @@ static void perform_reset(obj_t *client)
             strerror(errno));
     }
 
-    i = list_iterator_create(client->readers);
-    while ((console = list_next(i))) {
+    for (n = 0; (console = get_obj_set(&client->readers, n)); n++) {
 
         assert(is_console_obj(console));
 
@@ -498,7 +512,7 @@ static void perform_reset(obj_t *client)
 
         /*  Set a timer to ensure the reset cmd does not exceed its time limit.
          */
-        console->resetCmdTimer = tpoll_timeout_relative(tp_global,
+        console->resetCmdTimer = tpoll_timeout_relative(console->loop->tp,
             (callback_f) kill_reset_cmd, console, RESET_CMD_TIMEOUT * 1000);
         if (console->resetCmdTimer < 0) {
             write_notify_msg(console, LOG_WARNING,
@@ -506,7 +520,6 @@ static void perform_reset(obj_t *client)
                 console->name, strerror(errno));
         }
     }
-    list_iterator_destroy(i);
 
     if ((dev_null >= 0) && (close(dev_null) < 0)) {
         log_msg(LOG_WARNING,
@@ -562,10 +575,10 @@ static void perform_suspend(obj_t *client)
     client->aux.client.gotSuspend ^= 1;
 
     if (client->aux.client.gotSuspend) {
-        tpoll_clear(tp_global, client->fd, POLLOUT);
+        tpoll_clear(client->loop->tp, client->fd, POLLOUT);
     }
     else {
-        tpoll_set(tp_global, client->fd, POLLOUT);
+        tpoll_set(client->loop->tp, client->fd, POLLOUT);
     }
 
     /*  FIXME: Do check_console_state() here looking for downed telnets.
@@ -27,21 +27,131 @@
 #endif /* HAVE_CONFIG_H */
 
 #include <assert.h>
+#include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+#if WITH_ZLIB
+#  include <zlib.h>
+#endif /* WITH_ZLIB */
 #include "common.h"
 #include "log.h"
 #include "server.h"
 #include "tpoll.h"
 #include "util-file.h"
 #include "util-str.h"
+#include "util.h"
+#include "wrapper.h"
 
-extern tpoll_t tp_global;               /* defined in server.c */
+
+/*  A block of data (following the struct) queued for a logfile writer thread.
+ *  A block with a negative length closes the logfile fd instead; the logfile's
+ *    name follows it for reporting the writer stats of that fd.
+ */
+typedef struct log_block {
+    struct log_block *next;             /* next block in the writer's queue  */
+    obj_t            *logfile;          /* logfile obj being written         */
+    int               fd;               /* logfile fd when block was queued  */
+    int               indexFd;          /* index fd when queued, or -1       */
+    unsigned          gen;              /* logfile writeGen when queued      */
+    int               len;              /* num bytes of data, or -1 to close */
+} log_block_t;
+
+#define LOG_WRITER_MAX_IOVS             64
+
+#define LOG_REPLAY_WAIT_MSECS           10
+
+/*  The state of a log replay being streamed from disk to a client
+ *    (cf. start_log_replay()), which is only accessed by the client's loop.
+ *  The replay ends at the end of the logfile as of when it began;
+ *    console data received afterwards reaches the client as usual.
+ */
+typedef struct log_replay {
+    obj_t            *console;          /* console whose log is replayed     */
+    obj_t            *logfile;          /* console's logfile, or NULL        */
+    replay_t          type;             /* type of replay requested          */
+    long              arg;              /* num bytes/lines, or time in secs  */
+    int               fd;               /* logfile fd opened for replay      */
+    int               timer;            /* timer id awaiting writer, or -1   */
+    int               isStarted;        /* true once the replay has begun    */
+    int               isOpened;         /* true once the logfile is opened   */
+    int               isSeeking;        /* true while seeking back by lines  */
+    int               isZip;            /* true if logfile is compressed     */
+    off_t             pos;              /* logfile offset of next read       */
+    off_t             end;              /* logfile offset at which to stop   */
+    uint64_t          target;           /* logfile size preceding client data*/
+    long              numLines;         /* num lines left to seek back       */
+#if WITH_ZLIB
+    z_stream          z;                /* inflate stream for compressed log */
+#endif /* WITH_ZLIB */
+    unsigned char     buf[65536];       /* buffer for seeking/inflating      */
+} log_replay_t;
+
+#if WITH_ZLIB
+/*  The compression state of a logfile, which is only accessed by the logfile's
+ *    writer thread.  Each frame of compressed data is written as a separate
+ *    gzip member so it can be decompressed independently of the others; its
+ *    header records the time at which it was started.
+ */
+typedef struct log_zip {
+    z_stream          z;                /* deflate stream for current frame  */
+    gz_header         header;           /* gzip header for current frame     */
+    int               fd;               /* logfile fd of current frame       */
+    int               isOpen;           /* true if a frame is in progress    */
+    time_t            frameEnd;         /* time at which the frame ends      */
+    unsigned char     out[65536];       /* buffer for compressed data        */
+} log_zip_t;
+#endif /* WITH_ZLIB */
+
+
+static int is_splice_logfile_obj(obj_t *logfile);
+static void * log_writer_thread(log_writer_t *writer);
+static void write_log_blocks(log_writer_t *writer, log_block_t **headp);
+static void close_log_block(log_writer_t *writer, log_block_t *block);
+static void append_log_block(obj_t *logfile, log_block_t *block);
+static void resume_log_writes(obj_t *logfile);
+static uint64_t get_msecs(void);
+static int parse_log_flush(logopt_t *opts, const char *str,
+    char *errbuf, int errlen);
+static int sync_log_fd(int fd);
+static int parse_log_compress(logopt_t *opts, const char *str,
+    char *errbuf, int errlen);
+static int parse_log_interval(int *secsp, const char *opt, const char *str,
+    char *errbuf, int errlen);
+static int parse_log_maxsize(logopt_t *opts, const char *str,
+    char *errbuf, int errlen);
+static int parse_log_keep(logopt_t *opts, const char *str,
+    char *errbuf, int errlen);
+static void rotate_logfile_obj(obj_t *logfile);
+static int get_log_path(char *dst, size_t dstlen, const char *name,
+    int n, int isIndex);
+static int open_log_index(obj_t *logfile, int isNew);
+static int write_log_index(int fd, time_t t, uint64_t offset);
+static int open_log_replay(log_replay_t *replay, obj_t *client,
+    char *errbuf, int errlen);
+static int is_log_replay_pending(log_replay_t *replay);
+static int locate_log_replay(log_replay_t *replay, char *errbuf, int errlen);
+static int seek_log_replay_time(log_replay_t *replay, off_t *posp);
+static void seek_log_replay_lines(log_replay_t *replay);
+static int read_log_replay_data(log_replay_t *replay,
+    unsigned char *dst, int len);
+static void wait_log_replay(obj_t *client);
+static void resume_log_replay(obj_t *client);
+#if WITH_ZLIB
+static int write_log_zip(obj_t *logfile, int fd, int indexFd,
+    struct iovec *iov, int iovcnt, int *np);
+static void close_log_zip(obj_t *logfile, int fd);
+static int deflate_log_zip(log_zip_t *zip, int flush, int *np);
+#endif /* WITH_ZLIB */
 
 
 int parse_logfile_opts(logopt_t *opts, const char *str,
@@ -50,6 +160,8 @@ int parse_logfile_opts(logopt_t *opts, const char *str,
 /*  Parses 'str' for logfile device options 'opts'.
  *    The 'opts' struct should be initialized to a default value.
  *    The 'str' string is of the form "(sanitize|nosanitize)".
+ *    The "flush=" token may be given more than once (eg, "flush=64k,flush=5s")
+ *    since it sets either the batch size or the interval (cf. parse_log_flush).
  *  Returns 0 and updates the 'opts' struct on success; o/w, returns -1
  *    (writing an error message into 'errbuf' if defined).
  */
@@ -93,6 +205,48 @@ int parse_logfile_opts(logopt_t *opts, const char *str,
             optsTmp.enableTimestamp = 1;
         else if (!strcasecmp(tok, "notimestamp"))
             optsTmp.enableTimestamp = 0;
+        else if (!strcasecmp(tok, "sync"))
+            optsTmp.enableSync = 1;
+        else if (!strcasecmp(tok, "nosync"))
+            optsTmp.enableSync = 0;
+        else if (!strcasecmp(tok, "noflush"))
+            optsTmp.flushBytes = optsTmp.flushMsecs = 0;
+        else if (!strncasecmp(tok, "flush=", 6)) {
+            if (parse_log_flush(&optsTmp, tok + 6, errbuf, errlen) < 0)
+                return(-1);
+        }
+        else if (!strcasecmp(tok, "nocompress"))
+            optsTmp.compress = CONMAN_LOG_COMPRESS_NONE;
+        else if (!strncasecmp(tok, "compress=", 9)) {
+            if (parse_log_compress(&optsTmp, tok + 9, errbuf, errlen) < 0)
+                return(-1);
+        }
+        else if (!strncasecmp(tok, "frame=", 6)) {
+            if (parse_log_interval(&optsTmp.frameSecs, "frame", tok + 6,
+                    errbuf, errlen) < 0)
+                return(-1);
+        }
+        else if (!strcasecmp(tok, "index")) {
+            if (optsTmp.indexSecs == 0)
+                optsTmp.indexSecs = DEFAULT_LOG_INDEX_SECS;
+        }
+        else if (!strcasecmp(tok, "noindex"))
+            optsTmp.indexSecs = 0;
+        else if (!strncasecmp(tok, "index=", 6)) {
+            if (parse_log_interval(&optsTmp.indexSecs, "index", tok + 6,
+                    errbuf, errlen) < 0)
+                return(-1);
+        }
+        else if (!strcasecmp(tok, "nomaxsize"))
+            optsTmp.maxSize = 0;
+        else if (!strncasecmp(tok, "maxsize=", 8)) {
+            if (parse_log_maxsize(&optsTmp, tok + 8, errbuf, errlen) < 0)
+                return(-1);
+        }
+        else if (!strncasecmp(tok, "keep=", 5)) {
+            if (parse_log_keep(&optsTmp, tok + 5, errbuf, errlen) < 0)
+                return(-1);
+        }
         else {
             log_msg(LOG_WARNING, "ignoring unrecognized token '%s'", tok);
         }
@@ -160,6 +314,28 @@ obj_t * create_logfile_obj(server_conf_t *conf, char *name,
     logfile->aux.logfile.lineState = CONMAN_LOG_LINE_INIT;
     logfile->aux.logfile.opts = *opts;
     logfile->aux.logfile.gotTruncate = !!conf->enableZeroLogs;
+    logfile->aux.logfile.gotSplice = 0;
+    logfile->aux.logfile.pipeFds[0] = -1;
+    logfile->aux.logfile.pipeFds[1] = -1;
+    logfile->aux.logfile.writer = NULL;
+    logfile->aux.logfile.zip = NULL;
+    logfile->aux.logfile.numQueued = 0;
+    logfile->aux.logfile.numPending = 0;
+    logfile->aux.logfile.maxQueued = 0;
+    logfile->aux.logfile.isStalled = 0;
+    logfile->aux.logfile.writeErrno = 0;
+    logfile->aux.logfile.writeGen = 0;
+    logfile->aux.logfile.numWrites = 0;
+    logfile->aux.logfile.numStalls = 0;
+    logfile->aux.logfile.maxWriteMsecs = 0;
+    logfile->aux.logfile.numBytesWritten = 0;
+    logfile->aux.logfile.flushTimer = -1;
+    logfile->aux.logfile.size = 0;
+    logfile->aux.logfile.indexFd = -1;
+    logfile->aux.logfile.indexNext = 0;
+    logfile->aux.logfile.gotFlushDue = 0;
+    logfile->aux.logfile.gotUnsynced = 0;
+    logfile->aux.logfile.gotRotateDue = 0;
 
     if (logfile->aux.logfile.opts.enableSanitize
             || logfile->aux.logfile.opts.enableTimestamp) {
@@ -228,6 +404,9 @@ int open_logfile_obj(obj_t *logfile)
  */
     char  dirname[PATH_MAX];
     int   flags;
+    int   fval;
+    int   gotSplice;
+    struct stat st;
     char *now;
     char *msg;
 
@@ -239,11 +418,16 @@ int open_logfile_obj(obj_t *logfile)
     assert(logfile->aux.logfile.console->name != NULL);
 
     if (logfile->fd >= 0) {
-        tpoll_clear(tp_global, logfile->fd, POLLOUT);
-        if (close(logfile->fd) < 0)
+        tpoll_clear(logfile->loop->tp, logfile->fd, POLLOUT);
+        if (logfile->aux.logfile.writer) {
+            queue_log_close(logfile);
+        }
+        else if (close(logfile->fd) < 0) {
             log_msg(LOG_WARNING, "Unable to close logfile \"%s\": %s",
                 logfile->name, strerror(errno));
+        }
         logfile->fd = -1;
+        close_logfile_index(logfile);
     }
     /*  Perform conversion specifier expansion.
      */
@@ -269,8 +453,14 @@ int open_logfile_obj(obj_t *logfile)
         (void) create_dirs(dirname);
     }
     /*  Only truncate on the initial open if ZeroLogs was enabled.
+     *  The kernel refuses to splice into a file opened for appending,
+     *    so a spliced logfile is instead positioned at its end once opened.
      */
-    flags = O_WRONLY | O_CREAT | O_APPEND | O_NONBLOCK;
+    gotSplice = is_splice_logfile_obj(logfile);
+    flags = O_WRONLY | O_CREAT | O_NONBLOCK;
+    if (!gotSplice) {
+        flags |= O_APPEND;
+    }
     if (logfile->aux.logfile.gotTruncate) {
         logfile->aux.logfile.gotTruncate = 0;
         flags |= O_TRUNC;
@@ -280,6 +470,14 @@ int open_logfile_obj(obj_t *logfile)
             logfile->name, strerror(errno));
         return(-1);
     }
+    if (gotSplice && !(flags & O_TRUNC)
+            && (lseek(logfile->fd, 0, SEEK_END) < 0)) {
+        log_msg(LOG_WARNING, "Unable to seek logfile \"%s\": %s",
+            logfile->name, strerror(errno));
+        (void) close(logfile->fd);
+        logfile->fd = -1;
+        return(-1);
+    }
     if (logfile->aux.logfile.opts.enableLock
             && (get_write_lock(logfile->fd) < 0)) {
         log_msg(LOG_WARNING, "Unable to lock \"%s\"", logfile->name);
@@ -287,10 +485,47 @@ int open_logfile_obj(obj_t *logfile)
         logfile->fd = -1;
         return(-1);
     }
+    /*  The size of the file is tracked in order to rotate it at "maxsize".
+     *  Since a compressed logfile's size is counted in bytes of its output
+     *    before compression (cf. count_logfile_bytes()), and that of any
+     *    existing data cannot be determined without inflating it, the count
+     *    for a compressed logfile starts at 0 when it is opened.
+     */
+    logfile->aux.logfile.size = 0;
+    if (fstat(logfile->fd, &st) < 0) {
+        st.st_size = 0;
+    }
+    if (logfile->aux.logfile.opts.compress == CONMAN_LOG_COMPRESS_NONE) {
+        logfile->aux.logfile.size = st.st_size;
+    }
+    if (logfile->aux.logfile.opts.indexSecs > 0) {
+        (void) open_log_index(logfile, st.st_size == 0);
+    }
     logfile->gotEOF = 0;
     set_fd_nonblocking(logfile->fd);    /* redundant, just playing it safe */
     set_fd_closed_on_exec(logfile->fd);
 
+    if (gotSplice && (logfile->aux.logfile.pipeFds[0] < 0)) {
+        if (pipe(logfile->aux.logfile.pipeFds) < 0) {
+            log_msg(LOG_WARNING,
+                "Unable to create pipe for splicing logfile \"%s\": %s",
+                logfile->name, strerror(errno));
+            logfile->aux.logfile.pipeFds[0] = -1;
+            logfile->aux.logfile.pipeFds[1] = -1;
+            gotSplice = 0;
+            if ((fval = fcntl(logfile->fd, F_GETFL, 0)) >= 0) {
+                (void) fcntl(logfile->fd, F_SETFL, fval | O_APPEND);
+            }
+        }
+        else {
+            set_fd_nonblocking(logfile->aux.logfile.pipeFds[0]);
+            set_fd_nonblocking(logfile->aux.logfile.pipeFds[1]);
+            set_fd_closed_on_exec(logfile->aux.logfile.pipeFds[0]);
+            set_fd_closed_on_exec(logfile->aux.logfile.pipeFds[1]);
+        }
+    }
+    logfile->aux.logfile.gotSplice = gotSplice;
+
     now = create_long_time_string(0);
     msg = create_format_string("%sConsole [%s] log opened at %s%s",
         CONMAN_MSG_PREFIX, logfile->aux.logfile.console->name, now,
@@ -370,11 +605,13 @@ int write_log_data(obj_t *log, const void *src, int len)
     unsigned char buf[OBJ_BUF_SIZE - 1];
     const unsigned char *p;
     unsigned char *q;
-    const unsigned char * const qLast = buf + sizeof(buf);
+    const unsigned char * const qLast =
+        buf + MIN((int) sizeof(buf), log->bufSize / 2);
     int n = 0;
+    int m;
 
     assert(is_logfile_obj(log));
-    assert(sizeof(buf) >= (size_t) minbuf);
+    assert(qLast - buf >= minbuf);
 
     /*  If no additional processing is needed, listen to Biff Tannen:
      *    "make like a tree and get outta here".
@@ -387,7 +624,25 @@ int write_log_data(obj_t *log, const void *src, int len)
 
     for (p=src, q=buf; len>0; p++, len--) {
         /*
-         *  A newline state machine is used to properly sanitize CR/LF line
+         *  Within a line, a run of printable ASCII chars is written unchanged
+         *    (whether or not the log is sanitized), so the run is located via
+         *    a vectorized scan and copied in bulk.  The run is limited so
+         *    the buffer retains room (minbuf) for processing the char ending
+         *    the run below.
+         */
+        if (log->aux.logfile.lineState == CONMAN_LOG_LINE_DATA) {
+            m = span_printable_string(p, MIN(len, (qLast - q) - minbuf));
+            if (m > 0) {
+                memcpy(q, p, m);
+                q += m;
+                p += m;
+                len -= m;
+                if (len == 0) {
+                    break;
+                }
+            }
+        }
+        /*  A newline state machine is used to properly sanitize CR/LF line
          *    terminations.  This is responsible for coalescing multiple CRs,
          *    swapping LF/CR to CR/LF, transcribing CR/NUL to CR/LF,
          *    prepending a CR to a lonely LF, and appending a LF to a
@@ -454,7 +709,10 @@ int write_log_data(obj_t *log, const void *src, int len)
                 *q++ = *p;
             }
         }
-        /*  Flush internal buffer before it overruns.
+        /*  Flush internal buffer before it overruns.  Each flush is bounded
+         *    by half of the logfile's bufSize (as with a log replay) so it
+         *    cannot overwrite data in the logfile's circular-buf that has
+         *    not yet been written out.
          */
         if ((qLast - q) < minbuf) {
             assert((q >= buf) && (q <= qLast));
@@ -466,3 +724,1815 @@ int write_log_data(obj_t *log, const void *src, int len)
     n += write_obj_data(log, buf, q - buf, 0);
     return(n);
 }
+
+
+int read_logfile_tail(obj_t *logfile, unsigned char *dst, int len)
+{
+/*  Reads up to the last (len) bytes of the (logfile) from disk into (dst).
+ *  This is used to replay console output that was spliced into the logfile
+ *    without passing through the console's circular-buffer.
+ *  Returns the number of bytes read, or -1 on error.
+ */
+    int fd;
+    struct stat st;
+    off_t off;
+    ssize_t n;
+    int nread = 0;
+
+    assert(is_logfile_obj(logfile));
+    assert(dst != NULL);
+    assert(len >= 0);
+
+    if ((fd = open(logfile->name, O_RDONLY)) < 0) {
+        return(-1);
+    }
+    if (fstat(fd, &st) < 0) {
+        (void) close(fd);
+        return(-1);
+    }
+    off = (st.st_size > len) ? st.st_size - len : 0;
+    while (nread < len) {
+        n = pread(fd, dst + nread, len - nread, off + nread);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            (void) close(fd);
+            return(-1);
+        }
+        if (n == 0) {
+            break;
+        }
+        nread += n;
+    }
+    (void) close(fd);
+    return(nread);
+}
+
+
+void start_log_replay(obj_t *client)
+{
+/*  Starts streaming the log of the console connected to the (client) in a
+ *    R/O or R/W session from disk, as specified by the replay requested by
+ *    the client (cf. parse_replay_spec()).  Any replay already in progress
+ *    is restarted.  Unlike the in-memory replay of the last LOG_REPLAY_LEN
+ *    bytes, this is not bounded by the size of the client's buffer: the
+ *    logfile is read a chunk at a time as the client's buffer is emptied
+ *    (cf. begin_write_to_obj()).  The logfile is not opened until then so
+ *    this can be called before the client has been started by its loop.
+ */
+    log_replay_t *replay;
+    obj_t *console;
+
+    assert(is_client_obj(client));
+    assert(client->aux.client.req != NULL);
+    assert(client->aux.client.req->replay != CONMAN_REPLAY_NONE);
+
+    /*  Broadcast sessions are "write-only", so the log-replay is a no-op.
+     */
+    if (count_obj_set(&client->writers) == 0) {
+        return;
+    }
+    assert(count_obj_set(&client->writers) == 1);
+    console = get_obj_set(&client->writers, 0);
+    assert(is_console_obj(console));
+
+    stop_log_replay(client);
+
+    if (!(replay = malloc(sizeof(log_replay_t)))) {
+        out_of_memory();
+    }
+    memset(replay, 0, sizeof(*replay));
+    replay->console = console;
+    replay->logfile = get_console_logfile_obj(console);
+    replay->type = client->aux.client.req->replay;
+    replay->arg = client->aux.client.req->replayArg;
+    replay->fd = -1;
+    replay->timer = -1;
+    client->aux.client.replay = replay;
+
+    DPRINTF((5, "Starting log replay of console [%s] for <%s>.\n",
+        console->name, client->name));
+
+    if ((client->fd >= 0) && !client->aux.client.gotSuspend) {
+        tpoll_set(client->loop->tp, client->fd, POLLOUT);
+    }
+    return;
+}
+
+
+int read_log_replay(obj_t *client, unsigned char *dst, int len)
+{
+/*  Reads up to (len) bytes of the log replay in progress for the (client)
+ *    into (dst), starting with a message marking the beginning of the replay
+ *    and ending with a message marking its end; the replay is then stopped.
+ *  The replay does not begin until the data received by the logfile ahead of
+ *    the client's connection has been written out (cf. open_log_replay()).
+ *    In the meantime, POLLOUT is cleared for the client and set again once
+ *    the logfile has had time to write it out.
+ *  Must be called by the thread running the client's event loop.
+ *  Returns the number of bytes read, or 0 if none are available yet.
+ */
+    log_replay_t *replay;
+    char errbuf[256];
+    int n;
+
+    assert(is_client_obj(client));
+    assert(client->aux.client.replay != NULL);
+    assert(dst != NULL);
+    assert(len > 0);
+
+    replay = client->aux.client.replay;
+
+    if (!replay->isStarted) {
+        if (!replay->logfile) {
+            n = snprintf((char *) dst, len,
+                "%sConsole [%s] is not being logged -- cannot replay%s",
+                CONMAN_MSG_PREFIX, replay->console->name, CONMAN_MSG_SUFFIX);
+            stop_log_replay(client);
+            return(((n < 0) || (n >= len)) ? len - 1 : n);
+        }
+        if (!replay->isOpened
+                && (open_log_replay(replay, client, errbuf,
+                    sizeof(errbuf)) < 0)) {
+            goto err;
+        }
+        if (is_log_replay_pending(replay)) {
+            wait_log_replay(client);
+            return(0);
+        }
+        replay->isStarted = 1;
+        if (locate_log_replay(replay, errbuf, sizeof(errbuf)) < 0) {
+            goto err;
+        }
+        n = snprintf((char *) dst, len,
+            "%sBegin log replay of console [%s]%s",
+            CONMAN_MSG_PREFIX, replay->console->name, CONMAN_MSG_SUFFIX);
+        return(((n < 0) || (n >= len)) ? len - 1 : n);
+    }
+    if (replay->isSeeking) {
+        seek_log_replay_lines(replay);
+        return(0);
+    }
+    if ((n = read_log_replay_data(replay, dst, len)) > 0) {
+        return(n);
+    }
+    n = snprintf((char *) dst, len, "%sEnd log replay of console [%s]%s",
+        CONMAN_MSG_PREFIX, replay->console->name, CONMAN_MSG_SUFFIX);
+    stop_log_replay(client);
+    return(((n < 0) || (n >= len)) ? len - 1 : n);
+
+err:
+    n = snprintf((char *) dst, len, "%sUnable to replay console [%s] log: %s%s",
+        CONMAN_MSG_PREFIX, replay->console->name, errbuf, CONMAN_MSG_SUFFIX);
+    stop_log_replay(client);
+    return(((n < 0) || (n >= len)) ? len - 1 : n);
+}
+
+
+void stop_log_replay(obj_t *client)
+{
+/*  Stops the log replay in progress (if any) for the (client).
+ *  Must be called by the thread running the client's event loop
+ *    (or before the client has been started by it).
+ */
+    log_replay_t *replay;
+
+    assert(is_client_obj(client));
+
+    if (!(replay = client->aux.client.replay)) {
+        return;
+    }
+    if (replay->timer >= 0) {
+        (void) tpoll_timeout_cancel(client->loop->tp, replay->timer);
+    }
+    if ((replay->fd >= 0) && (close(replay->fd) < 0)) {
+        log_msg(LOG_WARNING, "Unable to close console [%s] log replay: %s",
+            replay->console->name, strerror(errno));
+    }
+#if WITH_ZLIB
+    if (replay->isZip) {
+        (void) inflateEnd(&replay->z);
+    }
+#endif /* WITH_ZLIB */
+    free(replay);
+    client->aux.client.replay = NULL;
+    return;
+}
+
+
+static int open_log_replay(log_replay_t *replay, obj_t *client,
+    char *errbuf, int errlen)
+{
+/*  Opens the logfile of the (replay) for the (client).  Replaying the last
+ *    bytes or lines requires the logfile to be uncompressed.  Replaying
+ *    everything since a given time requires the logfile to have a time index,
+ *    unless the time is 0.
+ *  The data received by the logfile ahead of that pending for the client may
+ *    not have been written out yet, whether it is deferred by the "flush"
+ *    logopt or queued for the logfile's writer thread (and compressed by it).
+ *    The size the logfile will have reached once it has been written out is
+ *    noted so the replay can wait for it (cf. is_log_replay_pending()), and
+ *    any deferred data is written out without waiting for its flush interval.
+ *  Returns 0 on success, or -1 on error (writing the reason into errbuf).
+ */
+    obj_t *logfile = replay->logfile;
+
+    assert(is_logfile_obj(logfile));
+    assert(!replay->isOpened);
+
+    replay->isOpened = 1;
+
+    if ((logfile->aux.logfile.opts.compress != CONMAN_LOG_COMPRESS_NONE)
+            && (replay->type != CONMAN_REPLAY_TIME)) {
+        snprintf(errbuf, errlen,
+            "compressed logs can only be replayed since a given time");
+        return(-1);
+    }
+    if ((replay->type == CONMAN_REPLAY_TIME) && (replay->arg > 0)
+            && (logfile->aux.logfile.opts.indexSecs == 0)) {
+        snprintf(errbuf, errlen, "log does not have a time index");
+        return(-1);
+    }
+    if ((replay->fd = open(logfile->name, O_RDONLY)) < 0) {
+        snprintf(errbuf, errlen, "%s", strerror(errno));
+        return(-1);
+    }
+    set_fd_closed_on_exec(replay->fd);
+
+    replay->target = get_logfile_obj_end(logfile, client);
+    expedite_obj_flush(logfile);
+
+#if WITH_ZLIB
+    if (logfile->aux.logfile.opts.compress != CONMAN_LOG_COMPRESS_NONE) {
+        /*
+         *  Each frame of the compressed logfile is a separate gzip member
+         *    (cf. write_log_zip()), and the time index locates the member
+         *    started at or before the given time.
+         */
+        if (inflateInit2(&replay->z, MAX_WBITS + 16) != Z_OK) {
+            snprintf(errbuf, errlen, "unable to initialize decompression");
+            return(-1);
+        }
+        replay->isZip = 1;
+    }
+#endif /* WITH_ZLIB */
+
+    return(0);
+}
+
+
+static int is_log_replay_pending(log_replay_t *replay)
+{
+/*  Checks whether the logfile of the (replay) has yet to write out the data
+ *    preceding that pending for the client (cf. open_log_replay()).  Data is
+ *    counted towards the logfile's size when queued for its writer thread,
+ *    so the data still queued is not yet written out.  Once the logfile has
+ *    been closed or reopened (eg, rotated), the file being replayed will not
+ *    be written to again.
+ *  Returns true if the replay must wait for the logfile; o/w, returns false.
+ */
+    obj_t *logfile = replay->logfile;
+    log_writer_t *writer;
+    struct stat st;
+    struct stat stReplay;
+    uint64_t size;
+
+    if ((logfile->fd < 0)
+            || (fstat(logfile->fd, &st) < 0)
+            || (fstat(replay->fd, &stReplay) < 0)
+            || (st.st_dev != stReplay.st_dev)
+            || (st.st_ino != stReplay.st_ino)) {
+        return(0);
+    }
+    size = logfile->aux.logfile.size;
+    if ((writer = logfile->aux.logfile.writer)) {
+        x_pthread_mutex_lock(&writer->lock);
+        size -= MIN(size, (uint64_t) logfile->aux.logfile.numQueued);
+        x_pthread_mutex_unlock(&writer->lock);
+    }
+    return(size < replay->target);
+}
+
+
+static int locate_log_replay(log_replay_t *replay, char *errbuf, int errlen)
+{
+/*  Determines the range of data of the (replay) once the logfile has written
+ *    out the data preceding that pending for the client.
+ *  Returns 0 on success, or -1 on error (writing the reason into errbuf).
+ */
+    obj_t *logfile = replay->logfile;
+    struct stat st;
+    off_t pos;
+
+    /*  An uncompressed logfile's size is its offset, so its replay ends where
+     *    the data pending for the client begins.  A compressed logfile's size
+     *    counts its data before compression, so its replay ends at the size
+     *    of the file on disk.
+     */
+    if (fstat(replay->fd, &st) < 0) {
+        snprintf(errbuf, errlen, "%s", strerror(errno));
+        return(-1);
+    }
+    replay->end = st.st_size;
+    if ((logfile->aux.logfile.opts.compress == CONMAN_LOG_COMPRESS_NONE)
+            && (replay->target < (uint64_t) st.st_size)) {
+        replay->end = replay->target;
+    }
+
+    switch (replay->type) {
+    case CONMAN_REPLAY_BYTES:
+        replay->pos = (replay->end > replay->arg)
+            ? replay->end - replay->arg : 0;
+        break;
+    case CONMAN_REPLAY_LINES:
+        replay->pos = replay->end;
+        replay->numLines = replay->arg;
+        replay->isSeeking = 1;
+        break;
+    case CONMAN_REPLAY_TIME:
+        pos = 0;
+        if ((replay->arg > 0) && (seek_log_replay_time(replay, &pos) < 0)) {
+            snprintf(errbuf, errlen, "unable to read time index: %s",
+                strerror(errno));
+            return(-1);
+        }
+        replay->pos = MIN(pos, replay->end);
+        break;
+    default:
+        snprintf(errbuf, errlen, "invalid replay type=%d", replay->type);
+        return(-1);
+    }
+
+    DPRINTF((10, "Replaying console [%s] log from offset %lld to %lld.\n",
+        replay->console->name, (long long) replay->pos,
+        (long long) replay->end));
+    return(0);
+}
+
+
+static int seek_log_replay_time(log_replay_t *replay, off_t *posp)
+{
+/*  Searches the time index of the logfile of the (replay) for the last
+ *    record whose time is at or before the time to replay since, storing
+ *    its logfile offset in (posp).  Since each record is the offset of the
+ *    first data written at or after its time, no data received since the
+ *    time to replay since precedes this offset.  If there is no such record,
+ *    (posp) is left unchanged.
+ *  Returns 0 on success, or -1 on error (with errno set).
+ */
+    char name[PATH_MAX];
+    char buf[LOG_INDEX_RECORD_LEN + 1];
+    struct stat st;
+    unsigned long t;
+    unsigned long long offset;
+    off_t lo, hi, mid;
+    ssize_t n;
+    int fd;
+
+    if (get_log_path(name, sizeof(name), replay->logfile->name, 0, 1) < 0) {
+        errno = ENAMETOOLONG;
+        return(-1);
+    }
+    if ((fd = open(name, O_RDONLY)) < 0) {
+        return(-1);
+    }
+    if (fstat(fd, &st) < 0) {
+        (void) close(fd);
+        return(-1);
+    }
+    /*  Invariant: records before 'lo' are at or before the time,
+     *    and records at or after 'hi' are after it.
+     */
+    lo = 0;
+    hi = st.st_size / LOG_INDEX_RECORD_LEN;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        do {
+            n = pread(fd, buf, LOG_INDEX_RECORD_LEN,
+                mid * LOG_INDEX_RECORD_LEN);
+        } while ((n < 0) && (errno == EINTR));
+
+        if (n != LOG_INDEX_RECORD_LEN) {
+            (void) close(fd);
+            if (n >= 0) {
+                errno = EIO;
+            }
+            return(-1);
+        }
+        buf[LOG_INDEX_RECORD_LEN] = '\0';
+        if (sscanf(buf, "%lu %llu", &t, &offset) != 2) {
+            (void) close(fd);
+            errno = EINVAL;
+            return(-1);
+        }
+        if (t <= (unsigned long) replay->arg) {
+            *posp = (off_t) offset;
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    (void) close(fd);
+    return(0);
+}
+
+
+static void seek_log_replay_lines(log_replay_t *replay)
+{
+/*  Seeks the logfile of the (replay) back by another chunk towards the start
+ *    of the last lines to be replayed.  A newline ending the logfile ends
+ *    the last line rather than starting a new one.
+ *  Seeking a chunk at a time keeps a replay of many lines from stalling
+ *    the client's loop; the seek ends once the lines have been found,
+ *    the start of the logfile has been reached, or the logfile cannot
+ *    be read (in which case everything after the chunk is replayed).
+ */
+    off_t off;
+    ssize_t n;
+    unsigned char *p;
+
+    assert(replay->isSeeking);
+
+    off = (replay->pos > (off_t) sizeof(replay->buf))
+        ? replay->pos - (off_t) sizeof(replay->buf) : 0;
+    do {
+        n = pread(replay->fd, replay->buf, replay->pos - off, off);
+    } while ((n < 0) && (errno == EINTR));
+
+    if (n < replay->pos - off) {
+        if (n < 0) {
+            log_msg(LOG_WARNING, "Unable to read console [%s] log: %s",
+                replay->console->name, strerror(errno));
+        }
+        replay->isSeeking = 0;
+        return;
+    }
+    for (p = replay->buf + n - 1; p >= replay->buf; p--) {
+        if ((*p == '\n') && (off + (p - replay->buf) != replay->end - 1)
+                && (--replay->numLines == 0)) {
+            replay->pos = off + (p - replay->buf) + 1;
+            replay->isSeeking = 0;
+            return;
+        }
+    }
+    replay->pos = off;
+    if (off == 0) {
+        replay->isSeeking = 0;
+    }
+    return;
+}
+
+
+static int read_log_replay_data(log_replay_t *replay,
+    unsigned char *dst, int len)
+{
+/*  Reads up to (len) bytes of the logfile data of the (replay) into (dst),
+ *    decompressing it if necessary.
+ *  Returns the number of bytes read, or 0 once the replay has ended.
+ */
+    ssize_t n;
+
+#if WITH_ZLIB
+    if (replay->isZip) {
+        int rc;
+
+        replay->z.next_out = dst;
+        replay->z.avail_out = len;
+        while (replay->z.avail_out == (uInt) len) {
+            if (replay->z.avail_in == 0) {
+                if (replay->pos >= replay->end) {
+                    break;
+                }
+                do {
+                    n = pread(replay->fd, replay->buf,
+                        MIN((off_t) sizeof(replay->buf),
+                            replay->end - replay->pos), replay->pos);
+                } while ((n < 0) && (errno == EINTR));
+
+                if (n <= 0) {
+                    break;
+                }
+                replay->pos += n;
+                replay->z.next_in = replay->buf;
+                replay->z.avail_in = n;
+            }
+            rc = inflate(&replay->z, Z_NO_FLUSH);
+            if (rc == Z_STREAM_END) {
+                (void) inflateReset(&replay->z);
+            }
+            else if ((rc != Z_OK) && (rc != Z_BUF_ERROR)) {
+                log_msg(LOG_WARNING,
+                    "Unable to decompress console [%s] log for replay",
+                    replay->console->name);
+                break;
+            }
+        }
+        return(len - replay->z.avail_out);
+    }
+#endif /* WITH_ZLIB */
+
+    if (replay->pos >= replay->end) {
+        return(0);
+    }
+    do {
+        n = pread(replay->fd, dst, MIN((off_t) len, replay->end - replay->pos),
+            replay->pos);
+    } while ((n < 0) && (errno == EINTR));
+
+    if (n > 0) {
+        replay->pos += n;
+        return(n);
+    }
+    if (n < 0) {
+        log_msg(LOG_WARNING, "Unable to read console [%s] log: %s",
+            replay->console->name, strerror(errno));
+    }
+    return(0);
+}
+
+
+static void wait_log_replay(obj_t *client)
+{
+/*  Suspends writing to the (client) while its log replay waits for the
+ *    logfile to write out the data preceding that pending for the client.
+ */
+    log_replay_t *replay = client->aux.client.replay;
+
+    tpoll_clear(client->loop->tp, client->fd, POLLOUT);
+    if (replay->timer >= 0) {
+        return;
+    }
+    replay->timer = tpoll_timeout_relative(client->loop->tp,
+        (callback_f) resume_log_replay, client, LOG_REPLAY_WAIT_MSECS);
+    if (replay->timer < 0) {
+        log_msg(LOG_ERR,
+            "Unable to create timer for replaying console [%s] log",
+            replay->console->name);
+        tpoll_set(client->loop->tp, client->fd, POLLOUT);
+    }
+    return;
+}
+
+
+static void resume_log_replay(obj_t *client)
+{
+/*  Resumes the log replay of the (client) once its logfile has had time to
+ *    write out the data preceding that pending for the client.
+ */
+    assert(is_client_obj(client));
+    assert(client->aux.client.replay != NULL);
+
+    client->aux.client.replay->timer = -1;
+    if ((client->fd >= 0) && !client->aux.client.gotSuspend) {
+        tpoll_set(client->loop->tp, client->fd, POLLOUT);
+    }
+    return;
+}
+
+
+void create_log_writers(server_conf_t *conf)
+{
+/*  Creates the logfile writer threads and assigns each logfile to one of them
+ *    in round-robin order.  A logfile's data is then written out to its file
+ *    by its writer thread instead of by the event loop that owns it, so disk
+ *    latency (eg, a slow NFS server or an overloaded local disk) does not
+ *    stall console and client I/O.
+ *  Compressed logfiles are always written by a writer thread so compression
+ *    does not stall the event loops either.  If no writer threads are
+ *    configured, a single writer thread is created for them alone.
+ *  Signals handled by the daemon are blocked in these threads so they will
+ *    be delivered to the main thread.
+ */
+    ListIterator i;
+    obj_t *logfile;
+    log_writer_t *writer;
+    int numLogfiles = 0;
+    int numCompressed = 0;
+    int isCompressedOnly = 0;
+    sigset_t sigset;
+    sigset_t sigsetSave;
+    int n;
+    int rc;
+
+    assert(conf->logWriters == NULL);
+
+    i = list_iterator_create(conf->objs);
+    while ((logfile = list_next(i))) {
+        if (is_logfile_obj(logfile)) {
+            numLogfiles++;
+            if (logfile->aux.logfile.opts.compress) {
+                numCompressed++;
+            }
+        }
+    }
+    if ((conf->numLogWriters <= 0) && (numCompressed > 0)) {
+        log_msg(LOG_INFO,
+            "Creating logfile writer thread for %d compressed logfile%s",
+            numCompressed, (numCompressed == 1) ? "" : "s");
+        conf->numLogWriters = 1;
+        isCompressedOnly = 1;
+    }
+    if (conf->numLogWriters <= 0) {
+        list_iterator_destroy(i);
+        return;
+    }
+    if (conf->numLogWriters > numLogfiles) {
+        log_msg(LOG_INFO, "Reducing logfile writer threads from %d to %d",
+            conf->numLogWriters, numLogfiles);
+        conf->numLogWriters = numLogfiles;
+    }
+    if (conf->numLogWriters == 0) {
+        list_iterator_destroy(i);
+        return;
+    }
+    if (!(conf->logWriters =
+            malloc(conf->numLogWriters * sizeof(log_writer_t)))) {
+        out_of_memory();
+    }
+    for (n = 0; n < conf->numLogWriters; n++) {
+        writer = &conf->logWriters[n];
+        writer->id = n;
+        x_pthread_mutex_init(&writer->lock, NULL);
+        x_pthread_cond_init(&writer->cond, NULL);
+        x_pthread_cond_init(&writer->drained, NULL);
+        writer->head = writer->tail = NULL;
+        writer->gotDone = 0;
+    }
+    n = 0;
+    list_iterator_reset(i);
+    while ((logfile = list_next(i))) {
+        if (!is_logfile_obj(logfile)) {
+            continue;
+        }
+        if (!isCompressedOnly || logfile->aux.logfile.opts.compress) {
+            logfile->aux.logfile.writer =
+                &conf->logWriters[n++ % conf->numLogWriters];
+        }
+    }
+    list_iterator_destroy(i);
+
+    sigemptyset(&sigset);
+    sigaddset(&sigset, SIGCHLD);
+    sigaddset(&sigset, SIGHUP);
+    sigaddset(&sigset, SIGINT);
+    sigaddset(&sigset, SIGTERM);
+    if ((rc = pthread_sigmask(SIG_BLOCK, &sigset, &sigsetSave)) != 0) {
+        log_err(rc, "Unable to block signals for logfile writer threads");
+    }
+    for (n = 0; n < conf->numLogWriters; n++) {
+        if ((rc = pthread_create(&conf->logWriters[n].tid, NULL,
+          (PthreadFunc) log_writer_thread, &conf->logWriters[n])) != 0) {
+            log_err(rc, "Unable to create logfile writer thread");
+        }
+    }
+    if ((rc = pthread_sigmask(SIG_SETMASK, &sigsetSave, NULL)) != 0) {
+        log_err(rc, "Unable to restore signal mask");
+    }
+    log_msg(LOG_INFO, "Running %d logfile writer thread%s",
+        conf->numLogWriters, (conf->numLogWriters == 1 ? "" : "s"));
+    return;
+}
+
+
+void destroy_log_writers(server_conf_t *conf)
+{
+/*  Stops the logfile writer threads once the data queued for them has been
+ *    written out, and releases their resources.
+ *  The logfile objs must have been destroyed beforehand.
+ */
+    log_writer_t *writer;
+    int n;
+    int rc;
+
+    if (!conf->logWriters) {
+        return;
+    }
+    for (n = 0; n < conf->numLogWriters; n++) {
+        writer = &conf->logWriters[n];
+        x_pthread_mutex_lock(&writer->lock);
+        writer->gotDone = 1;
+        x_pthread_cond_signal(&writer->cond);
+        x_pthread_mutex_unlock(&writer->lock);
+    }
+    for (n = 0; n < conf->numLogWriters; n++) {
+        writer = &conf->logWriters[n];
+        if ((rc = pthread_join(writer->tid, NULL)) != 0) {
+            log_err(rc, "Unable to join logfile writer thread");
+        }
+        assert(writer->head == NULL);
+        x_pthread_cond_destroy(&writer->drained);
+        x_pthread_cond_destroy(&writer->cond);
+        x_pthread_mutex_destroy(&writer->lock);
+    }
+    free(conf->logWriters);
+    conf->logWriters = NULL;
+    return;
+}
+
+
+int queue_log_write(obj_t *logfile, const struct iovec *iov, int iovcnt)
+{
+/*  Queues a copy of the data described by the (iovcnt) iovecs in (iov)
+ *    to be written out to the (logfile) by its writer thread.  Since the
+ *    data is copied, the caller can consider it written upon return.
+ *  If more than LOG_WRITER_MAX_QUEUED bytes are already queued for the
+ *    logfile (ie, its disk cannot keep up), the logfile is stalled:
+ *    POLLOUT is cleared so its loop does not spin, and it is set again
+ *    (cf. resume_log_writes()) once the writer has caught up.  Meanwhile,
+ *    the data remains in the logfile's buffers where it is subject to being
+ *    overwritten just as data for a client that falls behind.
+ *  Must be called by the thread running the logfile's event loop.
+ *  Returns the number of bytes queued, or -1 on error (with errno set to
+ *    EAGAIN if the logfile is stalled, or to the error of a previous write).
+ */
+    log_writer_t *writer;
+    log_block_t *block;
+    unsigned char *p;
+    int len = 0;
+    int n;
+    int e;
+
+    assert(is_logfile_obj(logfile));
+    assert(logfile->aux.logfile.writer != NULL);
+    assert(logfile->fd >= 0);
+
+    writer = logfile->aux.logfile.writer;
+
+    /*  The loop can be woken to write a stalled logfile as more data arrives,
+     *    so POLLOUT is simply cleared again until the writer resumes it.
+     */
+    if (__atomic_load_n(&logfile->aux.logfile.isStalled, __ATOMIC_SEQ_CST)) {
+        tpoll_clear(logfile->loop->tp, logfile->fd, POLLOUT);
+        errno = EAGAIN;
+        return(-1);
+    }
+    x_pthread_mutex_lock(&writer->lock);
+    if ((e = logfile->aux.logfile.writeErrno) != 0) {
+        logfile->aux.logfile.writeErrno = 0;
+        x_pthread_mutex_unlock(&writer->lock);
+        errno = e;
+        return(-1);
+    }
+    if (logfile->aux.logfile.numQueued >= LOG_WRITER_MAX_QUEUED) {
+        logfile->aux.logfile.numStalls++;
+        __atomic_store_n(&logfile->aux.logfile.isStalled, 1, __ATOMIC_SEQ_CST);
+        x_pthread_mutex_unlock(&writer->lock);
+        DPRINTF((10, "Stalled logfile [%s].\n", logfile->name));
+        /*
+         *  The writer may have caught up before the stall was noticed,
+         *    so re-check the queue after POLLOUT has been cleared.
+         */
+        tpoll_clear(logfile->loop->tp, logfile->fd, POLLOUT);
+        x_pthread_mutex_lock(&writer->lock);
+        n = logfile->aux.logfile.numQueued;
+        x_pthread_mutex_unlock(&writer->lock);
+        if ((n <= LOG_WRITER_MAX_QUEUED / 2) && __atomic_exchange_n(
+                &logfile->aux.logfile.isStalled, 0, __ATOMIC_SEQ_CST)) {
+            tpoll_set(logfile->loop->tp, logfile->fd, POLLOUT);
+        }
+        errno = EAGAIN;
+        return(-1);
+    }
+    x_pthread_mutex_unlock(&writer->lock);
+
+    for (n = 0; n < iovcnt; n++) {
+        len += iov[n].iov_len;
+    }
+    if (len <= 0) {
+        return(0);
+    }
+    if (!(block = malloc(sizeof(log_block_t) + len))) {
+        out_of_memory();
+    }
+    block->fd = logfile->fd;
+    block->indexFd = logfile->aux.logfile.indexFd;
+    block->len = len;
+    for (n = 0, p = (unsigned char *) (block + 1); n < iovcnt; n++) {
+        memcpy(p, iov[n].iov_base, iov[n].iov_len);
+        p += iov[n].iov_len;
+    }
+    append_log_block(logfile, block);
+    return(len);
+}
+
+
+void queue_log_close(obj_t *logfile)
+{
+/*  Queues the closing of the (logfile) fd (and its time index fd, if any)
+ *    to its writer thread after the data queued for it has been written out.
+ *    The writer stats for that fd are then logged.  Any subsequent write error from that fd is disregarded
+ *    since it no longer refers to the logfile's current fd.
+ *  Must be called by the thread running the logfile's event loop,
+ *    which then sets the logfile's fd to -1.
+ */
+    log_block_t *block;
+    int len;
+
+    assert(is_logfile_obj(logfile));
+    assert(logfile->aux.logfile.writer != NULL);
+    assert(logfile->fd >= 0);
+
+    len = strlen(logfile->name) + 1;
+    if (!(block = malloc(sizeof(log_block_t) + len))) {
+        out_of_memory();
+    }
+    block->fd = logfile->fd;
+    block->indexFd = logfile->aux.logfile.indexFd;
+    block->len = -1;
+    memcpy(block + 1, logfile->name, len);
+    logfile->aux.logfile.indexFd = -1;
+    append_log_block(logfile, block);
+    return;
+}
+
+
+void wait_log_writes(obj_t *logfile)
+{
+/*  Waits for the blocks queued for the (logfile) to be written out
+ *    by its writer thread.
+ */
+    log_writer_t *writer;
+
+    assert(is_logfile_obj(logfile));
+
+    if (!(writer = logfile->aux.logfile.writer)) {
+        return;
+    }
+    x_pthread_mutex_lock(&writer->lock);
+    while (logfile->aux.logfile.numPending > 0) {
+        x_pthread_cond_wait(&writer->drained, &writer->lock);
+    }
+    x_pthread_mutex_unlock(&writer->lock);
+    return;
+}
+
+
+int sync_logfile_obj(obj_t *logfile)
+{
+/*  Flushes the data written to the (logfile) by its loop out to disk
+ *    if the "sync" logopt is enabled and data has been written since the
+ *    last sync.  Logfiles with a writer thread are synced by that thread.
+ *  Returns 0 on success, or -1 on error (with errno set).
+ */
+    assert(is_logfile_obj(logfile));
+
+    if (!logfile->aux.logfile.gotUnsynced || (logfile->fd < 0)) {
+        return(0);
+    }
+    logfile->aux.logfile.gotUnsynced = 0;
+    return(sync_log_fd(logfile->fd));
+}
+
+
+void count_logfile_bytes(obj_t *logfile, int n)
+{
+/*  Adds the (n) bytes written to (or queued for) the (logfile) by its loop
+ *    to the size of its current file.  Once that size reaches the "maxsize"
+ *    logopt, a zero-delay timer is set to rotate this logfile; the rotation
+ *    thereby occurs outside of the write in progress, and only the logfile
+ *    that has grown too large is reopened.
+ *  The first write in each "index" interval adds an entry for the offset of
+ *    these bytes to the logfile's time index.  Since data is written after
+ *    it has been received, seeking to the entry for a given time never skips
+ *    data received at or after that time.  Compressed logfiles are instead
+ *    indexed by their writer thread at the start of each frame.
+ *  Must be called by the thread running the logfile's event loop.
+ */
+    time_t now;
+    int secs;
+
+    assert(is_logfile_obj(logfile));
+
+    if ((logfile->aux.logfile.indexFd >= 0)
+            && !logfile->aux.logfile.opts.compress
+            && (time(&now) >= logfile->aux.logfile.indexNext)) {
+        secs = logfile->aux.logfile.opts.indexSecs;
+        logfile->aux.logfile.indexNext = now - (now % secs) + secs;
+        if (write_log_index(logfile->aux.logfile.indexFd, now,
+                logfile->aux.logfile.size) < 0) {
+            log_msg(LOG_WARNING,
+                "Unable to write time index for logfile \"%s\": %s",
+                logfile->name, strerror(errno));
+        }
+    }
+    logfile->aux.logfile.size += n;
+
+    if ((logfile->aux.logfile.opts.maxSize == 0)
+            || (logfile->aux.logfile.size < logfile->aux.logfile.opts.maxSize)
+            || logfile->aux.logfile.gotRotateDue) {
+        return;
+    }
+    if (tpoll_timeout_relative(logfile->loop->tp,
+            (callback_f) rotate_logfile_obj, logfile, 0) < 0) {
+        log_msg(LOG_ERR, "Unable to create timer for rotating logfile \"%s\"",
+            logfile->name);
+        return;
+    }
+    logfile->aux.logfile.gotRotateDue = 1;
+    return;
+}
+
+
+static void rotate_logfile_obj(obj_t *logfile)
+{
+/*  Rotates the (logfile) once it has reached its "maxsize" logopt:
+ *    the file is renamed with a ".1" suffix (after renaming those already
+ *    rotated to the next suffix, up to the "keep" logopt) or removed if
+ *    no rotated files are kept, and then the logfile is reopened.
+ *  Data still queued for the logfile's writer thread is written to the
+ *    renamed file since the writer retains the previous fd until then.
+ *  If the rotation fails, it is retried once the logfile has grown by
+ *    another "maxsize".
+ */
+    char src[PATH_MAX];
+    char dst[PATH_MAX];
+    int n;
+    int isIndex;
+
+    assert(is_logfile_obj(logfile));
+
+    logfile->aux.logfile.gotRotateDue = 0;
+
+    /*  The logfile may have been reopened (and truncated) in the meantime.
+     */
+    if ((logfile->fd < 0) || (logfile->aux.logfile.opts.maxSize == 0)
+            || (logfile->aux.logfile.size < logfile->aux.logfile.opts.maxSize))
+    {
+        return;
+    }
+    /*  The time index (if any) is rotated along with its logfile.
+     */
+    if (logfile->aux.logfile.opts.numKeep == 0) {
+        if (unlink(logfile->name) < 0) {
+            log_msg(LOG_WARNING, "Unable to remove logfile \"%s\": %s",
+                logfile->name, strerror(errno));
+            logfile->aux.logfile.size = 0;
+            return;
+        }
+        if ((get_log_path(src, sizeof(src), logfile->name, 0, 1) == 0)
+                && (unlink(src) < 0) && (errno != ENOENT)) {
+            log_msg(LOG_WARNING, "Unable to remove logfile \"%s\": %s",
+                src, strerror(errno));
+        }
+    }
+    else {
+        for (n = logfile->aux.logfile.opts.numKeep; n > 0; n--) {
+            for (isIndex = 0; isIndex <= 1; isIndex++) {
+                if ((get_log_path(src, sizeof(src), logfile->name,
+                            n - 1, isIndex) < 0)
+                        || (get_log_path(dst, sizeof(dst), logfile->name,
+                            n, isIndex) < 0)) {
+                    log_msg(LOG_WARNING, "Unable to rotate logfile \"%s\": "
+                        "filename exceeded buffer", logfile->name);
+                    logfile->aux.logfile.size = 0;
+                    return;
+                }
+                if ((rename(src, dst) == 0) || (errno == ENOENT)) {
+                    continue;
+                }
+                log_msg(LOG_WARNING, "Unable to rename logfile \"%s\": %s",
+                    src, strerror(errno));
+                if ((n == 1) && !isIndex) {
+                    logfile->aux.logfile.size = 0;
+                    return;
+                }
+            }
+        }
+    }
+    log_msg(LOG_INFO, "Rotating logfile \"%s\" at %llu bytes",
+        logfile->name, (unsigned long long) logfile->aux.logfile.size);
+    (void) open_logfile_obj(logfile);
+    return;
+}
+
+
+static int get_log_path(char *dst, size_t dstlen, const char *name,
+    int n, int isIndex)
+{
+/*  Writes the pathname of the logfile (name) into the buffer (dst) of length
+ *    (dstlen), adding the suffix of its (n)th rotated file if (n) > 0, and the
+ *    suffix of its time index if (isIndex) is true (eg, "console.log.1.idx").
+ *  Returns 0 on success, or -1 if the buffer is too small.
+ */
+    const char *suffix = isIndex ? LOG_INDEX_SUFFIX : "";
+    int len;
+
+    if (n > 0) {
+        len = snprintf(dst, dstlen, "%s.%d%s", name, n, suffix);
+    }
+    else {
+        len = snprintf(dst, dstlen, "%s%s", name, suffix);
+    }
+    return(((len < 0) || ((size_t) len >= dstlen)) ? -1 : 0);
+}
+
+
+static int open_log_index(obj_t *logfile, int isNew)
+{
+/*  Opens the time index of the (logfile) that has just been opened,
+ *    truncating it if (isNew) is true since an empty logfile has no data
+ *    to index.
+ *  The index is a sidecar file (named after the logfile with an ".idx"
+ *    suffix) of fixed-length text records.  Each record maps a time (in
+ *    seconds since the epoch) to the byte offset of the data written to
+ *    the logfile at or after that time; for a compressed logfile, this is
+ *    the offset of the frame started at that time.  Since records are
+ *    appended in order of time and offset, a reader can binary-search the
+ *    index for a given time.
+ *  Returns 0 on success, or -1 on error.
+ */
+    char name[PATH_MAX];
+    int flags;
+    int fd;
+
+    assert(is_logfile_obj(logfile));
+    assert(logfile->aux.logfile.indexFd < 0);
+
+    if (get_log_path(name, sizeof(name), logfile->name, 0, 1) < 0) {
+        log_msg(LOG_WARNING,
+            "Unable to open time index for logfile \"%s\": "
+            "filename exceeded buffer", logfile->name);
+        return(-1);
+    }
+    flags = O_WRONLY | O_CREAT | O_APPEND;
+    if (isNew) {
+        flags |= O_TRUNC;
+    }
+    if ((fd = open(name, flags, S_IRUSR | S_IWUSR)) < 0) {
+        log_msg(LOG_WARNING, "Unable to open time index \"%s\": %s",
+            name, strerror(errno));
+        return(-1);
+    }
+    set_fd_closed_on_exec(fd);
+    logfile->aux.logfile.indexFd = fd;
+    logfile->aux.logfile.indexNext = 0;
+    return(0);
+}
+
+
+void close_logfile_index(obj_t *logfile)
+{
+/*  Closes the time index of the (logfile) along with the logfile itself.
+ *    If the logfile has a writer thread, its time index is instead closed
+ *    by that thread (cf. queue_log_close()).
+ */
+    assert(is_logfile_obj(logfile));
+
+    if (logfile->aux.logfile.indexFd < 0) {
+        return;
+    }
+    if (close(logfile->aux.logfile.indexFd) < 0) {
+        log_msg(LOG_WARNING,
+            "Unable to close time index for logfile \"%s\": %s",
+            logfile->name, strerror(errno));
+    }
+    logfile->aux.logfile.indexFd = -1;
+    return;
+}
+
+
+static int write_log_index(int fd, time_t t, uint64_t offset)
+{
+/*  Appends a record mapping the time (t) to the logfile (offset)
+ *    to the time index (fd).
+ *  Returns 0 on success, or -1 on error (with errno set).
+ */
+    char buf[LOG_INDEX_RECORD_LEN + 1];
+    int n;
+
+    n = snprintf(buf, sizeof(buf), "%010lu %020llu\n",
+        (unsigned long) t, (unsigned long long) offset);
+    assert(n == LOG_INDEX_RECORD_LEN);
+
+    do {
+        n = write(fd, buf, LOG_INDEX_RECORD_LEN);
+    } while ((n < 0) && (errno == EINTR));
+
+    if ((n >= 0) && (n < LOG_INDEX_RECORD_LEN)) {
+        errno = ENOSPC;
+        return(-1);
+    }
+    return((n < 0) ? -1 : 0);
+}
+
+
+static int is_splice_logfile_obj(obj_t *logfile)
+{
+/*  Returns true if console data can be spliced directly into the (logfile)
+ *    from its console's fd; o/w, returns false.
+ *  Splicing requires the logfile to need no processing, and the console to
+ *    hand its raw fd output to the logfile unmodified.  Telnet consoles are
+ *    excluded since their output must be scanned for telnet commands.
+ */
+    obj_t *console;
+
+    assert(is_logfile_obj(logfile));
+
+    if (!logfile->loop || !logfile->loop->conf->enableSplice) {
+        return(0);
+    }
+    /*  A splice would write the logfile from the loop's thread,
+     *    which is what its writer thread is there to avoid.
+     */
+    if (logfile->aux.logfile.writer) {
+        return(0);
+    }
+    if (logfile->aux.logfile.gotProcessing) {
+        return(0);
+    }
+    /*  Spliced data bypasses the logfile's buffer,
+     *    so it cannot be deferred to batch it into fewer writes.
+     */
+    if (logfile->aux.logfile.opts.flushBytes
+            || logfile->aux.logfile.opts.flushMsecs) {
+        return(0);
+    }
+    console = logfile->aux.logfile.console;
+    return(is_process_obj(console)
+        || is_serial_obj(console)
+        || is_unixsock_obj(console));
+}
+
+
+static void * log_writer_thread(log_writer_t *writer)
+{
+/*  Writes out the blocks queued for the logfiles assigned to the (writer)
+ *    until the writer is done and its queue is empty.
+ *  The entire queue is taken at once so the loops can continue to queue
+ *    blocks while the taken blocks are being written.
+ */
+    log_block_t *head;
+
+    DPRINTF((5, "Started logfile writer %d.\n", writer->id));
+    x_pthread_mutex_lock(&writer->lock);
+    for (;;) {
+        while (!writer->head && !writer->gotDone) {
+            x_pthread_cond_wait(&writer->cond, &writer->lock);
+        }
+        if (!writer->head) {
+            break;
+        }
+        head = writer->head;
+        writer->head = writer->tail = NULL;
+        x_pthread_mutex_unlock(&writer->lock);
+
+        while (head) {
+            write_log_blocks(writer, &head);
+        }
+        x_pthread_mutex_lock(&writer->lock);
+    }
+    x_pthread_mutex_unlock(&writer->lock);
+    DPRINTF((5, "Stopped logfile writer %d.\n", writer->id));
+    return(NULL);
+}
+
+
+static void write_log_blocks(log_writer_t *writer, log_block_t **headp)
+{
+/*  Writes out the run of data blocks at the head of the list (headp)
+ *    for the same logfile fd with a single writev(), and then removes them
+ *    from the list.  If the head block closes a logfile fd instead,
+ *    only that block is processed.
+ *  Must be called without holding the writer's lock.
+ */
+    struct iovec iov[LOG_WRITER_MAX_IOVS];
+    struct iovec *v;
+    log_block_t *head;
+    log_block_t *block;
+    log_block_t *next;
+    obj_t *logfile;
+    int iovcnt = 0;
+    int len = 0;
+    int m = 0;
+    int n;
+    int e = 0;
+    uint64_t t0;
+    uint64_t msecs;
+    tpoll_t tp;
+    int gotResume;
+
+    head = *headp;
+    if (head->len < 0) {
+        *headp = head->next;
+        close_log_block(writer, head);
+        return;
+    }
+    logfile = head->logfile;
+    for (block = head; block && (iovcnt < LOG_WRITER_MAX_IOVS);
+            block = block->next) {
+        if ((block->logfile != logfile) || (block->fd != head->fd)
+                || (block->len < 0)) {
+            break;
+        }
+        iov[iovcnt].iov_base = block + 1;
+        iov[iovcnt].iov_len = block->len;
+        len += block->len;
+        iovcnt++;
+    }
+    *headp = block;
+
+    /*  The data is written out in its entirety unless an error occurs.
+     *  Compressed data is written out as it is compressed, so (m) is then
+     *    the number of compressed bytes written.
+     */
+    t0 = get_msecs();
+    if (!logfile->aux.logfile.opts.compress) {
+        v = iov;
+        while (m < len) {
+            n = writev(head->fd, v, iovcnt);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                e = errno;
+                break;
+            }
+            m += n;
+            while ((iovcnt > 0) && ((size_t) n >= v->iov_len)) {
+                n -= v->iov_len;
+                v++;
+                iovcnt--;
+            }
+            if (iovcnt > 0) {
+                v->iov_base = (unsigned char *) v->iov_base + n;
+                v->iov_len -= n;
+            }
+        }
+    }
+#if WITH_ZLIB
+    else {
+        e = write_log_zip(logfile, head->fd, head->indexFd, iov, iovcnt, &m);
+    }
+#endif /* WITH_ZLIB */
+    /*  The logfile is synced once per run of blocks rather than per block,
+     *    so blocks queued while a sync is in progress are committed together.
+     */
+    if ((e == 0) && (m > 0) && logfile->aux.logfile.opts.enableSync
+            && (sync_log_fd(head->fd) < 0)) {
+        e = errno;
+    }
+    msecs = get_msecs() - t0;
+
+    x_pthread_mutex_lock(&writer->lock);
+    if (e && (head->gen == logfile->aux.logfile.writeGen)) {
+        logfile->aux.logfile.writeErrno = e;
+    }
+    logfile->aux.logfile.numWrites++;
+    logfile->aux.logfile.numBytesWritten += m;
+    if (msecs > logfile->aux.logfile.maxWriteMsecs) {
+        logfile->aux.logfile.maxWriteMsecs = msecs;
+    }
+    for (block = head; block != *headp; block = block->next) {
+        logfile->aux.logfile.numQueued -= block->len;
+        logfile->aux.logfile.numPending--;
+    }
+    assert(logfile->aux.logfile.numQueued >= 0);
+    assert(logfile->aux.logfile.numPending >= 0);
+
+    /*  A stalled logfile is resumed once its writer has caught up,
+     *    as is a logfile that has failed so its loop will notice the error.
+     */
+    gotResume = (e != 0);
+    if ((logfile->aux.logfile.numQueued <= LOG_WRITER_MAX_QUEUED / 2)
+            && __atomic_exchange_n(&logfile->aux.logfile.isStalled, 0,
+                __ATOMIC_SEQ_CST)) {
+        gotResume = 1;
+    }
+    tp = logfile->loop->tp;
+    x_pthread_cond_broadcast(&writer->drained);
+    x_pthread_mutex_unlock(&writer->lock);
+
+    /*  The logfile obj can be destroyed once its pending blocks are written,
+     *    but only after its loop has stopped so the timer will never run.
+     */
+    if (gotResume && (tpoll_timeout_relative(tp,
+            (callback_f) resume_log_writes, logfile, 0) < 0)) {
+        log_msg(LOG_ERR, "Unable to create timer for resuming logfile writes");
+    }
+    if (e) {
+        DPRINTF((5, "Unable to write to logfile fd=%d: %s.\n",
+            head->fd, strerror(e)));
+    }
+    DPRINTF((15, "Wrote %d bytes to logfile fd=%d in %lu ms.\n",
+        m, head->fd, (unsigned long) msecs));
+
+    for (block = head; block != *headp; block = next) {
+        next = block->next;
+        free(block);
+    }
+    return;
+}
+
+
+static void close_log_block(log_writer_t *writer, log_block_t *block)
+{
+/*  Closes the logfile fd specified by the close (block), and logs the writer
+ *    stats for that fd before resetting them.
+ *  Must be called without holding the writer's lock.
+ */
+    obj_t *logfile = block->logfile;
+    const char *name = (const char *) (block + 1);
+    uint64_t numBytes;
+    unsigned long numWrites;
+    unsigned long numStalls;
+    unsigned long maxMsecs;
+    int maxQueued;
+
+#if WITH_ZLIB
+    close_log_zip(logfile, block->fd);
+#endif /* WITH_ZLIB */
+    if (close(block->fd) < 0) {
+        log_msg(LOG_WARNING, "Unable to close logfile \"%s\": %s",
+            name, strerror(errno));
+    }
+    if ((block->indexFd >= 0) && (close(block->indexFd) < 0)) {
+        log_msg(LOG_WARNING,
+            "Unable to close time index for logfile \"%s\": %s",
+            name, strerror(errno));
+    }
+    x_pthread_mutex_lock(&writer->lock);
+    numBytes = logfile->aux.logfile.numBytesWritten;
+    numWrites = logfile->aux.logfile.numWrites;
+    numStalls = logfile->aux.logfile.numStalls;
+    maxMsecs = logfile->aux.logfile.maxWriteMsecs;
+    maxQueued = logfile->aux.logfile.maxQueued;
+    logfile->aux.logfile.numBytesWritten = 0;
+    logfile->aux.logfile.numWrites = 0;
+    logfile->aux.logfile.numStalls = 0;
+    logfile->aux.logfile.maxWriteMsecs = 0;
+    logfile->aux.logfile.maxQueued = 0;
+    logfile->aux.logfile.numPending--;
+    assert(logfile->aux.logfile.numPending >= 0);
+    x_pthread_cond_broadcast(&writer->drained);
+    x_pthread_mutex_unlock(&writer->lock);
+
+    if (numWrites > 0) {
+        log_msg((numStalls > 0) ? LOG_NOTICE : LOG_INFO,
+            "Logfile \"%s\" wrote %llu bytes in %lu write%s "
+            "(max queued %d bytes, max latency %lu ms, %lu stall%s)",
+            name, (unsigned long long) numBytes, numWrites,
+            (numWrites == 1 ? "" : "s"), maxQueued, maxMsecs, numStalls,
+            (numStalls == 1 ? "" : "s"));
+    }
+    free(block);
+    return;
+}
+
+
+static void append_log_block(obj_t *logfile, log_block_t *block)
+{
+/*  Appends the (block) for the (logfile) to its writer's queue,
+ *    and wakes the writer.
+ *  A close block advances the logfile's writeGen so errors from writes to the
+ *    closed fd will not be attributed to a subsequently opened one.
+ */
+    log_writer_t *writer = logfile->aux.logfile.writer;
+
+    block->next = NULL;
+    block->logfile = logfile;
+
+    x_pthread_mutex_lock(&writer->lock);
+    block->gen = logfile->aux.logfile.writeGen;
+    if (block->len < 0) {
+        logfile->aux.logfile.writeGen++;
+        logfile->aux.logfile.writeErrno = 0;
+    }
+    else {
+        logfile->aux.logfile.numQueued += block->len;
+        if (logfile->aux.logfile.numQueued > logfile->aux.logfile.maxQueued) {
+            logfile->aux.logfile.maxQueued = logfile->aux.logfile.numQueued;
+        }
+    }
+    logfile->aux.logfile.numPending++;
+    if (writer->tail) {
+        writer->tail->next = block;
+    }
+    else {
+        writer->head = block;
+    }
+    writer->tail = block;
+    x_pthread_cond_signal(&writer->cond);
+    x_pthread_mutex_unlock(&writer->lock);
+    return;
+}
+
+
+static void resume_log_writes(obj_t *logfile)
+{
+/*  Timer callback to resume writing the (logfile) once its writer thread
+ *    has caught up, or to have its loop notice a write error.
+ */
+    if (logfile->fd >= 0) {
+        tpoll_set(logfile->loop->tp, logfile->fd, POLLOUT);
+    }
+    return;
+}
+
+
+static uint64_t get_msecs(void)
+{
+/*  Returns the current time in milliseconds for measuring write latency.
+ *  The monotonic clock is used if available since it is unaffected by
+ *    changes to the system time.
+ */
+#if HAVE_CLOCK_GETTIME && defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+#endif /* HAVE_CLOCK_GETTIME && CLOCK_MONOTONIC */
+    struct timeval tv;
+
+#if HAVE_CLOCK_GETTIME && defined(CLOCK_MONOTONIC)
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+        return(((uint64_t) ts.tv_sec * 1000) + (ts.tv_nsec / 1000000));
+    }
+#endif /* HAVE_CLOCK_GETTIME && CLOCK_MONOTONIC */
+    if (gettimeofday(&tv, NULL) < 0) {
+        return(0);
+    }
+    return(((uint64_t) tv.tv_sec * 1000) + (tv.tv_usec / 1000));
+}
+
+
+static int parse_log_flush(logopt_t *opts, const char *str,
+    char *errbuf, int errlen)
+{
+/*  Parses the value 'str' of a "flush=" logopt into 'opts'.
+ *    A value with an "ms" or "s" suffix sets the max interval for which data
+ *    is deferred; o/w, it sets the num bytes deferred, optionally with a
+ *    "k" or "m" suffix for KiB or MiB.
+ *  Returns 0 on success, or -1 on error (writing an error message into
+ *    'errbuf' if defined).
+ */
+    long n;
+    char *p;
+    int scale = 1;
+    int isMsecs = 0;
+
+    errno = 0;
+    n = strtol(str, &p, 10);
+    if ((p == str) || (errno == ERANGE) || (n <= 0)) {
+        goto err;
+    }
+    if (!strcasecmp(p, "ms")) {
+        isMsecs = 1;
+    }
+    else if (!strcasecmp(p, "s")) {
+        isMsecs = 1;
+        scale = 1000;
+    }
+    else if (!strcasecmp(p, "k")) {
+        scale = 1024;
+    }
+    else if (!strcasecmp(p, "m")) {
+        scale = 1024 * 1024;
+    }
+    else if (*p != '\0') {
+        goto err;
+    }
+    if (isMsecs) {
+        if (n > MAX_LOG_FLUSH_MSECS / scale) {
+            if ((errbuf != NULL) && (errlen > 0))
+                snprintf(errbuf, errlen,
+                    "logopt flush interval exceeds max of %d ms",
+                    MAX_LOG_FLUSH_MSECS);
+            return(-1);
+        }
+        opts->flushMsecs = n * scale;
+    }
+    else {
+        if (n > MAX_OBJ_BUF_SIZE / scale) {
+            if ((errbuf != NULL) && (errlen > 0))
+                snprintf(errbuf, errlen,
+                    "logopt flush size exceeds max of %d bytes",
+                    MAX_OBJ_BUF_SIZE);
+            return(-1);
+        }
+        opts->flushBytes = n * scale;
+    }
+    return(0);
+
+err:
+    if ((errbuf != NULL) && (errlen > 0))
+        snprintf(errbuf, errlen, "invalid logopt flush value \"%s\"", str);
+    return(-1);
+}
+
+
+static int sync_log_fd(int fd)
+{
+/*  Flushes the data written to the logfile (fd) out to disk.
+ *    Only the file's data (and the metadata needed to read it back) is
+ *    flushed if fdatasync() is available.
+ *  Files that do not support syncing (eg, a pipe or /dev/null) are ignored.
+ *  Returns 0 on success, or -1 on error (with errno set).
+ */
+    int rc;
+
+    do {
+#if HAVE_FDATASYNC
+        rc = fdatasync(fd);
+#else  /* !HAVE_FDATASYNC */
+        rc = fsync(fd);
+#endif /* !HAVE_FDATASYNC */
+    } while ((rc < 0) && (errno == EINTR));
+
+    if ((rc < 0) && ((errno == EINVAL) || (errno == EROFS))) {
+        rc = 0;
+    }
+    return(rc);
+}
+
+
+static int parse_log_compress(logopt_t *opts, const char *str,
+    char *errbuf, int errlen)
+{
+/*  Parses the value 'str' of a "compress=" logopt into 'opts'.
+ *  Returns 0 on success, or -1 on error (writing an error message into
+ *    'errbuf' if defined).
+ */
+    if (!strcasecmp(str, "none")) {
+        opts->compress = CONMAN_LOG_COMPRESS_NONE;
+        return(0);
+    }
+#if WITH_ZLIB
+    if (!strcasecmp(str, "gzip")) {
+        opts->compress = CONMAN_LOG_COMPRESS_GZIP;
+        return(0);
+    }
+#endif /* WITH_ZLIB */
+    if ((errbuf != NULL) && (errlen > 0))
+        snprintf(errbuf, errlen, "logopt compress=%s is not supported", str);
+    return(-1);
+}
+
+
+static int parse_log_interval(int *secsp, const char *opt, const char *str,
+    char *errbuf, int errlen)
+{
+/*  Parses the value 'str' of an interval logopt (eg, "frame=" or "index=")
+ *    named 'opt' into 'secsp'.
+ *    The value is in seconds unless it has an "m" or "h" suffix for minutes
+ *    or hours.
+ *  Returns 0 on success, or -1 on error (writing an error message into
+ *    'errbuf' if defined).
+ */
+    long n;
+    char *p;
+    int scale = 1;
+
+    errno = 0;
+    n = strtol(str, &p, 10);
+    if ((p == str) || (errno == ERANGE) || (n <= 0)) {
+        goto err;
+    }
+    if (!strcasecmp(p, "m")) {
+        scale = 60;
+    }
+    else if (!strcasecmp(p, "h")) {
+        scale = 3600;
+    }
+    else if ((*p != '\0') && strcasecmp(p, "s")) {
+        goto err;
+    }
+    if (n > MAX_LOG_INTERVAL_SECS / scale) {
+        if ((errbuf != NULL) && (errlen > 0))
+            snprintf(errbuf, errlen,
+                "logopt %s interval exceeds max of %d secs",
+                opt, MAX_LOG_INTERVAL_SECS);
+        return(-1);
+    }
+    *secsp = n * scale;
+    return(0);
+
+err:
+    if ((errbuf != NULL) && (errlen > 0))
+        snprintf(errbuf, errlen, "invalid logopt %s value \"%s\"", opt, str);
+    return(-1);
+}
+
+
+#if WITH_ZLIB
+static int write_log_zip(obj_t *logfile, int fd, int indexFd,
+    struct iovec *iov, int iovcnt, int *np)
+{
+/*  Compresses the data described by the iovec array (iov) of length (iovcnt)
+ *    and writes it out to the (logfile) fd (fd), storing the number of
+ *    compressed bytes written in (np).
+ *  A new frame is started once the current frame's interval has elapsed.
+ *    Frame intervals are aligned to the clock (eg, frames of 60 secs start
+ *    on the minute) so frames can be located by time.  The compressed data
+ *    is flushed after each write so everything written thus far can be
+ *    decompressed even though the frame has not yet ended.
+ *  The start of each frame is recorded in the time index (indexFd) if >= 0.
+ *  Must be called by the logfile's writer thread.
+ *  Returns 0 on success, or an errno value on error.
+ */
+    log_zip_t *zip;
+    struct stat st;
+    time_t now;
+    int e = 0;
+    int rc;
+    int i;
+
+    *np = 0;
+
+    if (!(zip = logfile->aux.logfile.zip)) {
+        if (!(zip = malloc(sizeof(log_zip_t)))) {
+            out_of_memory();
+        }
+        memset(zip, 0, sizeof(*zip));
+        rc = deflateInit2(&zip->z, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+            MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY);
+        if (rc == Z_MEM_ERROR) {
+            out_of_memory();
+        }
+        else if (rc != Z_OK) {
+            log_err(0, "Unable to initialize compression for logfile \"%s\"",
+                logfile->name);
+        }
+        zip->fd = -1;
+        logfile->aux.logfile.zip = zip;
+    }
+    if (time(&now) == (time_t) -1) {
+        log_err(errno, "time() failed");
+    }
+    /*  The current frame ends once its interval has elapsed
+     *    (or its fd has been replaced without having been closed).
+     */
+    if (zip->isOpen && ((now >= zip->frameEnd) || (zip->fd != fd))) {
+        if (zip->fd == fd) {
+            e = deflate_log_zip(zip, Z_FINISH, np);
+        }
+        (void) deflateReset(&zip->z);
+        zip->isOpen = 0;
+    }
+    if (!zip->isOpen && (e == 0)) {
+        zip->header.time = (uLong) now;
+        zip->header.os = 3;             /* Unix */
+        (void) deflateSetHeader(&zip->z, &zip->header);
+        zip->fd = fd;
+        zip->frameEnd = now - (now % logfile->aux.logfile.opts.frameSecs)
+            + logfile->aux.logfile.opts.frameSecs;
+        zip->isOpen = 1;
+        /*
+         *  The frame starts at the end of the logfile, which is where the
+         *    previous frame was finished.
+         */
+        if ((indexFd >= 0) && (fstat(fd, &st) == 0)
+                && (write_log_index(indexFd, now, st.st_size) < 0)) {
+            log_msg(LOG_WARNING, "Unable to write logfile time index: %s",
+                strerror(errno));
+        }
+    }
+    for (i = 0; (i < iovcnt) && (e == 0); i++) {
+        zip->z.next_in = iov[i].iov_base;
+        zip->z.avail_in = iov[i].iov_len;
+        e = deflate_log_zip(zip, Z_NO_FLUSH, np);
+    }
+    if (e == 0) {
+        e = deflate_log_zip(zip, Z_SYNC_FLUSH, np);
+    }
+    return(e);
+}
+
+
+static void close_log_zip(obj_t *logfile, int fd)
+{
+/*  Ends the current frame of compressed data for the (logfile) fd (fd)
+ *    before that fd is closed, and releases the logfile's compression state.
+ *  Must be called by the logfile's writer thread.
+ */
+    log_zip_t *zip;
+    int n = 0;
+    int e;
+
+    if (!(zip = logfile->aux.logfile.zip)) {
+        return;
+    }
+    if (zip->isOpen && (zip->fd == fd)) {
+        if ((e = deflate_log_zip(zip, Z_FINISH, &n)) != 0) {
+            log_msg(LOG_WARNING,
+                "Unable to end compressed frame for logfile \"%s\": %s",
+                logfile->name, strerror(e));
+        }
+        x_pthread_mutex_lock(&logfile->aux.logfile.writer->lock);
+        logfile->aux.logfile.numBytesWritten += n;
+        x_pthread_mutex_unlock(&logfile->aux.logfile.writer->lock);
+    }
+    (void) deflateEnd(&zip->z);
+    free(zip);
+    logfile->aux.logfile.zip = NULL;
+    return;
+}
+
+
+static int deflate_log_zip(log_zip_t *zip, int flush, int *np)
+{
+/*  Compresses the pending input of the (zip) stream with the given (flush)
+ *    mode, writing the compressed output to the frame's fd and adding the
+ *    number of bytes written to (np).
+ *  Returns 0 on success, or an errno value on error.
+ */
+    unsigned char *p;
+    int len;
+    int n;
+
+    do {
+        zip->z.next_out = zip->out;
+        zip->z.avail_out = sizeof(zip->out);
+        if (deflate(&zip->z, flush) == Z_STREAM_ERROR) {
+            return(EINVAL);
+        }
+        p = zip->out;
+        len = sizeof(zip->out) - zip->z.avail_out;
+        while (len > 0) {
+            if ((n = write(zip->fd, p, len)) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return(errno);
+            }
+            p += n;
+            len -= n;
+            *np += n;
+        }
+    } while (zip->z.avail_out == 0);
+
+    return(0);
+}
+#endif /* WITH_ZLIB */
+
+
+static int parse_log_maxsize(logopt_t *opts, const char *str,
+    char *errbuf, int errlen)
+{
+/*  Parses the value 'str' of a "maxsize=" logopt (ie, the size at which
+ *    the logfile is rotated) into 'opts'.  The value is in bytes, optionally
+ *    with a "k", "m", or "g" suffix for KiB, MiB, or GiB.
+ *  Returns 0 on success, or -1 on error (writing an error message into
+ *    'errbuf' if defined).
+ */
+    unsigned long long n;
+    char *p;
+    unsigned long long scale = 1;
+
+    if (!isdigit((int) *str)) {
+        goto err;
+    }
+    errno = 0;
+    n = strtoull(str, &p, 10);
+    if ((p == str) || (errno == ERANGE) || (n == 0)) {
+        goto err;
+    }
+    if (!strcasecmp(p, "k")) {
+        scale = 1024;
+    }
+    else if (!strcasecmp(p, "m")) {
+        scale = 1024 * 1024;
+    }
+    else if (!strcasecmp(p, "g")) {
+        scale = 1024 * 1024 * 1024;
+    }
+    else if (*p != '\0') {
+        goto err;
+    }
+    if (n > UINT64_MAX / scale) {
+        goto err;
+    }
+    opts->maxSize = n * scale;
+    return(0);
+
+err:
+    if ((errbuf != NULL) && (errlen > 0))
+        snprintf(errbuf, errlen, "invalid logopt maxsize value \"%s\"", str);
+    return(-1);
+}
+
+
+static int parse_log_keep(logopt_t *opts, const char *str,
+    char *errbuf, int errlen)
+{
+/*  Parses the value 'str' of a "keep=" logopt (ie, the number of rotated
+ *    logfiles kept) into 'opts'.
+ *  Returns 0 on success, or -1 on error (writing an error message into
+ *    'errbuf' if defined).
+ */
+    long n;
+    char *p;
+
+    errno = 0;
+    n = strtol(str, &p, 10);
+    if ((p == str) || (*p != '\0') || (errno == ERANGE) || (n < 0)) {
+        if ((errbuf != NULL) && (errlen > 0))
+            snprintf(errbuf, errlen, "invalid logopt keep value \"%s\"", str);
+        return(-1);
+    }
+    if (n > MAX_LOG_KEEP) {
+        if ((errbuf != NULL) && (errlen > 0))
+            snprintf(errbuf, errlen, "logopt keep exceeds max of %d",
+                MAX_LOG_KEEP);
+        return(-1);
+    }
+    opts->numKeep = n;
+    return(0);
+}
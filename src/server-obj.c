@@ -33,6 +33,7 @@
 #include <assert.h>
 #include <ctype.h>
 #include <errno.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdlib.h>
@@ -51,15 +52,93 @@
 #include "util.h"
 #include "wrapper.h"
 
-extern tpoll_t tp_global;               /* defined in server.c */
+/*  The 'links_lock' serializes changes to the links between objs along with
+ *    the notifications written to a console's readers & writers.
+ *  A client can be linked to consoles owned by other event loops (eg, during
+ *    a broadcast session), so this lock ensures a client that has been
+ *    unlinked by its own loop is no longer referenced by any other loop
+ *    by the time it is destroyed.
+ *  Each obj's readers & writers sets also have their own lock, which is
+ *    acquired after this lock when a set is changed; this allows a console
+ *    to write out to its readers without acquiring this lock.
+ */
+static pthread_mutex_t links_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*  Data written to an obj by a thread other than the one running its event
+ *    loop is queued in the obj's inbox as a msg followed by the data itself.
+ */
+typedef struct obj_msg {
+    int              len;               /* num bytes of data following msg   */
+    int              isInfo;            /* true if informational message     */
+} obj_msg_t;
+
+#define FAN_POS_ATTACHED                UINT64_MAX
+
+/*  Objs are allocated from slabs of OBJ_SLAB_COUNT objs each, with each obj
+ *    padded to a multiple of the cache line size so its leading fields (those
+ *    accessed when its event loop dispatches its I/O) occupy a single line.
+ *  Like the List allocator, destroyed objs are kept on a free list for reuse
+ *    rather than returned to the heap; the free list is linked through the
+ *    'fanSrc' ptr of each free obj.
+ */
+#define OBJ_SLAB_COUNT                  32
+#define OBJ_SLAB_STRIDE \
+    ((sizeof(obj_t) + OBJ_CACHE_LINE_SIZE - 1) & ~(OBJ_CACHE_LINE_SIZE - 1))
 
+static obj_t *free_objs = NULL;
+static pthread_mutex_t free_objs_lock = PTHREAD_MUTEX_INITIALIZER;
 
+
+static obj_t * alloc_obj(void);
+static void free_obj(obj_t *obj);
+static void insert_loop_client(obj_t *client);
+static void set_client_overrun_policy(obj_t *client, server_conf_t *conf);
+static int get_overrun_strictness(overrun_policy_t policy);
+static void format_overrun_policy(char *dst, int dstlen,
+    overrun_policy_t policy, int limit);
 static char * sanitize_file_string(char *str);
 static char * find_trailing_int_str(char *str);
 #ifndef NDEBUG
 static int validate_obj_links(obj_t *obj);
 #endif /* !NDEBUG */
+static int is_obj_owner(obj_t *obj);
 static int num_bytes_buffered(obj_t *obj);
+static uint64_t get_fan_end(obj_t *obj);
+static int num_fan_bytes_pending(obj_t *obj, int *lostp);
+static void attach_fan_reader(obj_t *console, obj_t *reader);
+static void detach_fan_reader(obj_t *console, obj_t *reader);
+static int overrun_fan_reader(obj_t *console, obj_t *reader, int n);
+static int update_fan_reader(obj_t *console, obj_t *reader);
+static void write_fan_data(obj_t *console, unsigned char *buf, int n);
+static int append_obj_data(obj_t *obj, const void *src, int len, int *lostp);
+static int copy_obj_data(obj_t *obj, const void *src, int len, int *lostp);
+static void copy_fan_data(obj_t *obj);
+static void lose_obj_data(obj_t *obj, int lost);
+static int num_bytes_spooled(obj_t *obj);
+static int write_spool_data(obj_t *obj, const void *src, int len);
+static void read_spool_data(obj_t *obj);
+static int read_replay_data(obj_t *obj);
+static void write_lost_marker(obj_t *obj);
+static int store_obj_data(obj_t *obj, const void *src, int len, int isInfo);
+static int defer_obj_write(obj_t *obj);
+static void expire_obj_flush(obj_t *obj);
+static int write_obj_iov(obj_t *obj, struct iovec *iov, int iovcnt);
+static int post_obj_data(obj_t *obj, const void *src, int len, int isInfo);
+static void drain_obj_inbox(obj_t *obj);
+static void init_obj_set(obj_set_t *set);
+static void destroy_obj_set(obj_set_t *set);
+static void lock_obj_set(obj_set_t *set);
+static void unlock_obj_set(obj_set_t *set);
+static int find_obj_set(obj_set_t *set, obj_t *obj);
+static void insert_obj_set(obj_set_t *set, obj_t *obj);
+static int remove_obj_set(obj_set_t *set, obj_t *obj);
+static void notify_console_objs_unlocked(obj_t *console, char *msg);
+static void unlink_objs_unlocked(obj_t *src, obj_t *dst);
+static void unlink_obj_unlocked(obj_t *obj);
+static void update_fd_objs(loop_t *loop);
+static void update_fd_obj(loop_t *loop, obj_t *obj);
+static int splice_from_obj(obj_t *console, obj_t *logfile);
+static int process_obj_escapes(obj_t *obj, unsigned char *buf, int n);
 
 
 obj_t * create_obj(
@@ -72,20 +151,35 @@ obj_t * create_obj(
     assert(conf != NULL);
     assert(name != NULL);
 
-    if (!(obj = malloc(sizeof(obj_t))))
-        out_of_memory();
+    obj = alloc_obj();
     obj->name = create_string(name);
     obj->fd = fd;
-    obj->bufInPtr = obj->bufOutPtr = obj->buf;
-    x_pthread_mutex_init(&obj->bufLock, NULL);
-    obj->readers = list_create(NULL);
-    obj->writers = list_create(NULL);
+    obj->fdIndex = -1;
+    obj->loop = NULL;
+    /*
+     *  The circular-buf is allocated by create_obj_buf() once its size is
+     *    known.  A bufSize of 0 selects the server's default size.
+     */
+    obj->ring = NULL;
+    obj->buf = obj->bufInPtr = obj->bufOutPtr = NULL;
+    obj->bufSize = 0;
+    obj->inbox = list_create((ListDelF) free);
+    obj->numInbox = 0;
+    obj->fan = NULL;
+    obj->fanSrc = NULL;
+    obj->fanPos = 0;
+    obj->fanEnd = FAN_POS_ATTACHED;
+    init_obj_set(&obj->readers);
+    init_obj_set(&obj->writers);
     if ((type == 0) || (type >= CONMAN_OBJ_LAST_ENTRY)) {
         log_err(0, "INTERNAL: Unrecognized object [%s] type=%d", name, type);
     }
     obj->type = type;
     obj->gotBufWrap = 0;
     obj->gotEOF = 0;
+    obj->numReadBytes = 0;
+    obj->numReads = 0;
+    obj->numReadWakeups = 0;
     /*
      *  resetCmdRef, resetCmdPid, and resetCmdTimer only apply to console objs.
      *  But the code is simplified if they are placed in the base obj.
@@ -103,10 +197,13 @@ obj_t * create_client_obj(server_conf_t *conf, req_t *req)
 {
 /*  Creates a new client object and adds it to the master objs list.
  *    Note: the socket is open and set for non-blocking I/O.
+ *  The client is owned by the event loop of the first console in its request
+ *    so an R/O or R/W session is serviced by the same loop as its console.
  *  Returns the new object.
  */
     char name[MAX_LINE];
     obj_t *client;
+    obj_t *console;
 
     assert(conf != NULL);
     assert(req != NULL);
@@ -116,7 +213,6 @@ obj_t * create_client_obj(server_conf_t *conf, req_t *req)
 
     set_fd_nonblocking(req->sd);
     set_fd_closed_on_exec(req->sd);
-    tpoll_set(tp_global, req->sd, POLLIN);
 
     snprintf(name, sizeof(name), "%s@%s:%d", req->user, req->host, req->port);
     name[sizeof(name) - 1] = '\0';
@@ -125,12 +221,44 @@ obj_t * create_client_obj(server_conf_t *conf, req_t *req)
     time(&client->aux.client.timeLastRead);
     if (client->aux.client.timeLastRead == (time_t) -1)
         log_err(errno, "time() failed");
+    client->aux.client.overrunPolicy = conf->overrunPolicy;
+    client->aux.client.overrunLimit = conf->overrunLimit;
+    client->aux.client.spool = NULL;
+    client->aux.client.spoolHead = 0;
+    client->aux.client.spoolLen = 0;
+    client->aux.client.numOverruns = 0;
+    client->aux.client.numBytesLost = 0;
+    client->aux.client.numBytesLimited = 0;
+    client->aux.client.numBytesSpooled = 0;
+    client->aux.client.numBytesUnmarked = 0;
+    client->aux.client.replay = NULL;
+    client->aux.client.prev = NULL;
+    client->aux.client.next = NULL;
     client->aux.client.gotEscape = 0;
-    client->aux.client.gotSuspend = 0;
+    client->aux.client.gotOverrunLimit = 0;
+    /*
+     *  The client's output is suspended until its handshake thread has
+     *    finished with it (cf. start_client_obj()).
+     */
+    client->aux.client.gotSuspend = 1;
+
+    console = list_peek(req->consoles);
+    assert(is_console_obj(console));
+    assert(console->loop != NULL);
+    client->loop = console->loop;
+    /*
+     *  Console data is written out from the console's fan-out ring,
+     *    so the client's own circular-buf only needs to hold messages.
+     */
+    create_obj_buf(client, OBJ_MSG_BUF_SIZE);
 
-    /*  Add obj to the master conf->objs list.
+    /*  Add obj to its loop's client list before its fd can be reported ready.
+     *  Clients are not added to the master conf->objs list since they are
+     *    destroyed by their loop (cf. destroy_client_obj()).
      */
-    list_append(conf->objs, client);
+    insert_loop_client(client);
+
+    set_client_overrun_policy(client, conf);
 
     DPRINTF((9, "Opened client: fd=%d user=%s tty=%s host=%s port=%d.\n",
         req->sd, req->user, req->tty, req->host, req->port));
@@ -138,19 +266,183 @@ obj_t * create_client_obj(server_conf_t *conf, req_t *req)
 }
 
 
+static void insert_loop_client(obj_t *client)
+{
+/*  Inserts the (client) at the head of its loop's client list.
+ *  The list is doubly-linked through the client objs so a client can be
+ *    removed in constant time by destroy_client_obj().
+ */
+    loop_t *loop = client->loop;
+
+    x_pthread_mutex_lock(&loop->lock);
+    client->aux.client.prev = NULL;
+    client->aux.client.next = loop->clients;
+    if (loop->clients) {
+        loop->clients->aux.client.prev = client;
+    }
+    loop->clients = client;
+    loop->numClients++;
+    x_pthread_mutex_unlock(&loop->lock);
+    return;
+}
+
+
+static void set_client_overrun_policy(obj_t *client, server_conf_t *conf)
+{
+/*  Applies the overrun policy requested by the (client), if any.
+ *  A client may only make the server's policy stricter: it may choose
+ *    a stricter policy, or the same policy with a lower limit.  Otherwise,
+ *    the request is refused (since a client could, for instance, spool onto
+ *    the server's disk when the server does not spool), and the client is
+ *    warned that it retains the server's policy.
+ */
+    req_t *req = client->aux.client.req;
+    char want[MAX_LINE];
+    char have[MAX_LINE];
+    char buf[MAX_LINE];
+
+    if (!req->gotOverrunPolicy) {
+        return;
+    }
+    if ((get_overrun_strictness(req->overrunPolicy)
+                > get_overrun_strictness(conf->overrunPolicy))
+            || ((req->overrunPolicy == conf->overrunPolicy)
+                && (req->overrunLimit <= conf->overrunLimit))) {
+        client->aux.client.overrunPolicy = req->overrunPolicy;
+        client->aux.client.overrunLimit = req->overrunLimit;
+        return;
+    }
+    format_overrun_policy(want, sizeof(want),
+        req->overrunPolicy, req->overrunLimit);
+    format_overrun_policy(have, sizeof(have),
+        conf->overrunPolicy, conf->overrunLimit);
+    log_msg(LOG_NOTICE, "Client [%s] refused overrun policy \"%s\"",
+        client->name, want);
+    snprintf(buf, sizeof(buf),
+        "%sOverrun policy \"%s\" refused; using \"%s\" instead%s",
+        CONMAN_MSG_PREFIX, want, have, CONMAN_MSG_SUFFIX);
+    strcpy(&buf[sizeof(buf) - 3], "\r\n");
+    write_obj_data(client, buf, strlen(buf), 1);
+    return;
+}
+
+
+static int get_overrun_strictness(overrun_policy_t policy)
+{
+/*  Returns the strictness of the overrun (policy) for ranking the policy
+ *    requested by a client against that of the server: spooling is the most
+ *    lenient since it consumes the server's disk, and disconnecting is the
+ *    strictest since it ends the client's session.
+ */
+    switch (policy) {
+    case CONMAN_OVERRUN_SPOOL:
+        return(0);
+    case CONMAN_OVERRUN_MARKER:
+        return(1);
+    case CONMAN_OVERRUN_DISCONNECT:
+        return(2);
+    }
+    return(0);
+}
+
+
+static void format_overrun_policy(char *dst, int dstlen,
+    overrun_policy_t policy, int limit)
+{
+/*  Formats the overrun (policy) and its (limit) into the buffer (dst)
+ *    of length (dstlen) in the form parsed by parse_overrun_policy().
+ */
+    if (policy == CONMAN_OVERRUN_MARKER) {
+        snprintf(dst, dstlen, "marker");
+    }
+    else {
+        snprintf(dst, dstlen, "%s:%d",
+            (policy == CONMAN_OVERRUN_SPOOL ? "spool" : "disconnect"), limit);
+    }
+    return;
+}
+
+
+void start_client_obj(obj_t *client)
+{
+/*  Starts servicing the client obj by its event loop once the client's
+ *    handshake thread has linked it to its console(s).
+ *  Since the loop can then shut down and destroy the client at any time,
+ *    the handshake thread must not reference the client afterwards.
+ */
+    assert(is_client_obj(client));
+    assert(client->aux.client.gotSuspend);
+
+    client->aux.client.gotSuspend = 0;
+    tpoll_set(client->loop->tp, client->fd, POLLIN | POLLOUT);
+    return;
+}
+
+
+void create_obj_buf(obj_t *obj, int size)
+{
+/*  Allocates the obj's circular-buffer with a size of at least (size) bytes.
+ *    If the obj is a console, its fan-out ring of the same size is allocated
+ *    as well; data read from the console is written once into this ring,
+ *    and each of its attached readers writes it out from there.
+ *  Both are allocated as vrings whose memory is followed by a mirror of
+ *    itself, so any span of data therein is contiguous even where it wraps
+ *    around the end of the buffer.  A vring's size may be rounded up to
+ *    a multiple of the page size.
+ *  This must be called after the config has been parsed (since a console's
+ *    bufsize can be overridden) and before any data is written to the obj.
+ */
+    fan_ring_t *fan;
+
+    assert(obj != NULL);
+    assert(obj->buf == NULL);
+    assert(size >= MIN_OBJ_BUF_SIZE);
+    assert(size <= MAX_OBJ_BUF_SIZE);
+
+    if (!(obj->ring = vring_create(size))) {
+        out_of_memory();
+    }
+    obj->buf = vring_buf(obj->ring);
+    obj->bufSize = vring_size(obj->ring);
+    obj->bufInPtr = obj->bufOutPtr = obj->buf;
+
+    if (is_console_obj(obj)) {
+        assert(obj->fan == NULL);
+        if (!(fan = malloc(sizeof(fan_ring_t)))) {
+            out_of_memory();
+        }
+        if (!(fan->ring = vring_create(size))) {
+            out_of_memory();
+        }
+        fan->buf = vring_buf(fan->ring);
+        fan->size = vring_size(fan->ring);
+        fan->head = 0;
+        fan->numSpliced = 0;
+        obj->fan = fan;
+    }
+    return;
+}
+
+
 void destroy_obj(obj_t *obj)
 {
 /*  Destroys the object, closing the fd and freeing resources as needed.
- *  This routine should only be called via the obj's list destructor, thereby
- *    ensuring it will be removed from the master objs list before destruction.
+ *  This routine should only be called via the obj's list destructor
+ *    (or via destroy_client_obj() for client objs), thereby ensuring
+ *    it will be removed from its objs list before destruction.
  */
     int n;
     char **pp;
 
     assert(obj != NULL);
     DPRINTF((10, "Destroying object [%s].\n", obj->name));
+    if (obj->numReadWakeups > 0) {
+        DPRINTF((5, "Performed %lu reads in %lu wakeups for [%s] "
+            "(avg %.2f).\n", obj->numReads, obj->numReadWakeups, obj->name,
+            (double) obj->numReads / obj->numReadWakeups));
+    }
 
-    n = num_bytes_buffered(obj);
+    n = num_bytes_buffered(obj) + num_bytes_spooled(obj);
     if (n > 0) {
         log_msg(LOG_WARNING,
             "Destroying [%s] with %d byte%s of unwritten data",
@@ -159,6 +451,22 @@ void destroy_obj(obj_t *obj)
 
     switch(obj->type) {
     case CONMAN_OBJ_CLIENT:
+        if ((obj->aux.client.numOverruns > 0)
+                || (obj->aux.client.numBytesSpooled > 0)) {
+            log_msg(LOG_INFO, "Client [%s] lost %lu byte%s in %lu overrun%s "
+                "and spooled %lu byte%s", obj->name,
+                obj->aux.client.numBytesLost,
+                (obj->aux.client.numBytesLost == 1 ? "" : "s"),
+                obj->aux.client.numOverruns,
+                (obj->aux.client.numOverruns == 1 ? "" : "s"),
+                obj->aux.client.numBytesSpooled,
+                (obj->aux.client.numBytesSpooled == 1 ? "" : "s"));
+        }
+        if (obj->aux.client.spool) {
+            (void) fclose(obj->aux.client.spool);
+            obj->aux.client.spool = NULL;
+        }
+        stop_log_replay(obj);
         if (obj->aux.client.req) {
             req_t *req = obj->aux.client.req;
             log_msg(LOG_INFO, "Client <%s@%s:%d> disconnected",
@@ -172,6 +480,21 @@ void destroy_obj(obj_t *obj)
         if (obj->aux.logfile.fmtName) {
             free(obj->aux.logfile.fmtName);
         }
+        if (obj->aux.logfile.pipeFds[0] >= 0) {
+            (void) close(obj->aux.logfile.pipeFds[0]);
+            (void) close(obj->aux.logfile.pipeFds[1]);
+        }
+        /*  The data queued for the logfile's writer thread is written out
+         *    (and its fd closed) before the obj is released.
+         */
+        if (obj->aux.logfile.writer) {
+            if (obj->fd >= 0) {
+                queue_log_close(obj);
+                obj->fd = -1;
+            }
+            wait_log_writes(obj);
+        }
+        close_logfile_index(obj);
         break;
     case CONMAN_OBJ_PROCESS:
         for (pp = obj->aux.process.argv; *pp != NULL; pp++) {
@@ -237,15 +560,27 @@ void destroy_obj(obj_t *obj)
         break;
     }
 
-    x_pthread_mutex_destroy(&obj->bufLock);
-    if (obj->readers) {
-        list_destroy(obj->readers);
+    if (obj->loop && (obj->fdIndex >= 0)
+            && (obj->fdIndex < obj->loop->fdObjsLen)
+            && (obj->loop->fdObjs[obj->fdIndex] == obj)) {
+        obj->loop->fdObjs[obj->fdIndex] = NULL;
+    }
+    if (obj->ring) {
+        vring_destroy(obj->ring);
+    }
+    if (obj->inbox) {
+        list_destroy(obj->inbox);
     }
-    if (obj->writers) {
-        list_destroy(obj->writers);
+    if (obj->fan) {
+        vring_destroy(obj->fan->ring);
+        free(obj->fan);
     }
+    destroy_obj_set(&obj->readers);
+    destroy_obj_set(&obj->writers);
     if (obj->fd >= 0) {
-        tpoll_clear(tp_global, obj->fd, POLLIN | POLLOUT);
+        if (obj->loop) {
+            tpoll_clear(obj->loop->tp, obj->fd, POLLIN | POLLOUT);
+        }
         if (close(obj->fd) < 0) {
             log_msg(LOG_WARNING, "Unable to close [%s] during destruction: %s",
                 obj->name, strerror(errno));
@@ -255,7 +590,78 @@ void destroy_obj(obj_t *obj)
     if (obj->name) {
         free(obj->name);
     }
-    free(obj);
+    free_obj(obj);
+    return;
+}
+
+
+void destroy_client_obj(obj_t *client)
+{
+/*  Removes the (client) from its loop's client list and destroys it.
+ *  This routine should only be called by the thread running the client's
+ *    event loop (or once that loop has stopped).
+ */
+    loop_t *loop;
+
+    assert(is_client_obj(client));
+    assert(client->loop != NULL);
+
+    loop = client->loop;
+    x_pthread_mutex_lock(&loop->lock);
+    if (client->aux.client.prev) {
+        client->aux.client.prev->aux.client.next = client->aux.client.next;
+    }
+    else {
+        assert(loop->clients == client);
+        loop->clients = client->aux.client.next;
+    }
+    if (client->aux.client.next) {
+        client->aux.client.next->aux.client.prev = client->aux.client.prev;
+    }
+    loop->numClients--;
+    x_pthread_mutex_unlock(&loop->lock);
+
+    destroy_obj(client);
+    return;
+}
+
+
+static obj_t * alloc_obj(void)
+{
+/*  Allocates an uninitialized obj from the free list,
+ *    carving a new slab of objs when the list is empty.
+ */
+    void *slab = NULL;
+    obj_t *obj;
+    int i;
+
+    x_pthread_mutex_lock(&free_objs_lock);
+    if (!free_objs) {
+        if (posix_memalign(&slab, OBJ_CACHE_LINE_SIZE,
+                OBJ_SLAB_COUNT * OBJ_SLAB_STRIDE) != 0) {
+            out_of_memory();
+        }
+        for (i = OBJ_SLAB_COUNT - 1; i >= 0; i--) {
+            obj = (obj_t *) ((unsigned char *) slab + (i * OBJ_SLAB_STRIDE));
+            obj->fanSrc = free_objs;
+            free_objs = obj;
+        }
+    }
+    obj = free_objs;
+    free_objs = obj->fanSrc;
+    x_pthread_mutex_unlock(&free_objs_lock);
+    return(obj);
+}
+
+
+static void free_obj(obj_t *obj)
+{
+/*  Returns the destroyed obj to the free list.
+ */
+    x_pthread_mutex_lock(&free_objs_lock);
+    obj->fanSrc = free_objs;
+    free_objs = obj;
+    x_pthread_mutex_unlock(&free_objs_lock);
     return;
 }
 
@@ -512,6 +918,36 @@ int find_obj(obj_t *obj, obj_t *key)
 }
 
 
+obj_t * find_obj_by_fd(loop_t *loop, int fd)
+{
+/*  Locates the object owned by (loop) that is opened on (fd).
+ *  The loop's fd table is only accessed by the thread running that loop,
+ *    and is rebuilt from the loop's objs & client lists whenever a lookup
+ *    finds a missing or stale entry.
+ *  Returns the object, or NULL if not found.
+ */
+    obj_t *obj;
+
+    assert(loop != NULL);
+
+    if (fd < 0) {
+        return(NULL);
+    }
+    if ((fd < loop->fdObjsLen) && (obj = loop->fdObjs[fd])
+            && (obj->fd == fd)) {
+        return(obj);
+    }
+    update_fd_objs(loop);
+
+    if ((fd < loop->fdObjsLen) && (obj = loop->fdObjs[fd])
+            && (obj->fd == fd)) {
+        return(obj);
+    }
+    DPRINTF((15, "Unable to find object for fd=%d.\n", fd));
+    return(NULL);
+}
+
+
 int write_notify_msg(obj_t *console, int priority, char *fmt, ...)
 {
 /*  Writes a notification message to the daemon logfile and all attached
@@ -577,27 +1013,36 @@ void notify_console_objs(obj_t *console, char *msg)
 /*  Notifies all readers & writers of (console) with the informational (msg).
  *  If an obj is both a reader and a writer, it will only be notified once.
  */
-    ListIterator i;
+    x_pthread_mutex_lock(&links_lock);
+    notify_console_objs_unlocked(console, msg);
+    x_pthread_mutex_unlock(&links_lock);
+    return;
+}
+
+
+static void notify_console_objs_unlocked(obj_t *console, char *msg)
+{
+/*  Notifies all readers & writers of (console) with the informational (msg)
+ *    while the 'links_lock' is held by the caller.
+ */
     obj_t *obj;
+    int n;
 
     assert(is_console_obj(console));
 
     if (!msg || !strlen(msg)) {
         return;
     }
-    i = list_iterator_create(console->readers);
-    while ((obj = list_next(i))) {
+    for (n = 0; n < console->readers.numObjs; n++) {
+        obj = console->readers.objs[n];
         write_obj_data(obj, msg, strlen(msg), 1);
     }
-    list_iterator_destroy(i);
-
-    i = list_iterator_create(console->writers);
-    while ((obj = list_next(i))) {
-        if (!list_find_first(console->readers, (ListFindF) find_obj, obj)) {
+    for (n = 0; n < console->writers.numObjs; n++) {
+        obj = console->writers.objs[n];
+        if (!find_obj_set(&console->readers, obj)) {
             write_obj_data(obj, msg, strlen(msg), 1);
         }
     }
-    list_iterator_destroy(i);
     return;
 }
 
@@ -611,14 +1056,16 @@ void link_objs(obj_t *src, obj_t *dst)
     char *now;
     char *tty;
     char buf[MAX_LINE];
-    ListIterator i;
     obj_t *writer;
+    int n;
+
+    x_pthread_mutex_lock(&links_lock);
 
     if (is_client_obj(src) && is_console_obj(dst)) {
 
         gotBcast = src->aux.client.req->enableBroadcast;
         gotStolen = src->aux.client.req->enableForce
-            && !list_is_empty(dst->writers);
+            && (dst->writers.numObjs > 0);
         now = create_short_time_string(0);
 
         /*  Notify existing console readers and writers
@@ -632,12 +1079,12 @@ void link_objs(obj_t *src, obj_t *dst)
             src->aux.client.req->user, src->aux.client.req->host,
             (tty ? " on " : ""), (tty ? tty : ""), now, CONMAN_MSG_SUFFIX);
         strcpy(&buf[sizeof(buf) - 3], "\r\n");
-        notify_console_objs(dst, buf);
+        notify_console_objs_unlocked(dst, buf);
 
         /*  Write msg(s) to new client regarding existing console writer(s).
          */
-        i = list_iterator_create(dst->writers);
-        while ((writer = list_next(i))) {
+        for (n = 0; n < dst->writers.numObjs; n++) {
+            writer = dst->writers.objs[n];
             assert(is_client_obj(writer));
             tty = writer->aux.client.req->tty;
             snprintf(buf, sizeof(buf),
@@ -649,18 +1096,15 @@ void link_objs(obj_t *src, obj_t *dst)
             strcpy(&buf[sizeof(buf) - 3], "\r\n");
             write_obj_data(src, buf, strlen(buf), 1);
         }
-        list_iterator_destroy(i);
 
         /*  If the client is forcing the console session,
          *    disconnect existing clients with write-privileges.
          */
         if (gotStolen) {
-            i = list_iterator_create(dst->writers);
-            while ((writer = list_next(i))) {
+            while ((writer = get_obj_set(&dst->writers, 0))) {
                 assert(is_client_obj(writer));
-                unlink_obj(writer);
+                unlink_obj_unlocked(writer);
             }
-            list_iterator_destroy(i);
         }
 
         free(now);
@@ -668,14 +1112,19 @@ void link_objs(obj_t *src, obj_t *dst)
 
     /*  Create link from src reads to dst writes.
      */
-    assert(!list_find_first(src->readers, (ListFindF) find_obj, dst));
-    list_append(src->readers, dst);
-    assert(!list_find_first(dst->writers, (ListFindF) find_obj, src));
-    list_append(dst->writers, src);
+    if (is_console_obj(src)) {
+        attach_fan_reader(src, dst);
+    }
+    assert(!find_obj_set(&src->readers, dst));
+    insert_obj_set(&src->readers, dst);
+    assert(!find_obj_set(&dst->writers, src));
+    insert_obj_set(&dst->writers, src);
 
     DPRINTF((10, "Linked [%s] reads to [%s] writes.\n", src->name, dst->name));
     assert(validate_obj_links(src) >= 0);
     assert(validate_obj_links(dst) >= 0);
+
+    x_pthread_mutex_unlock(&links_lock);
     return;
 }
 
@@ -684,17 +1133,69 @@ void unlink_objs(obj_t *src, obj_t *dst)
 {
 /*  Destroys the link allowing data read from (src) to be written to (dst)
  *    (ie, the link from src readers to dst writers).
+ */
+    x_pthread_mutex_lock(&links_lock);
+    unlink_objs_unlocked(src, dst);
+    x_pthread_mutex_unlock(&links_lock);
+    return;
+}
+
+
+void unlink_obj(obj_t *obj)
+{
+/*  Destroys all links between (obj) and its readers & writers.
+ */
+    x_pthread_mutex_lock(&links_lock);
+    unlink_obj_unlocked(obj);
+    x_pthread_mutex_unlock(&links_lock);
+    return;
+}
+
+
+int count_obj_set(obj_set_t *set)
+{
+/*  Returns the number of objs in the (set).
+ */
+    assert(set != NULL);
+
+    return(__atomic_load_n(&set->numObjs, __ATOMIC_RELAXED));
+}
+
+
+obj_t * get_obj_set(obj_set_t *set, int n)
+{
+/*  Returns the (n)th obj in the (set), or NULL if there is no such obj.
+ *  Like a List iterator, this allows a set that may be changed by other
+ *    threads to be traversed by index without holding its lock throughout.
+ */
+    obj_t *obj;
+
+    assert(set != NULL);
+    assert(n >= 0);
+
+    lock_obj_set(set);
+    obj = (n < set->numObjs) ? set->objs[n] : NULL;
+    unlock_obj_set(set);
+    return(obj);
+}
+
+
+static void unlink_objs_unlocked(obj_t *src, obj_t *dst)
+{
+/*  Destroys the link from (src) reads to (dst) writes
+ *    while the 'links_lock' is held by the caller.
  */
     int n;
     char *now;
     char *tty;
     char buf[MAX_LINE];
 
-    if (list_delete_all(src->readers, (ListFindF) find_obj, dst)) {
+    if (remove_obj_set(&src->readers, dst)) {
         DPRINTF((10, "Removing [%s] from [%s] readers.\n",
             dst->name, src->name));
+        detach_fan_reader(src, dst);
     }
-    if ((n = list_delete_all(dst->writers, (ListFindF) find_obj, src))) {
+    if ((n = remove_obj_set(&dst->writers, src))) {
         DPRINTF((10, "Removing [%s] from [%s] writers.\n",
             src->name, dst->name));
     }
@@ -714,7 +1215,7 @@ void unlink_objs(obj_t *src, obj_t *dst)
             (tty ? " on " : ""), (tty ? tty : ""), now, CONMAN_MSG_SUFFIX);
         free(now);
         strcpy(&buf[sizeof(buf) - 3], "\r\n");
-        notify_console_objs(dst, buf);
+        notify_console_objs_unlocked(dst, buf);
     }
 
     /*  If a client obj has become completely unlinked, set its EOF flag.
@@ -722,12 +1223,12 @@ void unlink_objs(obj_t *src, obj_t *dst)
      *    and the obj will be closed once its buffer is empty.
      */
     if (is_client_obj(src)
-            && list_is_empty(src->readers) && list_is_empty(src->writers)) {
+            && (src->readers.numObjs == 0) && (src->writers.numObjs == 0)) {
         assert(is_console_obj(dst));
         src->gotEOF = 1;
     }
     else if (is_client_obj(dst)
-            && list_is_empty(dst->readers) && list_is_empty(dst->writers)) {
+            && (dst->readers.numObjs == 0) && (dst->writers.numObjs == 0)) {
         assert(is_console_obj(src));
         dst->gotEOF = 1;
     }
@@ -740,56 +1241,175 @@ void unlink_objs(obj_t *src, obj_t *dst)
 }
 
 
-void unlink_obj(obj_t *obj)
+static void unlink_obj_unlocked(obj_t *obj)
 {
-/*  Destroys all links between (obj) and its readers & writers.
+/*  Destroys all links between (obj) and its readers & writers
+ *    while the 'links_lock' is held by the caller.
  */
     obj_t *x;
 
-    while ((x = list_peek(obj->writers))) {
-        unlink_objs(x, obj);
+    while ((x = get_obj_set(&obj->writers, 0))) {
+        unlink_objs_unlocked(x, obj);
+    }
+    while ((x = get_obj_set(&obj->readers, 0))) {
+        unlink_objs_unlocked(obj, x);
+    }
+    return;
+}
+
+
+static void init_obj_set(obj_set_t *set)
+{
+/*  Initializes the (set) to be empty.
+ *  Objs are stored in the set's inline array until it overflows,
+ *    at which point they spill into an array allocated on the heap.
+ */
+    assert(set != NULL);
+
+    set->objs = set->inlineObjs;
+    set->numObjs = 0;
+    set->maxObjs = OBJ_SET_INLINE_LEN;
+    x_pthread_mutex_init(&set->lock, NULL);
+    return;
+}
+
+
+static void destroy_obj_set(obj_set_t *set)
+{
+/*  Releases the resources held by the (set).
+ */
+    assert(set != NULL);
+
+    if (set->objs != set->inlineObjs) {
+        free(set->objs);
+    }
+    set->objs = NULL;
+    set->numObjs = 0;
+    set->maxObjs = 0;
+    x_pthread_mutex_destroy(&set->lock);
+    return;
+}
+
+
+static void lock_obj_set(obj_set_t *set)
+{
+/*  Locks the (set) so it can be traversed without holding the 'links_lock'.
+ *  The set cannot be changed while it is locked, so the caller must not
+ *    link or unlink objs (or acquire the 'links_lock') until it is unlocked.
+ */
+    x_pthread_mutex_lock(&set->lock);
+    return;
+}
+
+
+static void unlock_obj_set(obj_set_t *set)
+{
+/*  Unlocks the (set).
+ */
+    x_pthread_mutex_unlock(&set->lock);
+    return;
+}
+
+
+static int find_obj_set(obj_set_t *set, obj_t *obj)
+{
+/*  Returns true if (obj) is in the (set); o/w, returns false.
+ *  The 'links_lock' (or the set's lock) must be held by the caller.
+ */
+    int n;
+
+    for (n = 0; n < set->numObjs; n++) {
+        if (set->objs[n] == obj) {
+            return(1);
+        }
     }
-    while ((x = list_peek(obj->readers))) {
-        unlink_objs(obj, x);
+    return(0);
+}
+
+
+static void insert_obj_set(obj_set_t *set, obj_t *obj)
+{
+/*  Appends (obj) to the (set), spilling the set onto the heap if needed.
+ *  The 'links_lock' must be held by the caller.
+ */
+    obj_t **objs;
+    int max;
+
+    lock_obj_set(set);
+    if (set->numObjs == set->maxObjs) {
+        max = set->maxObjs * 2;
+        if (!(objs = malloc(max * sizeof(obj_t *)))) {
+            out_of_memory();
+        }
+        memcpy(objs, set->objs, set->numObjs * sizeof(obj_t *));
+        if (set->objs != set->inlineObjs) {
+            free(set->objs);
+        }
+        set->objs = objs;
+        set->maxObjs = max;
     }
+    set->objs[set->numObjs] = obj;
+    __atomic_store_n(&set->numObjs, set->numObjs + 1, __ATOMIC_RELAXED);
+    unlock_obj_set(set);
     return;
 }
 
 
+static int remove_obj_set(obj_set_t *set, obj_t *obj)
+{
+/*  Removes (obj) from the (set), preserving the order of the remaining objs.
+ *  The 'links_lock' must be held by the caller.
+ *  Returns the number of objs removed.
+ */
+    int n;
+    int found = 0;
+
+    lock_obj_set(set);
+    for (n = 0; n < set->numObjs; n++) {
+        if (set->objs[n] == obj) {
+            memmove(&set->objs[n], &set->objs[n + 1],
+                (set->numObjs - n - 1) * sizeof(obj_t *));
+            __atomic_store_n(&set->numObjs, set->numObjs - 1,
+                __ATOMIC_RELAXED);
+            found = 1;
+            break;
+        }
+    }
+    unlock_obj_set(set);
+    return(found);
+}
+
+
 #ifndef NDEBUG
 static int validate_obj_links(obj_t *obj)
 {
-/*  Validates the readers and writers lists are successfully linked
+/*  Validates the readers and writers sets are successfully linked
  *    to other objects.
  *  Returns 0 if the links are good; o/w, returns -1.
  */
-    ListIterator i;
     obj_t *reader;
     obj_t *writer;
     int gotError = 0;
+    int n;
 
     assert (obj != NULL);
 
-    i = list_iterator_create(obj->readers);
-    while ((reader = list_next(i))) {
-        if (!list_find_first(reader->writers, (ListFindF) find_obj, obj)) {
+    for (n = 0; n < obj->readers.numObjs; n++) {
+        reader = obj->readers.objs[n];
+        if (!find_obj_set(&reader->writers, obj)) {
             DPRINTF((1, "[%s] writes not linked to [%s] reads.\n",
                 obj->name, reader->name));
             gotError = 1;
         }
     }
-    list_iterator_destroy(i);
-
-    i = list_iterator_create(obj->writers);
-    while ((writer = list_next(i))) {
-        if (!list_find_first(writer->readers, (ListFindF) find_obj, obj)) {
+    for (n = 0; n < obj->writers.numObjs; n++) {
+        writer = obj->writers.objs[n];
+        if (!find_obj_set(&writer->readers, obj)) {
             DPRINTF((1, "[%s] reads not linked to [%s] writes.\n",
                 obj->name, writer->name));
             gotError = 1;
         }
     }
-    list_iterator_destroy(i);
-
     return(gotError ? -1 : 0);
 }
 #endif /* !NDEBUG */
@@ -816,12 +1436,18 @@ int shutdown_obj(obj_t *obj)
     }
     /*  Close the existing connection.
      */
-    tpoll_clear(tp_global, obj->fd, POLLIN | POLLOUT);
-    if (close(obj->fd) < 0) {
+    tpoll_clear(obj->loop->tp, obj->fd, POLLIN | POLLOUT);
+    if (is_logfile_obj(obj) && obj->aux.logfile.writer) {
+        queue_log_close(obj);
+    }
+    else if (close(obj->fd) < 0) {
         log_msg(LOG_WARNING, "Unable to close [%s] during shutdown: %s",
             obj->name, strerror(errno));
     }
     obj->fd = -1;
+    if (is_logfile_obj(obj)) {
+        close_logfile_index(obj);
+    }
     /*
      *  FIXME:  The connection state should ideally be marked as DOWN here if
      *    applicable (eg, telnet & unixsock), perhaps via a close_foo_obj().
@@ -832,19 +1458,25 @@ int shutdown_obj(obj_t *obj)
 
     /*  Flush the obj's buffer.
      */
-    x_pthread_mutex_lock(&obj->bufLock);
-    n = num_bytes_buffered(obj);
+    drain_obj_inbox(obj);
+    n = num_bytes_buffered(obj) + num_bytes_spooled(obj)
+        + num_fan_bytes_pending(obj, NULL);
     obj->bufInPtr = obj->bufOutPtr = obj->buf;
+    if (is_client_obj(obj)) {
+        obj->aux.client.spoolHead = obj->aux.client.spoolLen = 0;
+        stop_log_replay(obj);
+    }
+    if (obj->fanSrc && obj->fanSrc->fan) {
+        obj->fanPos = get_fan_end(obj);
+    }
     obj->gotEOF = 0;
-    x_pthread_mutex_unlock(&obj->bufLock);
     if (n > 0) {
         log_msg(LOG_WARNING,
             "Flushed %d byte%s of unwritten data from [%s]",
             n, (n == 1 ? "" : "s"), obj->name);
     }
     /*  Prepare this obj for destruction by unlinking it from all others.
-     *    It will be removed from the master objs list by mux_io(),
-     *    and the objs list destructor will destroy the obj.
+     *    It will then be destroyed by mux_io() via destroy_client_obj().
      */
     if (is_client_obj(obj)) {
         unlink_obj(obj);
@@ -872,40 +1504,233 @@ int shutdown_obj(obj_t *obj)
 int read_from_obj(obj_t *obj)
 {
 /*  Reads data from the obj's file descriptor and writes it out
- *    to the circular-buffer of each obj in its "readers" list.
+ *    to the circular-buffer of each obj in its "readers" set.
+ *  Reads are repeated until the fd would block, the server's read budget
+ *    for this wakeup has been used, or a reader lacks room for another read,
+ *    so a chatty obj can be drained without returning to tpoll() between
+ *    reads while being unable to starve the other objs in its event loop
+ *    or to overrun its readers before they have written out the data.  Data from successive reads accumulates
+ *    in the buffer so it is written out to the readers in fewer, larger
+ *    chunks.  But data from a client is written out after each read since
+ *    its escape sequences can change the objs to which it is linked.
  *  Returns the number of bytes read (>=0 on success),
  *    or -1 if the obj is ready to be destroyed.
  *
  *  An obj's circular-buffer is empty when (bufInPtr == bufOutPtr).
- *    Thus, it can hold at most (OBJ_BUF_SIZE - 1) bytes of data.
+ *    Thus, it can hold at most (bufSize - 1) bytes of data.
  *  But if the obj is a logfile, its data can grow as a result of the
  *    additional processing.  This routine's internal buffer is reduced
  *    somewhat to reduce the likelihood of log data being dropped.
+ *    It is further bounded by the size of the obj's own circular-buffer
+ *    since its readers are typically configured with the same size.
  */
     unsigned char buf[(OBJ_BUF_SIZE / 2) - 1];
+    obj_t *logfile;
+    int size;
+    int len = 0;
+    int numBytes = 0;
+    int numReads = 0;
+    int budget;
     int n;
-    int isEmpty;
-    ListIterator i;
-    obj_t *reader;
+    int e;
 
     DPRINTF((20, "Entered read_from_obj: [%s]\n", obj->name));
 
-    if (obj->fd < 0) {
+    if (!prepare_read_from_obj(obj)) {
         return(0);
     }
-    /*  Do not read from a telnet obj that is not yet in the UP state.
-     *  When the non-blocking connect completes, the fd becomes writable;
-     *    when connection establishment fails, it becomes readable & writable.
-     *  The completion of a PENDING connection is handled in write_to_obj().
-     */
-    if (is_telnet_obj(obj) && (obj->aux.telnet.state != CONMAN_TELNET_UP)) {
+    if ((logfile = get_splice_logfile_obj(obj))) {
+        if ((n = splice_from_obj(obj, logfile)) != 0) {
+            return(n);
+        }
+        if (logfile->aux.logfile.gotSplice) {
+            return(0);
+        }
+    }
+    budget = obj->loop->conf->readBudget;
+    /*
+     *  Each read is bounded by the room its readers have for the data
+     *    (including the data read into 'buf' but not yet written to them).
+     */
+    size = MIN(get_obj_read_len(obj), get_obj_readers_room(obj));
+    if (size <= 0) {
         return(0);
     }
+    assert(size <= (int) sizeof(buf));
+
+    for (;;) {
 again:
-    if ((n = read(obj->fd, buf, sizeof(buf))) < 0) {
-        if (errno == EINTR) {
-            goto again;
+        if ((n = read(obj->fd, buf + len, size - len)) < 0) {
+            if (errno == EINTR) {
+                goto again;
+            }
+        }
+        if (n <= 0) {
+            break;
+        }
+        DPRINTF((15, "Read %d bytes from [%s].\n", n, obj->name));
+        numReads++;
+        numBytes += n;
+        len += process_obj_escapes(obj, buf + len, n);
+
+        if (is_client_obj(obj) || (len >= size / 2)) {
+            write_obj_readers(obj, buf, len);
+            len = 0;
+        }
+        if ((numBytes >= budget) || (obj->fd < 0)) {
+            break;
+        }
+        size = MIN(get_obj_read_len(obj), get_obj_readers_room(obj));
+        if (size <= len) {
+            break;
+        }
+    }
+    e = errno;
+    write_obj_readers(obj, buf, len);
+
+    if (numReads > 0) {
+        obj->numReads += numReads;
+        obj->numReadWakeups++;
+        DPRINTF((15, "Performed %d read%s for [%s] wakeup (avg %.2f).\n",
+            numReads, (numReads == 1 ? "" : "s"), obj->name,
+            (double) obj->numReads / obj->numReadWakeups));
+    }
+
+    if ((n < 0) && (e != EAGAIN) && (e != EWOULDBLOCK)) {
+        errno = e;
+        return(end_read_from_obj(obj, NULL, -1));
+    }
+    if (n == 0) {
+        return(end_read_from_obj(obj, NULL, 0));
+    }
+    return(numBytes);
+}
+
+
+int get_obj_readers_room(obj_t *obj)
+{
+/*  Returns the number of bytes that can be read from the obj and written out
+ *    to its "readers" set without overwriting data that a reader has not yet
+ *    written out.  Only open logfile readers are considered since the overruns
+ *    of a client are handled according to its overrun policy, and a stalled
+ *    client must not stall the console.  Data written into the
+ *    circular-buffer of a logfile requiring additional processing can double
+ *    in size when sanitized.
+ *  Must be called by the thread running the obj's event loop.
+ */
+    obj_set_t *readers = &obj->readers;
+    obj_t *reader;
+    uint64_t pending;
+    int room = INT_MAX;
+    int n;
+    int j;
+
+    lock_obj_set(readers);
+    for (j = 0; j < readers->numObjs; j++) {
+        reader = readers->objs[j];
+        if (!is_logfile_obj(reader) || (reader->fd < 0) || reader->gotEOF) {
+            continue;
+        }
+        assert(is_obj_owner(reader));
+        n = reader->bufSize - 1 - num_bytes_buffered(reader);
+        if (obj->fan && (reader->fanSrc == obj)) {
+            pending = get_fan_end(reader) - reader->fanPos;
+            n = MIN(n, obj->fan->size)
+                - (int) MIN(pending, (uint64_t) obj->fan->size);
         }
+        else if (reader->aux.logfile.gotProcessing) {
+            n /= 2;
+        }
+        room = MIN(room, n);
+    }
+    unlock_obj_set(readers);
+    return(room);
+}
+
+
+obj_t * get_splice_logfile_obj(obj_t *console)
+{
+/*  Returns a ptr to the logfile obj into which data read from the console
+ *    obj's file descriptor can be spliced directly; o/w, returns NULL.
+ *  Splicing bypasses the console's fan-out ring and the logfile's
+ *    circular-buffer, so it is only done while the logfile is the console's
+ *    sole reader and has no data of its own waiting to be written out.
+ *    Otherwise, the data is read into user-space as usual so it remains
+ *    ordered with respect to the logfile's pending data.
+ *  Must be called by the thread running the console's event loop.
+ */
+    obj_t *logfile;
+
+    if (!is_console_obj(console) || (console->fd < 0) || !console->fan) {
+        return(NULL);
+    }
+    if (!(logfile = get_console_logfile_obj(console))) {
+        return(NULL);
+    }
+    if (!logfile->aux.logfile.gotSplice || logfile->gotEOF
+            || (logfile->fanSrc != console)
+            || (__atomic_load_n(&logfile->fanEnd, __ATOMIC_ACQUIRE)
+                != FAN_POS_ATTACHED)) {
+        return(NULL);
+    }
+    if (count_obj_set(&console->readers) != 1) {
+        return(NULL);
+    }
+    if ((logfile->bufInPtr != logfile->bufOutPtr)
+            || (num_bytes_spooled(logfile) > 0)
+            || (get_fan_end(logfile) != logfile->fanPos)
+            || (__atomic_load_n(&logfile->numInbox, __ATOMIC_ACQUIRE) > 0)) {
+        return(NULL);
+    }
+    assert(is_obj_owner(logfile));
+    return(logfile);
+}
+
+
+int prepare_read_from_obj(obj_t *obj)
+{
+/*  Checks whether data should be read from the obj's file descriptor.
+ *  This allows the read itself to be performed elsewhere (eg, batched
+ *    via io_uring) before its result is passed to end_read_from_obj().
+ *  Returns true if the obj should be read; o/w, returns false.
+ */
+    if (obj->fd < 0) {
+        return(0);
+    }
+    /*  Do not read from a telnet obj that is not yet in the UP state.
+     *  When the non-blocking connect completes, the fd becomes writable;
+     *    when connection establishment fails, it becomes readable & writable.
+     *  The completion of a PENDING connection is handled in
+     *    prepare_write_to_obj().
+     */
+    if (is_telnet_obj(obj) && (obj->aux.telnet.state != CONMAN_TELNET_UP)) {
+        return(0);
+    }
+    return(1);
+}
+
+
+int get_obj_read_len(obj_t *obj)
+{
+/*  Returns the max number of bytes to read from the obj's file descriptor
+ *    at a time (cf. read_from_obj()).  This is bounded by the size of the
+ *    obj's own circular-buffer, which can be overridden per console.
+ */
+    return(MIN((OBJ_BUF_SIZE / 2) - 1, (obj->bufSize / 2) - 1));
+}
+
+
+int end_read_from_obj(obj_t *obj, unsigned char *buf, int n)
+{
+/*  Processes the result (n) of reading data from the obj's file descriptor
+ *    into the buffer (buf), writing it out to the circular-buffer of each
+ *    obj in its "readers" set.  If (n) is -1, errno specifies the error.
+ *  Returns the number of bytes read (>=0 on success),
+ *    or -1 if the obj is ready to be destroyed.
+ */
+    int isEmpty;
+
+    if (n < 0) {
         if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
             return(0);
         }
@@ -919,41 +1744,227 @@ again:
             log_msg(LOG_WARNING, "Read EOF from [%s] after gotEOF", obj->name);
         }
         obj->gotEOF = 1;
-        tpoll_clear(tp_global, obj->fd, POLLIN);
-        isEmpty = (obj->bufInPtr == obj->bufOutPtr);
+        tpoll_clear(obj->loop->tp, obj->fd, POLLIN);
+        /*
+         *  Since no more data can be written into the obj's buffer,
+         *    stop reading from the fan-out ring after moving the data
+         *    pending therein into the buffer.
+         */
+        drain_obj_inbox(obj);
+        copy_fan_data(obj);
+        obj->fanSrc = NULL;
+        obj->fanEnd = FAN_POS_ATTACHED;
+        isEmpty = (obj->bufInPtr == obj->bufOutPtr)
+            && (num_bytes_spooled(obj) == 0);
         return(isEmpty ? shutdown_obj(obj) : 0);
     }
     else {
         DPRINTF((15, "Read %d bytes from [%s].\n", n, obj->name));
-        if (is_client_obj(obj)) {
-            x_pthread_mutex_lock(&obj->bufLock);
-            time(&obj->aux.client.timeLastRead);
-            if (obj->aux.client.timeLastRead == (time_t) -1) {
-                log_err(errno, "time() failed");
+        n = process_obj_escapes(obj, buf, n);
+        write_obj_readers(obj, buf, n);
+    }
+    return(n);
+}
+
+
+static int splice_from_obj(obj_t *console, obj_t *logfile)
+{
+/*  Splices data from the console obj's file descriptor into its logfile obj
+ *    by way of the logfile's pipe, thereby moving the data into the logfile
+ *    without copying it through user-space.  The data spliced is counted
+ *    in the console's fan-out ring so a log replay knows to read it back
+ *    from the logfile (cf. perform_log_replay()).
+ *  Splices are repeated until the console's fd would block or the server's
+ *    read budget for this wakeup has been used, as in read_from_obj().
+ *  If the console's fd cannot be spliced, splicing is disabled for the
+ *    logfile and 0 is returned so the caller can read the data instead.
+ *    If the logfile cannot be written, splicing is likewise disabled and the
+ *    data already in the pipe is written out to the logfile's buffer.
+ *  Returns the number of bytes read (>=0 on success),
+ *    or -1 if the console obj is ready to be destroyed.
+ */
+    unsigned char buf[(OBJ_BUF_SIZE / 2) - 1];
+    int *pipeFds = logfile->aux.logfile.pipeFds;
+    int numBytes = 0;
+    int numReads = 0;
+    int budget;
+    ssize_t n;
+    ssize_t m;
+    ssize_t k;
+    int e;
+
+    assert(is_console_obj(console));
+    assert(is_logfile_obj(logfile));
+    assert(pipeFds[0] >= 0);
+
+    budget = console->loop->conf->readBudget;
+
+    for (;;) {
+        n = splice_fd(console->fd, pipeFds[1], budget - numBytes);
+        if (n <= 0) {
+            break;
+        }
+        numReads++;
+        numBytes += n;
+
+        for (m = 0; m < n; m += k) {
+            if ((k = splice_fd(pipeFds[0], logfile->fd, n - m)) <= 0) {
+                break;
+            }
+        }
+        __atomic_add_fetch(&console->fan->numSpliced, m, __ATOMIC_RELAXED);
+        count_logfile_bytes(logfile, m);
+
+        if (m < n) {
+            log_msg(LOG_WARNING,
+                "Unable to splice into logfile \"%s\": %s",
+                logfile->name, (k < 0) ? strerror(errno) : "short write");
+            logfile->aux.logfile.gotSplice = 0;
+            while ((m < n) && ((k = read(pipeFds[0], buf,
+                    MIN((ssize_t) sizeof(buf), n - m))) > 0)) {
+                write_obj_readers(console, buf, k);
+                m += k;
             }
-            x_pthread_mutex_unlock(&obj->bufLock);
-            n = process_client_escapes(obj, buf, n);
+            break;
         }
-        else if (is_telnet_obj(obj)) {
-            n = process_telnet_escapes(obj, buf, n);
+        if (numBytes >= budget) {
+            break;
         }
-        /*  Ensure the buffer still contains data
-         *    after the escape characters have been processed.
+    }
+    e = errno;
+
+    if (numReads > 0) {
+        console->numReads += numReads;
+        console->numReadWakeups++;
+        DPRINTF((15, "Spliced %d bytes in %d splice%s for [%s] log \"%s\".\n",
+            numBytes, numReads, (numReads == 1 ? "" : "s"), console->name,
+            logfile->name));
+    }
+    if (!logfile->aux.logfile.gotSplice) {
+        return(numBytes);
+    }
+    if ((n < 0) && ((e == EINVAL) || (e == ENOSYS))) {
+        log_msg(LOG_INFO, "Unable to splice from [%s]: %s",
+            console->name, strerror(e));
+        logfile->aux.logfile.gotSplice = 0;
+        return(numBytes);
+    }
+    if ((n < 0) && (e != EAGAIN) && (e != EWOULDBLOCK)) {
+        errno = e;
+        return(end_read_from_obj(console, NULL, -1));
+    }
+    if (n == 0) {
+        return(end_read_from_obj(console, NULL, 0));
+    }
+    return(numBytes);
+}
+
+
+static int process_obj_escapes(obj_t *obj, unsigned char *buf, int n)
+{
+/*  Processes escape characters in the buffer (buf) of length (n)
+ *    read from the obj's file descriptor.
+ *  Returns the number of bytes remaining in (buf) afterwards.
+ */
+    time_t t;
+
+    if (is_client_obj(obj)) {
+        /*
+         *  The client's timeLastRead is read by other threads (cf.
+         *    check_busy_consoles()), so it is stored atomically.
          */
-        if (n > 0) {
-            i = list_iterator_create(obj->readers);
-            while ((reader = list_next(i))) {
+        if (time(&t) == (time_t) -1) {
+            log_err(errno, "time() failed");
+        }
+        __atomic_store_n(&obj->aux.client.timeLastRead, t, __ATOMIC_RELAXED);
+        n = process_client_escapes(obj, buf, n);
+    }
+    else if (is_telnet_obj(obj)) {
+        n = process_telnet_escapes(obj, buf, n);
+    }
+    return(n);
+}
 
-                if (is_logfile_obj(reader)) {
-                    write_log_data(reader, buf, n);
-                }
-                else {
-                    write_obj_data(reader, buf, n, 0);
-                }
+
+void write_obj_readers(obj_t *obj, unsigned char *buf, int n)
+{
+/*  Writes the buffer (buf) of length (n) out to each obj in the obj's
+ *    "readers" set.
+ *  If the obj is a console, the data is written once into its fan-out ring
+ *    from which its attached readers write it out, thereby avoiding a copy
+ *    into each reader's circular-buffer.  Other readers (eg, a logfile
+ *    requiring additional processing) have the data written into their
+ *    circular-buffer.
+ *  Before data pending for an attached reader is overwritten in the ring,
+ *    it is handled according to the reader's overrun policy.  The data is
+ *    written into the ring in chunks no larger than the ring so the data
+ *    to be overwritten is always still in the ring.
+ *  The readers set is locked for the duration since it can be changed
+ *    by other threads (cf. link_objs()).
+ */
+    obj_set_t *readers = &obj->readers;
+    obj_t *reader;
+    int m, k;
+    int j;
+
+    /*  Ensure the buffer still contains data
+     *    after the escape characters have been processed.
+     */
+    if (n <= 0) {
+        return;
+    }
+    lock_obj_set(readers);
+
+    if (obj->fan) {
+        for (m = 0; m < n; m += k) {
+            k = MIN(n - m, obj->fan->size);
+            for (j = 0; j < readers->numObjs; j++) {
+                (void) overrun_fan_reader(obj, readers->objs[j], k);
             }
-            list_iterator_destroy(i);
+            write_fan_data(obj, buf + m, k);
+        }
+    }
+    for (j = 0; j < readers->numObjs; j++) {
+        reader = readers->objs[j];
+
+        if (update_fan_reader(obj, reader)) {
+            continue;
+        }
+        else if (is_logfile_obj(reader)) {
+            write_log_data(reader, buf, n);
+        }
+        else {
+            write_obj_data(reader, buf, n, 0);
         }
     }
+    unlock_obj_set(readers);
+    return;
+}
+
+
+int copy_obj_fan_history(obj_t *console, unsigned char *dst, int len)
+{
+/*  Copies up to (len) of the most recent bytes written into the fan-out ring
+ *    of (console) into the buffer (dst).
+ *  Must be called by the thread running the console's event loop.
+ *  Returns the number of bytes copied.
+ */
+    fan_ring_t *fan;
+    uint64_t pos;
+    int n;
+
+    assert(is_console_obj(console));
+    assert(dst != NULL);
+
+    if (!(fan = console->fan) || (len <= 0)) {
+        return(0);
+    }
+    assert(is_obj_owner(console));
+
+    n = (fan->head < (uint64_t) fan->size) ? (int) fan->head : fan->size;
+    n = MIN(n, len);
+    pos = fan->head - n;
+    memcpy(dst, fan->buf + (pos % fan->size), n);
     return(n);
 }
 
@@ -963,14 +1974,14 @@ int write_obj_data(obj_t *obj, const void *src, int len, int isInfo)
 /*  Writes the buffer (src) of length (len) into the object's (obj)
  *    circular-buffer.  If (isInfo) is true, the data is considered
  *    an informational message which a client may suppress.
+ *  If called by a thread other than the one running the obj's event loop,
+ *    the data is queued in the obj's inbox for that loop to write into
+ *    the circular-buffer.
  *  Returns the number of bytes written.
  *
- *  Note that this routine can write at most (OBJ_BUF_SIZE - 1) bytes
+ *  Note that this routine can write at most (bufSize - 1) bytes
  *    of data into the object's circular-buffer.
  */
-    int avail;
-    int n, m;
-
     DPRINTF((20, "Entered write_obj_data: [%s]\n", obj->name));
 
     if (!src || len <= 0) {
@@ -984,87 +1995,47 @@ int write_obj_data(obj_t *obj, const void *src, int len, int isInfo)
             len, (len == 1 ? "" : "s"), obj->name);
         return(0);
     }
-    /*  An obj's circular-buffer is empty when (bufInPtr == bufOutPtr).
-     *    Thus, it can hold at most (OBJ_BUF_SIZE - 1) bytes of data.
-     */
-    if (len >= OBJ_BUF_SIZE) {
-        len = OBJ_BUF_SIZE - 1;
-    }
-    x_pthread_mutex_lock(&obj->bufLock);
-
     /*  Do nothing if this is an informational message
      *    and the client has requested not to be bothered.
      */
     if (isInfo && is_client_obj(obj) && obj->aux.client.req->enableQuiet) {
-        x_pthread_mutex_unlock(&obj->bufLock);
         return(0);
     }
-    /*  Assert the buffer's input and output ptrs are valid upon entry.
+    if (!is_obj_owner(obj)) {
+        return(post_obj_data(obj, src, len, isInfo));
+    }
+    /*  Data queued by other threads was written before this data.
      */
-    assert(obj->bufInPtr >= obj->buf);
-    assert(obj->bufInPtr < &obj->buf[OBJ_BUF_SIZE]);
-    assert(obj->bufOutPtr >= obj->buf);
-    assert(obj->bufOutPtr < &obj->buf[OBJ_BUF_SIZE]);
+    drain_obj_inbox(obj);
+    return(store_obj_data(obj, src, len, isInfo));
+}
 
-    n = len;
 
-    /*  Calculate the number of bytes available before data is overwritten.
-     *  Data in the circular-buffer will be overwritten if needed since
-     *    this routine must not block.
-     *  Since an obj's circular-buffer is empty when (bufInPtr == bufOutPtr),
-     *    subtract one byte to account for this sentinel.
-     */
-    avail = OBJ_BUF_SIZE - 1 - num_bytes_buffered(obj);
+static int store_obj_data(obj_t *obj, const void *src, int len, int isInfo)
+{
+/*  Writes the buffer (src) of length (len) into the object's (obj)
+ *    circular-buffer on behalf of write_obj_data().
+ *  Must be called by the thread running the obj's event loop.
+ *  Returns the number of bytes written.
+ */
+    int lost;
 
-    /*  Copy first chunk of data (ie, up to the end of the buffer).
+    /*  Data pending in the fan-out ring precedes this data,
+     *    so move it into the circular-buffer first to preserve its order.
      */
-    m = MIN(len, &obj->buf[OBJ_BUF_SIZE] - obj->bufInPtr);
-    if (m > 0) {
-        memcpy(obj->bufInPtr, src, m);
-        n -= m;
-        src = (unsigned char *) src + m;
-        obj->bufInPtr += m;
-        /*
-         *  Do the hokey-pokey and perform a circular-buffer wrap-around.
-         */
-        if (obj->bufInPtr == &obj->buf[OBJ_BUF_SIZE]) {
-            obj->bufInPtr = obj->buf;
-            obj->gotBufWrap = 1;
-        }
-    }
-    /*  Copy second chunk of data (ie, from the beginning of the buffer).
-     */
-    if (n > 0) {
-        memcpy(obj->bufInPtr, src, n);
-        obj->bufInPtr += n;             /* Hokey-Pokey not needed here */
-    }
-    /*  Check to see if any data in circular-buffer was overwritten.
-     */
-    if (len > avail) {
-        if (!is_client_obj(obj) || !obj->aux.client.gotSuspend) {
-            log_msg(LOG_NOTICE, "Overwrote %d bytes for \"%s\"",
-                len - avail, obj->name);
-        }
-        obj->bufOutPtr = obj->bufInPtr + 1;
-        if (obj->bufOutPtr == &obj->buf[OBJ_BUF_SIZE]) {
-            obj->bufOutPtr = obj->buf;
-        }
-    }
+    copy_fan_data(obj);
+
+    len = append_obj_data(obj, src, len, &lost);
+    lose_obj_data(obj, lost);
+
     /*  Notify tpoll that data is available for writing
-     *    unless it is a client obj that is currently suspended.
+     *    unless it is a client obj that is currently suspended,
+     *    or a logfile obj whose writes are being deferred to batch them.
      */
-    if (!is_client_obj(obj) || !obj->aux.client.gotSuspend) {
-        tpoll_set(tp_global, obj->fd, POLLOUT);
+    if ((!is_client_obj(obj) || !obj->aux.client.gotSuspend)
+            && !defer_obj_write(obj)) {
+        tpoll_set(obj->loop->tp, obj->fd, POLLOUT);
     }
-    /*  Assert the buffer's input and output ptrs are valid upon exit.
-     */
-    assert(obj->bufInPtr >= obj->buf);
-    assert(obj->bufInPtr < &obj->buf[OBJ_BUF_SIZE]);
-    assert(obj->bufOutPtr >= obj->buf);
-    assert(obj->bufOutPtr < &obj->buf[OBJ_BUF_SIZE]);
-
-    x_pthread_mutex_unlock(&obj->bufLock);
-
     /*  If an informational message has been added to the log,
      *    re-initialize the console log's newline state.
      */
@@ -1075,110 +2046,659 @@ int write_obj_data(obj_t *obj, const void *src, int len, int isInfo)
 }
 
 
-int write_to_obj(obj_t *obj)
+static int defer_obj_write(obj_t *obj)
 {
-/*  Writes data from the obj's circular-buffer out to its file descriptor.
- *  Returns 0 on success, or -1 if the obj is ready to be destroyed.
+/*  Checks whether writing out the data pending for the obj should be deferred
+ *    in order to batch it into fewer, larger writes (cf. the "flush" logopt).
+ *  A logfile's data is deferred until either the amount pending reaches its
+ *    flush size or its flush interval has elapsed since the data was first
+ *    deferred.  The amount deferred is limited to half of the buffer holding
+ *    it so no data is overwritten before it is written out.
+ *  Must be called by the thread running the obj's event loop.
+ *  Returns true if the write should be deferred; o/w, returns false.
  */
-    struct iovec iov[2];
-    int iovcnt = 0;
-    int isDead = 0;
-    int n;
-
-    DPRINTF((20, "Entered write_to_obj: [%s]\n", obj->name));
+    logopt_t *opts;
+    int pending;
+    int msecs;
 
-    if (obj->fd < 0) {
+    if (!is_logfile_obj(obj)) {
         return(0);
     }
-    /*  The completion of a nonblocking connect() makes the socket writable,
-     *    so complete the telnet obj non-blocking connect here if needed.
-     */
-    if (is_telnet_obj(obj) && (obj->aux.telnet.state == CONMAN_TELNET_PENDING))
-    {
-        open_telnet_obj(obj);
+    opts = &obj->aux.logfile.opts;
+    if ((opts->flushBytes == 0) && (opts->flushMsecs == 0)) {
         return(0);
     }
-    x_pthread_mutex_lock(&obj->bufLock);
-
-    /*  Assert the buffer's input and output ptrs are valid upon entry.
-     */
-    assert(obj->bufInPtr >= obj->buf);
-    assert(obj->bufInPtr < &obj->buf[OBJ_BUF_SIZE]);
-    assert(obj->bufOutPtr >= obj->buf);
-    assert(obj->bufOutPtr < &obj->buf[OBJ_BUF_SIZE]);
-
-    /*  IOV for object buffer cases OIO (wrap-around pt1) & IO (no-wrap).
-     */
-    if (obj->bufOutPtr > obj->bufInPtr) {
-        iov[0].iov_base = obj->bufOutPtr;
-        iov[0].iov_len = &obj->buf[OBJ_BUF_SIZE] - obj->bufOutPtr;
-        iovcnt = 1;
-        /*
-         *  IOV for object buffer case OIO (wrap-around pt2).
-         */
-        if (obj->bufInPtr > obj->buf) {
-            iov[1].iov_base = obj->buf;
-            iov[1].iov_len = obj->bufInPtr - obj->buf;
-            iovcnt = 2;
-        }
+    if (obj->aux.logfile.gotFlushDue || (obj->fd < 0)) {
+        return(0);
     }
-    /*  IOV for object buffer cases IOI & OI.
-     */
-    else if (obj->bufInPtr > obj->bufOutPtr) {
-        iov[0].iov_base = obj->bufOutPtr;
-        iov[0].iov_len = obj->bufInPtr - obj->bufOutPtr;
-        iovcnt = 1;
+    if (num_bytes_buffered(obj) >= obj->bufSize / 2) {
+        return(0);
     }
-
-    if (iovcnt > 0) {
-again:
-        n = writev(obj->fd, iov, iovcnt);
-        if (n < 0) {
-            if (errno == EINTR) {
-                goto again;
-            }
-            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
-                /*
-                 *  If an error occurs while writing to the obj's fd,
-                 *    trigger a shutdown of the obj by setting 'isDead'.
-                 */
-                log_msg(LOG_INFO, "Unable to write to [%s]: %s",
-                    obj->name, strerror(errno));
-                isDead = 1;
-            }
-        }
-        else if (n > 0) {
-            DPRINTF((15, "Wrote %d bytes to [%s].\n", n, obj->name));
-            obj->bufOutPtr += n;
-            if (obj->bufOutPtr >= &obj->buf[OBJ_BUF_SIZE]) {
-                obj->bufOutPtr -= OBJ_BUF_SIZE;
-            }
-        }
+    pending = num_fan_bytes_pending(obj, NULL);
+    if ((pending > 0) && (pending >= obj->fanSrc->fan->size / 2)) {
+        return(0);
     }
-    /*  If all buffered data has been written out to the fd...
+    pending += num_bytes_buffered(obj);
+    if ((opts->flushBytes > 0) && (pending >= opts->flushBytes)) {
+        return(0);
+    }
+    /*  The interval is bounded even if only a flush size is specified.
      */
-    if (obj->bufInPtr == obj->bufOutPtr) {
-        /*
-         *  If the gotEOF flag is set, no additional data can be written into
-         *    the buffer.  As such, the object is ready for shutdown.
-         */
-        if (obj->gotEOF) {
-            isDead = 1;
+    if (obj->aux.logfile.flushTimer < 0) {
+        msecs = (opts->flushMsecs > 0)
+            ? opts->flushMsecs : DEFAULT_LOG_FLUSH_MSECS;
+        obj->aux.logfile.flushTimer = tpoll_timeout_relative(obj->loop->tp,
+            (callback_f) expire_obj_flush, obj, msecs);
+        if (obj->aux.logfile.flushTimer < 0) {
+            log_msg(LOG_ERR, "Unable to create timer for flushing [%s]",
+                obj->name);
+            return(0);
+        }
+    }
+    return(1);
+}
+
+
+static void expire_obj_flush(obj_t *obj)
+{
+/*  Writes out the data deferred for the logfile obj once its flush interval
+ *    has elapsed (cf. defer_obj_write()).
+ */
+    assert(is_logfile_obj(obj));
+
+    obj->aux.logfile.flushTimer = -1;
+    obj->aux.logfile.gotFlushDue = 1;
+    if (obj->fd >= 0) {
+        tpoll_set(obj->loop->tp, obj->fd, POLLOUT);
+    }
+    return;
+}
+
+
+void expedite_obj_flush(obj_t *obj)
+{
+/*  Writes out the data deferred for the logfile obj without waiting for its
+ *    flush interval to elapse (cf. defer_obj_write()).  This is a no-op if
+ *    no data has been deferred.
+ *  Must be called by the thread running the obj's event loop.
+ */
+    assert(is_logfile_obj(obj));
+    assert(is_obj_owner(obj));
+
+    if (obj->aux.logfile.flushTimer < 0) {
+        return;
+    }
+    (void) tpoll_timeout_cancel(obj->loop->tp, obj->aux.logfile.flushTimer);
+    expire_obj_flush(obj);
+    return;
+}
+
+
+uint64_t get_logfile_obj_end(obj_t *logfile, obj_t *reader)
+{
+/*  Returns the size (as counted by count_logfile_bytes()) that the logfile
+ *    obj's current file will have reached once the data received by the
+ *    logfile ahead of the data still pending in the fan-out ring for the
+ *    (reader) has been written out.  This includes the data deferred by the
+ *    "flush" logopt and that still pending for the logfile in the ring.
+ *    A logfile that does not read from the ring (cf. attach_fan_reader())
+ *    has already buffered all of the data it has received.
+ *  Must be called by the thread running the logfile's event loop.
+ */
+    fan_ring_t *fan;
+    uint64_t end;
+    uint64_t head;
+    uint64_t pos;
+
+    assert(is_logfile_obj(logfile));
+    assert(is_obj_owner(logfile));
+
+    end = logfile->aux.logfile.size + num_bytes_buffered(logfile);
+
+    if (reader && logfile->fanSrc && (fan = logfile->fanSrc->fan)
+            && (reader->fanSrc == logfile->fanSrc)) {
+        /*
+         *  Data overwritten in the ring before the logfile could write it
+         *    out has been lost, and so is not counted.
+         */
+        head = get_fan_end(logfile);
+        pos = logfile->fanPos;
+        if (head - pos > (uint64_t) fan->size) {
+            pos = head - fan->size;
+        }
+        if (reader->fanPos > pos) {
+            end += MIN(reader->fanPos, head) - pos;
+        }
+    }
+    return(end);
+}
+
+
+static int post_obj_data(obj_t *obj, const void *src, int len, int isInfo)
+{
+/*  Queues a copy of the buffer (src) of length (len) in the object's (obj)
+ *    inbox on behalf of write_obj_data() when called by a thread other than
+ *    the one running the obj's event loop.  That loop moves the data into
+ *    the obj's circular-buffer (cf. drain_obj_inbox()) before writing out
+ *    the circular-buffer, so the buffer is only ever accessed by that loop.
+ *  Returns the number of bytes queued.
+ */
+    obj_msg_t *msg;
+
+    if (len > obj->bufSize - 1) {
+        len = obj->bufSize - 1;
+    }
+    if (!(msg = malloc(sizeof(obj_msg_t) + len))) {
+        out_of_memory();
+    }
+    msg->len = len;
+    msg->isInfo = isInfo;
+    memcpy(msg + 1, src, len);
+    list_append(obj->inbox, msg);
+    __atomic_add_fetch(&obj->numInbox, 1, __ATOMIC_RELEASE);
+
+    /*  The tpoll fd events are set under the tpoll's lock,
+     *    so the obj's loop will be woken to drain the inbox.
+     */
+    if (!is_client_obj(obj) || !obj->aux.client.gotSuspend) {
+        tpoll_set(obj->loop->tp, obj->fd, POLLOUT);
+    }
+    return(len);
+}
+
+
+static void drain_obj_inbox(obj_t *obj)
+{
+/*  Moves the data queued in the object's (obj) inbox by other threads
+ *    into its circular-buffer.
+ *  Must be called by the thread running the obj's event loop.
+ */
+    obj_msg_t *msg;
+
+    while (__atomic_load_n(&obj->numInbox, __ATOMIC_ACQUIRE) > 0) {
+        if (!(msg = list_pop(obj->inbox))) {
+            break;
+        }
+        __atomic_sub_fetch(&obj->numInbox, 1, __ATOMIC_RELEASE);
+        (void) store_obj_data(obj, msg + 1, msg->len, msg->isInfo);
+        free(msg);
+    }
+    return;
+}
+
+
+static int append_obj_data(obj_t *obj, const void *src, int len, int *lostp)
+{
+/*  Appends the buffer (src) of length (len) to the data waiting to be written
+ *    out to the object's (obj) fd.  If the obj is a client whose overrun
+ *    policy is to spool, data that does not fit into its circular-buffer is
+ *    appended to its spool (as is all data once the spool holds data, since
+ *    it is written out before any newer data).
+ *  Must be called by the thread running the obj's event loop.
+ *  Returns the number of bytes appended; the number of bytes lost as a result
+ *    (either skipped or overwritten) is stored in (lostp) if non-NULL.
+ */
+    int n = 0;
+    int m;
+
+    if (!is_client_obj(obj)) {
+        return(copy_obj_data(obj, src, len, lostp));
+    }
+    /*  Once a client's overrun limit has been exceeded, only the notice
+     *    thereof is written out before it is disconnected.
+     */
+    if (obj->aux.client.gotOverrunLimit) {
+        len = 0;
+    }
+    /*  Data lost by the client was skipped at this point in its output,
+     *    so the marker noting the loss precedes this data.
+     */
+    else if ((len > 0) && (obj->aux.client.numBytesUnmarked > 0)) {
+        write_lost_marker(obj);
+    }
+    if ((len > 0)
+            && (obj->aux.client.overrunPolicy != CONMAN_OVERRUN_SPOOL)) {
+        return(copy_obj_data(obj, src, len, lostp));
+    }
+    if (obj->aux.client.spoolLen == 0) {
+        m = MIN(len, obj->bufSize - 1 - num_bytes_buffered(obj));
+        n = copy_obj_data(obj, src, m, NULL);
+        src = (unsigned char *) src + n;
+        len -= n;
+    }
+    if (len > 0) {
+        m = write_spool_data(obj, src, len);
+        n += m;
+        len -= m;
+    }
+    if (lostp) {
+        *lostp = len;
+    }
+    return(n);
+}
+
+
+static int copy_obj_data(obj_t *obj, const void *src, int len, int *lostp)
+{
+/*  Copies the buffer (src) of length (len) into the object's (obj)
+ *    circular-buffer.  Must be called by the thread running the obj's
+ *    event loop.
+ *  Returns the number of bytes copied; the number of bytes of older data
+ *    overwritten as a result is stored in (lostp) if non-NULL.
+ */
+    int avail;
+
+    if (lostp) {
+        *lostp = 0;
+    }
+    if (len <= 0) {
+        return(0);
+    }
+    /*  An obj's circular-buffer is empty when (bufInPtr == bufOutPtr).
+     *    Thus, it can hold at most (bufSize - 1) bytes of data.
+     */
+    if (len >= obj->bufSize) {
+        len = obj->bufSize - 1;
+    }
+    /*  Assert the buffer's input and output ptrs are valid upon entry.
+     */
+    assert(obj->bufInPtr >= obj->buf);
+    assert(obj->bufInPtr < &obj->buf[obj->bufSize]);
+    assert(obj->bufOutPtr >= obj->buf);
+    assert(obj->bufOutPtr < &obj->buf[obj->bufSize]);
+
+    /*  Calculate the number of bytes available before data is overwritten.
+     *  Data in the circular-buffer will be overwritten if needed since
+     *    this routine must not block.
+     *  Since an obj's circular-buffer is empty when (bufInPtr == bufOutPtr),
+     *    subtract one byte to account for this sentinel.
+     */
+    avail = obj->bufSize - 1 - num_bytes_buffered(obj);
+
+    /*  Copy the data as a single span since the vring mirrors the start of
+     *    the buffer past its end, then perform the circular-buffer wrap-around
+     *    on the input ptr.
+     */
+    vring_write(obj->ring, obj->bufInPtr - obj->buf, src, len);
+    obj->bufInPtr += len;
+    if (obj->bufInPtr >= &obj->buf[obj->bufSize]) {
+        obj->bufInPtr -= obj->bufSize;
+        obj->gotBufWrap = 1;
+    }
+    /*  Check to see if any data in circular-buffer was overwritten.
+     */
+    if (len > avail) {
+        if (lostp) {
+            *lostp = len - avail;
+        }
+        obj->bufOutPtr = obj->bufInPtr + 1;
+        if (obj->bufOutPtr == &obj->buf[obj->bufSize]) {
+            obj->bufOutPtr = obj->buf;
         }
-        /*  Notify tpoll that all available data has been written.
-         */
-        tpoll_clear(tp_global, obj->fd, POLLOUT);
     }
     /*  Assert the buffer's input and output ptrs are valid upon exit.
      */
     assert(obj->bufInPtr >= obj->buf);
-    assert(obj->bufInPtr < &obj->buf[OBJ_BUF_SIZE]);
+    assert(obj->bufInPtr < &obj->buf[obj->bufSize]);
     assert(obj->bufOutPtr >= obj->buf);
-    assert(obj->bufOutPtr < &obj->buf[OBJ_BUF_SIZE]);
+    assert(obj->bufOutPtr < &obj->buf[obj->bufSize]);
+
+    return(len);
+}
 
-    x_pthread_mutex_unlock(&obj->bufLock);
 
-    return(isDead ? shutdown_obj(obj) : 0);
+int write_to_obj(obj_t *obj)
+{
+/*  Writes data from the obj's circular-buffer out to its file descriptor.
+ *  Returns 0 on success, or -1 if the obj is ready to be destroyed.
+ */
+    struct iovec iov;
+    int iovcnt;
+    int n = 0;
+
+    DPRINTF((20, "Entered write_to_obj: [%s]\n", obj->name));
+
+    if (!prepare_write_to_obj(obj)) {
+        return(0);
+    }
+    if ((iovcnt = begin_write_to_obj(obj, &iov)) > 0) {
+        n = write_obj_iov(obj, &iov, iovcnt);
+    }
+    return(end_write_to_obj(obj, n) ? shutdown_obj(obj) : 0);
+}
+
+
+void flush_obj_data(obj_t *obj)
+{
+/*  Writes out all of the data buffered for the obj before its loop stops,
+ *    since a logfile's data may have been deferred to batch its writes.
+ *  Stops once no more data can be written without blocking.
+ *  Must be called by the thread running the obj's event loop.
+ */
+    struct iovec iov;
+    int iovcnt;
+    int n;
+
+    if (!prepare_write_to_obj(obj)) {
+        return;
+    }
+    while ((iovcnt = begin_write_to_obj(obj, &iov)) > 0) {
+        n = write_obj_iov(obj, &iov, iovcnt);
+        if (end_write_to_obj(obj, n) || (n <= 0)) {
+            break;
+        }
+    }
+    return;
+}
+
+
+static int write_obj_iov(obj_t *obj, struct iovec *iov, int iovcnt)
+{
+/*  Writes the data described by the iovec (iov) out to the obj's fd,
+ *    or queues it for the logfile's writer thread.
+ *  Returns the number of bytes written, or -1 on error (with errno set).
+ */
+    int n;
+
+    if (is_logfile_obj(obj) && obj->aux.logfile.writer) {
+        return(queue_log_write(obj, iov, iovcnt));
+    }
+    do {
+        n = writev(obj->fd, iov, iovcnt);
+    } while ((n < 0) && (errno == EINTR));
+
+    return(n);
+}
+
+
+int prepare_write_to_obj(obj_t *obj)
+{
+/*  Checks whether data should be written out to the obj's file descriptor.
+ *  Returns true if the obj should be written; o/w, returns false.
+ */
+    if (obj->fd < 0) {
+        return(0);
+    }
+    /*  The completion of a nonblocking connect() makes the socket writable,
+     *    so complete the telnet obj non-blocking connect here if needed.
+     */
+    if (is_telnet_obj(obj) && (obj->aux.telnet.state == CONMAN_TELNET_PENDING))
+    {
+        open_telnet_obj(obj);
+        return(0);
+    }
+    return(1);
+}
+
+
+int begin_write_to_obj(obj_t *obj, struct iovec *iov)
+{
+/*  Fills in the iovec (iov) with the data buffered in the obj's
+ *    circular-buffer.  This allows the write itself to be performed
+ *    elsewhere (eg, batched via io_uring) before its result is passed to
+ *    end_write_to_obj().  Since the circular-buffer is only accessed by the
+ *    thread running the obj's event loop, it remains unchanged until then.
+ *  Once the circular-buffer is empty, the iovec describes the data pending
+ *    in the fan-out ring of the console read by the obj (if any).  This data
+ *    is only overwritten by the console's loop thread, which is the same
+ *    thread that writes it out, so it remains valid until end_write_to_obj().
+ *  Since both buffers are vrings, the data is contiguous even where it
+ *    wraps around the end of the buffer.
+ *  Must be called by the thread running the obj's event loop.
+ *  Returns the number of iovecs filled in (0 or 1).
+ */
+    int iovcnt = 0;
+    fan_ring_t *fan;
+    int pending;
+
+    assert(is_obj_owner(obj));
+
+    /*  Data written by other threads precedes any data subsequently
+     *    written by this thread, so move it into the circular-buffer first.
+     */
+    if (__atomic_load_n(&obj->numInbox, __ATOMIC_ACQUIRE) > 0) {
+        drain_obj_inbox(obj);
+    }
+    /*  Assert the buffer's input and output ptrs are valid upon entry.
+     */
+    assert(obj->bufInPtr >= obj->buf);
+    assert(obj->bufInPtr < &obj->buf[obj->bufSize]);
+    assert(obj->bufOutPtr >= obj->buf);
+    assert(obj->bufOutPtr < &obj->buf[obj->bufSize]);
+
+    /*  Data in a client's overrun spool precedes that in the fan-out ring,
+     *    so refill the empty circular-buffer from the spool first.
+     *    Data lost by the client was skipped at this point in its output,
+     *    so the marker noting the loss is written out next.
+     *  A log replay in progress is written out before either, just as the
+     *    in-memory replay is written into the circular-buffer ahead of them;
+     *    the data of the console meanwhile remains pending until it ends.
+     *  Once a client's overrun limit has been exceeded, only the data in its
+     *    circular-buffer (ending with the notice thereof) is written out.
+     */
+    if (is_client_obj(obj) && (obj->bufInPtr == obj->bufOutPtr)) {
+        if (obj->aux.client.gotOverrunLimit) {
+            return(0);
+        }
+        if (obj->aux.client.replay) {
+            if (read_replay_data(obj) == 0) {
+                return(0);
+            }
+        }
+        else if (obj->aux.client.spoolLen > 0) {
+            read_spool_data(obj);
+        }
+        else if (obj->aux.client.numBytesUnmarked > 0) {
+            write_lost_marker(obj);
+        }
+    }
+    /*  IOV for data in the object buffer.
+     */
+    if (obj->bufInPtr != obj->bufOutPtr) {
+        iov->iov_base = obj->bufOutPtr;
+        iov->iov_len = num_bytes_buffered(obj);
+        iovcnt = 1;
+    }
+    /*  IOV for data pending in the fan-out ring.
+     */
+    else if ((pending = num_fan_bytes_pending(obj, NULL)) > 0) {
+        fan = obj->fanSrc->fan;
+        iov->iov_base = fan->buf + (obj->fanPos % fan->size);
+        iov->iov_len = pending;
+        iovcnt = 1;
+    }
+    return(iovcnt);
+}
+
+
+int end_write_to_obj(obj_t *obj, int n)
+{
+/*  Processes the result (n) of writing the data described by
+ *    begin_write_to_obj() out to the obj's file descriptor.
+ *    If (n) is -1, errno specifies the error.
+ *  Returns true if the obj must now be shut down via shutdown_obj();
+ *    o/w, returns false.
+ */
+    int isDead = 0;
+
+    if (n < 0) {
+        if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+            /*
+             *  If an error occurs while writing to the obj's fd,
+             *    trigger a shutdown of the obj by setting 'isDead'.
+             */
+            log_msg(LOG_INFO, "Unable to write to [%s]: %s",
+                obj->name, strerror(errno));
+            isDead = 1;
+        }
+    }
+    else if (n > 0) {
+        DPRINTF((15, "Wrote %d bytes to [%s].\n", n, obj->name));
+        /*
+         *  The circular-buffer is written out before the fan-out ring
+         *    (cf. begin_write_to_obj()).
+         */
+        if (obj->bufInPtr != obj->bufOutPtr) {
+            obj->bufOutPtr += n;
+            if (obj->bufOutPtr >= &obj->buf[obj->bufSize]) {
+                obj->bufOutPtr -= obj->bufSize;
+            }
+        }
+        else {
+            obj->fanPos += n;
+        }
+        if (is_logfile_obj(obj)) {
+            if (!obj->aux.logfile.writer) {
+                obj->aux.logfile.gotUnsynced =
+                    obj->aux.logfile.opts.enableSync;
+            }
+            count_logfile_bytes(obj, n);
+        }
+    }
+    /*  If all buffered data has been written out to the fd...
+     */
+    if ((obj->bufInPtr == obj->bufOutPtr)
+            && (num_bytes_spooled(obj) == 0)
+            && (num_fan_bytes_pending(obj, NULL) == 0)
+            && (!is_client_obj(obj) || !obj->aux.client.numBytesUnmarked)
+            && (!is_client_obj(obj) || !obj->aux.client.replay)
+            && (__atomic_load_n(&obj->numInbox, __ATOMIC_ACQUIRE) == 0)) {
+        /*
+         *  If the gotEOF flag is set, no additional data can be written into
+         *    the buffer.  As such, the object is ready for shutdown.
+         */
+        if (obj->gotEOF) {
+            isDead = 1;
+        }
+        /*  Complete the obj's detachment from the fan-out ring
+         *    by another thread once the data pending therein is written.
+         */
+        if (obj->fanEnd != FAN_POS_ATTACHED) {
+            obj->fanSrc = NULL;
+            obj->fanEnd = FAN_POS_ATTACHED;
+        }
+        /*  Once a logfile's deferred data has been written out, the next data
+         *    deferred starts a new flush interval.  The data is synced to disk
+         *    only at this point so each sync commits an entire batch.
+         */
+        if (is_logfile_obj(obj)) {
+            if (obj->aux.logfile.flushTimer >= 0) {
+                (void) tpoll_timeout_cancel(obj->loop->tp,
+                    obj->aux.logfile.flushTimer);
+                obj->aux.logfile.flushTimer = -1;
+            }
+            obj->aux.logfile.gotFlushDue = 0;
+            if (sync_logfile_obj(obj) < 0) {
+                log_msg(LOG_INFO, "Unable to sync [%s]: %s",
+                    obj->name, strerror(errno));
+                isDead = 1;
+            }
+        }
+        /*  Notify tpoll that all available data has been written.
+         *    Since another thread may have queued data in the obj's inbox
+         *    before POLLOUT was cleared, re-check the inbox afterwards.
+         */
+        tpoll_clear(obj->loop->tp, obj->fd, POLLOUT);
+        if (__atomic_load_n(&obj->numInbox, __ATOMIC_ACQUIRE) > 0) {
+            tpoll_set(obj->loop->tp, obj->fd, POLLOUT);
+        }
+    }
+    /*  If a client's overrun limit has been exceeded, it is disconnected
+     *    once the notice thereof has been written out.
+     */
+    if (is_client_obj(obj) && obj->aux.client.gotOverrunLimit
+            && (obj->bufInPtr == obj->bufOutPtr)) {
+        obj->fanPos += num_fan_bytes_pending(obj, NULL);
+        obj->aux.client.spoolHead = obj->aux.client.spoolLen = 0;
+        isDead = 1;
+    }
+    /*  Assert the buffer's input and output ptrs are valid upon exit.
+     */
+    assert(obj->bufInPtr >= obj->buf);
+    assert(obj->bufInPtr < &obj->buf[obj->bufSize]);
+    assert(obj->bufOutPtr >= obj->buf);
+    assert(obj->bufOutPtr < &obj->buf[obj->bufSize]);
+
+    return(isDead);
+}
+
+
+static void update_fd_objs(loop_t *loop)
+{
+/*  Rebuilds the (loop) fd table from its objs list and client list,
+ *    thereby accounting for objs that have been added or have since been
+ *    opened on a new fd.
+ */
+    ListIterator i;
+    obj_t *obj;
+
+    assert(loop != NULL);
+    assert(loop->objs != NULL);
+
+    i = list_iterator_create(loop->objs);
+    while ((obj = list_next(i))) {
+        update_fd_obj(loop, obj);
+    }
+    list_iterator_destroy(i);
+
+    x_pthread_mutex_lock(&loop->lock);
+    for (obj = loop->clients; obj; obj = obj->aux.client.next) {
+        update_fd_obj(loop, obj);
+    }
+    x_pthread_mutex_unlock(&loop->lock);
+
+    DPRINTF((15, "Updated fd table for %d objects in loop %d.\n",
+        list_count(loop->objs) + loop->numClients, loop->id));
+    return;
+}
+
+
+static void update_fd_obj(loop_t *loop, obj_t *obj)
+{
+/*  Updates the (loop) fd table entry for (obj).
+ */
+    obj_t **p;
+    int n;
+
+    assert(obj->loop == loop);
+
+    if ((obj->fdIndex >= 0) && (obj->fdIndex != obj->fd)) {
+        if (loop->fdObjs[obj->fdIndex] == obj) {
+            loop->fdObjs[obj->fdIndex] = NULL;
+        }
+        obj->fdIndex = -1;
+    }
+    if (obj->fd < 0) {
+        return;
+    }
+    if (obj->fd >= loop->fdObjsLen) {
+        n = (loop->fdObjsLen > 0) ? loop->fdObjsLen : 256;
+        while (n <= obj->fd) {
+            n *= 2;
+        }
+        if (!(p = realloc(loop->fdObjs, n * sizeof(obj_t *)))) {
+            out_of_memory();
+        }
+        memset(p + loop->fdObjsLen, 0,
+            (n - loop->fdObjsLen) * sizeof(obj_t *));
+        loop->fdObjs = p;
+        loop->fdObjsLen = n;
+    }
+    loop->fdObjs[obj->fd] = obj;
+    obj->fdIndex = obj->fd;
+    return;
+}
+
+
+static int is_obj_owner(obj_t *obj)
+{
+/*  Returns true if called by the thread running the obj's event loop
+ *    (or if the obj has not yet been assigned to a loop);
+ *    o/w, returns false.
+ */
+    assert(obj != NULL);
+
+    return(!obj->loop || pthread_equal(obj->loop->tid, pthread_self()));
 }
 
 
@@ -1195,8 +2715,488 @@ static int num_bytes_buffered(obj_t *obj)
         n = obj->bufInPtr - obj->bufOutPtr;
     }
     else {
-        n = (&obj->buf[OBJ_BUF_SIZE] - obj->bufOutPtr) +
+        n = (&obj->buf[obj->bufSize] - obj->bufOutPtr) +
             (obj->bufInPtr - obj->buf);
     }
     return(n);
 }
+
+
+static int num_fan_bytes_pending(obj_t *obj, int *lostp)
+{
+/*  Returns the number of bytes in the fan-out ring of the console read by
+ *    'obj' waiting to be written out to its file descriptor.
+ *  If the console has since overwritten data in the ring that had not yet
+ *    been written out, 'obj' skips past it; the number of bytes lost is
+ *    stored in (lostp) if non-NULL.
+ *  Must be called by the thread running the obj's event loop.
+ */
+    fan_ring_t *fan;
+    uint64_t n;
+    int lost = 0;
+
+    assert(obj != NULL);
+
+    if (!obj->fanSrc || !(fan = obj->fanSrc->fan)) {
+        n = 0;
+    }
+    else {
+        n = get_fan_end(obj) - obj->fanPos;
+        if (n > (uint64_t) fan->size) {
+            lost = n - fan->size;
+            obj->fanPos += lost;
+            n = fan->size;
+        }
+    }
+    if (lostp) {
+        *lostp = lost;
+    }
+    return((int) n);
+}
+
+
+static uint64_t get_fan_end(obj_t *obj)
+{
+/*  Returns the position in the fan-out ring of the console read by 'obj'
+ *    up to which data is to be written out to the obj.  This is the ring's
+ *    head unless the obj has been detached from the ring by another thread,
+ *    in which case the obj writes out the data up to the point of detachment.
+ */
+    uint64_t head;
+    uint64_t end;
+
+    assert(obj->fanSrc != NULL);
+    assert(obj->fanSrc->fan != NULL);
+
+    head = __atomic_load_n(&obj->fanSrc->fan->head, __ATOMIC_ACQUIRE);
+    end = __atomic_load_n(&obj->fanEnd, __ATOMIC_ACQUIRE);
+    assert(MIN(head, end) >= obj->fanPos);
+    return(MIN(head, end));
+}
+
+
+static void attach_fan_reader(obj_t *console, obj_t *reader)
+{
+/*  Attaches (reader) to the fan-out ring of (console) so subsequent data
+ *    read from the console is written out to the reader from the ring.
+ *  Logfiles requiring additional processing are not attached since their
+ *    data must be modified.
+ *  The reader must not yet be reading the console, and it must run on the
+ *    console's event loop since that loop's thread updates its position in
+ *    the ring (cf. overrun_fan_reader()).  The reader's position is set
+ *    before it is added to the console's readers, which the console's loop
+ *    then sees via the list's lock.
+ *  The 'links_lock' must be held by the caller.
+ */
+    assert(is_console_obj(console));
+
+    if (!is_client_obj(reader) && !(is_logfile_obj(reader)
+            && !reader->aux.logfile.gotProcessing)) {
+        return;
+    }
+    assert(reader->fanSrc == NULL);
+    assert(reader->loop == console->loop);
+    reader->fanPos = 0;
+    reader->fanEnd = FAN_POS_ATTACHED;
+    if (console->fan) {
+        reader->fanPos = __atomic_load_n(&console->fan->head, __ATOMIC_ACQUIRE);
+    }
+    reader->fanSrc = console;
+    DPRINTF((10, "Attached [%s] to [%s] fan-out ring.\n",
+        reader->name, console->name));
+    return;
+}
+
+
+static void detach_fan_reader(obj_t *console, obj_t *reader)
+{
+/*  Detaches (reader) from the fan-out ring of (console).
+ *  Data still pending in the ring is moved into the reader's circular-buffer
+ *    so it will be written out before the reader is closed.  If called by
+ *    a thread other than the one running the reader's event loop, the
+ *    reader's end position in the ring is set instead; the reader's loop
+ *    then writes out the data pending up to that point before completing
+ *    the detachment (cf. end_write_to_obj()).
+ *  The 'links_lock' must be held by the caller.
+ */
+    if (reader->fanSrc != console) {
+        return;
+    }
+    if (is_obj_owner(reader) || !console->fan) {
+        copy_fan_data(reader);
+        reader->fanSrc = NULL;
+        reader->fanPos = 0;
+        reader->fanEnd = FAN_POS_ATTACHED;
+    }
+    else {
+        __atomic_store_n(&reader->fanEnd,
+            __atomic_load_n(&console->fan->head, __ATOMIC_ACQUIRE),
+            __ATOMIC_RELEASE);
+        if (!is_client_obj(reader) || !reader->aux.client.gotSuspend) {
+            tpoll_set(reader->loop->tp, reader->fd, POLLOUT);
+        }
+    }
+    DPRINTF((10, "Detached [%s] from [%s] fan-out ring.\n",
+        reader->name, console->name));
+    return;
+}
+
+
+static int overrun_fan_reader(obj_t *console, obj_t *reader, int n)
+{
+/*  Prepares (reader) for (n) bytes of data to be written into the fan-out
+ *    ring of (console), where (n) is no larger than the ring.  Data pending
+ *    for the reader that would thereby be overwritten is moved into its
+ *    overrun spool if it is a client whose policy is to spool; o/w, the
+ *    reader skips past it and the data is lost.
+ *  Must be called by the thread running the console's event loop
+ *    (which also runs the reader's loop).
+ *  Returns true if the reader is attached to the console's ring;
+ *    o/w, returns false.
+ */
+    fan_ring_t *fan = console->fan;
+    uint64_t pending;
+    int excess;
+    int lost = 0;
+
+    assert(fan != NULL);
+    assert(n <= fan->size);
+
+    if (reader->fanSrc != console) {
+        return(0);
+    }
+    assert(is_obj_owner(reader));
+    pending = get_fan_end(reader) - reader->fanPos;
+    excess = (int) MIN(pending, (uint64_t) fan->size) + n - fan->size;
+
+    if (excess > 0) {
+        if (is_client_obj(reader) && !reader->aux.client.gotOverrunLimit
+                && (reader->aux.client.overrunPolicy == CONMAN_OVERRUN_SPOOL)) {
+            lost = excess - append_obj_data(reader,
+                fan->buf + (reader->fanPos % fan->size), excess, NULL);
+        }
+        else {
+            lost = excess;
+        }
+        reader->fanPos += excess;
+    }
+    lose_obj_data(reader, lost);
+    return(1);
+}
+
+
+static int update_fan_reader(obj_t *console, obj_t *reader)
+{
+/*  Updates (reader) after data has been written into the fan-out ring
+ *    of (console).
+ *  Returns true if the reader is attached to the console's ring;
+ *    o/w, returns false and the data must be written to it directly.
+ */
+    int lost;
+
+    if (reader->fanSrc != console) {
+        return(0);
+    }
+    /*  Any data overwritten in the ring has already been accounted for by
+     *    overrun_fan_reader() unless the reader attached in the meantime.
+     */
+    (void) num_fan_bytes_pending(reader, &lost);
+    lose_obj_data(reader, lost);
+
+    if ((!is_client_obj(reader) || !reader->aux.client.gotSuspend)
+            && !defer_obj_write(reader)) {
+        tpoll_set(reader->loop->tp, reader->fd, POLLOUT);
+    }
+    return(1);
+}
+
+
+static void write_fan_data(obj_t *console, unsigned char *buf, int n)
+{
+/*  Writes the buffer (buf) of length (n) into the fan-out ring of (console),
+ *    overwriting the oldest data as needed since this must not block.
+ *  The ring is only written by the thread running the console's event loop,
+ *    and its head is only advanced once the data is in place.  Other threads
+ *    only read the head (cf. detach_fan_reader()).
+ */
+    fan_ring_t *fan = console->fan;
+    uint64_t head;
+
+    assert(fan != NULL);
+    assert(n > 0);
+    assert(is_obj_owner(console));
+
+    head = fan->head;
+    if (n > fan->size) {
+        head += n - fan->size;
+        buf += n - fan->size;
+        n = fan->size;
+    }
+    vring_write(fan->ring, head % fan->size, buf, n);
+    __atomic_store_n(&fan->head, head + n, __ATOMIC_RELEASE);
+    return;
+}
+
+
+static void copy_fan_data(obj_t *obj)
+{
+/*  Moves any data pending in the fan-out ring of the console read by 'obj'
+ *    into its circular-buffer (or its overrun spool).  If this data exceeds
+ *    the capacity of the circular-buffer (and spool), the oldest data is
+ *    skipped.
+ *  Must be called by the thread running the obj's event loop.
+ */
+    fan_ring_t *fan;
+    uint64_t n;
+    int max;
+    int skipped = 0;
+    int lost = 0;
+
+    if (!obj->fanSrc || !(fan = obj->fanSrc->fan)) {
+        return;
+    }
+    max = fan->size;
+    if (!is_client_obj(obj)
+            || (obj->aux.client.overrunPolicy != CONMAN_OVERRUN_SPOOL)) {
+        max = MIN(obj->bufSize - 1, max);
+    }
+    n = get_fan_end(obj) - obj->fanPos;
+    if (n > (uint64_t) max) {
+        skipped = n - max;
+        obj->fanPos += skipped;
+        n = max;
+    }
+    /*  The marker for skipped data precedes the remaining data.
+     */
+    lose_obj_data(obj, skipped);
+
+    if (n > 0) {
+        lost = n - append_obj_data(obj,
+            fan->buf + (obj->fanPos % fan->size), n, NULL);
+        obj->fanPos += n;
+    }
+    lose_obj_data(obj, lost);
+    return;
+}
+
+
+static void lose_obj_data(obj_t *obj, int lost)
+{
+/*  Accounts for (lost) bytes of data that were dropped before being written
+ *    out to 'obj'.  If the obj is a client, the loss is counted and handled
+ *    according to its overrun policy: it is disconnected if its policy limit
+ *    on lost data has been exceeded; o/w, a marker noting the loss will be
+ *    written out once it catches up (cf. begin_write_to_obj()), thereby
+ *    coalescing the losses of a stalled client into a single marker.
+ *    Data lost while a client is suspended is not held against that limit.
+ *  Must be called by the thread running the obj's event loop.
+ */
+    client_obj_t *auxp;
+    char buf[MAX_LINE];
+    int n;
+
+    if (lost <= 0) {
+        return;
+    }
+    if (!is_client_obj(obj)) {
+        log_msg(LOG_NOTICE, "Overwrote %d bytes for \"%s\"",
+            lost, obj->name);
+        return;
+    }
+    auxp = &obj->aux.client;
+    if (auxp->gotOverrunLimit) {
+        return;
+    }
+    auxp->numOverruns++;
+    auxp->numBytesLost += lost;
+
+    if (!auxp->gotSuspend) {
+        log_msg(LOG_NOTICE, "Overwrote %d bytes for \"%s\"",
+            lost, obj->name);
+        auxp->numBytesLimited += lost;
+    }
+    if ((auxp->overrunPolicy == CONMAN_OVERRUN_DISCONNECT)
+            && (auxp->numBytesLimited > (unsigned long) auxp->overrunLimit)) {
+        log_msg(LOG_NOTICE, "Disconnecting client [%s] after losing %lu bytes",
+            obj->name, auxp->numBytesLimited);
+        n = snprintf(buf, sizeof(buf),
+            "%sDisconnected after losing %lu bytes of console output%s",
+            CONMAN_MSG_PREFIX, auxp->numBytesLimited, CONMAN_MSG_SUFFIX);
+        (void) copy_obj_data(obj, buf, n, NULL);
+        auxp->gotOverrunLimit = 1;
+        auxp->numBytesUnmarked = 0;
+        tpoll_set(obj->loop->tp, obj->fd, POLLOUT);
+    }
+    else if (!auxp->req->enableQuiet) {
+        auxp->numBytesUnmarked += lost;
+    }
+    return;
+}
+
+
+static void write_lost_marker(obj_t *obj)
+{
+/*  Appends a marker noting the data lost by the client 'obj' since its last
+ *    marker to its output.  If its overrun spool holds data but lacks room
+ *    for the marker, the marker is deferred until the spool has drained.
+ *  Must be called by the thread running the obj's event loop.
+ */
+    client_obj_t *auxp = &obj->aux.client;
+    char buf[MAX_LINE];
+    int n;
+
+    assert(is_client_obj(obj));
+
+    n = snprintf(buf, sizeof(buf), "%s[%lu byte%s lost]\r\n",
+        CONMAN_MSG_PREFIX, auxp->numBytesUnmarked,
+        (auxp->numBytesUnmarked == 1 ? "" : "s"));
+    if ((auxp->spoolLen > 0) && (auxp->overrunLimit - auxp->spoolLen < n)) {
+        return;
+    }
+    auxp->numBytesUnmarked = 0;
+    (void) append_obj_data(obj, buf, n, NULL);
+    return;
+}
+
+
+static int num_bytes_spooled(obj_t *obj)
+{
+/*  Returns the number of bytes of data in the overrun spool of 'obj'
+ *    waiting to be written out to the file descriptor.
+ */
+    assert(obj != NULL);
+
+    if (!is_client_obj(obj)) {
+        return(0);
+    }
+    return(obj->aux.client.spoolLen);
+}
+
+
+static int write_spool_data(obj_t *obj, const void *src, int len)
+{
+/*  Appends up to (len) bytes of the buffer (src) to the overrun spool of the
+ *    client 'obj', creating the spool tmpfile if needed.  The spool is
+ *    a circular file bounded by the client's overrun limit.
+ *  Must be called by the thread running the obj's event loop.
+ *  Returns the number of bytes spooled.
+ */
+    client_obj_t *auxp = &obj->aux.client;
+    int size = auxp->overrunLimit;
+    int n = 0;
+    int i;
+    ssize_t rc;
+
+    assert(is_client_obj(obj));
+
+    len = MIN(len, size - auxp->spoolLen);
+    if (len <= 0) {
+        return(0);
+    }
+    if (!auxp->spool) {
+        if (!(auxp->spool = tmpfile())) {
+            log_msg(LOG_WARNING,
+                "Unable to create overrun spool for [%s]: %s",
+                obj->name, strerror(errno));
+            auxp->overrunPolicy = CONMAN_OVERRUN_MARKER;
+            return(0);
+        }
+        set_fd_closed_on_exec(fileno(auxp->spool));
+    }
+    while (n < len) {
+        i = (auxp->spoolHead + auxp->spoolLen) % size;
+        rc = pwrite(fileno(auxp->spool), (const unsigned char *) src + n,
+            MIN(len - n, size - i), i);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            log_msg(LOG_WARNING, "Unable to write overrun spool for [%s]: %s",
+                obj->name, strerror(errno));
+            break;
+        }
+        auxp->spoolLen += rc;
+        n += rc;
+    }
+    auxp->numBytesSpooled += n;
+    return(n);
+}
+
+
+static void read_spool_data(obj_t *obj)
+{
+/*  Moves the oldest data in the overrun spool of the client 'obj'
+ *    into its empty circular-buffer.  If the spool cannot be read,
+ *    the data remaining therein is lost.
+ *  Must be called by the thread running the obj's event loop.
+ */
+    client_obj_t *auxp = &obj->aux.client;
+    int size = auxp->overrunLimit;
+    int len;
+    int lost;
+    ssize_t rc;
+
+    assert(is_client_obj(obj));
+    assert(obj->bufInPtr == obj->bufOutPtr);
+    assert(auxp->spool != NULL);
+
+    obj->bufInPtr = obj->bufOutPtr = obj->buf;
+    len = MIN(auxp->spoolLen, obj->bufSize - 1);
+
+    while (obj->bufInPtr - obj->buf < len) {
+        rc = pread(fileno(auxp->spool), obj->bufInPtr,
+            MIN(len - (obj->bufInPtr - obj->buf), size - auxp->spoolHead),
+            auxp->spoolHead);
+        if ((rc < 0) && (errno == EINTR)) {
+            continue;
+        }
+        if (rc <= 0) {
+            log_msg(LOG_WARNING, "Unable to read overrun spool for [%s]: %s",
+                obj->name, (rc < 0 ? strerror(errno) : "Unexpected EOF"));
+            lost = auxp->spoolLen;
+            auxp->spoolHead = auxp->spoolLen = 0;
+            lose_obj_data(obj, lost);
+            break;
+        }
+        obj->bufInPtr += rc;
+        auxp->spoolHead = (auxp->spoolHead + rc) % size;
+        auxp->spoolLen -= rc;
+    }
+    vring_commit(obj->ring, 0, obj->bufInPtr - obj->buf);
+
+    /*  Release the spool's disk space once it has been drained.
+     */
+    if (auxp->spoolLen == 0) {
+        auxp->spoolHead = 0;
+        if (ftruncate(fileno(auxp->spool), 0) < 0) {
+            log_msg(LOG_WARNING,
+                "Unable to truncate overrun spool for [%s]: %s",
+                obj->name, strerror(errno));
+        }
+    }
+    return;
+}
+
+
+static int read_replay_data(obj_t *obj)
+{
+/*  Moves the next chunk of the log replay in progress for the client 'obj'
+ *    into its empty circular-buffer.  The chunk is bounded by half of the
+ *    buffer so informational messages written into it meanwhile do not
+ *    overwrite the data not yet written out (cf. perform_log_replay()).
+ *  Must be called by the thread running the obj's event loop.
+ *  Returns the number of bytes moved into the buffer.
+ */
+    int n;
+
+    assert(is_client_obj(obj));
+    assert(obj->bufInPtr == obj->bufOutPtr);
+    assert(obj->aux.client.replay != NULL);
+
+    obj->bufInPtr = obj->bufOutPtr = obj->buf;
+    n = read_log_replay(obj, obj->buf, obj->bufSize / 2);
+    assert((n >= 0) && (n < obj->bufSize));
+    obj->bufInPtr += n;
+    vring_commit(obj->ring, 0, n);
+    return(n);
+}
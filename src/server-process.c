@@ -53,8 +53,6 @@ static int  connect_process_obj(obj_t *process);
 static int  check_process_prog(obj_t *process);
 static void reset_process_delay(obj_t *process);
 
-extern tpoll_t tp_global;               /* defined in server.c */
-
 
 int is_process_dev(const char *dev, const char *cwd,
     const char *exec_path, char **path_ref)
@@ -227,7 +225,7 @@ int open_process_obj(obj_t *process)
     auxp = &(process->aux.process);
 
     if (auxp->timer >= 0) {
-        (void) tpoll_timeout_cancel(tp_global, auxp->timer);
+        (void) tpoll_timeout_cancel(process->loop->tp, auxp->timer);
         auxp->timer = -1;
     }
 
@@ -242,7 +240,7 @@ int open_process_obj(obj_t *process)
         DPRINTF((15, "Retrying [%s] connection to prog=\"%s\" in %ds\n",
             process->name, auxp->argv[0], auxp->delay));
 
-        auxp->timer = tpoll_timeout_relative(tp_global,
+        auxp->timer = tpoll_timeout_relative(process->loop->tp,
             (callback_f) open_process_obj, process, auxp->delay * 1000);
 
         auxp->delay = (auxp->delay == 0)
@@ -270,7 +268,7 @@ static int disconnect_process_obj(obj_t *process)
     auxp = &(process->aux.process);
 
     if (process->fd >= 0) {
-        tpoll_clear(tp_global, process->fd, POLLIN | POLLOUT);
+        tpoll_clear(process->loop->tp, process->fd, POLLIN | POLLOUT);
         (void) close(process->fd);
         process->fd = -1;
     }
@@ -357,12 +355,12 @@ static int connect_process_obj(obj_t *process)
     auxp->pid = pid;
     process->gotEOF = 0;
     auxp->state = CONMAN_PROCESS_UP;
-    tpoll_set(tp_global, process->fd, POLLIN);
+    tpoll_set(process->loop->tp, process->fd, POLLIN);
 
     /*  Require the connection to be up for a minimum length of time before
      *    resetting the reconnect-delay back to zero.
      */
-    auxp->timer = tpoll_timeout_relative(tp_global,
+    auxp->timer = tpoll_timeout_relative(process->loop->tp,
         (callback_f) reset_process_delay, process, PROCESS_MIN_TIMEOUT * 1000);
 
     /*  Notify linked objs when transitioning into an UP state.
@@ -92,7 +92,7 @@ void process_client(client_arg_t *args)
  *    and processing the request.
  *  The QUERY cmd is processed entirely by this thread.
  *  The MONITOR and CONNECT cmds are setup and then placed
- *    in the conf->objs list to be handled by mux_io().
+ *    in the client list of the console's loop to be handled by mux_io().
  */
     int sd;
     server_conf_t *conf;
@@ -378,6 +378,8 @@ static void parse_cmd_opts(Lex l, req_t *req)
     int done = 0;
     int tok;
     char *str;
+    overrun_policy_t policy;
+    char err[MAX_LINE];
 
     while (!done) {
         tok = lex_next(l);
@@ -403,6 +405,25 @@ static void parse_cmd_opts(Lex l, req_t *req)
                     req->enableRegex = 1;
             }
             break;
+        case CONMAN_TOK_REPLAY:
+            if ((lex_next(l) == '=') && (lex_next(l) == LEX_STR)
+              && (parse_replay_spec(req, lex_text(l)) < 0)) {
+                log_msg(LOG_NOTICE, "Ignoring invalid replay spec \"%s\"",
+                    lex_text(l));
+            }
+            break;
+        case CONMAN_TOK_OVERRUN:
+            if ((lex_next(l) == '=') && (lex_next(l) == LEX_STR)) {
+                if (parse_overrun_policy(lex_text(l), &policy,
+                        &req->overrunLimit, err, sizeof(err)) < 0) {
+                    log_msg(LOG_NOTICE, "Ignoring client request: %s", err);
+                }
+                else {
+                    req->overrunPolicy = policy;
+                    req->gotOverrunPolicy = 1;
+                }
+            }
+            break;
         case LEX_EOF:
         case LEX_EOL:
             done = 1;
@@ -629,6 +650,7 @@ static int check_busy_consoles(req_t *req)
     ListIterator i;
     obj_t *console;
     obj_t *writer;
+    int n;
     int gotBcast;
     char *tty;
     time_t t;
@@ -647,7 +669,7 @@ static int check_busy_consoles(req_t *req)
     i = list_iterator_create(req->consoles);
     while ((console = list_next(i))) {
         assert(is_console_obj(console));
-        if (!list_is_empty(console->writers))
+        if (count_obj_set(&console->writers) > 0)
             list_append(busy, console);
     }
     list_iterator_destroy(i);
@@ -671,15 +693,16 @@ static int check_busy_consoles(req_t *req)
      */
     while ((console = list_pop(busy))) {
 
-        i = list_iterator_create(console->writers);
-        while ((writer = list_next(i))) {
+        for (n = 0; (writer = get_obj_set(&console->writers, n)); n++) {
 
             assert(is_client_obj(writer));
-            x_pthread_mutex_lock(&writer->bufLock);
-            t = writer->aux.client.timeLastRead;
-            gotBcast = list_is_empty(writer->writers);
+            /*  The writer's timeLastRead is updated by its loop's thread
+             *    (cf. process_obj_escapes()), so it is loaded atomically.
+             */
+            t = __atomic_load_n(&writer->aux.client.timeLastRead,
+                __ATOMIC_RELAXED);
+            gotBcast = (count_obj_set(&writer->writers) == 0);
             tty = writer->aux.client.req->tty;
-            x_pthread_mutex_unlock(&writer->bufLock);
             delta = create_time_delta_string(t, -1);
 
             snprintf(buf, sizeof(buf),
@@ -698,7 +721,6 @@ static int check_busy_consoles(req_t *req)
                 break;
             }
         }
-        list_iterator_destroy(i);
     }
     list_destroy(busy);
     return(-1);
@@ -843,10 +865,16 @@ static int perform_monitor_cmd(req_t *req, server_conf_t *conf)
     assert(is_console_obj(console));
     link_objs(console, client);
     check_console_state(console, client);
+    if (req->replay != CONMAN_REPLAY_NONE) {
+        start_log_replay(client);
+    }
 
     log_msg(LOG_INFO, "Client <%s@%s:%d> connected to [%s] (read-only)",
         req->user, req->fqdn, req->port, console->name);
 
+    /*  The client (along with its req) must not be referenced hereafter.
+     */
+    start_client_obj(client);
     return(0);
 }
 
@@ -880,6 +908,9 @@ static int perform_connect_cmd(req_t *req, server_conf_t *conf)
         link_objs(client, console);
         link_objs(console, client);
         check_console_state(console, client);
+        if (req->replay != CONMAN_REPLAY_NONE) {
+            start_log_replay(client);
+        }
 
         log_msg(LOG_INFO, "Client <%s@%s:%d> connected to [%s]",
             req->user, req->fqdn, req->port, console->name);
@@ -900,6 +931,9 @@ static int perform_connect_cmd(req_t *req, server_conf_t *conf)
             "Client <%s@%s:%d> connected to %d consoles (broadcast)",
             req->user, req->fqdn, req->port, list_count(req->consoles));
     }
+    /*  The client (along with its req) must not be referenced hereafter.
+     */
+    start_client_obj(client);
     return(0);
 }
 
@@ -57,8 +57,6 @@ static void reset_telnet_delay(obj_t *telnet);
 static int process_telnet_cmd(obj_t *telnet, int cmd, int opt);
 static char * opt2str(int opt, char *buf, int buflen);
 
-extern tpoll_t tp_global;               /* defined in server.c */
-
 
 int is_telnet_dev(const char *dev, char **host_ref, int *port_ref)
 {
@@ -185,7 +183,8 @@ static int connect_telnet_obj(obj_t *telnet)
     assert(telnet->aux.telnet.state != CONMAN_TELNET_UP);
 
     if (telnet->aux.telnet.timer >= 0) {
-        (void) tpoll_timeout_cancel(tp_global, telnet->aux.telnet.timer);
+        (void) tpoll_timeout_cancel(telnet->loop->tp,
+            telnet->aux.telnet.timer);
         telnet->aux.telnet.timer = -1;
     }
     if (telnet->aux.telnet.state == CONMAN_TELNET_DOWN) {
@@ -198,7 +197,7 @@ static int connect_telnet_obj(obj_t *telnet)
         if (host_name_to_addr4(telnet->aux.telnet.host, &saddr.sin_addr) < 0) {
             log_msg(LOG_WARNING, "Unable to resolve hostname \"%s\" for [%s]",
                 telnet->aux.telnet.host, telnet->name);
-            telnet->aux.telnet.timer = tpoll_timeout_relative(tp_global,
+            telnet->aux.telnet.timer = tpoll_timeout_relative(telnet->loop->tp,
                 (callback_f) connect_telnet_obj, telnet,
                 RESOLVE_RETRY_TIMEOUT * 1000);
             return(-1);
@@ -226,7 +225,7 @@ static int connect_telnet_obj(obj_t *telnet)
                 (struct sockaddr *) &saddr, sizeof(saddr)) < 0) {
             if (errno == EINPROGRESS) {
                 telnet->aux.telnet.state = CONMAN_TELNET_PENDING;
-                tpoll_set(tp_global, telnet->fd, POLLIN | POLLOUT);
+                tpoll_set(telnet->loop->tp, telnet->fd, POLLIN | POLLOUT);
             }
             else {
                 disconnect_telnet_obj(telnet);
@@ -256,7 +255,7 @@ static int connect_telnet_obj(obj_t *telnet)
             disconnect_telnet_obj(telnet);
             return(-1);
         }
-        tpoll_clear(tp_global, telnet->fd, POLLOUT);
+        tpoll_clear(telnet->loop->tp, telnet->fd, POLLOUT);
         DPRINTF((10, "Completing connection to <%s:%d> for [%s].\n",
             telnet->aux.telnet.host, telnet->aux.telnet.port, telnet->name));
     }
@@ -266,7 +265,7 @@ static int connect_telnet_obj(obj_t *telnet)
     }
     telnet->gotEOF = 0;
     telnet->aux.telnet.state = CONMAN_TELNET_UP;
-    tpoll_set(tp_global, telnet->fd, POLLIN);
+    tpoll_set(telnet->loop->tp, telnet->fd, POLLIN);
 
     /*  Notify linked objs when transitioning into an UP state.
      */
@@ -281,7 +280,7 @@ static int connect_telnet_obj(obj_t *telnet)
      *    disconnect_telnet_obj() will cancel the timer and the
      *    exponential backoff will continue.
      */
-    telnet->aux.telnet.timer = tpoll_timeout_relative(tp_global,
+    telnet->aux.telnet.timer = tpoll_timeout_relative(telnet->loop->tp,
         (callback_f) reset_telnet_delay, telnet, TELNET_MIN_TIMEOUT * 1000);
 
     send_telnet_cmd(telnet, DO, TELOPT_BINARY);
@@ -303,11 +302,12 @@ static void disconnect_telnet_obj(obj_t *telnet)
         telnet->aux.telnet.host, telnet->aux.telnet.port, telnet->name));
 
     if (telnet->aux.telnet.timer >= 0) {
-        (void) tpoll_timeout_cancel(tp_global, telnet->aux.telnet.timer);
+        (void) tpoll_timeout_cancel(telnet->loop->tp,
+            telnet->aux.telnet.timer);
         telnet->aux.telnet.timer = -1;
     }
     if (telnet->fd >= 0) {
-        tpoll_clear(tp_global, telnet->fd, POLLIN | POLLOUT);
+        tpoll_clear(telnet->loop->tp, telnet->fd, POLLIN | POLLOUT);
         if (close(telnet->fd) < 0)
             log_msg(LOG_WARNING,
                 "Unable to close connection to <%s:%d> for [%s]: %s",
@@ -326,7 +326,7 @@ static void disconnect_telnet_obj(obj_t *telnet)
     /*
      *  Set timer for establishing new connection using exponential backoff.
      */
-    telnet->aux.telnet.timer = tpoll_timeout_relative(tp_global,
+    telnet->aux.telnet.timer = tpoll_timeout_relative(telnet->loop->tp,
         (callback_f) connect_telnet_obj, telnet,
         telnet->aux.telnet.delay * 1000);
     if (telnet->aux.telnet.delay == 0) {
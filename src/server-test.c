@@ -42,8 +42,6 @@
 #include "util-str.h"
 #include "util.h"
 
-extern tpoll_t tp_global;               /* defined in server.c */
-
 
 #define TEST_CONSOLE_DEFAULT_BYTES              1024
 #define TEST_CONSOLE_DEFAULT_DELAY_MSECS        100
@@ -241,11 +239,11 @@ int open_test_obj(obj_t *test)
     opts = &test->aux.test.opts;
 
     if (auxp->timer >= 0) {
-        (void) tpoll_timeout_cancel(tp_global, auxp->timer);
+        (void) tpoll_timeout_cancel(test->loop->tp, auxp->timer);
         auxp->timer = -1;
     }
     if (test->fd >= 0) {
-        tpoll_clear(tp_global, test->fd, POLLOUT);
+        tpoll_clear(test->loop->tp, test->fd, POLLOUT);
         if (close(test->fd) < 0) {
             log_msg(LOG_WARNING,
                 "Unable to close test [%s]: %s", test->name, strerror(errno));
@@ -263,7 +261,7 @@ int open_test_obj(obj_t *test)
 
     /*  Schedule immediate timer to perform initial read once in mux_io().
      */
-    auxp->timer = tpoll_timeout_relative(tp_global,
+    auxp->timer = tpoll_timeout_relative(test->loop->tp,
         (callback_f) read_test_obj, test, 0);
 
     (void) opts;                /* suppress unused-but-set-variable warning */
@@ -288,8 +286,6 @@ int read_test_obj(obj_t *test)
     unsigned char buf[(OBJ_BUF_SIZE / 2) - 1];
     int n = 0;
     int m;
-    ListIterator i;
-    obj_t *reader;
     int delay;
     int interval;
 
@@ -300,7 +296,7 @@ int read_test_obj(obj_t *test)
     opts = &test->aux.test.opts;
 
     if (auxp->timer >= 0) {
-        (void) tpoll_timeout_cancel(tp_global, auxp->timer);
+        (void) tpoll_timeout_cancel(test->loop->tp, auxp->timer);
         auxp->timer = -1;
     }
     /*  Pseudorandomly perform a read at the start of a new burst.
@@ -320,18 +316,7 @@ int read_test_obj(obj_t *test)
             }
         }
         auxp->numLeft -= n;
-
-        i = list_iterator_create(test->readers);
-        while ((reader = list_next(i))) {
-
-            if (is_logfile_obj(reader)) {
-                write_log_data(reader, buf, n);
-            }
-            else {
-                write_obj_data(reader, buf, n, 0);
-            }
-        }
-        list_iterator_destroy(i);
+        write_obj_readers(test, buf, n);
     }
     /*  Schedule the next timer.
      */
@@ -348,7 +333,7 @@ int read_test_obj(obj_t *test)
         interval = opts->msecMax - opts->msecMin + 1;
         delay = opts->msecMin + (rand() % interval);
     }
-    auxp->timer = tpoll_timeout_relative(tp_global,
+    auxp->timer = tpoll_timeout_relative(test->loop->tp,
         (callback_f) read_test_obj, test, delay);
 
     return(n);
@@ -51,6 +51,7 @@
 #include "util-file.h"
 #include "util-str.h"
 #include "util.h"
+#include "wrapper.h"
 
 
 static void begin_daemonize(int *fd_ptr, pid_t *pgid_ptr);
@@ -65,12 +66,27 @@ static char ** get_sane_env(void);
 static void display_configuration(server_conf_t *conf);
 static void schedule_timestamp(server_conf_t *conf);
 static void timestamp_logfiles(server_conf_t *conf);
+static void timestamp_loop_logfiles(loop_t *loop);
 static void create_listen_socket(server_conf_t *conf);
 static void setup_nofile_limit(server_conf_t *conf);
+static void create_loops(server_conf_t *conf);
 static void open_objs(server_conf_t *conf);
-static void mux_io(server_conf_t *conf);
+static void start_loops(server_conf_t *conf);
+static void stop_loops(server_conf_t *conf);
+#ifndef NDEBUG
+static void display_list_stats(void);
+#endif /* !NDEBUG */
+static void * mux_io_thread(loop_t *loop);
+static void mux_io(loop_t *loop);
+static void mux_io_uring(loop_t *loop, int inevent_fd);
+static void submit_uring_reads(loop_t *loop);
+static void submit_uring_writes(loop_t *loop, obj_t **objs, int numObjs);
+static void check_loop_uring(loop_t *loop);
+static void wake_loop(loop_t *loop);
 static void open_daemon_logfile(server_conf_t *conf);
 static void reopen_logfiles(server_conf_t *conf);
+static void reopen_loop_logfiles(loop_t *loop);
+static void flush_loop_logfiles(loop_t *loop);
 static void accept_client(server_conf_t *conf);
 
 /*  Signal handler flags and whatnot.
@@ -80,11 +96,6 @@ static volatile sig_atomic_t reconfig = 0;
 static int coredump = 0;
 static char coredumpdir[PATH_MAX];
 
-/*  The 'tp_global' var is to allow timers to be set or canceled
- *    without having to pass the conf's tp var through the call stack.
- */
-tpoll_t tp_global = NULL;
-
 extern char ** environ;
 
 
@@ -102,7 +113,6 @@ int main(int argc, char *argv[])
     log_set_file(stderr, log_priority, 0);
 
     conf = create_server_conf();
-    tp_global = conf->tp;
 
     process_cmdline(conf, argc, argv);
     if (!conf->enableForeground) {
@@ -153,8 +163,15 @@ int main(int argc, char *argv[])
 #endif /* WITH_FREEIPMI */
 
     setup_nofile_limit(conf);
+    create_loops(conf);
+    create_log_writers(conf);
     open_objs(conf);
-    mux_io(conf);
+    start_loops(conf);
+    mux_io(&conf->loops[0]);
+    stop_loops(conf);
+#ifndef NDEBUG
+    display_list_stats();
+#endif /* !NDEBUG */
 
 #if WITH_FREEIPMI
     ipmi_fini();
@@ -508,10 +525,18 @@ static void display_configuration(server_conf_t *conf)
     fprintf(stderr, "Configuration: %s\n", conf->confFileName);
     fprintf(stderr, "Options:");
 
+    if (conf->bufSize != OBJ_BUF_SIZE) {
+        fprintf(stderr, " BufSize=%d", conf->bufSize);
+        gotOptions++;
+    }
     if (conf->enableCoreDump) {
         fprintf(stderr, " CoreDump");
         gotOptions++;
     }
+    if (conf->enableIOUring) {
+        fprintf(stderr, " IOUring");
+        gotOptions++;
+    }
     if (conf->enableKeepAlive) {
         fprintf(stderr, " KeepAlive");
         gotOptions++;
@@ -520,14 +545,34 @@ static void display_configuration(server_conf_t *conf)
         fprintf(stderr, " LogFile");
         gotOptions++;
     }
+    if (conf->numLogWriters > 0) {
+        fprintf(stderr, " LogWriters=%d", conf->numLogWriters);
+        gotOptions++;
+    }
     if (conf->enableLoopBack) {
         fprintf(stderr, " LoopBack");
         gotOptions++;
     }
+    if (conf->overrunPolicy == CONMAN_OVERRUN_DISCONNECT) {
+        fprintf(stderr, " Overrun=disconnect:%d", conf->overrunLimit);
+        gotOptions++;
+    }
+    else if (conf->overrunPolicy == CONMAN_OVERRUN_SPOOL) {
+        fprintf(stderr, " Overrun=spool:%d", conf->overrunLimit);
+        gotOptions++;
+    }
+    if (conf->readBudget != DEFAULT_READ_BUDGET) {
+        fprintf(stderr, " ReadBudget=%d", conf->readBudget);
+        gotOptions++;
+    }
     if (conf->resetCmd) {
         fprintf(stderr, " ResetCmd");
         gotOptions++;
     }
+    if (conf->enableSplice) {
+        fprintf(stderr, " Splice");
+        gotOptions++;
+    }
     if (conf->syslogFacility >= 0) {
         fprintf(stderr, " SysLog");
         gotOptions++;
@@ -536,6 +581,10 @@ static void display_configuration(server_conf_t *conf)
         fprintf(stderr, " TCP-Wrappers");
         gotOptions++;
     }
+    if (conf->numLoops > 1) {
+        fprintf(stderr, " Threads=%d", conf->numLoops);
+        gotOptions++;
+    }
     if (conf->tStampMinutes > 0) {
         fprintf(stderr, " TimeStamp=%dm", conf->tStampMinutes);
         gotOptions++;
@@ -591,7 +640,7 @@ static void schedule_timestamp(server_conf_t *conf)
 
     /*  The timer id is not saved because this timer will never be canceled.
      */
-    if (tpoll_timeout_absolute (tp_global,
+    if (tpoll_timeout_absolute (conf->tp,
             (callback_f) timestamp_logfiles, conf, &tv) < 0) {
         log_err(0, "Unable to create timer for timestamping logfiles");
     }
@@ -602,15 +651,38 @@ static void schedule_timestamp(server_conf_t *conf)
 static void timestamp_logfiles(server_conf_t *conf)
 {
 /*  Writes a timestamp message into all of the console logfiles.
+ *  Each event loop writes the timestamp into the logfiles it owns;
+ *    a timer is set to have each of the other loops write theirs.
+ *  Logfile objs persist for the lifetime of the daemon,
+ *    so a timer for the next timestamp is always scheduled.
+ */
+    int n;
+
+    for (n = 1; n < conf->numLoops; n++) {
+        if (tpoll_timeout_relative(conf->loops[n].tp,
+                (callback_f) timestamp_loop_logfiles,
+                &conf->loops[n], 0) < 0) {
+            log_msg(LOG_ERR, "Unable to create timer for timestamping "
+                "logfiles in loop %d", n);
+        }
+    }
+    timestamp_loop_logfiles(&conf->loops[0]);
+    schedule_timestamp(conf);
+    return;
+}
+
+
+static void timestamp_loop_logfiles(loop_t *loop)
+{
+/*  Writes a timestamp message into the console logfiles owned by (loop).
  */
     char *now;
     ListIterator i;
     obj_t *logfile;
     char buf[MAX_LINE];
-    int gotLogs = 0;
 
     now = create_long_time_string(0);
-    i = list_iterator_create(conf->objs);
+    i = list_iterator_create(loop->objs);
     while ((logfile = list_next(i))) {
         if (!is_logfile_obj(logfile)) {
             continue;
@@ -620,16 +692,9 @@ static void timestamp_logfiles(server_conf_t *conf)
             now, CONMAN_MSG_SUFFIX);
         strcpy(&buf[sizeof(buf) - 3], "\r\n");
         write_obj_data(logfile, buf, strlen(buf), 1);
-        gotLogs = 1;
     }
     list_iterator_destroy(i);
     free(now);
-
-    /*  If any logfile objs exist, schedule a timer for the next timestamp.
-     */
-    if (gotLogs) {
-        schedule_timestamp(conf);
-    }
     return;
 }
 
@@ -717,6 +782,111 @@ static void setup_nofile_limit(server_conf_t *conf)
 }
 
 
+static void create_loops(server_conf_t *conf)
+{
+/*  Creates the event loops and partitions the objs amongst them.
+ *  Each console is assigned to a loop in round-robin order, and each logfile
+ *    is assigned to the same loop as its console.  Clients are assigned to
+ *    the loop of their console as they connect (cf. create_client_obj()).
+ *  Unixsock consoles are assigned to the main loop since inotify events
+ *    that trigger their reconnects are processed there.
+ *  The main loop (loop 0) uses conf->tp, and it additionally services the
+ *    listen socket, inotify events, signals, and logfile timestamps.
+ *  If io_uring has been enabled but cannot be used, each loop falls back
+ *    to performing I/O via read() and writev().
+ */
+    ListIterator i;
+    obj_t *obj;
+    loop_t *loop;
+    int numConsoles = 0;
+    int n;
+
+    assert(conf->loops == NULL);
+    assert(conf->numLoops > 0);
+
+    i = list_iterator_create(conf->objs);
+    while ((obj = list_next(i))) {
+        if (is_console_obj(obj)) {
+            numConsoles++;
+        }
+    }
+    if ((numConsoles > 0) && (conf->numLoops > numConsoles)) {
+        log_msg(LOG_INFO, "Reducing event loop threads from %d to %d",
+            conf->numLoops, numConsoles);
+        conf->numLoops = numConsoles;
+    }
+    if (!(conf->loops = malloc(conf->numLoops * sizeof(loop_t)))) {
+        out_of_memory();
+    }
+    for (n = 0; n < conf->numLoops; n++) {
+        loop = &conf->loops[n];
+        loop->conf = conf;
+        loop->id = n;
+        /*
+         *  The objs of each loop are owned by the main thread until the
+         *    loop's own thread is started (cf. start_loops()).
+         */
+        loop->tid = pthread_self();
+        loop->tp = (n == 0) ? conf->tp : tpoll_create(0);
+        if (!loop->tp) {
+            log_err(0, "Unable to create object for multiplexing I/O");
+        }
+        loop->uring = NULL;
+        /*  Each read buffer holds the largest read from any obj;
+         *    reads are bounded per obj by get_obj_read_len().
+         */
+        if (conf->enableIOUring) {
+            loop->uring = uring_create(URING_BATCH_SIZE,
+                (OBJ_BUF_SIZE / 2) - 1);
+            if (!loop->uring) {
+                log_msg(LOG_WARNING, "Unable to use io_uring: %s",
+                    strerror(errno));
+                conf->enableIOUring = 0;
+            }
+        }
+        loop->objs = list_create(NULL);
+        x_pthread_mutex_init(&loop->lock, NULL);
+        loop->clients = NULL;
+        loop->numClients = 0;
+        loop->fdObjs = NULL;
+        loop->fdObjsLen = 0;
+    }
+    n = 0;
+    list_iterator_reset(i);
+    while ((obj = list_next(i))) {
+        if (!is_console_obj(obj)) {
+            continue;
+        }
+        if (is_unixsock_obj(obj)) {
+            obj->loop = &conf->loops[0];
+        }
+        else {
+            obj->loop = &conf->loops[n++ % conf->numLoops];
+        }
+        list_append(obj->loop->objs, obj);
+    }
+    list_iterator_reset(i);
+    while ((obj = list_next(i))) {
+        if (!is_logfile_obj(obj)) {
+            continue;
+        }
+        obj->loop = obj->aux.logfile.console->loop;
+        assert(obj->loop != NULL);
+        list_append(obj->loop->objs, obj);
+    }
+    list_iterator_destroy(i);
+
+    if (conf->numLoops > 1) {
+        log_msg(LOG_INFO, "Running %d event loop threads", conf->numLoops);
+    }
+    if (conf->enableIOUring) {
+        log_msg(LOG_INFO, "Using io_uring with %sregistered read buffers",
+            (uring_is_fixed(conf->loops[0].uring) ? "" : "un"));
+    }
+    return;
+}
+
+
 static void open_objs(server_conf_t *conf)
 {
 /*  Initially opens everything in the 'objs' list.
@@ -730,6 +900,9 @@ static void open_objs(server_conf_t *conf)
  *    specified when create_obj() initializes the obj members.
  *  This function is called once, performs a full traversal of the obj list,
  *    and allows resetCmdRef to be set before entering mux_io().
+ *  Likewise, each obj's circular-buffer is allocated here since the server's
+ *    default bufsize might not yet have been specified when a console (and
+ *    its logfile) was created.
  */
     ListIterator i;
     obj_t *obj;
@@ -739,6 +912,7 @@ static void open_objs(server_conf_t *conf)
         if (is_console_obj(obj)) {
             obj->resetCmdRef = conf->resetCmd;
         }
+        create_obj_buf(obj, (obj->bufSize > 0) ? obj->bufSize : conf->bufSize);
         reopen_obj(obj);
     }
     list_iterator_destroy(i);
@@ -746,29 +920,134 @@ static void open_objs(server_conf_t *conf)
 }
 
 
-static void mux_io(server_conf_t *conf)
+static void start_loops(server_conf_t *conf)
+{
+/*  Starts a thread for each event loop other than the main loop,
+ *    which is run by the main thread.
+ *  Signals handled by the daemon are blocked in these threads so they will
+ *    be delivered to the main thread where they can interrupt its tpoll().
+ */
+    sigset_t sigset;
+    sigset_t sigsetSave;
+    int n;
+    int rc;
+
+    if (conf->numLoops <= 1) {
+        return;
+    }
+    sigemptyset(&sigset);
+    sigaddset(&sigset, SIGCHLD);
+    sigaddset(&sigset, SIGHUP);
+    sigaddset(&sigset, SIGINT);
+    sigaddset(&sigset, SIGTERM);
+    if ((rc = pthread_sigmask(SIG_BLOCK, &sigset, &sigsetSave)) != 0) {
+        log_err(rc, "Unable to block signals for event loop threads");
+    }
+    for (n = 1; n < conf->numLoops; n++) {
+        if ((rc = pthread_create(&conf->loops[n].tid, NULL,
+          (PthreadFunc) mux_io_thread, &conf->loops[n])) != 0) {
+            log_err(rc, "Unable to create event loop thread");
+        }
+    }
+    if ((rc = pthread_sigmask(SIG_SETMASK, &sigsetSave, NULL)) != 0) {
+        log_err(rc, "Unable to restore signal mask");
+    }
+    return;
+}
+
+
+static void stop_loops(server_conf_t *conf)
+{
+/*  Stops the event loop threads once the main loop has exited.
+ *  A timer is set to wake each loop so it will notice the 'done' flag.
+ */
+    int n;
+    int rc;
+
+    assert(done);
+
+    for (n = 1; n < conf->numLoops; n++) {
+        if (tpoll_timeout_relative(conf->loops[n].tp,
+                (callback_f) wake_loop, &conf->loops[n], 0) < 0) {
+            log_err(0, "Unable to create timer for stopping loop %d", n);
+        }
+    }
+    for (n = 1; n < conf->numLoops; n++) {
+        if ((rc = pthread_join(conf->loops[n].tid, NULL)) != 0) {
+            log_err(rc, "Unable to join event loop thread");
+        }
+    }
+    return;
+}
+
+
+#ifndef NDEBUG
+static void display_list_stats(void)
+{
+/*  Displays the List allocator statistics (for debugging).
+ *  A high number of refills or flushes relative to the number of items
+ *    indicates the threads' caches of free items are too small.
+ */
+    ListStats nodes;
+    ListStats iterators;
+
+    list_get_stats(NULL, &nodes, &iterators);
+    DPRINTF((5, "Allocated %lu list nodes in %lu slab%s "
+        "(%lu refills, %lu flushes).\n", nodes.numItems, nodes.numSlabs,
+        (nodes.numSlabs == 1 ? "" : "s"), nodes.numRefills,
+        nodes.numFlushes));
+    DPRINTF((5, "Allocated %lu list iterators in %lu slab%s "
+        "(%lu refills, %lu flushes).\n", iterators.numItems,
+        iterators.numSlabs, (iterators.numSlabs == 1 ? "" : "s"),
+        iterators.numRefills, iterators.numFlushes));
+    return;
+}
+#endif /* !NDEBUG */
+
+
+static void * mux_io_thread(loop_t *loop)
+{
+/*  Runs an event loop within its own thread.
+ *  The loop's tid is set here as well since the thread may start running
+ *    before pthread_create() has stored it.
+ */
+    loop->tid = pthread_self();
+    DPRINTF((5, "Started event loop %d.\n", loop->id));
+    mux_io(loop);
+    DPRINTF((5, "Stopped event loop %d.\n", loop->id));
+    return(NULL);
+}
+
+
+static void mux_io(loop_t *loop)
 {
-/*  Multiplexes I/O between all of the objs in the configuration.
+/*  Multiplexes I/O between all of the objs owned by the event (loop).
  *  This routine is the heart of ConMan.
+ *  The main loop additionally accepts client connections, processes
+ *    inotify events, and performs reconfigs on behalf of all loops.
  */
-    ListIterator i;
+    server_conf_t *conf;
+    int isMain;
     int n;
+    int j;
+    int fd;
+    short int revents;
     obj_t *obj;
     int inevent_fd;
-    int rvr, rvw;
 
-    assert(conf->tp != NULL);
+    assert(loop != NULL);
+    assert(loop->tp != NULL);
+    conf = loop->conf;
+    isMain = (loop->id == 0);
     assert(!list_is_empty(conf->objs));
 
-    inevent_fd = inevent_get_fd();
+    inevent_fd = isMain ? inevent_get_fd() : -1;
     if (inevent_fd >= 0) {
-        tpoll_set(conf->tp, inevent_get_fd(), POLLIN);
+        tpoll_set(loop->tp, inevent_fd, POLLIN);
     }
-    i = list_iterator_create(conf->objs);
-
     while (!done) {
 
-        if (reconfig) {
+        if (isMain && reconfig) {
             /*
              *  FIXME: A reconfig should pro'ly resurrect "downed" serial objs
              *    and reset reconnect timers of "downed" telnet objs.
@@ -777,7 +1056,7 @@ static void mux_io(server_conf_t *conf)
             reopen_logfiles(conf);
             reconfig = 0;
         }
-        while ((n = tpoll(conf->tp, -1)) < 0) {
+        while ((n = tpoll(loop->tp, -1)) < 0) {
             if (errno != EINTR) {
                 log_err(errno, "Unable to multiplex I/O");
             }
@@ -785,43 +1064,313 @@ static void mux_io(server_conf_t *conf)
                 break;
             }
         }
-        if ((n > 0) &&
-                (tpoll_is_set(conf->tp, conf->ld, POLLIN) > 0)) {
-            n--;
+        if (isMain && (n > 0) &&
+                (tpoll_is_set(loop->tp, conf->ld, POLLIN) > 0)) {
             accept_client(conf);
         }
         if ((inevent_fd >= 0) &&
                 (n > 0) &&
-                (tpoll_is_set(conf->tp, inevent_fd, POLLIN) > 0)) {
-            n--;
+                (tpoll_is_set(loop->tp, inevent_fd, POLLIN) > 0)) {
             inevent_process();
         }
-        /*  If read_from_obj() or write_to_obj() returns -1,
+        /*  Only the fds that are ready are dispatched, so the cost of each
+         *    iteration is proportional to the number of ready objs rather
+         *    than the total number of objs.
+         *  If read_from_obj() or write_to_obj() returns -1,
          *    the obj's buffer has been flushed.  If it is a console obj,
          *    retain it and attempt to re-establish the connection;
-         *    o/w, give up and remove it from the master objs list.
+         *    o/w, give up and remove it from the loop's client list.
          */
-        list_iterator_reset(i);
+        if (loop->uring) {
+            if (n > 0) {
+                mux_io_uring(loop, inevent_fd);
+            }
+            continue;
+        }
+        j = 0;
         while ((n > 0) &&
-                ((obj = list_next(i)) != NULL)) {
+                ((fd = tpoll_next_ready(loop->tp, &j, &revents)) >= 0)) {
 
-            rvr = tpoll_is_set(conf->tp, obj->fd, POLLIN | POLLHUP | POLLERR);
-            rvw = tpoll_is_set(conf->tp, obj->fd, POLLOUT);
-            if ((rvr > 0) || (rvw > 0)) {
-                n--;
+            if ((isMain && (fd == conf->ld)) || (fd == inevent_fd)) {
+                continue;
+            }
+            if (!(obj = find_obj_by_fd(loop, fd))) {
+                continue;
             }
-            if ((rvr > 0) && (read_from_obj(obj) < 0)) {
-                list_delete(i);
+            if ((revents & (POLLIN | POLLHUP | POLLERR))
+                    && (read_from_obj(obj) < 0)) {
+                destroy_client_obj(obj);
                 continue;
             }
-            if ((rvw > 0) && (write_to_obj(obj) < 0)) {
-                list_delete(i);
+            if ((revents & POLLOUT) && (write_to_obj(obj) < 0)) {
+                destroy_client_obj(obj);
                 continue;
             }
         }
     }
-    log_msg(LOG_NOTICE, "Exiting on signal=%d", done);
-    list_iterator_destroy(i);
+    flush_loop_logfiles(loop);
+    if (isMain) {
+        log_msg(LOG_NOTICE, "Exiting on signal=%d", done);
+    }
+    return;
+}
+
+
+static void mux_io_uring(loop_t *loop, int inevent_fd)
+{
+/*  Dispatches the ready objs owned by the event (loop) like mux_io(),
+ *    but batches their I/O via io_uring so each batch of up to
+ *    URING_BATCH_SIZE objs is read or written with a single system call
+ *    instead of one per obj.
+ *  All reads are completed (and their data written into the circular-buffers
+ *    of their readers) before any writes are submitted, whereas mux_io()
+ *    alternates between the read and write of each obj.  Since data read
+ *    in an iteration only becomes writable in the next, the data written
+ *    is the same either way.
+ */
+    server_conf_t *conf = loop->conf;
+    obj_t *objs[URING_BATCH_SIZE];
+    int numObjs = 0;
+    int j;
+    int fd;
+    int len;
+    short int revents;
+    obj_t *obj;
+
+    j = 0;
+    while ((fd = tpoll_next_ready(loop->tp, &j, &revents)) >= 0) {
+
+        if (((loop->id == 0) && (fd == conf->ld)) || (fd == inevent_fd)) {
+            continue;
+        }
+        if (!(revents & (POLLIN | POLLHUP | POLLERR))) {
+            continue;
+        }
+        if (!(obj = find_obj_by_fd(loop, fd))) {
+            continue;
+        }
+        if (!prepare_read_from_obj(obj)) {
+            continue;
+        }
+        /*  Data spliced into a logfile bypasses user-space entirely,
+         *    so there is no read to be batched.
+         */
+        if (get_splice_logfile_obj(obj)) {
+            if (read_from_obj(obj) < 0) {
+                destroy_client_obj(obj);
+            }
+            continue;
+        }
+        /*  The read is bounded by the room its readers have for the data.
+         */
+        if ((len = MIN(get_obj_read_len(obj), get_obj_readers_room(obj)))
+                <= 0) {
+            continue;
+        }
+        obj->numReadBytes = 0;
+        if (uring_prep_read(loop->uring, fd, len, obj) < 0) {
+            if (errno != EBUSY) {
+                log_err(errno, "Unable to queue io_uring read");
+            }
+            submit_uring_reads(loop);
+            if (!loop->uring) {
+                return;
+            }
+            if (uring_prep_read(loop->uring, fd, len, obj) < 0) {
+                log_err(errno, "Unable to queue io_uring read");
+            }
+        }
+    }
+    submit_uring_reads(loop);
+    if (!loop->uring) {
+        return;
+    }
+
+    /*  The objs to be written are collected before any are locked since
+     *    prepare_write_to_obj() can write notification messages.
+     */
+    j = 0;
+    while ((fd = tpoll_next_ready(loop->tp, &j, &revents)) >= 0) {
+
+        if (((loop->id == 0) && (fd == conf->ld)) || (fd == inevent_fd)) {
+            continue;
+        }
+        if (!(revents & POLLOUT)) {
+            continue;
+        }
+        if (!(obj = find_obj_by_fd(loop, fd))) {
+            continue;
+        }
+        if (!prepare_write_to_obj(obj)) {
+            continue;
+        }
+        /*  Data written to a logfile with a writer thread is only copied
+         *    into the writer's queue, so there is no write to be batched.
+         */
+        if (is_logfile_obj(obj) && obj->aux.logfile.writer) {
+            if (write_to_obj(obj) < 0) {
+                destroy_client_obj(obj);
+            }
+            continue;
+        }
+        objs[numObjs++] = obj;
+        if (numObjs == URING_BATCH_SIZE) {
+            submit_uring_writes(loop, objs, numObjs);
+            numObjs = 0;
+            if (!loop->uring) {
+                return;
+            }
+        }
+    }
+    submit_uring_writes(loop, objs, numObjs);
+    return;
+}
+
+
+static void submit_uring_reads(loop_t *loop)
+{
+/*  Submits the batch of reads queued in the (loop) io_uring,
+ *    and processes their results as read_from_obj() would.
+ *  An obj whose read filled its buffer likely has more data pending,
+ *    so it is read again in another batch until its read budget is used.
+ */
+    server_conf_t *conf = loop->conf;
+    obj_t *again[URING_BATCH_SIZE];
+    int numAgain;
+    int i;
+    int j;
+    int n;
+    void *buf;
+    obj_t *obj;
+
+    do {
+        /*  If the submission fails, each read that did not complete is failed
+         *    with its error so the obj is processed as read_from_obj() would.
+         */
+        if (uring_submit(loop->uring) < 0) {
+            log_msg(LOG_ERR, "Unable to submit io_uring reads: %s",
+                strerror(errno));
+        }
+        numAgain = 0;
+        j = 0;
+        while ((obj = uring_next_completion(loop->uring, &j, &n, &buf))) {
+            if (n > 0) {
+                if (obj->numReadBytes == 0) {
+                    obj->numReadWakeups++;
+                }
+                obj->numReads++;
+                obj->numReadBytes += n;
+            }
+            if (end_read_from_obj(obj, buf, n) < 0) {
+                destroy_client_obj(obj);
+                continue;
+            }
+            if (uring_is_failed(loop->uring)) {
+                continue;
+            }
+            if ((n == get_obj_read_len(obj))
+                    && (obj->numReadBytes < conf->readBudget)
+                    && (get_obj_readers_room(obj) >= n)
+                    && prepare_read_from_obj(obj)) {
+                again[numAgain++] = obj;
+            }
+        }
+        for (i = 0; i < numAgain; i++) {
+            if (uring_prep_read(loop->uring, again[i]->fd,
+                    get_obj_read_len(again[i]), again[i]) < 0) {
+                log_err(errno, "Unable to queue io_uring read");
+            }
+        }
+    } while (numAgain > 0);
+    check_loop_uring(loop);
+    return;
+}
+
+
+static void submit_uring_writes(loop_t *loop, obj_t **objs, int numObjs)
+{
+/*  Writes the buffered data of the (numObjs) objs in the (objs) array
+ *    via a single batch submitted to the (loop) io_uring, and processes
+ *    their results as write_to_obj() would.
+ *  The buffer of each obj cannot change from begin_write_to_obj() until its
+ *    write has completed since only this loop's thread writes into it.
+ *    Objs that must be shut down are not shut down until every write has
+ *    completed since doing so can write notification messages into the
+ *    buffers of other objs in this batch.
+ */
+    server_conf_t *conf = loop->conf;
+    struct iovec iov;
+    int iovcnt;
+    int i;
+    int j;
+    int n;
+    obj_t *obj;
+
+    for (i = 0; i < numObjs; i++) {
+        obj = objs[i];
+        iovcnt = begin_write_to_obj(obj, &iov);
+        if (iovcnt == 0) {
+            if (!end_write_to_obj(obj, 0)) {
+                objs[i] = NULL;
+            }
+        }
+        else if (uring_prep_writev(loop->uring, obj->fd, &iov, iovcnt, obj) < 0)
+        {
+            log_err(errno, "Unable to queue io_uring write");
+        }
+    }
+    /*  If the submission fails, each write that did not complete is failed
+     *    with its error so the obj is processed as write_to_obj() would.
+     */
+    if (uring_submit(loop->uring) < 0) {
+        log_msg(LOG_ERR, "Unable to submit io_uring writes: %s",
+            strerror(errno));
+    }
+    j = 0;
+    i = 0;
+    while ((obj = uring_next_completion(loop->uring, &j, &n, NULL))) {
+        while ((i < numObjs) && (objs[i] != obj)) {
+            i++;
+        }
+        assert(i < numObjs);
+        if (!end_write_to_obj(obj, n) && (i < numObjs)) {
+            objs[i] = NULL;
+        }
+    }
+    for (i = 0; i < numObjs; i++) {
+        obj = objs[i];
+        if (obj && (shutdown_obj(obj) < 0)) {
+            destroy_client_obj(obj);
+        }
+    }
+    check_loop_uring(loop);
+    return;
+}
+
+
+static void check_loop_uring(loop_t *loop)
+{
+/*  Checks whether the (loop) io_uring can still be used after a batch.
+ *  If a failed submission left requests in flight, the kernel may still
+ *    access their buffers, so the uring is abandoned (and intentionally
+ *    leaked) rather than destroyed, and the loop falls back to tpoll()
+ *    with read() and writev() for the remainder of its lifetime.
+ */
+    if (!uring_is_failed(loop->uring)) {
+        return;
+    }
+    log_msg(LOG_WARNING, "Disabling io_uring for event loop %d", loop->id);
+    loop->uring = NULL;
+    return;
+}
+
+
+static void wake_loop(loop_t *loop)
+{
+/*  Timer callback to wake (loop) from tpoll() so it can check its flags.
+ */
+    (void) loop;                /* suppress unused-parameter warning */
+    DPRINTF((10, "Woke event loop %d.\n", loop->id));
     return;
 }
 
@@ -933,11 +1482,35 @@ err:
 static void reopen_logfiles(server_conf_t *conf)
 {
 /*  Reopens the daemon logfile and all of the logfiles in the 'objs' list.
+ *  Each event loop reopens the logfiles it owns;
+ *    a timer is set to have each of the other loops reopen theirs.
+ */
+    int n;
+
+    for (n = 1; n < conf->numLoops; n++) {
+        if (tpoll_timeout_relative(conf->loops[n].tp,
+                (callback_f) reopen_loop_logfiles, &conf->loops[n], 0) < 0) {
+            log_msg(LOG_ERR, "Unable to create timer for reopening logfiles "
+                "in loop %d", n);
+        }
+    }
+    reopen_loop_logfiles(&conf->loops[0]);
+
+    if (conf->logFileName && !conf->enableForeground) {
+        open_daemon_logfile(conf);
+    }
+    return;
+}
+
+
+static void reopen_loop_logfiles(loop_t *loop)
+{
+/*  Reopens the logfiles owned by (loop).
  */
     ListIterator i;
     obj_t *logfile;
 
-    i = list_iterator_create(conf->objs);
+    i = list_iterator_create(loop->objs);
     while ((logfile = list_next(i))) {
         if (!is_logfile_obj(logfile)) {
             continue;
@@ -945,10 +1518,26 @@ static void reopen_logfiles(server_conf_t *conf)
         open_logfile_obj(logfile);
     }
     list_iterator_destroy(i);
+    return;
+}
 
-    if (conf->logFileName && !conf->enableForeground) {
-        open_daemon_logfile(conf);
+
+static void flush_loop_logfiles(loop_t *loop)
+{
+/*  Writes out the data buffered for the logfiles owned by (loop) as it stops,
+ *    since data may have been deferred to batch it into fewer writes.
+ */
+    ListIterator i;
+    obj_t *logfile;
+
+    i = list_iterator_create(loop->objs);
+    while ((logfile = list_next(i))) {
+        if (!is_logfile_obj(logfile)) {
+            continue;
+        }
+        flush_obj_data(logfile);
     }
+    list_iterator_destroy(i);
     return;
 }
 
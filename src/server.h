@@ -36,26 +36,52 @@
 #include <sys/types.h>                  /* include before in.h for bsd */
 #include <netinet/in.h>                 /* for struct sockaddr_in            */
 #include <pthread.h>                    /* for pthread_mutex_t               */
+#include <stdint.h>                     /* for uint64_t                      */
 #include <stdio.h>                      /* for FILE                          */
+#include <sys/uio.h>                    /* for struct iovec                  */
 #include <termios.h>                    /* for struct termios, speed_t       */
 #include <time.h>                       /* for time_t                        */
 #include <unistd.h>                     /* for pid_t                         */
 #include "common.h"
 #include "list.h"
 #include "tpoll.h"
+#include "uring.h"
+#include "vring.h"
 
 
 #define DEFAULT_LOGOPT_LOCK             1
 #define DEFAULT_LOGOPT_SANITIZE         0
 #define DEFAULT_LOGOPT_TIMESTAMP        0
+#define DEFAULT_LOGOPT_SYNC             0
+
+#define DEFAULT_LOG_FLUSH_MSECS         1000
+#define MAX_LOG_FLUSH_MSECS             60000
+
+#define DEFAULT_LOG_FRAME_SECS          60
+#define DEFAULT_LOG_INDEX_SECS          60
+#define MAX_LOG_INTERVAL_SECS           86400
+#define LOG_INDEX_SUFFIX                ".idx"
+#define LOG_INDEX_RECORD_LEN            32
+
+#define DEFAULT_LOG_KEEP                4
+#define MAX_LOG_KEEP                    999
+
+#define DEFAULT_READ_BUDGET             65536
 
 #define DEFAULT_SEROPT_BPS              B9600
 #define DEFAULT_SEROPT_DATABITS         8
 #define DEFAULT_SEROPT_PARITY           0
 #define DEFAULT_SEROPT_STOPBITS         1
 
+#define LOG_WRITER_MAX_QUEUED           1048576
+
 #define MIN_CONNECT_SECS                60
 
+#define MAX_THREADS_PER_CPU             4
+
+#define OBJ_CACHE_LINE_SIZE             64
+#define OBJ_SET_INLINE_LEN              4
+
 #if WITH_FREEIPMI
 #define IPMI_ENGINE_CONSOLES_PER_THREAD 128
 #define IPMI_MAX_USER_LEN               IPMI_MAX_USER_NAME_LENGTH
@@ -79,6 +105,8 @@
 #define UNIXSOCK_MAX_TIMEOUT            60
 #define UNIXSOCK_MIN_TIMEOUT            1
 
+#define URING_BATCH_SIZE                64
+
 #ifndef CONMAN_CONF
 #define CONMAN_CONF                     QUOTE(SYSCONFDIR) "/conman.conf"
 #endif /* !CONMAN_CONF */
@@ -99,14 +127,41 @@ enum obj_type {                         /* type of auxiliary obj             */
 typedef struct client_obj {             /* CLIENT AUX OBJ DATA:              */
     req_t           *req;               /*  client request info              */
     time_t           timeLastRead;      /*  time last data was read from fd  */
+    overrun_policy_t overrunPolicy;     /*  policy for handling overruns     */
+    int              overrunLimit;      /*  disconnect limit or spool size   */
+    FILE            *spool;             /*  overrun spool tmpfile, or NULL   */
+    int              spoolHead;         /*  spool offset of oldest data      */
+    int              spoolLen;          /*  num bytes of data in the spool   */
+    unsigned long    numOverruns;       /*  num overruns where data was lost */
+    unsigned long    numBytesLost;      /*  num bytes lost to overruns       */
+    unsigned long    numBytesLimited;   /*  num bytes lost while !suspended  */
+    unsigned long    numBytesSpooled;   /*  num bytes written to the spool   */
+    unsigned long    numBytesUnmarked;  /*  num bytes lost since last marker */
+    struct log_replay *replay;          /*  log replay in progress, or NULL  */
+    struct base_obj *prev;              /*  prev client in loop's client list*/
+    struct base_obj *next;              /*  next client in loop's client list*/
     unsigned         gotEscape:1;       /*  true if last char rcvd was esc   */
     unsigned         gotSuspend:1;      /*  true if suspending client output */
+    unsigned         gotOverrunLimit:1; /*  true if overrun limit exceeded   */
 } client_obj_t;
 
+typedef enum logfile_compress_type {    /* logfile compression type          */
+    CONMAN_LOG_COMPRESS_NONE,
+    CONMAN_LOG_COMPRESS_GZIP
+} log_compress_t;
+
 typedef struct logfile_opt {            /* LOGFILE OBJ OPTIONS:              */
+    int              flushBytes;        /*  bytes deferred to batch writes   */
+    int              flushMsecs;        /*  max ms deferred to batch writes  */
+    log_compress_t   compress;          /*  compression type                 */
+    int              frameSecs;         /*  secs per compressed frame        */
+    int              indexSecs;         /*  secs per time index entry, or 0  */
+    uint64_t         maxSize;           /*  bytes at which log is rotated    */
+    int              numKeep;           /*  num rotated logs kept            */
     unsigned         enableLock:1;      /*  true if logfile being locked     */
     unsigned         enableSanitize:1;  /*  true if logfile being sanitized  */
     unsigned         enableTimestamp:1; /*  true if timestamping each line   */
+    unsigned         enableSync:1;      /*  true if syncing data to disk     */
 } logopt_t;
 
 typedef enum logfile_line_state {       /* log CR/LF newline state (2 bits)  */
@@ -120,8 +175,29 @@ typedef struct logfile_obj {            /* LOGFILE AUX OBJ DATA:             */
     struct base_obj *console;           /*  con obj ref for name expansion   */
     char            *fmtName;           /*  name with conversion specifiers  */
     logopt_t         opts;              /*  local options                    */
+    int              pipeFds[2];        /*  pipe for splicing console data   */
+    struct log_writer *writer;          /*  writer thread, or NULL if none   */
+    struct log_zip  *zip;               /*  compression state (writer only)  */
+    int              numQueued;         /*  bytes queued for writer thread   */
+    int              numPending;        /*  blocks queued for writer thread  */
+    int              maxQueued;         /*  max bytes queued (stats)         */
+    int              isStalled;         /*  true if writes await queue space */
+    int              writeErrno;        /*  errno of failed write by writer  */
+    unsigned         writeGen;          /*  generation of fd being written   */
+    unsigned long    numWrites;         /*  num writes by writer (stats)     */
+    unsigned long    numStalls;         /*  num times queue was full (stats) */
+    unsigned long    maxWriteMsecs;     /*  max write latency in ms (stats)  */
+    uint64_t         numBytesWritten;   /*  bytes written by writer (stats)  */
+    int              flushTimer;        /*  timer id for deferred flush      */
+    uint64_t         size;              /*  bytes written to current file    */
+    int              indexFd;           /*  time index fd, or -1 if none     */
+    time_t           indexNext;         /*  time at which next entry is due  */
+    unsigned         gotFlushDue:1;     /*  true if deferred data is due     */
+    unsigned         gotUnsynced:1;     /*  true if data written since sync  */
     unsigned         gotProcessing:1;   /*  true if input processing req'd   */
+    unsigned         gotSplice:1;       /*  true if console data is spliced  */
     unsigned         gotTruncate:1;     /*  true if ZeroLogs is enabled      */
+    unsigned         gotRotateDue:1;    /*  true if log rotation is pending  */
     unsigned         lineState:2;       /*  log_line_state_t CR/LF state     */
 } logfile_obj_t;
 
@@ -251,24 +327,85 @@ typedef union aux_obj {
     test_obj_t       test;
 } aux_obj_t;
 
+typedef struct fan_ring {               /* FAN-OUT RING:                     */
+    vring_t          ring;              /*  mirrored mapping of circular-buf */
+    unsigned char   *buf;               /*  circular-buf of data read by obj */
+    int              size;              /*  size of circular-buf in bytes    */
+    uint64_t         head;              /*  total num bytes written (atomic) */
+    uint64_t         numSpliced;        /*  num bytes spliced past the ring  */
+} fan_ring_t;
+
+typedef struct obj_set {                /* OBJ SET:                          */
+    struct base_obj **objs;             /*  ary of objs (inline or spilled)  */
+    int              numObjs;           /*  num objs in set (atomic)         */
+    int              maxObjs;           /*  num objs the ary can hold        */
+    pthread_mutex_t  lock;              /*  lock for traversal w/o links lck */
+    struct base_obj *inlineObjs[OBJ_SET_INLINE_LEN]; /* ary until spilled */
+} obj_set_t;
+
+/*  The fields accessed each time an obj's event loop dispatches its I/O are
+ *    placed first so they share the obj's leading cache line (objs are
+ *    allocated from cache-aligned slabs); the rarely-used fields follow.
+ *  The inbox is written by other threads, so it is placed last on a cache
+ *    line of its own where those writes do not evict the leading line
+ *    from the cache of the obj's event loop.
+ */
 typedef struct base_obj {               /* BASE OBJ:                         */
-    char            *name;              /*  obj name                         */
     int              fd;                /*  file descriptor                  */
-    unsigned char    buf[OBJ_BUF_SIZE]; /*  circular-buf to be written to fd */
+    unsigned         type;              /*  enum obj_type of auxiliary obj   */
+    unsigned         gotBufWrap:1;      /*  true if circular-buf has wrapped */
+    unsigned         gotEOF:1;          /*  true if obj got EOF on last read */
+    struct server_loop *loop;           /*  event loop that owns this obj    */
+    unsigned char   *buf;               /*  circular-buf to be written to fd */
     unsigned char   *bufInPtr;          /*  ptr for data written in to buf   */
     unsigned char   *bufOutPtr;         /*  ptr for data written out to fd   */
-    pthread_mutex_t  bufLock;           /*  lock protecting access to buf    */
-    List             readers;           /*  list of objs that read from me   */
-    List             writers;           /*  list of objs that write to me    */
+    fan_ring_t      *fan;               /*  console ring shared by readers   */
+    struct base_obj *fanSrc;            /*  console whose fan ring is read   */
+    int              bufSize;           /*  size of circular-buf in bytes    */
+    int              numReadBytes;      /*  bytes read during current wakeup */
+    uint64_t         fanPos;            /*  fan ring pos of next byte out    */
+    uint64_t         fanEnd;            /*  fan ring pos at detach (atomic)  */
+    obj_set_t        readers;           /*  set of objs that read from me    */
+    obj_set_t        writers;           /*  set of objs that write to me     */
+    char            *name;              /*  obj name                         */
+    int              fdIndex;           /*  fd under which obj is in fd tab  */
+    vring_t          ring;              /*  mirrored mapping of circular-buf */
     char            *resetCmdRef;       /*  console reset cmd string ref     */
     pid_t            resetCmdPid;       /*  console reset cmd active pid     */
     int              resetCmdTimer;     /*  console reset cmd timer id       */
-    unsigned         type;              /*  enum obj_type of auxiliary obj   */
-    unsigned         gotBufWrap:1;      /*  true if circular-buf has wrapped */
-    unsigned         gotEOF:1;          /*  true if obj got EOF on last read */
+    unsigned long    numReads;          /*  num reads returning data (stats) */
+    unsigned long    numReadWakeups;    /*  num wakeups w/ data read (stats) */
     aux_obj_t        aux;               /*  auxiliary obj data union         */
+    int              numInbox           /*  num msgs in inbox (atomic)       */
+        __attribute__((aligned(OBJ_CACHE_LINE_SIZE)));
+    List             inbox;             /*  data written by other threads    */
 } obj_t;
 
+typedef struct server_loop {            /* EVENT LOOP:                       */
+    struct server_conf *conf;           /*  server's configuration           */
+    int              id;                /*  index into the conf loops array  */
+    pthread_t        tid;               /*  thread running the loop          */
+    tpoll_t          tp;                /*  tpoll obj for its i/o & timers   */
+    uring_t          uring;             /*  io_uring batch obj, or NULL      */
+    List             objs;              /*  list of static objs in this loop */
+    pthread_mutex_t  lock;              /*  lock for the loop's client list  */
+    obj_t           *clients;           /*  list of clients owned by loop    */
+    int              numClients;        /*  num clients in the client list   */
+    obj_t          **fdObjs;            /*  table mapping fds to owned objs  */
+    int              fdObjsLen;         /*  num entries in fdObjs table      */
+} loop_t;
+
+typedef struct log_writer {             /* LOGFILE WRITER THREAD:            */
+    int              id;                /*  index into the conf writers array*/
+    pthread_t        tid;               /*  thread writing out the logfiles  */
+    pthread_mutex_t  lock;              /*  lock for queue & logfile stats   */
+    pthread_cond_t   cond;              /*  cond signaled when blocks queued */
+    pthread_cond_t   drained;           /*  cond signaled when blocks written*/
+    struct log_block *head;             /*  queue of blocks to be written    */
+    struct log_block *tail;             /*  last block in the queue          */
+    unsigned         gotDone:1;         /*  true if thread should exit       */
+} log_writer_t;
+
 typedef struct server_conf {
     char            *confFileName;      /* configuration file name           */
     char            *coreDumpDir;       /* dir where core dumps are written  */
@@ -288,9 +425,17 @@ typedef struct server_conf {
     time_t           tStampNext;        /* time next stamp written to logs   */
     int              fd;                /* configuration file descriptor     */
     int              port;              /* port number on which to listen    */
+    int              readBudget;        /* max bytes read from obj per wakeup*/
+    int              bufSize;           /* default circular-buf size for objs*/
+    overrun_policy_t overrunPolicy;     /* policy for client buffer overruns */
+    int              overrunLimit;      /* disconnect limit or spool size    */
     int              ld;                /* listening socket descriptor       */
     List             objs;              /* list of all server obj_t's        */
-    tpoll_t          tp;                /* tpoll obj for muxing i/o & timers */
+    tpoll_t          tp;                /* tpoll obj for the main event loop */
+    loop_t          *loops;             /* array of event loops              */
+    int              numLoops;          /* number of event loop threads      */
+    log_writer_t    *logWriters;        /* array of logfile writer threads   */
+    int              numLogWriters;     /* number of logfile writer threads  */
     char            *globalLogName;     /* global log name (must contain &)  */
     logopt_t         globalLogOpts;     /* global opts for logfile objects   */
     seropt_t         globalSerOpts;     /* global opts for serial objects    */
@@ -306,6 +451,8 @@ typedef struct server_conf {
     unsigned         enableVerbose:1;   /* true if verbose output requested  */
     unsigned         enableZeroLogs:1;  /* true if console logs are zero'd   */
     unsigned         enableForeground:1;/* true if daemon should not fork    */
+    unsigned         enableIOUring:1;   /* true if i/o is batched w/ io_uring*/
+    unsigned         enableSplice:1;    /* true if logs are spliced from fds */
 } server_conf_t;
 
 typedef struct client_args {
@@ -348,6 +495,21 @@ typedef struct client_args {
  */
 
 
+/*  Concerning object OWNERSHIP:
+ *
+ *  An object's circular write-buffer (along with its position in the fan-out
+ *  ring of the console it reads and its overrun spool) is only accessed by
+ *  the thread running the event loop that owns it.  Since a console's readers
+ *  are owned by the console's loop, data read from a console is written into
+ *  the buffers of its readers without locking.
+ *
+ *  Data written to an object by any other thread (eg, a client's handshake
+ *  thread or a B/C client owned by another loop) is queued in the object's
+ *  inbox.  The owning loop moves it into the object's write-buffer before
+ *  the object is next written out.
+ */
+
+
 /*  Macros
  */
 #define CONMAN_OBJ_IS_CONSOLE \
@@ -422,6 +584,30 @@ int open_logfile_obj(obj_t *logfile);
 
 obj_t * get_console_logfile_obj(obj_t *console);
 
+int read_logfile_tail(obj_t *logfile, unsigned char *dst, int len);
+
+void create_log_writers(server_conf_t *conf);
+
+void destroy_log_writers(server_conf_t *conf);
+
+int queue_log_write(obj_t *logfile, const struct iovec *iov, int iovcnt);
+
+void queue_log_close(obj_t *logfile);
+
+void wait_log_writes(obj_t *logfile);
+
+int sync_logfile_obj(obj_t *logfile);
+
+void count_logfile_bytes(obj_t *logfile, int n);
+
+void close_logfile_index(obj_t *logfile);
+
+void start_log_replay(obj_t *client);
+
+int read_log_replay(obj_t *client, unsigned char *dst, int len);
+
+void stop_log_replay(obj_t *client);
+
 int write_log_data(obj_t *log, const void *src, int len);
 
 
@@ -432,8 +618,16 @@ obj_t * create_obj(server_conf_t *conf, char *name,
 
 obj_t * create_client_obj(server_conf_t *conf, req_t *req);
 
+void start_client_obj(obj_t *client);
+
+void create_obj_buf(obj_t *obj, int size);
+
+int copy_obj_fan_history(obj_t *console, unsigned char *dst, int len);
+
 void destroy_obj(obj_t *obj);
 
+void destroy_client_obj(obj_t *client);
+
 void reopen_obj(obj_t *obj);
 
 int format_obj_string(char *buf, int buflen, obj_t *obj, const char *fmt);
@@ -442,10 +636,16 @@ int compare_objs(obj_t *obj1, obj_t *obj2);
 
 int find_obj(obj_t *obj, obj_t *key);
 
+obj_t * find_obj_by_fd(loop_t *loop, int fd);
+
 int write_notify_msg(obj_t *console, int priority, char *fmt, ...);
 
 void notify_console_objs(obj_t *console, char *msg);
 
+int count_obj_set(obj_set_t *set);
+
+obj_t * get_obj_set(obj_set_t *set, int n);
+
 void link_objs(obj_t *src, obj_t *dst);
 
 void unlink_objs(obj_t *src, obj_t *dst);
@@ -456,10 +656,34 @@ int shutdown_obj(obj_t *obj);
 
 int read_from_obj(obj_t *obj);
 
+int get_obj_readers_room(obj_t *obj);
+
+obj_t * get_splice_logfile_obj(obj_t *console);
+
+void flush_obj_data(obj_t *obj);
+
+void expedite_obj_flush(obj_t *obj);
+
+uint64_t get_logfile_obj_end(obj_t *logfile, obj_t *reader);
+
+int prepare_read_from_obj(obj_t *obj);
+
+int get_obj_read_len(obj_t *obj);
+
+int end_read_from_obj(obj_t *obj, unsigned char *buf, int n);
+
+void write_obj_readers(obj_t *obj, unsigned char *buf, int n);
+
 int write_obj_data(obj_t *obj, const void *src, int len, int isInfo);
 
 int write_to_obj(obj_t *obj);
 
+int prepare_write_to_obj(obj_t *obj);
+
+int begin_write_to_obj(obj_t *obj, struct iovec *iov);
+
+int end_write_to_obj(obj_t *obj, int n);
+
 
 /*  server-process.c
  */
@@ -32,10 +32,28 @@
 #include <poll.h>
 #include <pthread.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <sys/resource.h>
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
+#if HAVE_SYS_EPOLL_H && HAVE_EPOLL_CREATE1
+#  include <sys/epoll.h>
+#  define TPOLL_HAVE_EPOLL 1
+#endif /* HAVE_SYS_EPOLL_H && HAVE_EPOLL_CREATE1 */
+#if HAVE_CLOCK_GETTIME && defined(CLOCK_MONOTONIC)
+#  define TPOLL_HAVE_MONOTONIC 1
+#endif /* HAVE_CLOCK_GETTIME && CLOCK_MONOTONIC */
+#if HAVE_SYS_EVENTFD_H && HAVE_EVENTFD
+#  include <sys/eventfd.h>
+#  define TPOLL_HAVE_EVENTFD 1
+#endif /* HAVE_SYS_EVENTFD_H && HAVE_EVENTFD */
+#if TPOLL_HAVE_EPOLL && TPOLL_HAVE_MONOTONIC \
+        && HAVE_SYS_TIMERFD_H && HAVE_TIMERFD_CREATE
+#  include <sys/timerfd.h>
+#  define TPOLL_HAVE_TIMERFD 1
+#endif /* TPOLL_HAVE_EPOLL && ... && HAVE_TIMERFD_CREATE */
 #include "bool.h"
 #include "log.h"
 #include "tpoll.h"
@@ -57,15 +75,60 @@
  *  descriptors to the first empty slot in fd_array[], and maintaining a hash
  *  to map file descriptors onto the corresponding fd_array[] index.
  *
- *  This implementation assumes the number of concurrent active timers is
- *  moderate; as such, active timers are stored in a linked-list in order of
- *  increasing timevals (ie, the head of the list (timers_active) is the next
- *  timer to expire).  It does not scale well to a large number of timers
- *  because insertion and deletion are O(n), although dispatching is O(1).
- *  Other possible implementations are heaps [Sedgewick 1998] which are
- *  O(log n) for insertion, deletion, and dispatch; or hashed timing wheels
- *  [Varghese and Lauck 1996] which can be as efficient as O(1) for insertion,
- *  deletion, and dispatch.
+ *  Two backends are supported for waiting on the file descriptors.  The poll
+ *  backend passes fd_array[0..max_fd] to poll() on every call, so each wakeup
+ *  costs O(max_fd) both in the kernel and in userspace.  The epoll backend
+ *  (Linux) keeps the interest set persistent within the kernel by updating it
+ *  via epoll_ctl() whenever the events for an fd change; epoll_wait() then
+ *  returns only the fds that are ready, so each wakeup costs O(ready fds).
+ *  The fd_array[] is still maintained by the epoll backend in order to
+ *  record the requested events and to store the revents for tpoll_is_set().
+ *
+ *  With either backend, the fds that were ready after the last tpoll() are
+ *  recorded in fd_ready[].  This allows the caller to dispatch only the fds
+ *  that are ready via tpoll_next_ready(), and allows the epoll backend to
+ *  reset their revents on the next call without scanning all of fd_array[].
+ *  File descriptors that do not support epoll (eg, regular files and
+ *  /dev/null) are tracked in fd_nopoll[] and are always reported as ready
+ *  for their requested events, which matches the behavior of poll().
+ *
+ *  Active timers are stored in a binary min-heap [Sedgewick 1998] ordered by
+ *  increasing timevals (ie, the root of the heap (timers_heap[0]) is the next
+ *  timer to expire), so insertion, deletion, and dispatch are O(log n).
+ *  Timers with identical timevals are ordered by their sequence number so
+ *  they are dispatched in the order in which they were set.  Each timer
+ *  records its index within the heap, and timers are also chained in a hash
+ *  table keyed by timer ID, so canceling a timer by its ID does not require
+ *  searching the heap.  Hashed timing wheels [Varghese and Lauck 1996] can
+ *  be as efficient as O(1) for insertion and deletion, but require a fixed
+ *  timer resolution and range.
+ *
+ *  Timers are driven by the monotonic clock (where available) so they are
+ *  unaffected by changes to the system time.  Relative timers are keyed by
+ *  their monotonic expiration time.  Absolute timers specify a wall-clock
+ *  expiration time (eg, for jobs aligned to the top of the minute); they are
+ *  keyed by the equivalent monotonic time, and are re-keyed whenever the
+ *  offset between the wall clock and the monotonic clock changes (eg, when
+ *  the system time is stepped) so they still expire at the wall-clock time.
+ *  The epoll backend also arms a timerfd for the next timer to expire and
+ *  waits on it along with the other fds.  This avoids recomputing the
+ *  epoll_wait() timeout on each iteration and provides sub-millisecond
+ *  precision so tpoll() does not wake up before the next timer is due.
+ *
+ *  A thread blocked in tpoll() is woken by signaling the "signaling pipe"
+ *  whenever another thread changes its state (eg, sets a new timer to expire
+ *  first).  Where available, an eventfd serves as both ends of this pipe; it
+ *  costs a single fd and accumulates wakeups in a counter that is reset by
+ *  a single read.  Otherwise, a non-blocking pipe is used.  Either way, at
+ *  most one wakeup is pending at a time since signals sent while one is
+ *  already pending are coalesced.
+ *
+ *  The poll backend passes fd_array[] to poll() while the mutex is released,
+ *  so the array cannot be realloc'd out from under the kernel.  If it must
+ *  grow while poll() is blocked, a new array is allocated and the polled
+ *  array is retained in fd_array_polled until poll() returns; its revents
+ *  are then carried over into the new array so the ready fds need not be
+ *  polled again.
  */
 
 
@@ -74,6 +137,9 @@
  *****************************************************************************/
 
 #define TPOLL_ALLOC     256
+#define TPOLL_TIMERS    256
+#define TPOLL_SKEW_MSEC 10
+#define TPOLL_EVENTS    1024
 
 
 /*****************************************************************************
@@ -83,26 +149,52 @@
 typedef struct tpoll_timer * _tpoll_timer_t;
 
 struct tpoll {
+    tpoll_backend_t  backend;           /* backend used for waiting on fds   */
     struct pollfd   *fd_array;          /* poll fd array                     */
+    struct pollfd   *fd_array_polled;   /* fd array being polled, or NULL    */
+    int              num_fds_polled;    /* num pollfd structs being polled   */
     int              fd_pipe[ 2 ];      /* signal pipe for unblocking poll() */
     int              num_fds_alloc;     /* num pollfd structs allocated      */
     int              num_fds_used;      /* num pollfd structs in use         */
     int              max_fd;            /* max fd in array in use            */
-    _tpoll_timer_t   timers_active;     /* sorted list of active timers      */
+    _tpoll_timer_t  *timers_heap;       /* min-heap of active timers         */
+    int              num_timers;        /* num active timers in heap         */
+    int              num_timers_alloc;  /* num timer ptrs allocated for heap */
+    _tpoll_timer_t  *timers_hash;       /* hash of active timers keyed by id */
+    int              timers_hash_size;  /* num buckets in hash (power of 2)  */
     int              timers_next_id;    /* next id to be assigned to a timer */
+    unsigned long    timers_next_seq;   /* next seq num for ordering timers  */
+    int              num_timers_real;   /* num active wall-clock timers      */
+    struct timeval   tv_offset;         /* wall-clock minus monotonic time   */
+    int              fd_timer;          /* timerfd for next timer, or -1     */
+    struct timeval   tv_timer;          /* expiration time armed in timerfd  */
+    bool             is_timer_armed;    /* flag set when timerfd is armed    */
     pthread_mutex_t  mutex;             /* locking primitive                 */
     bool             is_blocked;        /* flag set when blocking on poll()  */
-    bool             is_realloced;      /* flag set after fd_array[] realloc */
     bool             is_signaled;       /* flag set when fd_pipe is signaled */
+    bool             is_eventfd;        /* flag set when fd_pipe is eventfd  */
     bool             is_mutex_inited;   /* flag set when mutex initialized   */
+    int             *fd_ready;          /* fds w/ revents set by last tpoll  */
+    int              num_fds_ready;     /* num fds in fd_ready[]             */
+#if TPOLL_HAVE_EPOLL
+    int              fd_epoll;          /* epoll fd for the epoll backend    */
+    struct epoll_event *ep_events;      /* event array for epoll_wait()      */
+    int             *fd_nopoll;         /* fds unsupported by epoll          */
+    int              num_fds_nopoll;    /* num fds in fd_nopoll[]            */
+    int             *fd_nopoll_idx;     /* fd_nopoll[] index by fd, or -1    */
+#endif /* TPOLL_HAVE_EPOLL */
 };
 
 struct tpoll_timer {
     int              id;                /* timer ID                          */
     callback_f       fnc;               /* callback function                 */
     void            *arg;               /* callback function arg             */
-    struct timeval   tv;                /* expiration time                   */
-    _tpoll_timer_t   next;              /* next timer in list                */
+    struct timeval   tv;                /* expiration time (monotonic)       */
+    struct timeval   tv_real;           /* expiration time (wall-clock)      */
+    bool             is_real;           /* flag set for wall-clock timers    */
+    unsigned long    seq;               /* seq num for ordering equal tvs    */
+    int              heap_idx;          /* index of timer in heap            */
+    _tpoll_timer_t   hash_next;         /* next timer in hash bucket         */
 };
 
 
@@ -112,16 +204,64 @@ struct tpoll_timer {
 
 static void _tpoll_init (tpoll_t tp, tpoll_zero_t how);
 
+static int _tpoll_signal_create (tpoll_t tp);
+
 static void _tpoll_signal_send (tpoll_t tp);
 
 static void _tpoll_signal_recv (tpoll_t tp);
 
 static int _tpoll_grow (tpoll_t tp, int num_fds_req);
 
+static void _tpoll_poll_carry (tpoll_t tp, int n);
+
+static void _tpoll_ready_reset (tpoll_t tp);
+
+static int _tpoll_ready_collect (tpoll_t tp);
+
+static int _tpoll_timer_set (tpoll_t tp, callback_f cb, void *arg,
+    const struct timeval *tvp, const struct timeval *tvp_real);
+
+static int _tpoll_timer_insert (tpoll_t tp, _tpoll_timer_t t);
+
+static void _tpoll_timer_remove (tpoll_t tp, _tpoll_timer_t t);
+
+static _tpoll_timer_t _tpoll_timer_find (tpoll_t tp, int id);
+
+static int _tpoll_timer_cmp (_tpoll_timer_t t1, _tpoll_timer_t t2);
+
+static void _tpoll_heap_up (tpoll_t tp, int i);
+
+static void _tpoll_heap_down (tpoll_t tp, int i);
+
+static int _tpoll_hash_grow (tpoll_t tp);
+
+static void _tpoll_timer_rekey (tpoll_t tp, const struct timeval *tvp_now);
+
 static void _tpoll_get_timeval (struct timeval *tvp, int ms);
 
+static void _tpoll_get_realtime (struct timeval *tvp);
+
 static int _tpoll_diff_timeval (struct timeval *tvp1, struct timeval *tvp0);
 
+#if TPOLL_HAVE_EPOLL
+static int _tpoll_epoll_create (tpoll_t tp);
+
+static int _tpoll_epoll_update (tpoll_t tp, int fd, short int events_old);
+
+static void _tpoll_epoll_nopoll_add (tpoll_t tp, int fd);
+
+static void _tpoll_epoll_nopoll_del (tpoll_t tp, int fd);
+
+static int _tpoll_epoll_wait (tpoll_t tp, int timeout);
+
+#if TPOLL_HAVE_TIMERFD
+static int _tpoll_timerfd_arm (tpoll_t tp);
+
+static void _tpoll_timerfd_recv (tpoll_t tp);
+#endif /* TPOLL_HAVE_TIMERFD */
+
+#endif /* TPOLL_HAVE_EPOLL */
+
 
 /*****************************************************************************
  *  Functions
@@ -132,47 +272,92 @@ tpoll_create (int n)
 {
 /*  Creates a new tpoll object for multiplexing timers as well as I/O over at
  *    least [n] file descriptors.  If [n] is 0, the default size will be used.
+ *  The best backend available on this system will be used.
  *  Returns an opaque pointer to this new object, or NULL on error.
+ */
+    return (tpoll_create_backend (n, TPOLL_BACKEND_DEFAULT));
+}
+
+
+tpoll_t
+tpoll_create_backend (int n, tpoll_backend_t backend)
+{
+/*  Creates a new tpoll object for multiplexing timers as well as I/O over at
+ *    least [n] file descriptors using the specified [backend].  If [n] is 0,
+ *    the default size will be used.  If [backend] is TPOLL_BACKEND_DEFAULT,
+ *    the epoll backend will be used if available with the poll backend as
+ *    a fallback.
+ *  Returns an opaque pointer to this new object, or NULL on error
+ *    (with errno set to ENOSYS if the requested backend is not supported).
  */
     tpoll_t tp = NULL;
-    int     i;
-    int     fval;
     int     e;
 
     assert (TPOLL_ALLOC > 0);
+    assert ((TPOLL_TIMERS > 0) && ((TPOLL_TIMERS & (TPOLL_TIMERS - 1)) == 0));
 
     if (n <= 0) {
         n = TPOLL_ALLOC;
     }
+#if ! TPOLL_HAVE_EPOLL
+    if (backend == TPOLL_BACKEND_EPOLL) {
+        errno = ENOSYS;
+        return (NULL);
+    }
+#endif /* !TPOLL_HAVE_EPOLL */
     if (!(tp = malloc (sizeof (struct tpoll)))) {
         goto err;
     }
+    tp->backend = TPOLL_BACKEND_POLL;
+    tp->fd_array = NULL;
+    tp->fd_array_polled = NULL;
+    tp->num_fds_polled = 0;
     tp->fd_pipe[ 0 ] = tp->fd_pipe[ 1 ] = -1;
-    tp->timers_active = NULL;
+    tp->timers_heap = NULL;
+    tp->num_timers = 0;
+    tp->num_timers_alloc = 0;
+    tp->timers_hash = NULL;
+    tp->timers_hash_size = 0;
+    tp->fd_timer = -1;
+    tp->is_timer_armed = false;
     tp->is_blocked = false;
-    tp->is_realloced = false;
     tp->is_signaled = false;
+    tp->is_eventfd = false;
     tp->is_mutex_inited = false;
+    tp->fd_ready = NULL;
+    tp->num_fds_ready = 0;
+#if TPOLL_HAVE_EPOLL
+    tp->fd_epoll = -1;
+    tp->ep_events = NULL;
+    tp->fd_nopoll = NULL;
+    tp->num_fds_nopoll = 0;
+    tp->fd_nopoll_idx = NULL;
+#endif /* TPOLL_HAVE_EPOLL */
 
     if (!(tp->fd_array = malloc (n * sizeof (struct pollfd)))) {
         goto err;
     }
+    if (!(tp->fd_ready = malloc (n * sizeof (int)))) {
+        goto err;
+    }
     tp->num_fds_alloc = n;
+    tp->num_fds_used = 0;
+    tp->max_fd = -1;
 
-    if (pipe (tp->fd_pipe) < 0) {
+    if (_tpoll_signal_create (tp) < 0) {
         goto err;
     }
-    for (i = 0; i < 2; i++) {
-        if ((fval = fcntl (tp->fd_pipe[ i ], F_GETFL, 0)) < 0) {
-            goto err;
-        }
-        if (fcntl (tp->fd_pipe[ i ], F_SETFL, fval | O_NONBLOCK) < 0) {
-            goto err;
-        }
-        if (fcntl (tp->fd_pipe[ i ], F_SETFD, FD_CLOEXEC) < 0) {
-            goto err;
+#if TPOLL_HAVE_EPOLL
+    if (backend != TPOLL_BACKEND_POLL) {
+        if (_tpoll_epoll_create (tp) < 0) {
+            if (backend == TPOLL_BACKEND_EPOLL) {
+                goto err;
+            }
+            DPRINTF((5, "Unable to create epoll backend: %s.\n",
+                strerror (errno)));
         }
     }
+#endif /* TPOLL_HAVE_EPOLL */
     if ((e = pthread_mutex_init (&tp->mutex, NULL)) != 0) {
         errno = e;
         goto err;
@@ -186,18 +371,33 @@ tpoll_create (int n)
     return (tp);
 
 err:
+    e = errno;
     tpoll_destroy (tp);
+    errno = e;
     return (NULL);
 }
 
 
+tpoll_backend_t
+tpoll_get_backend (tpoll_t tp)
+{
+/*  Returns the backend used by the tpoll object [tp] for waiting on fds,
+ *    or TPOLL_BACKEND_DEFAULT on error.
+ */
+    if (!tp) {
+        errno = EINVAL;
+        return (TPOLL_BACKEND_DEFAULT);
+    }
+    return (tp->backend);
+}
+
+
 void
 tpoll_destroy (tpoll_t tp)
 {
 /*  Destroys the tpoll object [tp] and cancels all of its associated timers.
  */
     int            i;
-    _tpoll_timer_t t;
     int            e;
 
     if (!tp) {
@@ -212,17 +412,44 @@ tpoll_destroy (tpoll_t tp)
         free (tp->fd_array);
         tp->fd_array = NULL;
     }
+    if (tp->fd_array_polled) {
+        free (tp->fd_array_polled);
+        tp->fd_array_polled = NULL;
+    }
+    if (tp->is_eventfd) {
+        tp->fd_pipe[ 1 ] = -1;          /* both ends share the eventfd */
+    }
     for (i = 0; i < 2; i++) {
         if (tp->fd_pipe[ i ] > -1) {
             (void) close (tp->fd_pipe[ i ]);
             tp->fd_pipe[ i ] = -1;
         }
     }
-    while (tp->timers_active) {
-        t = tp->timers_active;
-        tp->timers_active = t->next;
-        free (t);
-    }
+    if (tp->timers_heap) {
+        for (i = 0; i < tp->num_timers; i++) {
+            free (tp->timers_heap[ i ]);
+        }
+        free (tp->timers_heap);
+        tp->timers_heap = NULL;
+    }
+    if (tp->timers_hash) {
+        free (tp->timers_hash);
+        tp->timers_hash = NULL;
+    }
+    if (tp->fd_timer > -1) {
+        (void) close (tp->fd_timer);
+        tp->fd_timer = -1;
+    }
+#if TPOLL_HAVE_EPOLL
+    if (tp->fd_epoll > -1) {
+        (void) close (tp->fd_epoll);
+        tp->fd_epoll = -1;
+    }
+    free (tp->ep_events);
+    free (tp->fd_nopoll);
+    free (tp->fd_nopoll_idx);
+#endif /* TPOLL_HAVE_EPOLL */
+    free (tp->fd_ready);
     if (tp->is_mutex_inited) {
         if ((e = pthread_mutex_unlock (&tp->mutex)) != 0) {
             log_err (errno = e, "Unable to unlock tpoll mutex");
@@ -278,6 +505,7 @@ tpoll_clear (tpoll_t tp, int fd, short int events)
  *    descriptor [fd] within the tpoll object [tp].
  *  Returns 0 on success, or -1 on error.
  */
+    short int events_old;
     short int events_new = 0;
     int       i;
     int       e;
@@ -299,8 +527,9 @@ tpoll_clear (tpoll_t tp, int fd, short int events)
     if ((fd <= tp->max_fd) && (tp->fd_array[ fd ].fd > -1)) {
 
         assert (tp->fd_array[ fd ].fd == fd);
-        events_new = tp->fd_array[ fd ].events & ~events;
-        if (tp->fd_array[ fd ].events != events_new) {
+        events_old = tp->fd_array[ fd ].events;
+        events_new = events_old & ~events;
+        if (events_old != events_new) {
 
             tp->fd_array[ fd ].events = events_new;
 
@@ -318,6 +547,12 @@ tpoll_clear (tpoll_t tp, int fd, short int events)
                     tp->max_fd = i;
                 }
             }
+#if TPOLL_HAVE_EPOLL
+            if (tp->backend == TPOLL_BACKEND_EPOLL) {
+                (void) _tpoll_epoll_update (tp, fd, events_old);
+            }
+            else
+#endif /* TPOLL_HAVE_EPOLL */
             _tpoll_signal_send (tp);
         }
     }
@@ -380,7 +615,9 @@ tpoll_set (tpoll_t tp, int fd, short int events)
  *  Returns 0 on success, or -1 on error.
  */
     int       rc;
+    short int events_old;
     short int events_new = 0;
+    int       i;
     int       e;
 
     if (!tp) {
@@ -401,6 +638,7 @@ tpoll_set (tpoll_t tp, int fd, short int events)
         rc = -1;
     }
     else {
+        events_old = tp->fd_array[ fd ].events;
         if (tp->fd_array[ fd ].fd < 0) {
             assert (tp->fd_array[ fd ].events == 0);
             assert (tp->fd_array[ fd ].revents == 0);
@@ -412,13 +650,36 @@ tpoll_set (tpoll_t tp, int fd, short int events)
             events_new = events;
         }
         else {
-            events_new = tp->fd_array[ fd ].events | events;
+            events_new = events_old | events;
         }
-        if (tp->fd_array[ fd ].events != events_new) {
+        rc = 0;
+        if (events_old != events_new) {
             tp->fd_array[ fd ].events = events_new;
+#if TPOLL_HAVE_EPOLL
+            if (tp->backend == TPOLL_BACKEND_EPOLL) {
+                rc = _tpoll_epoll_update (tp, fd, events_old);
+            }
+            else
+#endif /* TPOLL_HAVE_EPOLL */
             _tpoll_signal_send (tp);
         }
-        rc = 0;
+        if ((rc < 0) && (events_old == 0)) {
+            tp->fd_array[ fd ].events = 0;
+            tp->fd_array[ fd ].fd = -1;
+            tp->num_fds_used--;
+
+            if (tp->max_fd == fd) {
+                for (i = fd - 1; i >= 0; i--) {
+                    if (tp->fd_array[ i ].fd > -1) {
+                        break;
+                    }
+                }
+                tp->max_fd = i;
+            }
+        }
+        else if (rc < 0) {
+            tp->fd_array[ fd ].events = events_old;
+        }
     }
     DPRINTF((21, "tpoll_set fd=%d e=0x%02x r=0x%02x.\n",
         fd, events, events_new));
@@ -436,54 +697,25 @@ tpoll_timeout_absolute (tpoll_t tp, callback_f cb, void *arg,
 /*  Sets an "absolute" timer event for the tpoll object [tp] specifying when
  *    the timer should expire.  At expiration time [tvp], the callback
  *    function [cb] will be invoked with the argument [arg].
+ *  The expiration time is specified in wall-clock time (as returned by
+ *    gettimeofday()); the timer will expire at that wall-clock time even if
+ *    the system time is changed in the interim.
  *  Returns a timer ID > 0 for use with tpoll_timeout_cancel(), or -1 on error.
  */
-    _tpoll_timer_t  t;
-    _tpoll_timer_t *t_ptr;
-    int             rc;
-    int             e;
+    struct timeval tv_now;
+    struct timeval tv_real;
+    struct timeval tv_diff;
+    struct timeval tv;
 
-    if (!tp) {
-        errno = EINVAL;
-        return (-1);
-    }
-    if (!cb) {
-        errno = EINVAL;
-        return (-1);
-    }
     if (!tvp) {
         errno = EINVAL;
         return (-1);
     }
-    if (!(t = malloc (sizeof (struct tpoll_timer)))) {
-        return (-1);
-    }
-    t->fnc = cb;
-    t->arg = arg;
-    t->tv = *tvp;
-
-    if ((e = pthread_mutex_lock (&tp->mutex)) != 0) {
-        log_err (errno = e, "Unable to lock tpoll mutex");
-    }
-    rc = t->id = tp->timers_next_id++;
-    if (tp->timers_next_id <= 0) {
-        tp->timers_next_id = 1;
-    }
-    t_ptr = &tp->timers_active;
-    while (*t_ptr && !timercmp (tvp, &(*t_ptr)->tv, <)) {
-        t_ptr = &((*t_ptr)->next);
-    }
-    if (*t_ptr == tp->timers_active) {
-        _tpoll_signal_send (tp);
-    }
-    t->next = *t_ptr;
-    *t_ptr = t;
-
-    DPRINTF((22, "tpoll timer set id=%d.\n", t->id));
-    if ((e = pthread_mutex_unlock (&tp->mutex)) != 0) {
-        log_err (errno = e, "Unable to unlock tpoll mutex");
-    }
-    return (rc);
+    _tpoll_get_timeval (&tv_now, 0);
+    _tpoll_get_realtime (&tv_real);
+    timersub (tvp, &tv_real, &tv_diff);
+    timeradd (&tv_now, &tv_diff, &tv);
+    return (_tpoll_timer_set (tp, cb, arg, &tv, tvp));
 }
 
 
@@ -493,12 +725,14 @@ tpoll_timeout_relative (tpoll_t tp, callback_f cb, void *arg, int ms)
 /*  Sets a "relative" timer event for the tpoll object [tp] specifying the
  *    duration (in milliseconds [ms]) before it expires.  At expiration, the
  *    callback function [cb] will be invoked with the argument [arg].
+ *  The duration is measured with the monotonic clock, so it is unaffected
+ *    by changes to the system time.
  *  Returns a timer ID > 0 for use with tpoll_timeout_cancel(), or -1 on error.
  */
     struct timeval tv;
 
     _tpoll_get_timeval (&tv, ms);
-    return (tpoll_timeout_absolute (tp, cb, arg, &tv));
+    return (_tpoll_timer_set (tp, cb, arg, &tv, NULL));
 }
 
 
@@ -510,7 +744,6 @@ tpoll_timeout_cancel (tpoll_t tp, int id)
  *    or -1 on error.
  */
     _tpoll_timer_t  t;
-    _tpoll_timer_t *t_ptr;
     int             rc;
     int             e;
 
@@ -525,20 +758,15 @@ tpoll_timeout_cancel (tpoll_t tp, int id)
     if ((e = pthread_mutex_lock (&tp->mutex)) != 0) {
         log_err (errno = e, "Unable to lock tpoll mutex");
     }
-    t_ptr = &tp->timers_active;
-    while (*t_ptr && (id != (*t_ptr)->id)) {
-        t_ptr = &((*t_ptr)->next);
-    }
-    if (!*t_ptr) {
+    if (!(t = _tpoll_timer_find (tp, id))) {
         rc = 0;
     }
     else {
-        DPRINTF((22, "tpoll timer cancel id=%d.\n", (*t_ptr)->id));
-        if (*t_ptr == tp->timers_active) {
+        DPRINTF((22, "tpoll timer cancel id=%d.\n", t->id));
+        if (t->heap_idx == 0) {
             _tpoll_signal_send (tp);
         }
-        t = *t_ptr;
-        *t_ptr = t->next;
+        _tpoll_timer_remove (tp, t);
         free (t);
         rc = 1;
     }
@@ -586,16 +814,19 @@ tpoll (tpoll_t tp, int ms)
     DPRINTF((23, "tpoll enter ms=%d nfd=%d mfd=%d.\n",
         ms, tp->num_fds_used, tp->max_fd));
     _tpoll_get_timeval (&tv_now, 0);
+    _tpoll_ready_reset (tp);
 
     for (;;) {
         /*
          *  Dispatch timer events that have expired.
          */
-        while (tp->timers_active
-                && !timercmp (&tp->timers_active->tv, &tv_now, >)) {
+        _tpoll_timer_rekey (tp, &tv_now);
 
-            t = tp->timers_active;
-            tp->timers_active = t->next;
+        while ((tp->num_timers > 0)
+                && !timercmp (&tp->timers_heap[ 0 ]->tv, &tv_now, >)) {
+
+            t = tp->timers_heap[ 0 ];
+            _tpoll_timer_remove (tp, t);
             DPRINTF((22, "tpoll timer dispatch id=%d.\n", t->id));
             /*
              *  Release the mutex while performing the callback function
@@ -616,7 +847,7 @@ tpoll (tpoll_t tp, int ms)
         if (ms == 0) {
             timeout = 0;
         }
-        else if ((ms < 0) && !tp->timers_active) {
+        else if ((ms < 0) && (tp->num_timers == 0)) {
             if (tp->num_fds_used > 0) {
                 timeout = -1;           /* fd events but no more timers */
             }
@@ -628,19 +859,19 @@ tpoll (tpoll_t tp, int ms)
             _tpoll_get_timeval (&tv_now, 0);
 
             if (ms < 0) {
-                assert (tp->timers_active != NULL);
+                assert (tp->num_timers > 0);
                 ms_diff =
-                    _tpoll_diff_timeval (&tp->timers_active->tv, &tv_now);
+                    _tpoll_diff_timeval (&tp->timers_heap[ 0 ]->tv, &tv_now);
             }
-            else if (!tp->timers_active) {
+            else if (tp->num_timers == 0) {
                 assert (ms > 0);
                 ms_diff =
                     _tpoll_diff_timeval (&tv_timeout, &tv_now);
             }
-            else if (!timercmp (&tp->timers_active->tv, &tv_timeout, >)) {
+            else if (!timercmp (&tp->timers_heap[ 0 ]->tv, &tv_timeout, >)) {
                 assert (ms > 0);
                 ms_diff =
-                    _tpoll_diff_timeval (&tp->timers_active->tv, &tv_now);
+                    _tpoll_diff_timeval (&tp->timers_heap[ 0 ]->tv, &tv_now);
             }
             else {
                 assert (ms > 0);
@@ -649,41 +880,79 @@ tpoll (tpoll_t tp, int ms)
             }
             timeout = (ms_diff > 0) ? ms_diff : 0;
         }
-        /*  Poll for events, discarding any on the "signaling pipe".
+#if TPOLL_HAVE_TIMERFD
+        /*  If the timerfd is armed for the next timer to expire, epoll_wait()
+         *    only needs to time out for the [ms] timeout.
          */
-        tp->is_blocked = true;
-
-        if ((e = pthread_mutex_unlock (&tp->mutex)) != 0) {
-            log_err (errno = e, "Unable to unlock tpoll mutex");
+        if ((ms != 0) && (tp->num_timers > 0) && (tp->fd_timer > -1)
+                && (_tpoll_timerfd_arm (tp) == 0)) {
+            if (ms < 0) {
+                timeout = -1;
+            }
+            else {
+                ms_diff = _tpoll_diff_timeval (&tv_timeout, &tv_now);
+                timeout = (ms_diff > 0) ? ms_diff : 0;
+            }
         }
-        DPRINTF((25, "tpoll poll enter ms=%d mfd=%d.\n", timeout, tp->max_fd));
-        n = poll (tp->fd_array, tp->max_fd + 1, timeout);
-        DPRINTF((25, "tpoll poll return n=%d.\n", n));
-
-        if ((e = pthread_mutex_lock (&tp->mutex)) != 0) {
-            log_err (errno = e, "Unable to lock tpoll mutex");
+#endif /* TPOLL_HAVE_TIMERFD */
+#if TPOLL_HAVE_EPOLL
+        if (tp->backend == TPOLL_BACKEND_EPOLL) {
+            /*
+             *  Wait for events on fds monitored by epoll.  Fds unsupported
+             *    by epoll are always ready, so don't block if any are set.
+             */
+            if (tp->num_fds_nopoll > 0) {
+                timeout = 0;
+            }
+            n = _tpoll_epoll_wait (tp, timeout);
+            if (n < 0) {
+                break;
+            }
         }
-        tp->is_blocked = false;
+        else
+#endif /* TPOLL_HAVE_EPOLL */
+        {
+            /*  Poll for events, discarding any on the "signaling pipe".
+             */
+            tp->is_blocked = true;
+            tp->fd_array_polled = tp->fd_array;
+            tp->num_fds_polled = tp->max_fd + 1;
 
-        if (n < 0) {
-            break;
-        }
-        if (tp->is_realloced) {
-            DPRINTF((25, "tpoll is_realloced.\n"));
-            tp->is_realloced = false;
-            _tpoll_signal_recv (tp);
-            continue;
-        }
-        if (tp->fd_array[ tp->fd_pipe[ 0 ] ].revents & POLLIN) {
-            _tpoll_signal_recv (tp);
-            n--;
+            if ((e = pthread_mutex_unlock (&tp->mutex)) != 0) {
+                log_err (errno = e, "Unable to unlock tpoll mutex");
+            }
+            DPRINTF((25, "tpoll poll enter ms=%d mfd=%d.\n",
+                timeout, tp->num_fds_polled - 1));
+            n = poll (tp->fd_array_polled, tp->num_fds_polled, timeout);
+            DPRINTF((25, "tpoll poll return n=%d.\n", n));
+
+            if ((e = pthread_mutex_lock (&tp->mutex)) != 0) {
+                log_err (errno = e, "Unable to lock tpoll mutex");
+            }
+            tp->is_blocked = false;
+
+            if (tp->fd_array_polled != tp->fd_array) {
+                _tpoll_poll_carry (tp, n);
+            }
+            tp->fd_array_polled = NULL;
+
+            if (n < 0) {
+                break;
+            }
+            if (tp->fd_array[ tp->fd_pipe[ 0 ] ].revents & POLLIN) {
+                _tpoll_signal_recv (tp);
+                n--;
+            }
+            if (n > 0) {
+                n = _tpoll_ready_collect (tp);
+            }
         }
         if (n > 0) {
             assert (tp->num_fds_used > 0);
             break;
         }
         if ((ms == 0)
-                || ((ms < 0) && !tp->num_fds_used && !tp->timers_active)) {
+                || ((ms < 0) && !tp->num_fds_used && !tp->num_timers)) {
             break;
         }
         _tpoll_get_timeval (&tv_now, 0);
@@ -699,6 +968,51 @@ tpoll (tpoll_t tp, int ms)
 }
 
 
+int
+tpoll_next_ready (tpoll_t tp, int *ip, short int *reventsp)
+{
+/*  Iterates over the file descriptors found to be ready by the last call to
+ *    tpoll() for the tpoll object [tp].  The cursor [ip] must be set to 0
+ *    before the first call; it is advanced by each successive call.
+ *  Fds whose events have been cleared since tpoll() returned are skipped.
+ *  Returns the next ready fd (and sets [reventsp] to its revents if not
+ *    NULL), or -1 once all ready fds have been returned or on error.
+ */
+    int       fd = -1;
+    short int revents = 0;
+    int       e;
+
+    if (!tp) {
+        errno = EINVAL;
+        return (-1);
+    }
+    if (!ip || (*ip < 0)) {
+        errno = EINVAL;
+        return (-1);
+    }
+    if ((e = pthread_mutex_lock (&tp->mutex)) != 0) {
+        log_err (errno = e, "Unable to lock tpoll mutex");
+    }
+    while (*ip < tp->num_fds_ready) {
+        fd = tp->fd_ready[ (*ip)++ ];
+        if ((fd <= tp->max_fd) && (tp->fd_array[ fd ].fd > -1)) {
+            revents = tp->fd_array[ fd ].revents;
+            if (revents != 0) {
+                break;
+            }
+        }
+        fd = -1;
+    }
+    if ((e = pthread_mutex_unlock (&tp->mutex)) != 0) {
+        log_err (errno = e, "Unable to unlock tpoll mutex");
+    }
+    if (reventsp) {
+        *reventsp = revents;
+    }
+    return (fd);
+}
+
+
 /*****************************************************************************
  *  Internal Functions
  *****************************************************************************/
@@ -710,7 +1024,6 @@ _tpoll_init (tpoll_t tp, tpoll_zero_t how)
  *  This routine assumes the [tp] mutex is already locked.
  */
     int            i;
-    _tpoll_timer_t t;
 
     assert (tp != NULL);
     assert (tp->fd_pipe[ 0 ] > -1);
@@ -718,6 +1031,23 @@ _tpoll_init (tpoll_t tp, tpoll_zero_t how)
     assert ((how & ~TPOLL_ZERO_ALL) == 0);
 
     if (how & TPOLL_ZERO_FDS) {
+#if TPOLL_HAVE_EPOLL
+        if (tp->backend == TPOLL_BACKEND_EPOLL) {
+            for (i = 0; i <= tp->max_fd; i++) {
+                if ((tp->fd_array[ i ].fd > -1)
+                        && (tp->fd_array[ i ].events != 0)
+                        && (i != tp->fd_pipe[ 0 ])
+                        && (tp->fd_nopoll_idx[ i ] < 0)) {
+                    (void) epoll_ctl (tp->fd_epoll, EPOLL_CTL_DEL, i, NULL);
+                }
+            }
+            for (i = 0; i < tp->num_fds_alloc; i++) {
+                tp->fd_nopoll_idx[ i ] = -1;
+            }
+            tp->num_fds_nopoll = 0;
+        }
+#endif /* TPOLL_HAVE_EPOLL */
+        tp->num_fds_ready = 0;
         memset (tp->fd_array, 0, tp->num_fds_alloc * sizeof (struct pollfd));
         for (i = 0; i < tp->num_fds_alloc; i++) {
             tp->fd_array[ i ].fd = -1;
@@ -728,26 +1058,79 @@ _tpoll_init (tpoll_t tp, tpoll_zero_t how)
         tp->num_fds_used = 0;
     }
     if (how & TPOLL_ZERO_TIMERS) {
-        while (tp->timers_active) {
-            t = tp->timers_active;
-            tp->timers_active = t->next;
-            free (t);
+        for (i = 0; i < tp->num_timers; i++) {
+            free (tp->timers_heap[ i ]);
+        }
+        tp->num_timers = 0;
+        if (tp->timers_hash) {
+            memset (tp->timers_hash, 0,
+                tp->timers_hash_size * sizeof (_tpoll_timer_t));
         }
         tp->timers_next_id = 1;
+        tp->timers_next_seq = 0;
+        tp->num_timers_real = 0;
+        timerclear (&tp->tv_offset);
     }
     return;
 }
 
 
+static int
+_tpoll_signal_create (tpoll_t tp)
+{
+/*  Creates the "signaling pipe" used to unblock tpoll() for [tp].
+ *  An eventfd is used for both ends of the pipe if available;
+ *    o/w, a non-blocking pipe is created.
+ *  Returns 0 on success, or -1 on error.
+ */
+    int i;
+    int fval;
+
+    assert (tp != NULL);
+    assert (tp->fd_pipe[ 0 ] < 0);
+    assert (tp->fd_pipe[ 1 ] < 0);
+
+#if TPOLL_HAVE_EVENTFD
+    tp->fd_pipe[ 0 ] = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (tp->fd_pipe[ 0 ] > -1) {
+        tp->fd_pipe[ 1 ] = tp->fd_pipe[ 0 ];
+        tp->is_eventfd = true;
+        return (0);
+    }
+    DPRINTF((5, "Unable to create eventfd for tpoll: %s.\n",
+        strerror (errno)));
+#endif /* TPOLL_HAVE_EVENTFD */
+
+    if (pipe (tp->fd_pipe) < 0) {
+        return (-1);
+    }
+    for (i = 0; i < 2; i++) {
+        if ((fval = fcntl (tp->fd_pipe[ i ], F_GETFL, 0)) < 0) {
+            return (-1);
+        }
+        if (fcntl (tp->fd_pipe[ i ], F_SETFL, fval | O_NONBLOCK) < 0) {
+            return (-1);
+        }
+        if (fcntl (tp->fd_pipe[ i ], F_SETFD, FD_CLOEXEC) < 0) {
+            return (-1);
+        }
+    }
+    return (0);
+}
+
+
 static void
 _tpoll_signal_send (tpoll_t tp)
 {
 /*  Signals the tpoll object [tp] that an fd or timer or somesuch has changed
  *    and poll() needs to unblock and re-examine its state.
+ *  The signal is only sent if tpoll() is blocked and a signal is not already
+ *    pending, so concurrent changes are coalesced into a single wakeup.
  *  This routine assumes the [tp] mutex is already locked.
  */
     int           n;
-    unsigned char c = 0;
+    uint64_t      v = 1;
+    size_t        len;
 
     assert (tp != NULL);
     assert (tp->fd_pipe[ 1 ] > -1);
@@ -755,8 +1138,12 @@ _tpoll_signal_send (tpoll_t tp)
     if (tp->is_signaled || !tp->is_blocked) {
         return;
     }
+    /*  An eventfd requires an 8-byte counter increment,
+     *    whereas a single byte suffices for a pipe.
+     */
+    len = tp->is_eventfd ? sizeof (v) : 1;
     for (;;) {
-        n = write (tp->fd_pipe[ 1 ], &c, 1);
+        n = write (tp->fd_pipe[ 1 ], &v, len);
         if (n < 0) {
             if (errno == EINTR) {
                 continue;
@@ -784,7 +1171,8 @@ _tpoll_signal_recv (tpoll_t tp)
  *  This routine assumes the [tp] mutex is already locked.
  */
     int           n;
-    unsigned char c[ 2 ];
+    uint64_t      v[ 2 ];
+    size_t        len;
 
     assert (tp != NULL);
     assert (tp->fd_pipe[ 0 ] > -1);
@@ -793,8 +1181,12 @@ _tpoll_signal_recv (tpoll_t tp)
     if (!tp->is_signaled) {
         return;
     }
+    /*  A single read resets an eventfd's counter.  For a pipe, attempt to
+     *    read 2 bytes in order to detect if more than 1 signal was sent.
+     */
+    len = tp->is_eventfd ? sizeof (v[ 0 ]) : 2;
     for (;;) {
-        n = read (tp->fd_pipe[ 0 ], &c, sizeof (c));
+        n = read (tp->fd_pipe[ 0 ], v, len);
         if (n < 0) {
             if (errno == EINTR) {
                 continue;
@@ -807,7 +1199,7 @@ _tpoll_signal_recv (tpoll_t tp)
         else if (n == 0) {
             log_err (0, "Got an unexpected EOF reading from tpoll's pipe");
         }
-        else if (n == sizeof (c)) {
+        else if (!tp->is_eventfd && (n > 1)) {
             assert (0);                 /* is_signaled should prevent this */
             continue;
         }
@@ -831,6 +1223,7 @@ _tpoll_grow (tpoll_t tp, int num_fds_req)
     int            num_fds_tmp;
     int            num_fds_new;
     int            i;
+    int           *p;
 
     assert (tp != NULL);
     assert (num_fds_req > 0);
@@ -845,69 +1238,551 @@ _tpoll_grow (tpoll_t tp, int num_fds_req)
     if (num_fds_tmp < num_fds_req) {
         num_fds_tmp = num_fds_req;
     }
-    /*  Force tpoll()'s poll() to unblock before we realloc the fd_array.
-     *  Then tpoll() will have to re-acquire the mutex before continuing.
-     *  Since we currently have the mutex, we can now safely realloc fd_array.
+    /*  If tpoll()'s poll() is blocked on the fd_array, it cannot be
+     *    realloc'd since the kernel will write the revents back into it.
+     *  Instead, copy it into a new array and leave the polled array intact;
+     *    it will be freed by tpoll() once poll() returns.
+     *  Otherwise (or if the current array is not the one being polled),
+     *    the fd_array can be safely realloc'd since we have the mutex.
      */
-    _tpoll_signal_send (tp);
-    if (!(fd_array_tmp =
+    if (tp->fd_array == tp->fd_array_polled) {
+        if (!(fd_array_tmp = malloc (num_fds_tmp * sizeof (struct pollfd)))) {
+            return (-1);
+        }
+        memcpy (fd_array_tmp, tp->fd_array,
+            tp->num_fds_alloc * sizeof (struct pollfd));
+        DPRINTF((25, "tpoll grow while polled n=%d.\n", num_fds_tmp));
+    }
+    else if (!(fd_array_tmp =
             realloc (tp->fd_array, num_fds_tmp * sizeof (struct pollfd)))) {
         return (-1);
     }
+    tp->fd_array = fd_array_tmp;
+
+    if (!(p = realloc (tp->fd_ready, num_fds_tmp * sizeof (int)))) {
+        return (-1);
+    }
+    tp->fd_ready = p;
+#if TPOLL_HAVE_EPOLL
+    if (tp->backend == TPOLL_BACKEND_EPOLL) {
+        if (!(p = realloc (tp->fd_nopoll, num_fds_tmp * sizeof (int)))) {
+            return (-1);
+        }
+        tp->fd_nopoll = p;
+        if (!(p = realloc (tp->fd_nopoll_idx, num_fds_tmp * sizeof (int)))) {
+            return (-1);
+        }
+        tp->fd_nopoll_idx = p;
+        for (i = tp->num_fds_alloc; i < num_fds_tmp; i++) {
+            tp->fd_nopoll_idx[ i ] = -1;
+        }
+    }
+#endif /* TPOLL_HAVE_EPOLL */
     fd_array_new = fd_array_tmp + tp->num_fds_alloc;
     num_fds_new = num_fds_tmp - tp->num_fds_alloc;
     memset (fd_array_new, 0, num_fds_new * sizeof (struct pollfd));
     for (i = tp->num_fds_alloc; i < num_fds_tmp; i++) {
         fd_array_tmp[ i ].fd = -1;
     }
-    tp->is_realloced = true;
-    tp->fd_array = fd_array_tmp;
     tp->num_fds_alloc = num_fds_tmp;
     return (0);
 }
 
 
 static void
-_tpoll_get_timeval (struct timeval *tvp, int ms)
+_tpoll_poll_carry (tpoll_t tp, int n)
 {
-/*  Sets [tvp] to the current time.
- *  If [ms] > 0, adds the number of milliseconds [ms] to [tvp].
+/*  Carries over the revents from the fd array polled by tpoll() into [tp]'s
+ *    current fd_array[] after it was grown while poll() was blocked, and then
+ *    frees the polled array.  [n] is the value returned by poll().
+ *  This routine assumes the [tp] mutex is already locked.
  */
-    assert (tvp != NULL);
+    struct pollfd *pfd;
+    int            i;
 
-    if (gettimeofday (tvp, NULL) < 0) {
-        log_err (0, "Unable to get time of day");
+    assert (tp != NULL);
+    assert (tp->fd_array_polled != NULL);
+    assert (tp->fd_array_polled != tp->fd_array);
+    assert (tp->num_fds_polled <= tp->num_fds_alloc);
+
+    for (i = 0; i < tp->num_fds_polled; i++) {
+        pfd = &tp->fd_array_polled[ i ];
+        if ((n > 0) && (pfd->revents != 0)
+                && (tp->fd_array[ i ].fd == pfd->fd)) {
+            tp->fd_array[ i ].revents = pfd->revents
+                & (tp->fd_array[ i ].events | POLLERR | POLLHUP | POLLNVAL);
+        }
+        else {
+            tp->fd_array[ i ].revents = 0;
+        }
     }
-    if (ms > 0) {
-        tvp->tv_sec += ms / 1000;
-        tvp->tv_usec += (ms % 1000) * 1000;
-        if (tvp->tv_usec >= 1000000) {
-            tvp->tv_sec += tvp->tv_usec / 1000000;
-            tvp->tv_usec %= 1000000;
+    free (tp->fd_array_polled);
+    tp->fd_array_polled = NULL;
+    DPRINTF((25, "tpoll carried revents for %d fds.\n", tp->num_fds_polled));
+    return;
+}
+
+
+static void
+_tpoll_ready_reset (tpoll_t tp)
+{
+/*  Resets the revents of the fds that were ready after the last tpoll().
+ *  This routine assumes the [tp] mutex is already locked.
+ */
+    int i;
+    int fd;
+
+    assert (tp != NULL);
+
+    for (i = 0; i < tp->num_fds_ready; i++) {
+        fd = tp->fd_ready[ i ];
+        if (fd < tp->num_fds_alloc) {
+            tp->fd_array[ fd ].revents = 0;
         }
     }
+    tp->num_fds_ready = 0;
     return;
 }
 
 
 static int
-_tpoll_diff_timeval (struct timeval *tvp1, struct timeval *tvp0)
+_tpoll_ready_collect (tpoll_t tp)
 {
-/*  Returns the millisecond difference between [tvp1] and [tvp0].
- *  If either is NULL, the current time will be used in its place.
+/*  Records the fds with revents set by poll() in [tp]'s fd_ready[].
+ *  Returns the number of fds with I/O ready.
+ *  This routine assumes the [tp] mutex is already locked.
  */
-    struct timeval tv;
-    int            ms;
+    int i;
 
-    if (!tvp0 || !tvp1) {
-        if (gettimeofday (&tv, NULL) < 0) {
-            log_err (0, "Unable to get time of day");
-        }
-        if (!tvp0) {
-            tvp0 = &tv;
-        }
-        if (!tvp1) {
-            tvp1 = &tv;
+    assert (tp != NULL);
+    assert (tp->backend == TPOLL_BACKEND_POLL);
+
+    tp->num_fds_ready = 0;
+    for (i = 0; i <= tp->max_fd; i++) {
+        if ((tp->fd_array[ i ].revents != 0) && (i != tp->fd_pipe[ 0 ])) {
+            tp->fd_ready[ tp->num_fds_ready++ ] = i;
+        }
+    }
+    return (tp->num_fds_ready);
+}
+
+
+static int
+_tpoll_timer_set (tpoll_t tp, callback_f cb, void *arg,
+    const struct timeval *tvp, const struct timeval *tvp_real)
+{
+/*  Sets a timer event for the tpoll object [tp] to expire at the monotonic
+ *    time [tvp].  If [tvp_real] is not NULL, the timer is to expire at that
+ *    wall-clock time, and [tvp] is its current monotonic equivalent.
+ *  Returns a timer ID > 0 for use with tpoll_timeout_cancel(), or -1 on error.
+ */
+    _tpoll_timer_t  t;
+    int             rc;
+    int             e;
+
+    if (!tp) {
+        errno = EINVAL;
+        return (-1);
+    }
+    if (!cb) {
+        errno = EINVAL;
+        return (-1);
+    }
+    assert (tvp != NULL);
+
+    if (!(t = malloc (sizeof (struct tpoll_timer)))) {
+        return (-1);
+    }
+    t->fnc = cb;
+    t->arg = arg;
+    t->tv = *tvp;
+    if (tvp_real) {
+        t->tv_real = *tvp_real;
+        t->is_real = true;
+    }
+    else {
+        timerclear (&t->tv_real);
+        t->is_real = false;
+    }
+    if ((e = pthread_mutex_lock (&tp->mutex)) != 0) {
+        log_err (errno = e, "Unable to lock tpoll mutex");
+    }
+    /*  Skip over IDs still in use after the ID counter has wrapped around.
+     */
+    do {
+        t->id = tp->timers_next_id++;
+        if (tp->timers_next_id <= 0) {
+            tp->timers_next_id = 1;
+        }
+    } while (_tpoll_timer_find (tp, t->id) != NULL);
+
+    t->seq = tp->timers_next_seq++;
+
+    if (_tpoll_timer_insert (tp, t) < 0) {
+        free (t);
+        rc = -1;
+    }
+    else {
+        if (t->heap_idx == 0) {
+            _tpoll_signal_send (tp);
+        }
+        rc = t->id;
+    }
+    DPRINTF((22, "tpoll timer set id=%d.\n", rc));
+    if ((e = pthread_mutex_unlock (&tp->mutex)) != 0) {
+        log_err (errno = e, "Unable to unlock tpoll mutex");
+    }
+    return (rc);
+}
+
+
+static int
+_tpoll_timer_insert (tpoll_t tp, _tpoll_timer_t t)
+{
+/*  Inserts the timer [t] into [tp]'s heap and hash of active timers.
+ *  Returns 0 on success, or -1 on error.
+ *  This routine assumes the [tp] mutex is already locked.
+ */
+    _tpoll_timer_t *heap_tmp;
+    int             n;
+    int             b;
+
+    assert (tp != NULL);
+    assert (t != NULL);
+
+    if (tp->num_timers >= tp->num_timers_alloc) {
+        n = (tp->num_timers_alloc > 0) ? tp->num_timers_alloc * 2
+                                       : TPOLL_TIMERS;
+        if (!(heap_tmp = realloc (tp->timers_heap, n * sizeof (t)))) {
+            return (-1);
+        }
+        tp->timers_heap = heap_tmp;
+        tp->num_timers_alloc = n;
+    }
+    if ((tp->num_timers >= tp->timers_hash_size)
+            && (_tpoll_hash_grow (tp) < 0)) {
+        return (-1);
+    }
+    b = t->id & (tp->timers_hash_size - 1);
+    t->hash_next = tp->timers_hash[ b ];
+    tp->timers_hash[ b ] = t;
+
+    t->heap_idx = tp->num_timers++;
+    tp->timers_heap[ t->heap_idx ] = t;
+    _tpoll_heap_up (tp, t->heap_idx);
+
+    if (t->is_real) {
+        tp->num_timers_real++;
+    }
+    return (0);
+}
+
+
+static void
+_tpoll_timer_remove (tpoll_t tp, _tpoll_timer_t t)
+{
+/*  Removes the timer [t] from [tp]'s heap and hash of active timers.
+ *  This routine assumes the [tp] mutex is already locked.
+ */
+    _tpoll_timer_t *t_ptr;
+    _tpoll_timer_t  t_last;
+    int             i;
+
+    assert (tp != NULL);
+    assert (t != NULL);
+    assert (t->heap_idx >= 0);
+    assert (t->heap_idx < tp->num_timers);
+    assert (tp->timers_heap[ t->heap_idx ] == t);
+
+    t_ptr = &tp->timers_hash[ t->id & (tp->timers_hash_size - 1) ];
+    while (*t_ptr != t) {
+        assert (*t_ptr != NULL);
+        t_ptr = &((*t_ptr)->hash_next);
+    }
+    *t_ptr = t->hash_next;
+    t->hash_next = NULL;
+
+    if (t->is_real) {
+        assert (tp->num_timers_real > 0);
+        tp->num_timers_real--;
+    }
+
+    i = t->heap_idx;
+    t_last = tp->timers_heap[ --tp->num_timers ];
+    t->heap_idx = -1;
+    if (t_last != t) {
+        tp->timers_heap[ i ] = t_last;
+        t_last->heap_idx = i;
+        if ((i > 0) && (_tpoll_timer_cmp (
+                t_last, tp->timers_heap[ (i - 1) / 2 ]) < 0)) {
+            _tpoll_heap_up (tp, i);
+        }
+        else {
+            _tpoll_heap_down (tp, i);
+        }
+    }
+    return;
+}
+
+
+static _tpoll_timer_t
+_tpoll_timer_find (tpoll_t tp, int id)
+{
+/*  Returns the active timer [id] from [tp], or NULL if not found.
+ *  This routine assumes the [tp] mutex is already locked.
+ */
+    _tpoll_timer_t t;
+
+    assert (tp != NULL);
+
+    if (tp->timers_hash_size == 0) {
+        return (NULL);
+    }
+    t = tp->timers_hash[ id & (tp->timers_hash_size - 1) ];
+    while (t && (t->id != id)) {
+        t = t->hash_next;
+    }
+    return (t);
+}
+
+
+static int
+_tpoll_timer_cmp (_tpoll_timer_t t1, _tpoll_timer_t t2)
+{
+/*  Compares the expiration times of timers [t1] and [t2], breaking ties by
+ *    the order in which they were set.
+ *  Returns <0, 0, or >0 if [t1] expires before, with, or after [t2].
+ */
+    if (timercmp (&t1->tv, &t2->tv, <)) {
+        return (-1);
+    }
+    if (timercmp (&t1->tv, &t2->tv, >)) {
+        return (1);
+    }
+    if (t1->seq < t2->seq) {
+        return (-1);
+    }
+    if (t1->seq > t2->seq) {
+        return (1);
+    }
+    return (0);
+}
+
+
+static void
+_tpoll_heap_up (tpoll_t tp, int i)
+{
+/*  Restores the heap property by moving the timer at index [i] of [tp]'s
+ *    heap up towards the root.
+ *  This routine assumes the [tp] mutex is already locked.
+ */
+    _tpoll_timer_t t;
+    int            j;
+
+    assert (tp != NULL);
+    assert ((i >= 0) && (i < tp->num_timers));
+
+    t = tp->timers_heap[ i ];
+    while (i > 0) {
+        j = (i - 1) / 2;
+        if (_tpoll_timer_cmp (t, tp->timers_heap[ j ]) >= 0) {
+            break;
+        }
+        tp->timers_heap[ i ] = tp->timers_heap[ j ];
+        tp->timers_heap[ i ]->heap_idx = i;
+        i = j;
+    }
+    tp->timers_heap[ i ] = t;
+    t->heap_idx = i;
+    return;
+}
+
+
+static void
+_tpoll_heap_down (tpoll_t tp, int i)
+{
+/*  Restores the heap property by moving the timer at index [i] of [tp]'s
+ *    heap down towards the leaves.
+ *  This routine assumes the [tp] mutex is already locked.
+ */
+    _tpoll_timer_t t;
+    int            j;
+
+    assert (tp != NULL);
+    assert ((i >= 0) && (i < tp->num_timers));
+
+    t = tp->timers_heap[ i ];
+    for (;;) {
+        j = (2 * i) + 1;
+        if (j >= tp->num_timers) {
+            break;
+        }
+        if ((j + 1 < tp->num_timers) && (_tpoll_timer_cmp (
+                tp->timers_heap[ j + 1 ], tp->timers_heap[ j ]) < 0)) {
+            j++;
+        }
+        if (_tpoll_timer_cmp (tp->timers_heap[ j ], t) >= 0) {
+            break;
+        }
+        tp->timers_heap[ i ] = tp->timers_heap[ j ];
+        tp->timers_heap[ i ]->heap_idx = i;
+        i = j;
+    }
+    tp->timers_heap[ i ] = t;
+    t->heap_idx = i;
+    return;
+}
+
+
+static int
+_tpoll_hash_grow (tpoll_t tp)
+{
+/*  Doubles the number of buckets in [tp]'s hash of active timers, rehashing
+ *    the active timers into the new buckets.
+ *  Returns 0 on success, or -1 on error.
+ *  This routine assumes the [tp] mutex is already locked.
+ */
+    _tpoll_timer_t *hash_new;
+    int             n;
+    int             i;
+    int             b;
+    _tpoll_timer_t  t;
+
+    assert (tp != NULL);
+
+    n = (tp->timers_hash_size > 0) ? tp->timers_hash_size * 2 : TPOLL_TIMERS;
+    if (!(hash_new = calloc (n, sizeof (_tpoll_timer_t)))) {
+        return (-1);
+    }
+    for (i = 0; i < tp->num_timers; i++) {
+        t = tp->timers_heap[ i ];
+        b = t->id & (n - 1);
+        t->hash_next = hash_new[ b ];
+        hash_new[ b ] = t;
+    }
+    free (tp->timers_hash);
+    tp->timers_hash = hash_new;
+    tp->timers_hash_size = n;
+    return (0);
+}
+
+
+static void
+_tpoll_timer_rekey (tpoll_t tp, const struct timeval *tvp_now)
+{
+/*  Checks whether the offset between the wall clock and the monotonic clock
+ *    has changed by more than TPOLL_SKEW_MSEC (eg, if the system time has
+ *    been stepped).  If so, the monotonic expiration times of [tp]'s
+ *    wall-clock timers are recomputed from the current monotonic time
+ *    [tvp_now] and the heap is rebuilt.
+ *  This routine assumes the [tp] mutex is already locked.
+ */
+    struct timeval tv_real;
+    struct timeval tv_offset;
+    struct timeval tv_diff;
+    _tpoll_timer_t t;
+    int            i;
+
+    assert (tp != NULL);
+    assert (tvp_now != NULL);
+
+    if (tp->num_timers_real == 0) {
+        return;
+    }
+    _tpoll_get_realtime (&tv_real);
+    timersub (&tv_real, tvp_now, &tv_offset);
+    timersub (&tv_offset, &tp->tv_offset, &tv_diff);
+    if ((tv_diff.tv_sec == 0)
+            && (tv_diff.tv_usec <= TPOLL_SKEW_MSEC * 1000)) {
+        return;
+    }
+    if ((tv_diff.tv_sec == -1)
+            && (tv_diff.tv_usec >= 1000000 - (TPOLL_SKEW_MSEC * 1000))) {
+        return;
+    }
+    DPRINTF((22, "tpoll timer rekey n=%d.\n", tp->num_timers_real));
+    tp->tv_offset = tv_offset;
+
+    for (i = 0; i < tp->num_timers; i++) {
+        t = tp->timers_heap[ i ];
+        if (t->is_real) {
+            timersub (&t->tv_real, &tv_real, &tv_diff);
+            timeradd (tvp_now, &tv_diff, &t->tv);
+        }
+    }
+    for (i = (tp->num_timers / 2) - 1; i >= 0; i--) {
+        _tpoll_heap_down (tp, i);
+    }
+    return;
+}
+
+
+static void
+_tpoll_get_timeval (struct timeval *tvp, int ms)
+{
+/*  Sets [tvp] to the current monotonic time (or the wall-clock time if the
+ *    monotonic clock is not available).
+ *  If [ms] > 0, adds the number of milliseconds [ms] to [tvp].
+ */
+#if TPOLL_HAVE_MONOTONIC
+    struct timespec ts;
+#endif /* TPOLL_HAVE_MONOTONIC */
+
+    assert (tvp != NULL);
+
+#if TPOLL_HAVE_MONOTONIC
+    if (clock_gettime (CLOCK_MONOTONIC, &ts) < 0) {
+        log_err (errno, "Unable to get monotonic time");
+    }
+    tvp->tv_sec = ts.tv_sec;
+    tvp->tv_usec = ts.tv_nsec / 1000;
+#else  /* !TPOLL_HAVE_MONOTONIC */
+    if (gettimeofday (tvp, NULL) < 0) {
+        log_err (0, "Unable to get time of day");
+    }
+#endif /* !TPOLL_HAVE_MONOTONIC */
+    if (ms > 0) {
+        tvp->tv_sec += ms / 1000;
+        tvp->tv_usec += (ms % 1000) * 1000;
+        if (tvp->tv_usec >= 1000000) {
+            tvp->tv_sec += tvp->tv_usec / 1000000;
+            tvp->tv_usec %= 1000000;
+        }
+    }
+    return;
+}
+
+
+static void
+_tpoll_get_realtime (struct timeval *tvp)
+{
+/*  Sets [tvp] to the current wall-clock time.
+ */
+    assert (tvp != NULL);
+
+    if (gettimeofday (tvp, NULL) < 0) {
+        log_err (0, "Unable to get time of day");
+    }
+    return;
+}
+
+
+static int
+_tpoll_diff_timeval (struct timeval *tvp1, struct timeval *tvp0)
+{
+/*  Returns the millisecond difference between [tvp1] and [tvp0].
+ *  If either is NULL, the current time will be used in its place.
+ */
+    struct timeval tv;
+    int            ms;
+
+    if (!tvp0 || !tvp1) {
+        _tpoll_get_timeval (&tv, 0);
+        if (!tvp0) {
+            tvp0 = &tv;
+        }
+        if (!tvp1) {
+            tvp1 = &tv;
         }
     }
     ms = ( (tvp1->tv_sec  - tvp0->tv_sec)  * 1000 ) +
@@ -925,3 +1800,362 @@ _tpoll_diff_timeval (struct timeval *tvp1, struct timeval *tvp0)
     }
     return (ms);
 }
+
+
+#if TPOLL_HAVE_EPOLL
+
+static int
+_tpoll_epoll_create (tpoll_t tp)
+{
+/*  Creates the epoll instance for [tp] and registers the signal pipe with it.
+ *  On success, switches [tp] over to the epoll backend.
+ *  Returns 0 on success, or -1 on error.
+ */
+    struct epoll_event ev;
+    int                i;
+    int                e;
+
+    assert (tp != NULL);
+    assert (tp->fd_pipe[ 0 ] > -1);
+    assert (tp->num_fds_alloc > 0);
+
+    if ((tp->fd_epoll = epoll_create1 (EPOLL_CLOEXEC)) < 0) {
+        goto err;
+    }
+    if (!(tp->ep_events = malloc (TPOLL_EVENTS * sizeof (ev)))) {
+        goto err;
+    }
+    if (!(tp->fd_nopoll = malloc (tp->num_fds_alloc * sizeof (int)))) {
+        goto err;
+    }
+    if (!(tp->fd_nopoll_idx = malloc (tp->num_fds_alloc * sizeof (int)))) {
+        goto err;
+    }
+    for (i = 0; i < tp->num_fds_alloc; i++) {
+        tp->fd_nopoll_idx[ i ] = -1;
+    }
+    memset (&ev, 0, sizeof (ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = tp->fd_pipe[ 0 ];
+    if (epoll_ctl (tp->fd_epoll, EPOLL_CTL_ADD, tp->fd_pipe[ 0 ], &ev) < 0) {
+        goto err;
+    }
+#if TPOLL_HAVE_TIMERFD
+    /*  The timerfd is optional; if unavailable, the epoll_wait() timeout is
+     *    computed from the next timer to expire as with the poll backend.
+     */
+    tp->fd_timer =
+        timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tp->fd_timer > -1) {
+        ev.events = EPOLLIN;
+        ev.data.fd = tp->fd_timer;
+        if (epoll_ctl (tp->fd_epoll, EPOLL_CTL_ADD, tp->fd_timer, &ev) < 0) {
+            (void) close (tp->fd_timer);
+            tp->fd_timer = -1;
+        }
+    }
+#endif /* TPOLL_HAVE_TIMERFD */
+    tp->backend = TPOLL_BACKEND_EPOLL;
+    return (0);
+
+err:
+    e = errno;
+    if (tp->fd_epoll > -1) {
+        (void) close (tp->fd_epoll);
+        tp->fd_epoll = -1;
+    }
+    free (tp->ep_events);
+    tp->ep_events = NULL;
+    free (tp->fd_nopoll);
+    tp->fd_nopoll = NULL;
+    free (tp->fd_nopoll_idx);
+    tp->fd_nopoll_idx = NULL;
+    errno = e;
+    return (-1);
+}
+
+
+static int
+_tpoll_epoll_update (tpoll_t tp, int fd, short int events_old)
+{
+/*  Updates the epoll interest set of [tp] for file descriptor [fd] after its
+ *    requested events have changed from [events_old] to those now recorded
+ *    in fd_array[].
+ *  Returns 0 on success, or -1 on error.
+ *  This routine assumes the [tp] mutex is already locked.
+ */
+    struct epoll_event ev;
+    short int          events_new;
+    int                op;
+
+    assert (tp != NULL);
+    assert (tp->backend == TPOLL_BACKEND_EPOLL);
+    assert (fd >= 0);
+    assert (fd < tp->num_fds_alloc);
+
+    events_new = tp->fd_array[ fd ].events;
+
+    if (tp->fd_nopoll_idx[ fd ] > -1) {
+        if (events_new == 0) {
+            _tpoll_epoll_nopoll_del (tp, fd);
+        }
+        return (0);
+    }
+    memset (&ev, 0, sizeof (ev));
+    ev.data.fd = fd;
+    if (events_new & POLLIN) {
+        ev.events |= EPOLLIN;
+    }
+    if (events_new & POLLPRI) {
+        ev.events |= EPOLLPRI;
+    }
+    if (events_new & POLLOUT) {
+        ev.events |= EPOLLOUT;
+    }
+    if (events_new == 0) {
+        op = EPOLL_CTL_DEL;
+    }
+    else if (events_old == 0) {
+        op = EPOLL_CTL_ADD;
+    }
+    else {
+        op = EPOLL_CTL_MOD;
+    }
+    if (epoll_ctl (tp->fd_epoll, op, fd, &ev) == 0) {
+        return (0);
+    }
+    /*  The fd may have been closed without having its events cleared (which
+     *    removes it from the epoll interest set), and a new fd may have since
+     *    been opened with the same number.
+     */
+    if ((op == EPOLL_CTL_MOD) && (errno == ENOENT)) {
+        op = EPOLL_CTL_ADD;
+        if (epoll_ctl (tp->fd_epoll, op, fd, &ev) == 0) {
+            return (0);
+        }
+    }
+    else if ((op == EPOLL_CTL_ADD) && (errno == EEXIST)) {
+        op = EPOLL_CTL_MOD;
+        if (epoll_ctl (tp->fd_epoll, op, fd, &ev) == 0) {
+            return (0);
+        }
+    }
+    if (op == EPOLL_CTL_DEL) {
+        return (0);                     /* fd was likely closed already */
+    }
+    if ((op == EPOLL_CTL_ADD) && (errno == EPERM)) {
+        _tpoll_epoll_nopoll_add (tp, fd);
+        return (0);
+    }
+    DPRINTF((5, "Unable to update epoll for fd=%d: %s.\n",
+        fd, strerror (errno)));
+    return (-1);
+}
+
+
+static void
+_tpoll_epoll_nopoll_add (tpoll_t tp, int fd)
+{
+/*  Adds file descriptor [fd] to [tp]'s set of fds unsupported by epoll.
+ *    Since these fds are always ready, tpoll() must be signaled in case it
+ *    is currently blocked.
+ *  This routine assumes the [tp] mutex is already locked.
+ */
+    assert (tp != NULL);
+    assert (fd >= 0);
+    assert (tp->fd_nopoll_idx[ fd ] < 0);
+    assert (tp->num_fds_nopoll < tp->num_fds_alloc);
+
+    tp->fd_nopoll_idx[ fd ] = tp->num_fds_nopoll;
+    tp->fd_nopoll[ tp->num_fds_nopoll++ ] = fd;
+    _tpoll_signal_send (tp);
+    DPRINTF((21, "tpoll nopoll add fd=%d n=%d.\n", fd, tp->num_fds_nopoll));
+    return;
+}
+
+
+static void
+_tpoll_epoll_nopoll_del (tpoll_t tp, int fd)
+{
+/*  Removes file descriptor [fd] from [tp]'s set of fds unsupported by epoll.
+ *  This routine assumes the [tp] mutex is already locked.
+ */
+    int i;
+    int fd_last;
+
+    assert (tp != NULL);
+    assert (fd >= 0);
+    assert (tp->fd_nopoll_idx[ fd ] > -1);
+    assert (tp->num_fds_nopoll > 0);
+
+    i = tp->fd_nopoll_idx[ fd ];
+    fd_last = tp->fd_nopoll[ --tp->num_fds_nopoll ];
+    tp->fd_nopoll[ i ] = fd_last;
+    tp->fd_nopoll_idx[ fd_last ] = i;
+    tp->fd_nopoll_idx[ fd ] = -1;
+    DPRINTF((21, "tpoll nopoll del fd=%d n=%d.\n", fd, tp->num_fds_nopoll));
+    return;
+}
+
+
+static int
+_tpoll_epoll_wait (tpoll_t tp, int timeout)
+{
+/*  Waits up to [timeout] milliseconds for events on [tp]'s epoll instance,
+ *    discarding any on the "signaling pipe".  The revents of each ready fd
+ *    are set in fd_array[] and the fd is recorded in fd_ready[].
+ *  Returns the number of fds with I/O ready, or -1 on error.
+ *  This routine assumes the [tp] mutex is already locked; the mutex is
+ *    released while blocked in epoll_wait().
+ */
+    int       n;
+    int       i;
+    int       fd;
+    short int revents;
+    uint32_t  ev;
+    int       e;
+
+    assert (tp != NULL);
+    assert (tp->backend == TPOLL_BACKEND_EPOLL);
+
+    tp->is_blocked = true;
+
+    if ((e = pthread_mutex_unlock (&tp->mutex)) != 0) {
+        log_err (errno = e, "Unable to unlock tpoll mutex");
+    }
+    DPRINTF((25, "tpoll epoll enter ms=%d nfd=%d.\n",
+        timeout, tp->num_fds_used));
+    n = epoll_wait (tp->fd_epoll, tp->ep_events, TPOLL_EVENTS, timeout);
+    DPRINTF((25, "tpoll epoll return n=%d.\n", n));
+
+    if ((e = pthread_mutex_lock (&tp->mutex)) != 0) {
+        log_err (errno = e, "Unable to lock tpoll mutex");
+    }
+    tp->is_blocked = false;
+
+    if (n < 0) {
+        return (-1);
+    }
+    /*  The fd_array[] may have been realloc'd while blocked, but it is not
+     *    accessed until the mutex is re-acquired, so there is nothing to redo.
+     */
+    for (i = 0; i < n; i++) {
+        fd = tp->ep_events[ i ].data.fd;
+        ev = tp->ep_events[ i ].events;
+
+        if (fd == tp->fd_pipe[ 0 ]) {
+            _tpoll_signal_recv (tp);
+            continue;
+        }
+#if TPOLL_HAVE_TIMERFD
+        if (fd == tp->fd_timer) {
+            _tpoll_timerfd_recv (tp);
+            continue;
+        }
+#endif /* TPOLL_HAVE_TIMERFD */
+        /*  Ignore events for an fd whose events were cleared while blocked.
+         */
+        if ((fd > tp->max_fd) || (tp->fd_array[ fd ].fd < 0)) {
+            continue;
+        }
+        revents = 0;
+        if (ev & EPOLLIN) {
+            revents |= POLLIN;
+        }
+        if (ev & EPOLLPRI) {
+            revents |= POLLPRI;
+        }
+        if (ev & EPOLLOUT) {
+            revents |= POLLOUT;
+        }
+        if (ev & EPOLLERR) {
+            revents |= POLLERR;
+        }
+        if (ev & EPOLLHUP) {
+            revents |= POLLHUP;
+        }
+        revents &= tp->fd_array[ fd ].events | POLLERR | POLLHUP;
+        if ((revents != 0) && (tp->fd_array[ fd ].revents == 0)) {
+            tp->fd_array[ fd ].revents = revents;
+            tp->fd_ready[ tp->num_fds_ready++ ] = fd;
+        }
+    }
+    /*  Fds unsupported by epoll are always ready for their requested events.
+     */
+    for (i = 0; i < tp->num_fds_nopoll; i++) {
+        fd = tp->fd_nopoll[ i ];
+        if (tp->fd_array[ fd ].revents == 0) {
+            tp->fd_array[ fd ].revents = tp->fd_array[ fd ].events;
+            tp->fd_ready[ tp->num_fds_ready++ ] = fd;
+        }
+    }
+    return (tp->num_fds_ready);
+}
+
+
+#endif /* TPOLL_HAVE_EPOLL */
+
+
+#if TPOLL_HAVE_TIMERFD
+
+static int
+_tpoll_timerfd_arm (tpoll_t tp)
+{
+/*  Arms [tp]'s timerfd to expire along with the next timer in the heap.
+ *    The timerfd is only re-armed if the next timer's expiration has changed.
+ *  Returns 0 if the timerfd is armed, or -1 on error (in which case the
+ *    timerfd is abandoned).
+ *  This routine assumes the [tp] mutex is already locked.
+ */
+    struct itimerspec its;
+    _tpoll_timer_t    t;
+
+    assert (tp != NULL);
+    assert (tp->fd_timer > -1);
+    assert (tp->num_timers > 0);
+
+    t = tp->timers_heap[ 0 ];
+    if (tp->is_timer_armed && !timercmp (&tp->tv_timer, &t->tv, !=)) {
+        return (0);
+    }
+    memset (&its, 0, sizeof (its));
+    its.it_value.tv_sec = t->tv.tv_sec;
+    its.it_value.tv_nsec = t->tv.tv_usec * 1000;
+    if ((its.it_value.tv_sec <= 0) && (its.it_value.tv_nsec <= 0)) {
+        its.it_value.tv_nsec = 1;       /* zero would disarm the timerfd */
+    }
+    if (timerfd_settime (tp->fd_timer, TFD_TIMER_ABSTIME, &its, NULL) < 0) {
+        DPRINTF((5, "Unable to arm tpoll timerfd: %s.\n", strerror (errno)));
+        (void) epoll_ctl (tp->fd_epoll, EPOLL_CTL_DEL, tp->fd_timer, NULL);
+        (void) close (tp->fd_timer);
+        tp->fd_timer = -1;
+        tp->is_timer_armed = false;
+        return (-1);
+    }
+    tp->tv_timer = t->tv;
+    tp->is_timer_armed = true;
+    DPRINTF((24, "tpoll timerfd armed id=%d.\n", t->id));
+    return (0);
+}
+
+
+static void
+_tpoll_timerfd_recv (tpoll_t tp)
+{
+/*  Drains the expiration count from [tp]'s timerfd.
+ *  This routine assumes the [tp] mutex is already locked.
+ */
+    uint64_t n;
+
+    assert (tp != NULL);
+    assert (tp->fd_timer > -1);
+
+    while ((read (tp->fd_timer, &n, sizeof (n)) < 0) && (errno == EINTR)) {
+        ;
+    }
+    tp->is_timer_armed = false;
+    DPRINTF((24, "tpoll timerfd expired.\n"));
+    return;
+}
+
+#endif /* TPOLL_HAVE_TIMERFD */
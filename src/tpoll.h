@@ -52,6 +52,15 @@ typedef enum {
     TPOLL_ZERO_ALL    = 0x03            /* zero both fds and timers */
 } tpoll_zero_t;
 
+typedef enum {
+/*
+ *  Data type for tpoll_create_backend() [backend] parameter.
+ */
+    TPOLL_BACKEND_DEFAULT = 0,          /* best backend available            */
+    TPOLL_BACKEND_POLL    = 1,          /* poll() over the whole fd array    */
+    TPOLL_BACKEND_EPOLL   = 2           /* epoll w/ persistent interest set  */
+} tpoll_backend_t;
+
 
 /*****************************************************************************
  *  Functions
@@ -59,6 +68,10 @@ typedef enum {
 
 tpoll_t tpoll_create (int n);
 
+tpoll_t tpoll_create_backend (int n, tpoll_backend_t backend);
+
+tpoll_backend_t tpoll_get_backend (tpoll_t tp);
+
 void tpoll_destroy (tpoll_t tp);
 
 int tpoll_zero (tpoll_t tp, tpoll_zero_t how);
@@ -78,5 +91,7 @@ int tpoll_timeout_cancel (tpoll_t tp, int id);
 
 int tpoll (tpoll_t tp, int ms);
 
+int tpoll_next_ready (tpoll_t tp, int *ip, short int *reventsp);
+
 
 #endif /* !_TPOLL_H */
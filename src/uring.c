@@ -0,0 +1,669 @@
+/*****************************************************************************
+ *  Written by Chris Dunlap <cdunlap@llnl.gov>.
+ *  Copyright (C) 2007-2023 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2001-2007 The Regents of the University of California.
+ *  UCRL-CODE-2002-009.
+ *
+ *  This file is part of ConMan: The Console Manager.
+ *  For details, see <https://dun.github.io/conman/>.
+ *
+ *  ConMan is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  ConMan is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with ConMan.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#if HAVE_LINUX_IO_URING_H
+#  include <linux/io_uring.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) \
+        && defined(__NR_io_uring_register)
+#    define URING_HAVE_IO_URING 1
+#  endif /* __NR_io_uring_setup && ... && __NR_io_uring_register */
+#endif /* HAVE_LINUX_IO_URING_H */
+#include "bool.h"
+#include "uring.h"
+
+
+/*****************************************************************************
+ *  Notes
+ *****************************************************************************
+ *  This implementation is NOT thread-safe; a uring object is intended to be
+ *  owned by the single thread running an event loop.
+ *
+ *  A uring object batches the reads and writes for the fds found to be ready
+ *  by an event loop iteration so they can be submitted to the kernel via a
+ *  single io_uring_enter() system call instead of one read() or writev() per
+ *  fd.  The io_uring interface is used directly via its system calls (ie,
+ *  without liburing).  Requests are queued into the submission ring as
+ *  consecutive slots of the current batch, and uring_submit() waits for all
+ *  of them to complete so their results can be returned in the order in
+ *  which they were queued.  Since the fds are known to be ready, a batch
+ *  completes without blocking (or fails with EAGAIN if the fd is no longer
+ *  ready), so waiting for the entire batch does not delay the event loop.
+ *
+ *  Each slot has its own read buffer.  The read buffers are allocated from
+ *  a single region that is registered with the kernel where possible so
+ *  reads can use IORING_OP_READ_FIXED, thereby avoiding the cost of mapping
+ *  the buffer's pages on each request.  If the registration fails (eg, due to
+ *  RLIMIT_MEMLOCK), reads fall back to IORING_OP_READ into the same buffers.
+ *  Writes are submitted via IORING_OP_WRITEV directly from the caller's
+ *  buffers since those are not known in advance.
+ *
+ *  All requests use an offset of -1 so they read from or write to the fd's
+ *  current file position (or append to the file if opened with O_APPEND),
+ *  just like read() and writev().  This requires IORING_FEAT_RW_CUR_POS
+ *  (Linux 5.6); ENOSYS is returned by uring_create() if it is unavailable
+ *  so the caller can fall back to read() and writev().
+ */
+
+
+/*****************************************************************************
+ *  Internal Data Types
+ *****************************************************************************/
+
+struct uring_req {
+    void            *arg;               /* caller's arg for the request      */
+    void            *buf;               /* read buffer, or NULL for a write  */
+    struct iovec     iov[ 2 ];          /* iovec array for a writev          */
+    int              res;               /* result (bytes, or negated errno)  */
+};
+
+struct uring {
+    int              fd;                /* io_uring fd                       */
+    int              num_reqs_alloc;    /* max num requests in a batch       */
+    int              num_reqs;          /* num requests queued in the batch  */
+    int              num_done;          /* num requests completed in batch   */
+    struct uring_req *reqs;             /* array of requests in the batch    */
+    unsigned char   *bufs;              /* region of per-request read bufs   */
+    int              bufsize;           /* size of each read buffer          */
+    bool             is_fixed;          /* flag set if read bufs registered  */
+    bool             is_submitted;      /* flag set when batch is submitted  */
+    bool             is_failed;         /* flag set if reqs left in flight   */
+    unsigned         gen;               /* batch generation for user_data    */
+    unsigned         batch_head;        /* sq ring pos of batch's first sqe  */
+#if URING_HAVE_IO_URING
+    void            *sq_ring;           /* mmap'd submission ring            */
+    size_t           sq_ring_len;       /* length of submission ring mapping */
+    void            *cq_ring;           /* mmap'd completion ring            */
+    size_t           cq_ring_len;       /* length of completion ring mapping */
+    struct io_uring_sqe *sqes;          /* mmap'd submission queue entries   */
+    size_t           sqes_len;          /* length of sqes mapping            */
+    unsigned        *sq_head;           /* submission ring head (kernel)     */
+    unsigned        *sq_tail;           /* submission ring tail (user)       */
+    unsigned        *sq_mask;           /* submission ring index mask        */
+    unsigned        *sq_array;          /* submission ring sqe index array   */
+    unsigned        *cq_head;           /* completion ring head (user)       */
+    unsigned        *cq_tail;           /* completion ring tail (kernel)     */
+    unsigned        *cq_mask;           /* completion ring index mask        */
+    struct io_uring_cqe *cqes;          /* completion queue entries          */
+#endif /* URING_HAVE_IO_URING */
+};
+
+
+/*****************************************************************************
+ *  Internal Prototypes
+ *****************************************************************************/
+
+#if URING_HAVE_IO_URING
+static int _uring_setup (uring_t ur);
+
+static void _uring_register (uring_t ur);
+
+static struct io_uring_sqe * _uring_get_sqe (uring_t ur);
+
+static void _uring_reap (uring_t ur);
+
+static void _uring_abort (uring_t ur, int e);
+#endif /* URING_HAVE_IO_URING */
+
+
+/*****************************************************************************
+ *  Functions
+ *****************************************************************************/
+
+uring_t
+uring_create (int n, int bufsize)
+{
+/*  Creates a new uring object for batching up to [n] requests per
+ *    submission, each read being performed into its own [bufsize]-byte
+ *    buffer.
+ *  Returns an opaque pointer to this new object, or NULL on error
+ *    (with errno set to ENOSYS if io_uring is not supported).
+ */
+#if ! URING_HAVE_IO_URING
+    (void) n;
+    (void) bufsize;
+    errno = ENOSYS;
+    return (NULL);
+#else /* URING_HAVE_IO_URING */
+    uring_t ur = NULL;
+    long    pagesize;
+    int     e;
+
+    if ((n <= 0) || (bufsize <= 0)) {
+        errno = EINVAL;
+        return (NULL);
+    }
+    if (!(ur = malloc (sizeof (struct uring)))) {
+        goto err;
+    }
+    memset (ur, 0, sizeof (struct uring));
+    ur->fd = -1;
+    ur->num_reqs_alloc = n;
+    ur->bufsize = bufsize;
+    ur->sq_ring = ur->cq_ring = MAP_FAILED;
+    ur->sqes = MAP_FAILED;
+
+    if (!(ur->reqs = calloc (n, sizeof (struct uring_req)))) {
+        goto err;
+    }
+    if ((pagesize = sysconf (_SC_PAGESIZE)) <= 0) {
+        pagesize = 4096;
+    }
+    if ((e = posix_memalign ((void **) &ur->bufs, pagesize,
+            (size_t) n * bufsize)) != 0) {
+        ur->bufs = NULL;
+        errno = e;
+        goto err;
+    }
+    if (_uring_setup (ur) < 0) {
+        goto err;
+    }
+    _uring_register (ur);
+    return (ur);
+
+err:
+    e = errno;
+    uring_destroy (ur);
+    errno = e;
+    return (NULL);
+#endif /* URING_HAVE_IO_URING */
+}
+
+
+void
+uring_destroy (uring_t ur)
+{
+/*  Destroys the uring object [ur].
+ *  The batch must not have any requests still in flight.
+ */
+    if (!ur) {
+        return;
+    }
+#if URING_HAVE_IO_URING
+    if (ur->sqes != MAP_FAILED) {
+        (void) munmap (ur->sqes, ur->sqes_len);
+    }
+    if ((ur->cq_ring != MAP_FAILED) && (ur->cq_ring != ur->sq_ring)) {
+        (void) munmap (ur->cq_ring, ur->cq_ring_len);
+    }
+    if (ur->sq_ring != MAP_FAILED) {
+        (void) munmap (ur->sq_ring, ur->sq_ring_len);
+    }
+#endif /* URING_HAVE_IO_URING */
+    if (ur->fd >= 0) {
+        (void) close (ur->fd);
+    }
+    free (ur->bufs);
+    free (ur->reqs);
+    free (ur);
+    return;
+}
+
+
+int
+uring_is_fixed (uring_t ur)
+{
+/*  Returns true if the read buffers of the uring object [ur] have been
+ *    registered with the kernel.
+ */
+    return (ur && ur->is_fixed);
+}
+
+
+int
+uring_is_failed (uring_t ur)
+{
+/*  Returns true if a failed submission left requests of the uring object
+ *    [ur] in flight, in which case [ur] can no longer be used.
+ */
+    return (ur && ur->is_failed);
+}
+
+
+int
+uring_prep_read (uring_t ur, int fd, int len, void *arg)
+{
+/*  Queues a read of up to [len] bytes from [fd] into the next available
+ *    read buffer of [ur].  The [len] cannot exceed the size of the buffer.
+ *  The [arg] is returned along with the request's completion.
+ *  Returns 0 on success, or -1 on error (with errno set to EBUSY if the
+ *    batch is full and must first be submitted).
+ */
+#if ! URING_HAVE_IO_URING
+    (void) ur;
+    (void) fd;
+    (void) len;
+    (void) arg;
+    errno = ENOSYS;
+    return (-1);
+#else /* URING_HAVE_IO_URING */
+    struct io_uring_sqe *sqe;
+    struct uring_req    *req;
+    int                  i;
+
+    if (!ur || (fd < 0) || (len <= 0) || (len > ur->bufsize)) {
+        errno = EINVAL;
+        return (-1);
+    }
+    if (!(sqe = _uring_get_sqe (ur))) {
+        return (-1);
+    }
+    i = ur->num_reqs - 1;
+    req = &ur->reqs[ i ];
+    req->arg = arg;
+    req->buf = ur->bufs + ((size_t) i * ur->bufsize);
+
+    sqe->fd = fd;
+    sqe->off = (uint64_t) -1;
+    sqe->addr = (uint64_t) (uintptr_t) req->buf;
+    sqe->len = len;
+    if (ur->is_fixed) {
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->buf_index = i;
+    }
+    else {
+        sqe->opcode = IORING_OP_READ;
+    }
+    return (0);
+#endif /* URING_HAVE_IO_URING */
+}
+
+
+int
+uring_prep_writev (uring_t ur, int fd, const struct iovec *iov, int iovcnt,
+    void *arg)
+{
+/*  Queues a writev of the [iovcnt] (at most 2) buffers in [iov] to [fd].
+ *  The iovec array is copied, but the data it references must remain
+ *    unchanged until the request has completed.
+ *  The [arg] is returned along with the request's completion.
+ *  Returns 0 on success, or -1 on error (with errno set to EBUSY if the
+ *    batch is full and must first be submitted).
+ */
+#if ! URING_HAVE_IO_URING
+    (void) ur;
+    (void) fd;
+    (void) iov;
+    (void) iovcnt;
+    (void) arg;
+    errno = ENOSYS;
+    return (-1);
+#else /* URING_HAVE_IO_URING */
+    struct io_uring_sqe *sqe;
+    struct uring_req    *req;
+
+    if (!ur || (fd < 0) || !iov || (iovcnt <= 0) || (iovcnt > 2)) {
+        errno = EINVAL;
+        return (-1);
+    }
+    if (!(sqe = _uring_get_sqe (ur))) {
+        return (-1);
+    }
+    req = &ur->reqs[ ur->num_reqs - 1 ];
+    req->arg = arg;
+    req->buf = NULL;
+    memcpy (req->iov, iov, iovcnt * sizeof (struct iovec));
+
+    sqe->opcode = IORING_OP_WRITEV;
+    sqe->fd = fd;
+    sqe->off = (uint64_t) -1;
+    sqe->addr = (uint64_t) (uintptr_t) req->iov;
+    sqe->len = iovcnt;
+    return (0);
+#endif /* URING_HAVE_IO_URING */
+}
+
+
+int
+uring_submit (uring_t ur)
+{
+/*  Submits the batch of requests queued in [ur] via a single system call
+ *    (barring interruption), and waits for all of them to complete.
+ *  If the submission fails, the requests not yet consumed by the kernel are
+ *    withdrawn from the submission ring and failed with the submission's
+ *    error, and the requests already consumed are waited upon since their
+ *    buffers cannot be reused until they complete.  The batch can then be
+ *    iterated via uring_next_completion() as usual so the caller can process
+ *    the result of each request.  If the consumed requests cannot be waited
+ *    upon, they are failed as well, and [ur] is marked as failed (cf.
+ *    uring_is_failed()) since those requests remain in flight.
+ *  Returns the number of requests completed, or -1 on error.
+ */
+#if ! URING_HAVE_IO_URING
+    (void) ur;
+    errno = ENOSYS;
+    return (-1);
+#else /* URING_HAVE_IO_URING */
+    unsigned to_submit;
+    int      rc;
+    int      e;
+
+    if (!ur) {
+        errno = EINVAL;
+        return (-1);
+    }
+    if (ur->is_submitted || ur->is_failed) {
+        errno = EINVAL;
+        return (-1);
+    }
+    while (ur->num_done < ur->num_reqs) {
+        to_submit = *ur->sq_tail
+            - __atomic_load_n (ur->sq_head, __ATOMIC_ACQUIRE);
+        rc = syscall (__NR_io_uring_enter, ur->fd, to_submit,
+            ur->num_reqs - ur->num_done, IORING_ENTER_GETEVENTS, NULL, 0);
+        if ((rc < 0) && (errno != EINTR) && (errno != EAGAIN)
+                && (errno != EBUSY)) {
+            e = errno;
+            _uring_abort (ur, e);
+            errno = e;
+            return (-1);
+        }
+        _uring_reap (ur);
+    }
+    ur->is_submitted = true;
+    return (ur->num_done);
+#endif /* URING_HAVE_IO_URING */
+}
+
+
+void *
+uring_next_completion (uring_t ur, int *ip, int *resp, void **bufp)
+{
+/*  Iterates over the requests completed by the last uring_submit() in the
+ *    order in which they were queued.  The cursor [ip] must be set to 0
+ *    before the first call; it is advanced by each successive call.
+ *  Sets [resp] to the request's result (ie, the number of bytes
+ *    transferred, or -1 with errno set), and [bufp] (if not NULL) to its
+ *    read buffer (or NULL for a write).
+ *  Returns the arg of the next completed request, or NULL once all
+ *    completions have been returned (at which point the batch is reset so
+ *    new requests can be queued).
+ */
+    struct uring_req *req;
+
+    if (!ur || !ip || (*ip < 0) || !resp) {
+        errno = EINVAL;
+        return (NULL);
+    }
+    if (!ur->is_submitted) {
+        return (NULL);
+    }
+    if (*ip >= ur->num_reqs) {
+        ur->num_reqs = 0;
+        ur->num_done = 0;
+        ur->is_submitted = false;
+        return (NULL);
+    }
+    req = &ur->reqs[ (*ip)++ ];
+    if (req->res < 0) {
+        errno = -req->res;
+        *resp = -1;
+    }
+    else {
+        *resp = req->res;
+    }
+    if (bufp) {
+        *bufp = req->buf;
+    }
+    return (req->arg);
+}
+
+
+/*****************************************************************************
+ *  Internal Functions
+ *****************************************************************************/
+
+#if URING_HAVE_IO_URING
+
+static int
+_uring_setup (uring_t ur)
+{
+/*  Creates the io_uring instance for [ur] and maps its rings.
+ *  Returns 0 on success, or -1 on error.
+ */
+    struct io_uring_params p;
+    unsigned char         *sq;
+    unsigned char         *cq;
+
+    assert (ur != NULL);
+    assert (ur->fd < 0);
+
+    memset (&p, 0, sizeof (p));
+    ur->fd = syscall (__NR_io_uring_setup, ur->num_reqs_alloc, &p);
+    if (ur->fd < 0) {
+        return (-1);
+    }
+    if (!(p.features & IORING_FEAT_RW_CUR_POS)) {
+        errno = ENOSYS;
+        return (-1);
+    }
+    ur->sq_ring_len = p.sq_off.array + (p.sq_entries * sizeof (unsigned));
+    ur->cq_ring_len = p.cq_off.cqes
+        + (p.cq_entries * sizeof (struct io_uring_cqe));
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ur->cq_ring_len > ur->sq_ring_len) {
+            ur->sq_ring_len = ur->cq_ring_len;
+        }
+        ur->cq_ring_len = ur->sq_ring_len;
+    }
+    ur->sq_ring = mmap (NULL, ur->sq_ring_len, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ur->fd, IORING_OFF_SQ_RING);
+    if (ur->sq_ring == MAP_FAILED) {
+        return (-1);
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        ur->cq_ring = ur->sq_ring;
+    }
+    else {
+        ur->cq_ring = mmap (NULL, ur->cq_ring_len, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ur->fd, IORING_OFF_CQ_RING);
+        if (ur->cq_ring == MAP_FAILED) {
+            return (-1);
+        }
+    }
+    ur->sqes_len = p.sq_entries * sizeof (struct io_uring_sqe);
+    ur->sqes = mmap (NULL, ur->sqes_len, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ur->fd, IORING_OFF_SQES);
+    if (ur->sqes == MAP_FAILED) {
+        return (-1);
+    }
+    sq = ur->sq_ring;
+    cq = ur->cq_ring;
+    ur->sq_head = (unsigned *) (sq + p.sq_off.head);
+    ur->sq_tail = (unsigned *) (sq + p.sq_off.tail);
+    ur->sq_mask = (unsigned *) (sq + p.sq_off.ring_mask);
+    ur->sq_array = (unsigned *) (sq + p.sq_off.array);
+    ur->cq_head = (unsigned *) (cq + p.cq_off.head);
+    ur->cq_tail = (unsigned *) (cq + p.cq_off.tail);
+    ur->cq_mask = (unsigned *) (cq + p.cq_off.ring_mask);
+    ur->cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+    return (0);
+}
+
+
+static void
+_uring_register (uring_t ur)
+{
+/*  Registers the read buffers of [ur] with the kernel if possible.
+ *  On failure, reads will not use the fixed buffer opcode.
+ */
+    struct iovec *iovs;
+    int           i;
+
+    assert (ur != NULL);
+    assert (ur->fd >= 0);
+    assert (ur->bufs != NULL);
+
+    ur->is_fixed = false;
+    if (!(iovs = malloc (ur->num_reqs_alloc * sizeof (struct iovec)))) {
+        return;
+    }
+    for (i = 0; i < ur->num_reqs_alloc; i++) {
+        iovs[ i ].iov_base = ur->bufs + ((size_t) i * ur->bufsize);
+        iovs[ i ].iov_len = ur->bufsize;
+    }
+    if (syscall (__NR_io_uring_register, ur->fd, IORING_REGISTER_BUFFERS,
+            iovs, ur->num_reqs_alloc) == 0) {
+        ur->is_fixed = true;
+    }
+    free (iovs);
+    return;
+}
+
+
+static struct io_uring_sqe *
+_uring_get_sqe (uring_t ur)
+{
+/*  Allocates the next slot in the current batch of [ur] and publishes its
+ *    (zeroed) submission queue entry to the submission ring.  The entry must
+ *    be filled in before the batch is submitted.
+ *  Returns the entry, or NULL with errno set to EBUSY if the batch is full.
+ */
+    struct io_uring_sqe *sqe;
+    unsigned             tail;
+    unsigned             idx;
+
+    assert (ur != NULL);
+
+    if (ur->is_submitted) {
+        ur->num_reqs = 0;
+        ur->num_done = 0;
+        ur->is_submitted = false;
+    }
+    if (ur->is_failed) {
+        errno = EINVAL;
+        return (NULL);
+    }
+    if (ur->num_reqs >= ur->num_reqs_alloc) {
+        errno = EBUSY;
+        return (NULL);
+    }
+    tail = *ur->sq_tail;
+    if (ur->num_reqs == 0) {
+        ur->batch_head = tail;
+    }
+    idx = tail & *ur->sq_mask;
+    sqe = &ur->sqes[ idx ];
+    memset (sqe, 0, sizeof (*sqe));
+    sqe->user_data = ((uint64_t) ur->gen << 32) | (unsigned) ur->num_reqs;
+    ur->reqs[ ur->num_reqs ].res = -ECANCELED;
+    ur->num_reqs++;
+    ur->sq_array[ idx ] = idx;
+    /*
+     *  The kernel does not read the entry until io_uring_enter() is called,
+     *    but the tail is published with release semantics regardless.
+     */
+    __atomic_store_n (ur->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    return (sqe);
+}
+
+
+static void
+_uring_reap (uring_t ur)
+{
+/*  Records the results of all completions available in the completion ring
+ *    of [ur] into their corresponding requests.
+ */
+    unsigned             head;
+    unsigned             tail;
+    struct io_uring_cqe *cqe;
+
+    assert (ur != NULL);
+
+    head = *ur->cq_head;
+    tail = __atomic_load_n (ur->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        cqe = &ur->cqes[ head & *ur->cq_mask ];
+        if (((cqe->user_data >> 32) == ur->gen)
+                && ((cqe->user_data & 0xffffffff) < (uint64_t) ur->num_reqs)) {
+            ur->reqs[ cqe->user_data & 0xffffffff ].res = cqe->res;
+            ur->num_done++;
+        }
+        head++;
+    }
+    __atomic_store_n (ur->cq_head, head, __ATOMIC_RELEASE);
+    return;
+}
+
+
+static void
+_uring_abort (uring_t ur, int e)
+{
+/*  Aborts the batch of [ur] after its submission failed with error [e].
+ *  The kernel consumes the entries of the submission ring in order, so the
+ *    ring head determines which requests were consumed.  The remaining
+ *    requests are withdrawn from the ring and failed with [e].  The consumed
+ *    requests are then waited upon so their read buffers (or the caller's
+ *    write buffers) are not reused while the kernel may still access them.
+ */
+    unsigned head;
+    int      num_consumed;
+    int      rc;
+    int      i;
+
+    assert (ur != NULL);
+
+    head = __atomic_load_n (ur->sq_head, __ATOMIC_ACQUIRE);
+    __atomic_store_n (ur->sq_tail, head, __ATOMIC_RELEASE);
+    num_consumed = head - ur->batch_head;
+    assert ((num_consumed >= 0) && (num_consumed <= ur->num_reqs));
+
+    for (i = num_consumed; i < ur->num_reqs; i++) {
+        ur->reqs[ i ].res = -e;
+    }
+    _uring_reap (ur);
+    while (ur->num_done < num_consumed) {
+        rc = syscall (__NR_io_uring_enter, ur->fd, 0,
+            num_consumed - ur->num_done, IORING_ENTER_GETEVENTS, NULL, 0);
+        if ((rc < 0) && (errno != EINTR) && (errno != EAGAIN)
+                && (errno != EBUSY)) {
+            ur->is_failed = true;
+            break;
+        }
+        _uring_reap (ur);
+    }
+    for (i = 0; i < num_consumed; i++) {
+        if (ur->reqs[ i ].res == -ECANCELED) {
+            ur->reqs[ i ].res = -e;
+        }
+    }
+    ur->num_done = ur->num_reqs;
+    ur->is_submitted = true;
+    ur->gen++;
+    return;
+}
+
+#endif /* URING_HAVE_IO_URING */
@@ -0,0 +1,63 @@
+/*****************************************************************************
+ *  Written by Chris Dunlap <cdunlap@llnl.gov>.
+ *  Copyright (C) 2007-2023 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2001-2007 The Regents of the University of California.
+ *  UCRL-CODE-2002-009.
+ *
+ *  This file is part of ConMan: The Console Manager.
+ *  For details, see <https://dun.github.io/conman/>.
+ *
+ *  ConMan is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  ConMan is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with ConMan.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+#ifndef _URING_H
+#define _URING_H
+
+#include <sys/uio.h>
+
+
+/*****************************************************************************
+ *  Data Types
+ *****************************************************************************/
+
+typedef struct uring * uring_t;
+/*
+ *  Opaque data pointer for a uring object.
+ */
+
+
+/*****************************************************************************
+ *  Functions
+ *****************************************************************************/
+
+uring_t uring_create (int n, int bufsize);
+
+void uring_destroy (uring_t ur);
+
+int uring_is_fixed (uring_t ur);
+
+int uring_is_failed (uring_t ur);
+
+int uring_prep_read (uring_t ur, int fd, int len, void *arg);
+
+int uring_prep_writev (uring_t ur, int fd, const struct iovec *iov,
+    int iovcnt, void *arg);
+
+int uring_submit (uring_t ur);
+
+void * uring_next_completion (uring_t ur, int *ip, int *resp, void **bufp);
+
+
+#endif /* !_URING_H */
@@ -35,11 +35,22 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#if HAVE_SYS_SYSCALL_H
+#  include <sys/syscall.h>
+#endif /* HAVE_SYS_SYSCALL_H */
 #include "log.h"
 #include "util-file.h"
 #include "util-str.h"
 
 
+#ifndef SPLICE_F_MOVE
+#  define SPLICE_F_MOVE         1
+#endif /* !SPLICE_F_MOVE */
+#ifndef SPLICE_F_NONBLOCK
+#  define SPLICE_F_NONBLOCK     2
+#endif /* !SPLICE_F_NONBLOCK */
+
+
 static int get_file_lock(int fd, int cmd, int type);
 static pid_t test_file_lock(int fd, int type);
 
@@ -247,6 +258,26 @@ ssize_t read_line(int fd, void *buf, size_t maxlen)
 }
 
 
+ssize_t splice_fd(int fd_in, int fd_out, size_t n)
+{
+    ssize_t rv;
+
+    assert(fd_in >= 0);
+    assert(fd_out >= 0);
+
+#if defined(__NR_splice)
+    do {
+        rv = syscall(__NR_splice, fd_in, NULL, fd_out, NULL, n,
+            SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    } while ((rv < 0) && (errno == EINTR));
+#else  /* !__NR_splice */
+    errno = ENOSYS;
+    rv = -1;
+#endif /* !__NR_splice */
+    return(rv);
+}
+
+
 char *
 get_dir_name (const char *srcpath, char *dstdir, size_t dstdirlen)
 {
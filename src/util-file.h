@@ -114,6 +114,16 @@ ssize_t read_line(int fd, void *buf, size_t maxlen);
  *  Returns the number of bytes read, 0 on EOF, or -1 on error.
  */
 
+ssize_t splice_fd(int fd_in, int fd_out, size_t n);
+/*
+ *  Moves up to (n) bytes from (fd_in) to (fd_out) without copying them
+ *    through user-space; one of the two descriptors must refer to a pipe.
+ *  The transfer does not block on the pipe, but may still block on the
+ *    other descriptor if it is not in non-blocking mode.
+ *  Returns the number of bytes moved, 0 on EOF, or -1 on error (with errno
+ *    set to ENOSYS if splicing is not supported).
+ */
+
 char * get_dir_name (const char *srcpath, char *dstdir, size_t dstdirlen);
 /*
  *  Copies the parent directory name of (srcpath) into the buffer (dstdir)
@@ -37,6 +37,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#if HAVE_AVX2_TARGET
+#  include <immintrin.h>
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#endif /* __SSE2__ */
 #include "log.h"
 #include "util-str.h"
 #include "util.h"
@@ -45,6 +50,35 @@
 
 #define MAX_STR_SIZE 1024
 
+#define IS_PRINTABLE_CHAR(c) (((c) >= 0x20) && ((c) < 0x7F))
+
+#define TIME_STRING_LEN 20              /* "YYYY-MM-DD HH:MM:SS " */
+
+
+/*  The time string for the current second is cached since timestamped logs
+ *    would o/w format it for every line (cf. write_time_string()).
+ *  The cache is shared by all threads via a sequence lock:  the seq is odd
+ *    while the cache is being updated, and readers discard their copy if the
+ *    seq has changed while it was being made.
+ */
+static struct {
+    unsigned    seq;                    /* update sequence num (atomic)      */
+    time_t      t;                      /* time of cached string (atomic)    */
+    char        str[TIME_STRING_LEN + 1];
+} time_cache = { 0, (time_t) -1, "" };
+
+
+static size_t span_printable_scalar(const unsigned char *p, size_t len);
+#if defined(__SSE2__)
+static size_t span_printable_sse2(const unsigned char *p, size_t len);
+#endif /* __SSE2__ */
+#if HAVE_AVX2_TARGET
+static size_t span_printable_avx2(const unsigned char *p, size_t len);
+#endif /* HAVE_AVX2_TARGET */
+static int read_time_cache(time_t t, char *dst);
+static void write_time_cache(time_t t, const char *src);
+static struct tm * convert_localtime(const time_t *tPtr, struct tm *tmPtr);
+
 
 char * create_string(const char *str)
 {
@@ -120,6 +154,95 @@ int is_empty_string(const char *str)
 }
 
 
+size_t span_printable_string(const void *src, size_t len)
+{
+    const unsigned char *p = src;
+
+    assert(p != NULL);
+
+#if HAVE_AVX2_TARGET
+    if ((len >= 32) && __builtin_cpu_supports("avx2")) {
+        return(span_printable_avx2(p, len));
+    }
+#endif /* HAVE_AVX2_TARGET */
+#if defined(__SSE2__)
+    if (len >= 16) {
+        return(span_printable_sse2(p, len));
+    }
+#endif /* __SSE2__ */
+    return(span_printable_scalar(p, len));
+}
+
+
+static size_t span_printable_scalar(const unsigned char *p, size_t len)
+{
+/*  Scans the buffer (p) of length (len) one char at a time
+ *    on behalf of span_printable_string().
+ */
+    size_t n;
+
+    for (n = 0; (n < len) && IS_PRINTABLE_CHAR(p[n]); n++) {;}
+    return(n);
+}
+
+
+#if defined(__SSE2__)
+static size_t span_printable_sse2(const unsigned char *p, size_t len)
+{
+/*  Scans the buffer (p) of length (len) 16 chars at a time
+ *    on behalf of span_printable_string().
+ *  A char is printable if it is greater than 0x1F as a signed char (which
+ *    excludes control chars and chars with the high bit set) and is not DEL.
+ */
+    const __m128i ctl = _mm_set1_epi8(0x1F);
+    const __m128i del = _mm_set1_epi8(0x7F);
+    __m128i v;
+    int mask;
+    size_t n;
+
+    for (n = 0; n + 16 <= len; n += 16) {
+        v = _mm_loadu_si128((const __m128i *) (p + n));
+        mask = _mm_movemask_epi8(_mm_andnot_si128(
+            _mm_cmpeq_epi8(v, del), _mm_cmpgt_epi8(v, ctl)));
+        if (mask != 0xFFFF) {
+            return(n + __builtin_ctz(~mask));
+        }
+    }
+    return(n + span_printable_scalar(p + n, len - n));
+}
+#endif /* __SSE2__ */
+
+
+#if HAVE_AVX2_TARGET
+__attribute__((target("avx2")))
+static size_t span_printable_avx2(const unsigned char *p, size_t len)
+{
+/*  Scans the buffer (p) of length (len) 32 chars at a time
+ *    on behalf of span_printable_string() (cf. span_printable_sse2()).
+ */
+    const __m256i ctl = _mm256_set1_epi8(0x1F);
+    const __m256i del = _mm256_set1_epi8(0x7F);
+    __m256i v;
+    unsigned int mask;
+    size_t n;
+
+    for (n = 0; n + 32 <= len; n += 32) {
+        v = _mm256_loadu_si256((const __m256i *) (p + n));
+        mask = (unsigned int) _mm256_movemask_epi8(_mm256_andnot_si256(
+            _mm256_cmpeq_epi8(v, del), _mm256_cmpgt_epi8(v, ctl)));
+        if (mask != 0xFFFFFFFF) {
+            return(n + __builtin_ctz(~mask));
+        }
+    }
+#if defined(__SSE2__)
+    return(n + span_printable_sse2(p + n, len - n));
+#else  /* !__SSE2__ */
+    return(n + span_printable_scalar(p + n, len - n));
+#endif /* !__SSE2__ */
+}
+#endif /* HAVE_AVX2_TARGET */
+
+
 int parse_string(char *src, char **dst_p, char **ptr_p, char *quote_p)
 {
     char *p;
@@ -348,29 +471,83 @@ int write_time_string(time_t t, char *dst, size_t dstlen)
 {
     struct tm tm;
     int n;
+    int isNow = 0;
 
-    if (dstlen <= 20) {                 /* "YYYY-MM-DD HH:MM:SS " + NUL */
+    if (dstlen <= TIME_STRING_LEN) {    /* "YYYY-MM-DD HH:MM:SS " + NUL */
+        return(0);
+    }
+    /*  The current time string only needs to be formatted once per second.
+     */
+    if (t == 0) {
+        if (time(&t) == (time_t) -1) {
+            return(0);
+        }
+        if (read_time_cache(t, dst)) {
+            return(TIME_STRING_LEN);
+        }
+        isNow = 1;
+    }
+    /*  Errors are not logged here since this formats the timestamp
+     *    of each message logged (cf. log_aux()).
+     */
+    if (!convert_localtime(&t, &tm)) {
         return(0);
     }
-    get_localtime(&t, &tm);
-
     if (!(n = strftime(dst, dstlen, "%Y-%m-%d %H:%M:%S ", &tm))) {
         return(0);
     }
-    assert(n == 20);
+    assert(n == TIME_STRING_LEN);
+
+    if (isNow) {
+        write_time_cache(t, dst);
+    }
     return(n);
 }
 
 
-struct tm * get_localtime(time_t *tPtr, struct tm *tmPtr)
+static int read_time_cache(time_t t, char *dst)
 {
-#if ! HAVE_LOCALTIME_R
+/*  Copies the cached time string (including its NUL) into (dst)
+ *    if it was formatted for time (t).
+ *  Returns true if the string was copied; o/w, returns false.
+ */
+    unsigned seq;
 
-    static pthread_mutex_t localtimeLock = PTHREAD_MUTEX_INITIALIZER;
-    struct tm *tmTmpPtr;
+    seq = __atomic_load_n(&time_cache.seq, __ATOMIC_ACQUIRE);
+    if ((seq & 1) || (__atomic_load_n(&time_cache.t, __ATOMIC_RELAXED) != t)) {
+        return(0);
+    }
+    memcpy(dst, time_cache.str, TIME_STRING_LEN + 1);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return(__atomic_load_n(&time_cache.seq, __ATOMIC_RELAXED) == seq);
+}
+
+
+static void write_time_cache(time_t t, const char *src)
+{
+/*  Caches the time string (src) formatted for time (t).
+ *  If another thread is updating the cache, this update is skipped
+ *    rather than waiting for it.
+ *  The string is formatted before the cache is claimed, so any error
+ *    logged while formatting it cannot recurse into a claimed cache.
+ */
+    unsigned seq;
+
+    seq = __atomic_load_n(&time_cache.seq, __ATOMIC_RELAXED);
+    if ((seq & 1) || !__atomic_compare_exchange_n(&time_cache.seq, &seq,
+            seq + 1, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        return;
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&time_cache.t, t, __ATOMIC_RELAXED);
+    memcpy(time_cache.str, src, TIME_STRING_LEN + 1);
+    __atomic_store_n(&time_cache.seq, seq + 2, __ATOMIC_RELEASE);
+    return;
+}
 
-#endif /* !HAVE_LOCALTIME_R */
 
+struct tm * get_localtime(time_t *tPtr, struct tm *tmPtr)
+{
     assert(tPtr != NULL);
     assert(tmPtr != NULL);
 
@@ -379,27 +556,42 @@ struct tm * get_localtime(time_t *tPtr, struct tm *tmPtr)
             log_err(errno, "time() failed");
         }
     }
+    if (!convert_localtime(tPtr, tmPtr)) {
+#if ! HAVE_LOCALTIME_R
+        log_err(errno, "localtime() failed");
+#else /* HAVE_LOCALTIME_R */
+        log_err(errno, "localtime_r() failed");
+#endif /* !HAVE_LOCALTIME_R */
+    }
+    return(tmPtr);
+}
+
 
+static struct tm * convert_localtime(const time_t *tPtr, struct tm *tmPtr)
+{
+/*  Converts the time (tPtr) into the local time (tmPtr) in a thread-safe
+ *    manner without logging any error.
+ *  Returns (tmPtr), or NULL on error (with errno set).
+ */
 #if ! HAVE_LOCALTIME_R
 
+    static pthread_mutex_t localtimeLock = PTHREAD_MUTEX_INITIALIZER;
+    struct tm *tmTmpPtr;
+
     /*  localtime() is not thread-safe, so it is protected by a mutex.
      */
     x_pthread_mutex_lock(&localtimeLock);
-    if (!(tmTmpPtr = localtime(tPtr))) {
-        log_err(errno, "localtime() failed");
+    if ((tmTmpPtr = localtime(tPtr))) {
+        *tmPtr = *tmTmpPtr;
     }
-    *tmPtr = *tmTmpPtr;
     x_pthread_mutex_unlock(&localtimeLock);
+    return(tmTmpPtr ? tmPtr : NULL);
 
 #else /* HAVE_LOCALTIME_R */
 
-    if (!localtime_r(tPtr, tmPtr)) {
-        log_err(errno, "localtime_r() failed");
-    }
+    return(localtime_r(tPtr, tmPtr));
 
 #endif /* !HAVE_LOCALTIME_R */
-
-    return(tmPtr);
 }
 
 
@@ -65,6 +65,14 @@ int is_empty_string(const char *str);
  *  Returns -1 if (str) is NULL.
  */
 
+size_t span_printable_string(const void *src, size_t len);
+/*
+ *  Returns the length of the initial segment of the buffer (src) of length
+ *    (len) that consists entirely of printable 7-bit ASCII chars (ie, up to
+ *    the first CR, LF, NUL, control char, DEL, or char with the high bit set).
+ *  The buffer is scanned with SSE2/AVX2 vector instructions if available.
+ */
+
 int parse_string(char *src, char **dst_p, char **ptr_p, char *quote_p);
 /*
  *  Parses the next word in (src), storing a pointer to the word in (dst_p).
@@ -132,8 +140,11 @@ int write_time_string(time_t t, char *dst, size_t dstlen);
 /*
  *  Writes the time string "YYYY-MM-DD HH:MM:SS " specified by (t)
  *    into the buffer (dst) of size (dstlen).
- *  If no time is given (t=0), the current date & time is used.
- *  Returns the number of characters written (not including the NUL).
+ *  If no time is given (t=0), the current date & time is used; this string
+ *    is cached so it is only formatted once per second.
+ *  Returns the number of characters written (not including the NUL),
+ *    or 0 if the time cannot be determined or formatted.  No error is logged
+ *    since this is also used to timestamp the messages being logged.
  */
 
 struct tm * get_localtime(time_t *tPtr, struct tm *tmPtr);
@@ -0,0 +1,309 @@
+/*****************************************************************************
+ *  Written by Chris Dunlap <cdunlap@llnl.gov>.
+ *  Copyright (C) 2007-2023 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2001-2007 The Regents of the University of California.
+ *  UCRL-CODE-2002-009.
+ *
+ *  This file is part of ConMan: The Console Manager.
+ *  For details, see <https://dun.github.io/conman/>.
+ *
+ *  ConMan is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  ConMan is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with ConMan.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if HAVE_LINUX_MEMFD_H
+#  include <linux/memfd.h>
+#  include <sys/syscall.h>
+#  if defined(__NR_memfd_create) && defined(MFD_CLOEXEC)
+#    define VRING_HAVE_MEMFD 1
+#  endif /* __NR_memfd_create && MFD_CLOEXEC */
+#endif /* HAVE_LINUX_MEMFD_H */
+#include "bool.h"
+#include "vring.h"
+
+
+/*****************************************************************************
+ *  Notes
+ *****************************************************************************
+ *  This implementation is NOT thread-safe; a vring object is intended to be
+ *  written by the single thread running the event loop that owns it.
+ *
+ *  A vring object is a circular buffer of [size] bytes whose memory is
+ *  followed by a mirror of itself, so buf[i + size] is the same byte as
+ *  buf[i] for 0 <= i < size.  Any span of up to [size] bytes starting within
+ *  the buffer is thereby contiguous in memory, so it can be copied with a
+ *  single memcpy() or described by a single iovec regardless of where the
+ *  buffer wraps around.
+ *
+ *  Where possible, the mirror is provided by the MMU: a memfd of [size] bytes
+ *  is mapped twice back-to-back into a reserved region of twice that size.
+ *  This requires [size] to be a multiple of the page size, so the size is
+ *  rounded up accordingly.  Data can then be written anywhere in either half.
+ *
+ *  If memfd_create() is unavailable or the mapping fails (eg, due to the
+ *  number of mappings allowed per process), the buffer falls back to a heap
+ *  allocation of twice its size whose upper half is kept in sync by copying
+ *  every write into the other half.  The writer must therefore write data
+ *  via vring_write(), or call vring_commit() after writing data directly
+ *  into the lower half of the buffer (eg, via read()).  The size is not
+ *  rounded up in this case.
+ */
+
+
+/*****************************************************************************
+ *  Internal Data Types
+ *****************************************************************************/
+
+struct vring {
+    unsigned char   *buf;               /* circular buf followed by mirror   */
+    int              size;              /* size of circular buf in bytes     */
+    bool             is_mapped;         /* flag set if mirrored by the MMU   */
+};
+
+
+/*****************************************************************************
+ *  Internal Prototypes
+ *****************************************************************************/
+
+#if VRING_HAVE_MEMFD
+static int _vring_map (vring_t vr, int size);
+#endif /* VRING_HAVE_MEMFD */
+
+
+/*****************************************************************************
+ *  Functions
+ *****************************************************************************/
+
+vring_t
+vring_create (int size)
+{
+/*  Creates a new vring object for a circular buffer of at least [size] bytes.
+ *  Returns an opaque pointer to this new object, or NULL on error
+ *    (with errno set).
+ */
+    vring_t vr;
+    int     e;
+
+    if (size <= 0) {
+        errno = EINVAL;
+        return (NULL);
+    }
+    if (!(vr = malloc (sizeof (struct vring)))) {
+        return (NULL);
+    }
+    vr->buf = NULL;
+    vr->size = size;
+    vr->is_mapped = false;
+
+#if VRING_HAVE_MEMFD
+    if (_vring_map (vr, size) == 0) {
+        return (vr);
+    }
+#endif /* VRING_HAVE_MEMFD */
+
+    if ((size_t) size > ((size_t) -1) / 2) {
+        free (vr);
+        errno = ENOMEM;
+        return (NULL);
+    }
+    if (!(vr->buf = malloc ((size_t) size * 2))) {
+        e = errno;
+        free (vr);
+        errno = e;
+        return (NULL);
+    }
+    return (vr);
+}
+
+
+void
+vring_destroy (vring_t vr)
+{
+/*  Destroys the vring object [vr].
+ */
+    if (!vr) {
+        return;
+    }
+    if (vr->is_mapped) {
+        (void) munmap (vr->buf, (size_t) vr->size * 2);
+    }
+    else {
+        free (vr->buf);
+    }
+    free (vr);
+    return;
+}
+
+
+unsigned char *
+vring_buf (vring_t vr)
+{
+/*  Returns a pointer to the circular buffer of [vr].  The (2 * size) bytes
+ *    starting here can be read, with the upper half mirroring the lower half.
+ */
+    assert (vr != NULL);
+    return (vr->buf);
+}
+
+
+int
+vring_size (vring_t vr)
+{
+/*  Returns the size (in bytes) of the circular buffer of [vr].
+ *    This may be larger than the size requested at creation.
+ */
+    assert (vr != NULL);
+    return (vr->size);
+}
+
+
+int
+vring_is_mapped (vring_t vr)
+{
+/*  Returns true if the circular buffer of [vr] is mirrored by the MMU;
+ *    o/w, returns false if the mirror is maintained by copying.
+ */
+    assert (vr != NULL);
+    return (vr->is_mapped);
+}
+
+
+void
+vring_write (vring_t vr, int pos, const void *src, int n)
+{
+/*  Writes [n] bytes of [src] into the circular buffer of [vr] starting at
+ *    position [pos], wrapping around the end of the buffer as needed.
+ *    [n] must not exceed the buffer's size.
+ */
+    assert (vr != NULL);
+    assert (n >= 0);
+    assert (n <= vr->size);
+
+    if (n <= 0) {
+        return;
+    }
+    pos %= vr->size;
+    memcpy (vr->buf + pos, src, n);
+    vring_commit (vr, pos, n);
+    return;
+}
+
+
+void
+vring_commit (vring_t vr, int pos, int n)
+{
+/*  Commits [n] bytes written directly into the circular buffer of [vr]
+ *    starting at position [pos] (where pos + n <= 2 * size) by updating
+ *    the other half of the buffer to mirror them.
+ *  This is a no-op if the buffer is mirrored by the MMU.
+ */
+    int m;
+
+    assert (vr != NULL);
+    assert (n >= 0);
+    assert (n <= vr->size);
+
+    if (vr->is_mapped || (n <= 0)) {
+        return;
+    }
+    pos %= vr->size;
+    assert (pos + n <= 2 * vr->size);
+
+    /*  Mirror the bytes written into the lower half into the upper half,
+     *    and those that spilled over into the upper half into the lower half.
+     */
+    m = (pos + n <= vr->size) ? n : vr->size - pos;
+    memcpy (vr->buf + vr->size + pos, vr->buf + pos, m);
+    if (m < n) {
+        memcpy (vr->buf, vr->buf + vr->size, n - m);
+    }
+    return;
+}
+
+
+/*****************************************************************************
+ *  Internal Functions
+ *****************************************************************************/
+
+#if VRING_HAVE_MEMFD
+static int
+_vring_map (vring_t vr, int size)
+{
+/*  Maps the circular buffer of [vr] twice back-to-back from a memfd of at
+ *    least [size] bytes, rounding the size up to a multiple of the page size.
+ *  Returns 0 on success, or -1 on error (with errno set).
+ */
+    long           pagesize;
+    size_t         len;
+    int            fd;
+    unsigned char *p;
+    int            e;
+
+    if ((pagesize = sysconf (_SC_PAGESIZE)) <= 0) {
+        pagesize = 4096;
+    }
+    len = (((size_t) size + pagesize - 1) / pagesize) * pagesize;
+    if (len > (size_t) (((unsigned) -1) >> 1)) {
+        errno = EINVAL;
+        return (-1);
+    }
+    fd = syscall (__NR_memfd_create, "conman-vring", MFD_CLOEXEC);
+    if (fd < 0) {
+        return (-1);
+    }
+    if (ftruncate (fd, len) < 0) {
+        goto err;
+    }
+    /*  Reserve the address space for both halves before mapping the memfd
+     *    into each of them so the halves are guaranteed to be adjacent.
+     */
+    p = mmap (NULL, len * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        goto err;
+    }
+    if ((mmap (p, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+            fd, 0) == MAP_FAILED)
+      || (mmap (p + len, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+            fd, 0) == MAP_FAILED)) {
+        e = errno;
+        (void) munmap (p, len * 2);
+        errno = e;
+        goto err;
+    }
+    /*  The mappings hold a reference to the memfd, so it can be closed now.
+     */
+    (void) close (fd);
+    vr->buf = p;
+    vr->size = (int) len;
+    vr->is_mapped = true;
+    return (0);
+
+err:
+    e = errno;
+    (void) close (fd);
+    errno = e;
+    return (-1);
+}
+#endif /* VRING_HAVE_MEMFD */
@@ -0,0 +1,59 @@
+/*****************************************************************************
+ *  Written by Chris Dunlap <cdunlap@llnl.gov>.
+ *  Copyright (C) 2007-2023 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2001-2007 The Regents of the University of California.
+ *  UCRL-CODE-2002-009.
+ *
+ *  This file is part of ConMan: The Console Manager.
+ *  For details, see <https://dun.github.io/conman/>.
+ *
+ *  ConMan is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  ConMan is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with ConMan.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+
+
+#ifndef _VRING_H
+#define _VRING_H
+
+
+/*****************************************************************************
+ *  Data Types
+ *****************************************************************************/
+
+typedef struct vring * vring_t;
+/*
+ *  Opaque data pointer for a vring object.
+ */
+
+
+/*****************************************************************************
+ *  Functions
+ *****************************************************************************/
+
+vring_t vring_create (int size);
+
+void vring_destroy (vring_t vr);
+
+unsigned char * vring_buf (vring_t vr);
+
+int vring_size (vring_t vr);
+
+int vring_is_mapped (vring_t vr);
+
+void vring_write (vring_t vr, int pos, const void *src, int n);
+
+void vring_commit (vring_t vr, int pos, int n);
+
+
+#endif /* !_VRING_H */
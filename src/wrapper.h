@@ -65,6 +65,36 @@
              log_err(errno, "pthread_detach() failed");                       \
      } while (0)
 
+#  define x_pthread_cond_init(COND,ATTR)                                      \
+     do {                                                                     \
+         if ((errno = pthread_cond_init((COND), (ATTR))) != 0)                \
+             log_err(errno, "pthread_cond_init() failed");                    \
+     } while (0)
+
+#  define x_pthread_cond_wait(COND,MUTEX)                                     \
+     do {                                                                     \
+         if ((errno = pthread_cond_wait((COND), (MUTEX))) != 0)               \
+             log_err(errno, "pthread_cond_wait() failed");                    \
+     } while (0)
+
+#  define x_pthread_cond_signal(COND)                                         \
+     do {                                                                     \
+         if ((errno = pthread_cond_signal(COND)) != 0)                        \
+             log_err(errno, "pthread_cond_signal() failed");                  \
+     } while (0)
+
+#  define x_pthread_cond_broadcast(COND)                                      \
+     do {                                                                     \
+         if ((errno = pthread_cond_broadcast(COND)) != 0)                     \
+             log_err(errno, "pthread_cond_broadcast() failed");               \
+     } while (0)
+
+#  define x_pthread_cond_destroy(COND)                                        \
+     do {                                                                     \
+         if ((errno = pthread_cond_destroy(COND)) != 0)                       \
+             log_err(errno, "pthread_cond_destroy() failed");                 \
+     } while (0)
+
 #else /* !WITH_PTHREADS */
 
 #  define x_pthread_mutex_init(MUTEX,ATTR)
@@ -72,6 +102,11 @@
 #  define x_pthread_mutex_unlock(MUTEX)
 #  define x_pthread_mutex_destroy(MUTEX)
 #  define x_pthread_detach(THREAD)
+#  define x_pthread_cond_init(COND,ATTR)
+#  define x_pthread_cond_wait(COND,MUTEX)
+#  define x_pthread_cond_signal(COND)
+#  define x_pthread_cond_broadcast(COND)
+#  define x_pthread_cond_destroy(COND)
 
 #endif /* WITH_PTHREADS */
 
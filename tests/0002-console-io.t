@@ -0,0 +1,95 @@
+#!/bin/sh
+
+test_description="Check console and client I/O"
+
+: "${SHARNESS_TEST_SRCDIR:=$(cd "$(dirname "$0")" && pwd)}"
+. "${SHARNESS_TEST_SRCDIR}/sharness.sh"
+
+# Provide the log of the console named [console].
+#
+console_log()
+{
+    echo "${CONMAND_CONSOLE_GLOB}" | sed -e "s/\*/$1/"
+}
+
+# Create a process console that outputs 100 lines, and another that echoes
+#   its input.  The latter polls since its input is non-blocking.
+# Provide [GEN] and [ECHO].
+#
+test_expect_success 'create process consoles' '
+    GEN=$(conmand_script gen <<-EOF
+	#!/bin/sh
+	awk "BEGIN { for (i = 1; i <= 100; i++) print \"line-\" i }"
+	exec sleep 60
+	EOF
+    ) &&
+    ECHO=$(conmand_script echo <<-EOF
+	#!/bin/sh
+	while :; do cat 2>/dev/null; sleep 0.1; done
+	EOF
+    ) &&
+    awk "BEGIN { for (i = 1; i <= 100; i++) print \"line-\" i }" >lines.exp
+'
+
+# Set up the environment with the process consoles.
+#
+test_expect_success 'setup' '
+    conmand_setup \
+            "console name=\"lines\" dev=\"${GEN}\"" \
+            "console name=\"echo\" dev=\"${ECHO}\""
+'
+
+# Start the daemon and let the consoles output some data.
+#
+test_expect_success 'start conmand' '
+    conmand_start &&
+    sleep 1
+'
+
+# Verify the output of the process console has been logged.
+#
+test_expect_success 'check process console log' '
+    tr -d "\r" <"$(console_log lines)" | grep "^line-" >lines.out &&
+    test_cmp lines.exp lines.out
+'
+
+# Verify the output of the test consoles is being logged in order.
+#
+test_expect_success 'check test console logs' '
+    n1=$(check_test_console_data "$(console_log test1)") &&
+    sleep 1 &&
+    n2=$(check_test_console_data "$(console_log test1)") &&
+    test "${n2}" -gt "${n1}" &&
+    check_test_console_data "$(console_log test2)"
+'
+
+# Write to the echo console via the client.
+# Verify the echoed data is both sent to the client and logged.
+#
+test_expect_success SCRIPT 'check client input and output' '
+    (sleep 1; printf "hello-echo\n"; sleep 1; printf "&.") |
+            conman_client echo >out.echo 2>&1 &&
+    test_debug "cat out.echo" &&
+    grep "hello-echo" out.echo &&
+    grep "hello-echo" "$(console_log echo)"
+'
+
+# Stop the daemon.
+#
+test_expect_success 'stop conmand' '
+    conmand_stop
+'
+
+# Check the logfile for errors.
+#
+test_expect_success 'check logfile for errors' '
+    ! grep -E -i "(EMERGENCY|ALERT|CRITICAL|ERROR):" "${CONMAND_LOGFILE}"
+'
+
+# Perform housekeeping to clean up afterwards.
+#
+test_expect_success 'cleanup' '
+    conmand_cleanup
+'
+
+test_done
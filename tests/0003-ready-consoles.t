@@ -0,0 +1,115 @@
+#!/bin/sh
+
+test_description="Check servicing ready consoles amongst idle ones"
+
+: "${SHARNESS_TEST_SRCDIR:=$(cd "$(dirname "$0")" && pwd)}"
+. "${SHARNESS_TEST_SRCDIR}/sharness.sh"
+
+# Provide the log of the console named [console].
+#
+console_log()
+{
+    echo "${CONMAND_CONSOLE_GLOB}" | sed -e "s/\*/$1/"
+}
+
+# Create a process console that outputs 50 lines over 5 seconds, and another
+#   that echoes its input.  The latter polls since its input is non-blocking.
+# Provide [GEN] and [ECHO].
+#
+test_expect_success 'create process consoles' '
+    GEN=$(conmand_script gen <<-EOF
+	#!/bin/sh
+	i=1
+	while test \${i} -le 50; do echo "line-\${i}"; i=\$((i + 1)); sleep 0.1; done
+	exec sleep 60
+	EOF
+    ) &&
+    ECHO=$(conmand_script echo <<-EOF
+	#!/bin/sh
+	while :; do cat 2>/dev/null; sleep 0.1; done
+	EOF
+    ) &&
+    awk "BEGIN { for (i = 1; i <= 50; i++) print \"line-\" i }" >lines.exp
+'
+
+# Set up the environment with 50 idle consoles, the process console, and
+#   3 echo consoles.
+#
+test_expect_success 'setup' '
+    for i in $(test_seq 1 50); do
+        echo "console name=\"idle${i}\" dev=\"/bin/sleep 60\""
+    done >idle.conf &&
+    conmand_setup "$(cat idle.conf)" \
+            "console name=\"lines\" dev=\"${GEN}\"" \
+            "console name=\"echo1\" dev=\"${ECHO}\"" \
+            "console name=\"echo2\" dev=\"${ECHO}\"" \
+            "console name=\"echo3\" dev=\"${ECHO}\"" &&
+    test "${CONMAND_CONSOLE_COUNT}" -eq 56
+'
+
+# Start the daemon.
+#
+test_expect_success 'start conmand' '
+    conmand_start
+'
+
+# Connect to each echo console in turn while the other consoles are active.
+#   Each client is likely to be assigned the fd of the client preceding it.
+# Verify the data written by each client is only echoed to that client and
+#   logged for its console.
+#
+test_expect_success SCRIPT 'check successive clients' '
+    for i in 1 2 3; do
+        (sleep 1; printf "hello-echo${i}\n"; sleep 1; printf "&.") |
+                conman_client "echo${i}" >"out.echo${i}" 2>&1 || return 1
+    done &&
+    for i in 1 2 3; do
+        test_debug "cat out.echo${i}" &&
+        grep "hello-echo${i}" "out.echo${i}" &&
+        test "$(grep -c hello-echo "out.echo${i}")" -eq 1 &&
+        grep "hello-echo${i}" "$(console_log "echo${i}")" &&
+        test "$(grep -c hello-echo "$(console_log "echo${i}")")" -eq 1 ||
+        return 1
+    done
+'
+
+# Verify the output of the process console has been logged.
+#
+test_expect_success 'check process console log' '
+    tr -d "\r" <"$(console_log lines)" | grep "^line-" >lines.out &&
+    test_cmp lines.exp lines.out
+'
+
+# Verify the output of the test consoles has been logged in order.
+#
+test_expect_success 'check test console logs' '
+    check_test_console_data "$(console_log test1)" &&
+    check_test_console_data "$(console_log test2)"
+'
+
+# Verify each console is listed by a query.
+#
+test_expect_success 'check conman query' '
+    "${CONMAN}" -d "127.0.0.1:${CONMAND_PORT}" -q >out.query &&
+    test "$(wc -l <out.query)" -eq "${CONMAND_CONSOLE_COUNT}"
+'
+
+# Stop the daemon.
+#
+test_expect_success 'stop conmand' '
+    conmand_stop
+'
+
+# Check the logfile for errors.
+#
+test_expect_success 'check logfile for errors' '
+    ! grep -E -i "(EMERGENCY|ALERT|CRITICAL|ERROR):" "${CONMAND_LOGFILE}"
+'
+
+# Perform housekeeping to clean up afterwards.
+#
+test_expect_success 'cleanup' '
+    conmand_cleanup
+'
+
+test_done
@@ -0,0 +1,94 @@
+#!/bin/sh
+
+test_description="Check console timers"
+
+: "${SHARNESS_TEST_SRCDIR:=$(cd "$(dirname "$0")" && pwd)}"
+. "${SHARNESS_TEST_SRCDIR}/sharness.sh"
+
+# Provide the log of the console named [console].
+#
+console_log()
+{
+    echo "${CONMAND_CONSOLE_GLOB}" | sed -e "s/\*/$1/"
+}
+
+# Output the number of chars output by each of the [consoles] during an
+#   interval of 2 seconds, one console per line.
+#
+count_console_data()
+{
+    local console
+    for console in "$@"; do
+        check_test_console_data "$(console_log "${console}")" || return 1
+    done >count.1 &&
+    sleep 2 &&
+    for console in "$@"; do
+        check_test_console_data "$(console_log "${console}")" || return 1
+    done >count.2 &&
+    paste count.1 count.2 | awk "{ print \$2 - \$1 }"
+}
+
+# Set up the environment with test consoles that output 1 byte every 10ms,
+#   50ms, 250ms, and 30s.  The timers of all of the test consoles are
+#   interleaved in the same event loop.  Logfile timestamps are written every
+#   minute.
+#
+test_expect_success 'setup' '
+    conmand_setup "server timestamp=1m" \
+            "console name=\"fast\" dev=\"test:\" testopts=\"m:10,n:10\"" \
+            "console name=\"medium\" dev=\"test:\" testopts=\"m:50,n:50\"" \
+            "console name=\"slow\" dev=\"test:\" testopts=\"m:250,n:250\"" \
+            "console name=\"idle\" dev=\"test:\" testopts=\"m:30000,n:30000\""
+'
+
+# Start the daemon.
+#
+test_expect_success 'start conmand' '
+    conmand_start &&
+    sleep 1
+'
+
+# Verify each test console outputs data at its own interval.
+#
+test_expect_success 'check timer intervals' '
+    count_console_data fast medium slow idle >counts &&
+    test_debug "cat counts" &&
+    { read fast && read medium && read slow && read idle; } <counts &&
+    test "${fast}" -ge 100 && test "${fast}" -le 230 &&
+    test "${medium}" -ge 20 && test "${medium}" -le 46 &&
+    test "${slow}" -ge 4 && test "${slow}" -le 10 &&
+    test "${idle}" -le 1
+'
+
+# Wait for the next logfile timestamp, which is scheduled by the wall clock
+#   for the start of each minute instead of relative to the current time.
+# Verify it has been written to the logs on time.  The time in the message
+#   comes from time(), which can lag the timer's clock by a tick.
+#
+test_expect_success EXPENSIVE 'check logfile timestamps' '
+    sleep $((62 - $(date +%S | sed -e "s/^0//"))) &&
+    for console in fast idle; do
+        grep -E "Console \[${console}\] log at .* [0-9:]{5}:(59|00) " \
+                "$(console_log "${console}")" || return 1
+    done
+'
+
+# Stop the daemon.
+#
+test_expect_success 'stop conmand' '
+    conmand_stop
+'
+
+# Check the logfile for errors.
+#
+test_expect_success 'check logfile for errors' '
+    ! grep -E -i "(EMERGENCY|ALERT|CRITICAL|ERROR):" "${CONMAND_LOGFILE}"
+'
+
+# Perform housekeeping to clean up afterwards.
+#
+test_expect_success 'cleanup' '
+    conmand_cleanup
+'
+
+test_done
@@ -0,0 +1,100 @@
+#!/bin/sh
+
+test_description="Check waking event loops from other threads"
+
+: "${SHARNESS_TEST_SRCDIR:=$(cd "$(dirname "$0")" && pwd)}"
+. "${SHARNESS_TEST_SRCDIR}/sharness.sh"
+
+# Provide the log of the console named [console].
+#
+console_log()
+{
+    echo "${CONMAND_CONSOLE_GLOB}" | sed -e "s/\*/$1/"
+}
+
+# Create a process console that echoes its input.  It polls since its input is
+#   non-blocking.
+# Provide [ECHO].
+#
+test_expect_success 'create process console' '
+    ECHO=$(conmand_script echo <<-EOF
+	#!/bin/sh
+	while :; do cat 2>/dev/null; sleep 0.1; done
+	EOF
+    )
+'
+
+# Set up the environment with 2 event loops and 2 echo consoles.  The consoles
+#   are divided amongst the loops, while clients are accepted by the main
+#   thread, so each loop must be woken to service its new clients.
+#
+test_expect_success 'setup' '
+    conmand_setup "server threads=2" \
+            "console name=\"echo1\" dev=\"${ECHO}\"" \
+            "console name=\"echo2\" dev=\"${ECHO}\""
+'
+
+# Start the daemon.
+#
+test_expect_success 'start conmand' '
+    conmand_start
+'
+
+# Connect 20 clients to a test console at once.
+# Verify each client receives the console output in order.
+#
+test_expect_success SCRIPT 'check concurrent clients' '
+    for i in $(test_seq 1 20); do
+        (sleep 2; printf "&.") |
+                conman_client -m test1 >"out.test1.${i}" 2>&1 &
+    done &&
+    wait &&
+    for i in $(test_seq 1 20); do
+        check_test_console_data "out.test1.${i}" || return 1
+    done
+'
+
+# Broadcast to both echo consoles.
+# Verify the data is echoed by each console.
+#
+test_expect_success SCRIPT 'check broadcast client' '
+    (sleep 1; printf "hello-bcast\n"; sleep 1; printf "&.") |
+            conman_client -b echo1 echo2 >out.bcast 2>&1 &&
+    test_debug "cat out.bcast" &&
+    grep "hello-bcast" "$(console_log echo1)" &&
+    grep "hello-bcast" "$(console_log echo2)"
+'
+
+# Move a console log aside and send a SIGHUP to the daemon, which has each loop
+#   reopen its logs.
+# Verify the log has been recreated and is written to again.
+#
+test_expect_success 'check reopening logs' '
+    log=$(console_log test2) &&
+    mv "${log}" "${log}.old" &&
+    kill -HUP "$(cat "${CONMAND_PIDFILE}")" &&
+    sleep 1 &&
+    check_test_console_data "${log}"
+'
+
+# Stop the daemon.
+# Verify each loop has been woken to exit.
+#
+test_expect_success 'stop conmand' '
+    conmand_stop
+'
+
+# Check the logfile for errors.
+#
+test_expect_success 'check logfile for errors' '
+    ! grep -E -i "(EMERGENCY|ALERT|CRITICAL|ERROR):" "${CONMAND_LOGFILE}"
+'
+
+# Perform housekeeping to clean up afterwards.
+#
+test_expect_success 'cleanup' '
+    conmand_cleanup &&
+    rm -f "$(console_log test2).old"
+'
+
+test_done
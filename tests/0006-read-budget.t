@@ -0,0 +1,118 @@
+#!/bin/sh
+
+test_description="Check draining busy consoles"
+
+: "${SHARNESS_TEST_SRCDIR:=$(cd "$(dirname "$0")" && pwd)}"
+. "${SHARNESS_TEST_SRCDIR}/sharness.sh"
+
+# Provide the log of the console named [console].
+#
+console_log()
+{
+    echo "${CONMAND_CONSOLE_GLOB}" | sed -e "s/\*/$1/"
+}
+
+# Create a process console that outputs 32 bursts of 64 lines of 999 chars
+#   each, once a second has passed.  The bursts are paced since a process
+#   console's output is non-blocking.
+# Provide [GEN].
+#
+test_expect_success 'create process console' '
+    GEN=$(conmand_script gen <<-EOF
+	#!/bin/sh
+	sleep 1
+	i=0
+	while test \${i} -lt 32; do
+	    awk "BEGIN { s = sprintf(\"%999s\", \"\"); gsub(/ /, \"x\", s);
+	            for (i = 1; i <= 64; i++) print s }"
+	    sleep 0.05
+	    i=\$((i + 1))
+	done
+	exec sleep 60
+	EOF
+    )
+'
+
+# Set up the environment with the process console and a read budget smaller
+#   than the data it outputs at once.
+#
+test_expect_success 'setup' '
+    conmand_setup "server readbudget=4096" \
+            "console name=\"busy\" dev=\"${GEN}\""
+'
+
+# Start the daemon and let the process console output its data.
+#
+test_expect_success 'start conmand' '
+    conmand_start &&
+    sleep 3
+'
+
+# Verify all of the output of the busy console has been logged.
+#
+test_expect_success 'check busy console log' '
+    test "$(tr -d "\r" <"$(console_log busy)" | grep -c "^x\{999\}\$")" \
+            -eq 2048
+'
+
+# Verify the output of the test consoles has been logged in order despite the
+#   busy console sharing their event loop.
+#
+test_expect_success 'check test console logs' '
+    check_test_console_data "$(console_log test1)" &&
+    check_test_console_data "$(console_log test2)"
+'
+
+# Stop the daemon.
+#
+test_expect_success 'stop conmand' '
+    conmand_stop
+'
+
+# Set up the environment again with the default read budget (which exceeds
+#   the circular-buf of each logfile), and a second instance of the process
+#   console whose log is sanitized.
+#
+test_expect_success 'setup with default read budget' '
+    rm -f ${CONMAND_CONSOLE_GLOB} &&
+    conmand_setup "console name=\"busy\" dev=\"${GEN}\"" \
+            "console name=\"sanitized\" dev=\"${GEN}\" logopts=\"sanitize\""
+'
+
+# Start the daemon and let the process consoles output their data.
+#
+test_expect_success 'start conmand with default read budget' '
+    conmand_start &&
+    sleep 3
+'
+
+# Verify all of the output of the busy consoles has been logged without
+#   overrunning their logfiles.
+#
+test_expect_success 'check busy console logs with default read budget' '
+    test "$(tr -d "\r" <"$(console_log busy)" | grep -c "^x\{999\}\$")" \
+            -eq 2048 &&
+    test "$(tr -d "\r" <"$(console_log sanitized)" | grep -c "^x\{999\}\$")" \
+            -eq 2048 &&
+    ! grep "Overwrote" "${CONMAND_LOGFILE}"
+'
+
+# Stop the daemon.
+#
+test_expect_success 'stop conmand with default read budget' '
+    conmand_stop
+'
+
+# Check the logfile for errors.
+#
+test_expect_success 'check logfile for errors' '
+    ! grep -E -i "(EMERGENCY|ALERT|CRITICAL|ERROR):" "${CONMAND_LOGFILE}"
+'
+
+# Perform housekeeping to clean up afterwards.
+#
+test_expect_success 'cleanup' '
+    conmand_cleanup
+'
+
+test_done
@@ -0,0 +1,108 @@
+#!/bin/sh
+
+test_description="Check sharing console output amongst its readers"
+
+: "${SHARNESS_TEST_SRCDIR:=$(cd "$(dirname "$0")" && pwd)}"
+. "${SHARNESS_TEST_SRCDIR}/sharness.sh"
+
+# Provide the log of the console named [console].
+#
+console_log()
+{
+    echo "${CONMAND_CONSOLE_GLOB}" | sed -e "s/\*/$1/"
+}
+
+# Create a process console that outputs 100 lines over 2 seconds, once
+#   2 seconds have passed.
+# Provide [GEN].
+#
+test_expect_success 'create process console' '
+    GEN=$(conmand_script gen <<-EOF
+	#!/bin/sh
+	sleep 2
+	i=1
+	while test \${i} -le 100; do echo "line-\${i}"; i=\$((i + 1)); sleep 0.02; done
+	exec sleep 60
+	EOF
+    ) &&
+    awk "BEGIN { for (i = 1; i <= 100; i++) print \"line-\" i }" >lines.exp
+'
+
+# Set up the environment with 2 instances of the process console: the log of
+#   "lines" is written from the console's fan-out ring, whereas the log of
+#   "sanitized" requires processing and is written from its own copy.
+#
+test_expect_success 'setup' '
+    conmand_setup \
+            "console name=\"lines\" dev=\"${GEN}\"" \
+            "console name=\"sanitized\" dev=\"${GEN}\" logopts=\"sanitize\""
+'
+
+# Start the daemon.
+#
+test_expect_success 'start conmand' '
+    conmand_start
+'
+
+# Connect 3 clients to each console before the process consoles start their
+#   output: 2 monitoring it, and 1 joining it read-write.
+# Verify each client receives all of the process console output in order.
+#
+test_expect_success SCRIPT 'check process console clients' '
+    for console in lines sanitized; do
+        for opt in m1 m2 j; do
+            (sleep 5; printf "&.") |
+                    conman_client -${opt%[0-9]} ${console} \
+                    >"out.${console}.${opt}" 2>&1 &
+        done
+    done &&
+    wait &&
+    for f in out.lines.* out.sanitized.*; do
+        tr -d "\r" <"${f}" | grep "^line-" >"${f}.lines" &&
+        test_cmp lines.exp "${f}.lines" || return 1
+    done
+'
+
+# Verify the output of the process consoles has been logged.
+#
+test_expect_success 'check process console logs' '
+    for console in lines sanitized; do
+        tr -d "\r" <"$(console_log ${console})" | grep "^line-" \
+                >"log.${console}.lines" &&
+        test_cmp lines.exp "log.${console}.lines" || return 1
+    done
+'
+
+# Connect 3 clients to a test console at once.
+# Verify each client and the log receive the console output in order.
+#
+test_expect_success SCRIPT 'check test console clients' '
+    for i in 1 2 3; do
+        (sleep 2; printf "&.") | conman_client -m test1 >"out.test1.${i}" 2>&1 &
+    done &&
+    wait &&
+    for i in 1 2 3; do
+        check_test_console_data "out.test1.${i}" || return 1
+    done &&
+    check_test_console_data "$(console_log test1)"
+'
+
+# Stop the daemon.
+#
+test_expect_success 'stop conmand' '
+    conmand_stop
+'
+
+# Check the logfile for errors.
+#
+test_expect_success 'check logfile for errors' '
+    ! grep -E -i "(EMERGENCY|ALERT|CRITICAL|ERROR):" "${CONMAND_LOGFILE}"
+'
+
+# Perform housekeeping to clean up afterwards.
+#
+test_expect_success 'cleanup' '
+    conmand_cleanup
+'
+
+test_done
@@ -0,0 +1,154 @@
+#!/bin/sh
+
+test_description="Check clients falling behind their console"
+
+: "${SHARNESS_TEST_SRCDIR:=$(cd "$(dirname "$0")" && pwd)}"
+. "${SHARNESS_TEST_SRCDIR}/sharness.sh"
+
+# Check the output of a test console received by a client in [file] for
+#   missing, duplicated, or reordered data, allowing for the data noted as lost
+#   by each "[N bytes lost]" marker.  A test console cycles through the 94
+#   printable ASCII chars other than space, so the char following a marker
+#   must be N chars further along in that cycle.
+# Output the number of markers found.
+#
+check_lost_data()
+{
+    tr -d "\r" <"$1" | sed -e "s/&\.\$//" | awk "
+        BEGIN { for (i = 33; i <= 126; i++) ord[sprintf(\"%c\", i)] = i - 33 }
+        /^<ConMan> \[[0-9]+ bytes? lost\]\$/ {
+            skip += substr(\$2, 2); markers++; next
+        }
+        /^<ConMan> / { next }
+        {
+            for (j = 1; j <= length(\$0); j++) {
+                c = ord[substr(\$0, j, 1)]
+                if ((n++ > 0) && (c != (p + 1 + skip) % 94)) bad++
+                p = c; skip = 0
+            }
+        }
+        END { print markers + 0; exit ((n == 0) || (bad > 0)) }"
+}
+
+# Connect a client to the "flood" console that does not read its output
+#   for 3 seconds, writing the output it eventually reads to [file].
+#   Any remaining arguments are passed to the client.
+#
+conman_slow_client()
+{
+    local file
+
+    file=$1
+    shift
+    (sleep 4; printf "&.") | conman_client "$@" -m flood 2>&1 |
+            { sleep 3; cat; } >"${file}"
+}
+
+# Set up the environment with a test console that outputs 500KB bursts
+#   10 times a second without being logged.
+#
+test_expect_success 'setup' '
+    opts="b:500000,m:100,n:100" &&
+    conmand_setup \
+            "console name=\"flood\" dev=\"test:\" log=\"\" testopts=\"${opts}\""
+'
+
+# Start the daemon.
+#
+test_expect_success 'start conmand' '
+    conmand_start
+'
+
+# Verify a client that falls behind receives markers noting the data it lost.
+#
+test_expect_success SCRIPT 'check lost data markers' '
+    conman_slow_client out.marker &&
+    markers=$(check_lost_data out.marker) &&
+    test "${markers}" -gt 0 &&
+    grep "Client .* lost [0-9]* bytes in [0-9]* overruns" "${CONMAND_LOGFILE}"
+'
+
+# Verify a client cannot spool when the daemon does not, but is warned that
+#   it receives markers instead.
+#
+test_expect_success SCRIPT 'check spool refused' '
+    conman_slow_client out.refused -O spool &&
+    grep "Overrun policy \"spool:[0-9]*\" refused; using \"marker\"" \
+            out.refused &&
+    markers=$(check_lost_data out.refused) &&
+    test "${markers}" -gt 0
+'
+
+# Stop the daemon.
+#
+test_expect_success 'stop conmand' '
+    conmand_stop
+'
+
+# Restart the daemon with clients disconnected once they lose data.
+#
+test_expect_success 'restart conmand with disconnect policy' '
+    sed -i -e "/^server port=/a\\
+server overrun=\"disconnect\"" "${CONMAND_CONFIG}" &&
+    conmand_start
+'
+
+# Verify a client that falls behind is disconnected.
+#
+test_expect_success SCRIPT 'check disconnected client' '
+    conman_slow_client out.disconnect &&
+    grep "Disconnected after losing [0-9]* bytes" out.disconnect &&
+    ! grep "bytes lost\]" out.disconnect &&
+    check_test_console_data out.disconnect
+'
+
+# Stop the daemon.
+#
+test_expect_success 'stop conmand' '
+    conmand_stop
+'
+
+# Restart the daemon with clients spooling up to 64MB of data they cannot
+#   yet receive.
+#
+test_expect_success 'restart conmand with spool policy' '
+    sed -i -e "s/^server overrun=.*/server overrun=\"spool:67108864\"/" \
+            "${CONMAND_CONFIG}" &&
+    conmand_start
+'
+
+# Verify a client that falls behind receives all of the data.
+#
+test_expect_success SCRIPT 'check spooled client' '
+    conman_slow_client out.spool &&
+    ! grep "bytes lost\]" out.spool &&
+    check_test_console_data out.spool
+'
+
+# Verify a client can select a stricter policy than the daemon.
+#
+test_expect_success SCRIPT 'check client selecting disconnect policy' '
+    conman_slow_client out.stricter -O disconnect &&
+    ! grep "refused" out.stricter &&
+    grep "Disconnected after losing [0-9]* bytes" out.stricter
+'
+
+# Stop the daemon.
+#
+test_expect_success 'stop conmand' '
+    conmand_stop
+'
+
+# Check the logfile for errors.
+#
+test_expect_success 'check logfile for errors' '
+    ! grep -E -i "(EMERGENCY|ALERT|CRITICAL|ERROR):" "${CONMAND_LOGFILE}"
+'
+
+# Perform housekeeping to clean up afterwards.
+#
+test_expect_success 'cleanup' '
+    conmand_cleanup
+'
+
+test_done
@@ -0,0 +1,104 @@
+#!/bin/sh
+
+test_description="Check obj buffers confined to their event loops"
+
+: "${SHARNESS_TEST_SRCDIR:=$(cd "$(dirname "$0")" && pwd)}"
+. "${SHARNESS_TEST_SRCDIR}/sharness.sh"
+
+# Provide the log of the console named [console].
+#
+console_log()
+{
+    echo "${CONMAND_CONSOLE_GLOB}" | sed -e "s/\*/$1/"
+}
+
+# Create a process console that echoes its input.  It polls since its input is
+#   non-blocking.
+# Provide [ECHO].
+#
+test_expect_success 'create process console' '
+    ECHO=$(conmand_script echo <<-EOF
+	#!/bin/sh
+	while :; do cat 2>/dev/null; sleep 0.1; done
+	EOF
+    )
+'
+
+# Set up the environment with 4 event loops, 8 busy test consoles, and 4 echo
+#   consoles.  The consoles are divided amongst the loops, so each loop
+#   services the buffers of its own consoles and their clients.
+#
+test_expect_success 'setup' '
+    opts="b:256,m:1,n:5" &&
+    for i in $(test_seq 1 8); do
+        echo "console name=\"busy${i}\" dev=\"test:\" testopts=\"${opts}\"" ||
+                return 1
+    done >busy.conf &&
+    for i in $(test_seq 1 4); do
+        echo "console name=\"echo${i}\" dev=\"${ECHO}\"" || return 1
+    done >echo.conf &&
+    conmand_setup "server threads=4" "$(cat busy.conf)" "$(cat echo.conf)"
+'
+
+# Start the daemon.
+#
+test_expect_success 'start conmand' '
+    conmand_start
+'
+
+# Connect 2 clients to each busy console at once.
+# Verify each client receives the console output in order.
+#
+test_expect_success SCRIPT 'check busy console clients' '
+    for i in $(test_seq 1 8); do
+        for j in 1 2; do
+            (sleep 2; printf "&.") |
+                    conman_client -m "busy${i}" >"out.busy${i}.${j}" 2>&1 &
+        done
+    done &&
+    wait &&
+    for i in $(test_seq 1 8); do
+        for j in 1 2; do
+            check_test_console_data "out.busy${i}.${j}" || return 1
+        done
+    done
+'
+
+# Verify the output of each busy console has been logged in order.
+#
+test_expect_success 'check busy console logs' '
+    for i in $(test_seq 1 8); do
+        check_test_console_data "$(console_log "busy${i}")" || return 1
+    done
+'
+
+# Broadcast to all of the echo consoles, which are spread across the loops.
+# Verify the data is echoed by each console.
+#
+test_expect_success SCRIPT 'check broadcast client' '
+    (sleep 1; printf "hello-bcast\n"; sleep 1; printf "&.") |
+            conman_client -b echo1 echo2 echo3 echo4 >out.bcast 2>&1 &&
+    for i in $(test_seq 1 4); do
+        grep "hello-bcast" "$(console_log "echo${i}")" || return 1
+    done
+'
+
+# Stop the daemon.
+#
+test_expect_success 'stop conmand' '
+    conmand_stop
+'
+
+# Check the logfile for errors.
+#
+test_expect_success 'check logfile for errors' '
+    ! grep -E -i "(EMERGENCY|ALERT|CRITICAL|ERROR):" "${CONMAND_LOGFILE}"
+'
+
+# Perform housekeeping to clean up afterwards.
+#
+test_expect_success 'cleanup' '
+    conmand_cleanup
+'
+
+test_done
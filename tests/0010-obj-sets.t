@@ -0,0 +1,109 @@
+#!/bin/sh
+
+test_description="Check consoles with more readers and writers than fit inline"
+
+: "${SHARNESS_TEST_SRCDIR:=$(cd "$(dirname "$0")" && pwd)}"
+. "${SHARNESS_TEST_SRCDIR}/sharness.sh"
+
+# Provide the log of the console named [console].
+#
+console_log()
+{
+    echo "${CONMAND_CONSOLE_GLOB}" | sed -e "s/\*/$1/"
+}
+
+# Create a process console that echoes its input.  It polls since its input is
+#   non-blocking.
+# Provide [ECHO].
+#
+test_expect_success 'create process console' '
+    ECHO=$(conmand_script echo <<-EOF
+	#!/bin/sh
+	while :; do cat 2>/dev/null; sleep 0.1; done
+	EOF
+    )
+'
+
+# Set up the environment with 6 echo consoles.
+#
+test_expect_success 'setup' '
+    for i in $(test_seq 1 6); do
+        echo "console name=\"echo${i}\" dev=\"${ECHO}\"" || return 1
+    done >echo.conf &&
+    conmand_setup "$(cat echo.conf)"
+'
+
+# Start the daemon.
+#
+test_expect_success 'start conmand' '
+    conmand_start
+'
+
+# Connect 8 clients to a test console at once, which together with its log
+#   exceed the readers held inline by the console.  Half of the clients
+#   disconnect early, removing readers from the middle of the set.
+# Verify each client receives the console output in order.
+#
+test_expect_success SCRIPT 'check many readers' '
+    for i in $(test_seq 1 8); do
+        (sleep $((i % 2 + 2)); printf "&.") |
+                conman_client -m test1 >"out.test1.${i}" 2>&1 &
+    done &&
+    wait &&
+    for i in $(test_seq 1 8); do
+        check_test_console_data "out.test1.${i}" || return 1
+    done &&
+    check_test_console_data "$(console_log test1)"
+'
+
+# Join 6 clients read-write to an echo console at once, each writing its own
+#   token half a second apart from the others so their input is not
+#   interleaved.
+# Verify each client receives the tokens written by all of the clients.
+#
+test_expect_success SCRIPT 'check many writers' '
+    for i in $(test_seq 1 6); do
+        (sleep "$((i / 2 + 1)).$((i % 2 * 5))"; printf "hello-join${i}\n";
+                sleep 3; printf "&.") |
+                conman_client -j echo1 >"out.join.${i}" 2>&1 &
+    done &&
+    wait &&
+    for i in $(test_seq 1 6); do
+        for j in $(test_seq 1 6); do
+            grep "hello-join${j}" "out.join.${i}" || return 1
+        done
+    done
+'
+
+# Broadcast to all 6 echo consoles, which exceed the writers held inline by
+#   the client.
+# Verify the data is echoed by each console.
+#
+test_expect_success SCRIPT 'check broadcast client' '
+    (sleep 1; printf "hello-bcast\n"; sleep 1; printf "&.") |
+            conman_client -b echo1 echo2 echo3 echo4 echo5 echo6 \
+            >out.bcast 2>&1 &&
+    for i in $(test_seq 1 6); do
+        grep "hello-bcast" "$(console_log "echo${i}")" || return 1
+    done
+'
+
+# Stop the daemon.
+#
+test_expect_success 'stop conmand' '
+    conmand_stop
+'
+
+# Check the logfile for errors.
+#
+test_expect_success 'check logfile for errors' '
+    ! grep -E -i "(EMERGENCY|ALERT|CRITICAL|ERROR):" "${CONMAND_LOGFILE}"
+'
+
+# Perform housekeeping to clean up afterwards.
+#
+test_expect_success 'cleanup' '
+    conmand_cleanup
+'
+
+test_done
@@ -0,0 +1,113 @@
+#!/bin/sh
+
+test_description="Check batching console log writes"
+
+: "${SHARNESS_TEST_SRCDIR:=$(cd "$(dirname "$0")" && pwd)}"
+. "${SHARNESS_TEST_SRCDIR}/sharness.sh"
+
+# Provide the log of the console named [console].
+#
+console_log()
+{
+    echo "${CONMAND_CONSOLE_GLOB}" | sed -e "s/\*/$1/"
+}
+
+# Output the distinct sizes of the log of the console named [console] sampled
+#   every 100ms for 2 seconds, one size per line.
+#
+sample_log_sizes()
+{
+    local log i
+
+    log=$(console_log "$1")
+    for i in $(test_seq 1 20); do
+        wc -c <"${log}" || return 1
+        sleep 0.1
+    done | uniq
+}
+
+# Set up the environment with a test console that outputs 1 byte every 100ms
+#   and whose log is written once a minute, and test consoles that output
+#   64 bytes every 10ms: the log of "batched" is written once 1KB has
+#   accumulated, that of "synced" likewise but synced to disk, and that of
+#   "direct" as soon as possible.
+#
+test_expect_success 'setup' '
+    opts="b:64,m:10,n:10" &&
+    {
+        echo "console name=\"deferred\" dev=\"test:\"" \
+                "testopts=\"b:1,m:100,n:100\" logopts=\"flush=60s\"" &&
+        echo "console name=\"batched\" dev=\"test:\"" \
+                "testopts=\"${opts}\" logopts=\"flush=1k\"" &&
+        echo "console name=\"synced\" dev=\"test:\"" \
+                "testopts=\"${opts}\" logopts=\"flush=1k,sync\"" &&
+        echo "console name=\"direct\" dev=\"test:\"" \
+                "testopts=\"${opts}\" logopts=\"noflush\""
+    } >flush.conf &&
+    conmand_setup "$(cat flush.conf)"
+'
+
+# Start the daemon.
+#
+test_expect_success 'start conmand' '
+    conmand_start &&
+    sleep 1
+'
+
+# Verify the log deferred for a minute has not been written to yet.  It is
+#   sampled for a couple of seconds since the console only outputs 1 byte every
+#   100ms, which would otherwise be written out as it arrives.
+#
+test_expect_success 'check deferred log' '
+    sample_log_sizes deferred >sizes.deferred &&
+    test_debug "cat sizes.deferred" &&
+    test "$(wc -l <sizes.deferred)" -eq 1
+'
+
+# Verify the batched logs grow by at least 1KB at a time, whereas the direct
+#   log grows in smaller steps.
+#
+test_expect_success 'check batched logs' '
+    for console in batched synced direct; do
+        sample_log_sizes "${console}" |
+                awk "NR > 1 { print \$1 - n } { n = \$1 }" \
+                >"steps.${console}" || return 1
+    done &&
+    test_debug "head steps.*" &&
+    test "$(wc -l <steps.batched)" -gt 0 &&
+    test "$(wc -l <steps.synced)" -gt 0 &&
+    ! awk "\$1 < 1024 { exit 1 }" steps.direct &&
+    awk "\$1 < 1024 { exit 1 }" steps.batched &&
+    awk "\$1 < 1024 { exit 1 }" steps.synced
+'
+
+# Stop the daemon.
+#
+test_expect_success 'stop conmand' '
+    conmand_stop
+'
+
+# Verify the deferred output has been written out when the daemon stopped,
+#   and all of the logs are in order.
+#
+test_expect_success 'check logs after stopping' '
+    for console in deferred batched synced direct; do
+        check_test_console_data "$(console_log "${console}")" || return 1
+    done >counts &&
+    test_debug "cat counts" &&
+    test "$(head -n 1 counts)" -ge 20
+'
+
+# Check the logfile for errors.
+#
+test_expect_success 'check logfile for errors' '
+    ! grep -E -i "(EMERGENCY|ALERT|CRITICAL|ERROR):" "${CONMAND_LOGFILE}"
+'
+
+# Perform housekeeping to clean up afterwards.
+#
+test_expect_success 'cleanup' '
+    conmand_cleanup
+'
+
+test_done
@@ -0,0 +1,138 @@
+#!/bin/sh
+
+test_description="Check processing console output written to logs"
+
+: "${SHARNESS_TEST_SRCDIR:=$(cd "$(dirname "$0")" && pwd)}"
+. "${SHARNESS_TEST_SRCDIR}/sharness.sh"
+
+# Provide the log of the console named [console].
+#
+console_log()
+{
+    echo "${CONMAND_CONSOLE_GLOB}" | sed -e "s/\*/$1/"
+}
+
+# Output the console output written to the log of the console named [console]
+#   following the message noting its process was started.
+#
+log_data()
+{
+    sed -e "1,/<ConMan> Console \[$1\] connected to/d" "$(console_log "$1")"
+}
+
+# Create the console output: runs of printable chars around the lengths
+#   scanned at once, followed by a run of control chars that doubles in size
+#   when sanitized, control chars, DEL, chars with the high bit set, and the
+#   various line terminations.
+# Create a process console that outputs it once a second has passed.
+# Provide [GEN].
+#
+test_expect_success 'create process console' '
+    for n in 1 15 16 17 31 32 33 63 64 65 255 256 257 12000; do
+        awk "BEGIN { for (i = 0; i < ${n}; i++)
+                printf(\"%c\", 33 + i % 94); print \"\" }" || return 1
+    done >runs &&
+    awk "BEGIN { for (i = 0; i < 3000; i++) printf(\"%c\", 1); print \"\" }" \
+            >ctrls &&
+    {
+        cat runs ctrls &&
+        printf "a\\001b\\037c\\177d\\200e\\233f\\377g\\341h\\n" &&
+        printf "x\\r\\ny\\n\\rz\\r\\r\\nw\\r\\000v\\n\\n"
+    } >input &&
+    GEN=$(conmand_script gen <<-EOF
+	#!/bin/sh
+	sleep 1
+	cat "$(pwd)/input"
+	exec sleep 60
+	EOF
+    )
+'
+
+# Create the output expected in sanitized logs, where each line is terminated
+#   by CR/LF.
+#
+test_expect_success 'create expected output' '
+    {
+        cat runs &&
+        sed -e "s/\x01/^A/g" ctrls &&
+        echo "a^Ab^_c^?d~@e~[f~?g\`ah" &&
+        printf "x\\ny\\nz\\nw\\nv\\n\\n"
+    } | sed -e "s/\$/\r/" >sanitized.exp
+'
+
+# Set up the environment with 4 instances of the process console: the log of
+#   "raw" is written unchanged, that of "sanitized" is sanitized, that of
+#   "stamped" is both sanitized and timestamped, and that of "small" is
+#   sanitized within the smallest bufsize.
+#
+test_expect_success 'setup' '
+    conmand_setup \
+            "console name=\"raw\" dev=\"${GEN}\" logopts=\"nosanitize\"" \
+            "console name=\"sanitized\" dev=\"${GEN}\" logopts=\"sanitize\"" \
+            "console name=\"stamped\" dev=\"${GEN}\"" \
+            "console name=\"small\" dev=\"${GEN}\" bufsize=2048" &&
+    sed -i -e "/name=\"stamped\"/ s/\$/ logopts=\"sanitize,timestamp\"/" \
+            -e "/name=\"small\"/ s/\$/ logopts=\"sanitize\"/" \
+            "${CONMAND_CONFIG}"
+'
+
+# Start the daemon and let the process consoles output their data.
+#
+test_expect_success 'start conmand' '
+    conmand_start &&
+    sleep 3
+'
+
+# Verify the output of the process console has been logged unchanged.
+#
+test_expect_success 'check raw log' '
+    log_data raw >raw.out &&
+    test_cmp input raw.out
+'
+
+# Verify the output of the process console has been sanitized.
+#
+test_expect_success 'check sanitized log' '
+    log_data sanitized >sanitized.out &&
+    test_cmp sanitized.exp sanitized.out
+'
+
+# Verify the output of the process console has been sanitized without
+#   overrunning the circular-buf of a logfile with the smallest bufsize.
+#
+test_expect_success 'check sanitized log with small bufsize' '
+    log_data small >small.out &&
+    test_cmp sanitized.exp small.out &&
+    ! grep "Overwrote" "${CONMAND_LOGFILE}"
+'
+
+# Verify the output of the process console has been sanitized, and each line
+#   has been timestamped.
+#
+test_expect_success 'check timestamped log' '
+    log_data stamped >stamped.out &&
+    ! grep -v "^[0-9]\{4\}-[0-9]\{2\}-[0-9]\{2\} [0-9:]\{8\} " stamped.out &&
+    sed -e "s/^[0-9]\{4\}-[0-9]\{2\}-[0-9]\{2\} [0-9:]\{8\} //" \
+            stamped.out >stamped.lines &&
+    test_cmp sanitized.exp stamped.lines
+'
+
+# Stop the daemon.
+#
+test_expect_success 'stop conmand' '
+    conmand_stop
+'
+
+# Check the logfile for errors.
+#
+test_expect_success 'check logfile for errors' '
+    ! grep -E -i "(EMERGENCY|ALERT|CRITICAL|ERROR):" "${CONMAND_LOGFILE}"
+'
+
+# Perform housekeeping to clean up afterwards.
+#
+test_expect_success 'cleanup' '
+    conmand_cleanup
+'
+
+test_done
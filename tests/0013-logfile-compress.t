@@ -0,0 +1,89 @@
+#!/bin/sh
+
+test_description="Check compressed console logs"
+
+: "${SHARNESS_TEST_SRCDIR:=$(cd "$(dirname "$0")" && pwd)}"
+. "${SHARNESS_TEST_SRCDIR}/sharness.sh"
+
+# Compressed logs require conmand to have been built with zlib.
+#
+if "${CONMAND}" -V | grep ZLIB >/dev/null; then :; else
+    skip_all='skipping compress test; conmand not built with zlib'
+    test_done
+fi
+
+# Ensure the gzip executable is available to decompress the logs.
+#
+if command -v gzip >/dev/null 2>&1; then :; else
+    skip_all='skipping compress test; gzip not installed'
+    test_done
+fi
+
+# Set up the environment with compressed console logs starting a new frame
+#   every second.
+#
+test_expect_success 'setup' '
+    conmand_setup "global logopts=\"compress=gzip,frame=1\""
+'
+
+# Start the daemon.
+#
+test_expect_success 'start conmand' '
+    conmand_start
+'
+
+# Let the test consoles write their logs over several frames.
+#
+test_expect_success 'wait for console output' '
+    sleep 3
+'
+
+# Stop the daemon, thereby ending the current frame of each log.
+#
+test_expect_success 'stop conmand' '
+    conmand_stop
+'
+
+# Verify the console logs are valid gzip files.
+#
+test_expect_success 'check console logs are compressed' '
+    ls -l ${CONMAND_CONSOLE_GLOB} &&
+    for f in ${CONMAND_CONSOLE_GLOB}; do gzip -t "$f" || return 1; done
+'
+
+# Verify each decompressed log starts with the message noting it was opened
+#   and contains the console output that followed.
+#
+test_expect_success 'check decompressed log content' '
+    for f in ${CONMAND_CONSOLE_GLOB}; do
+        gzip -dc "$f" >out.$$ &&
+        head -n 2 out.$$ | grep "Console \[test[12]\] log opened" &&
+        test "$(wc -c <out.$$)" -gt 100 || return 1
+    done
+'
+
+# Verify each log has been written as a series of gzip members (one per frame)
+#   by counting the gzip headers therein.
+#
+test_expect_success 'check console logs are framed' '
+    magic=$(printf "\037\213\010") &&
+    for f in ${CONMAND_CONSOLE_GLOB}; do
+        n=$(LC_ALL=C grep -a -o "${magic}" "$f" | wc -l) &&
+        test_debug "echo \"$f: $n frames\"" &&
+        test "$n" -ge 2 || return 1
+    done
+'
+
+# Check the logfile for errors.
+#
+test_expect_success 'check logfile for errors' '
+    ! grep -E -i "(EMERGENCY|ALERT|CRITICAL|ERROR):" "${CONMAND_LOGFILE}"
+'
+
+# Perform housekeeping to clean up afterwards.
+#
+test_expect_success 'cleanup' '
+    conmand_cleanup
+'
+
+test_done
@@ -0,0 +1,134 @@
+#!/bin/sh
+
+test_description="Check size-limited console logs"
+
+: "${SHARNESS_TEST_SRCDIR:=$(cd "$(dirname "$0")" && pwd)}"
+. "${SHARNESS_TEST_SRCDIR}/sharness.sh"
+
+# Compressed logs require conmand to have been built with zlib, and the gzip
+#   executable to decompress them.
+#
+if "${CONMAND}" -V | grep ZLIB >/dev/null \
+        && command -v gzip >/dev/null 2>&1; then
+    test_set_prereq ZLIB
+fi
+
+# Set up the environment with test consoles that output 10KB/s into logs that
+#   are rotated at 2KB, keeping 2 rotated logs.
+#
+test_expect_success 'setup' '
+    conmand_setup \
+            "global testopts=\"b:100,m:10,n:10,p:100\"" \
+            "global logopts=\"maxsize=2k,keep=2\""
+'
+
+# Start the daemon and let the consoles fill several logs.
+#
+test_expect_success 'start conmand' '
+    conmand_start &&
+    sleep 2
+'
+
+# Stop the daemon.
+#
+test_expect_success 'stop conmand' '
+    conmand_stop
+'
+
+# Verify the daemon logged the rotations.
+#
+test_expect_success 'check logfile for rotation' '
+    grep "Rotating logfile" "${CONMAND_LOGFILE}"
+'
+
+# Verify each console log has been rotated into 2 logs with the ".1" and ".2"
+#   suffixes, and the oldest logs were removed.
+#
+test_expect_success 'check rotated log names and count' '
+    ls -l ${CONMAND_CONSOLE_GLOB}* &&
+    for f in ${CONMAND_CONSOLE_GLOB}; do
+        test -s "$f.1" &&
+        test -s "$f.2" &&
+        test ! -e "$f.3" &&
+        test "$(ls "$f".* | wc -l)" -eq 2 || return 1
+    done
+'
+
+# Verify each rotated log reached the size limit before being rotated.
+#
+test_expect_success 'check rotated log sizes' '
+    for f in ${CONMAND_CONSOLE_GLOB}; do
+        for n in 1 2; do
+            test "$(wc -c <"$f.$n")" -ge 2048 || return 1
+        done
+    done
+'
+
+# Check the logfile for errors.
+#
+test_expect_success 'check logfile for errors' '
+    ! grep -E -i "(EMERGENCY|ALERT|CRITICAL|ERROR):" "${CONMAND_LOGFILE}"
+'
+
+# Clean up before restarting the daemon with compressed logs.
+#
+test_expect_success 'cleanup' '
+    conmand_cleanup
+'
+
+# Set up the environment as before, but with compressed logs keeping only
+#   1 rotated log.  The size limit applies to the data before compression.
+#
+test_expect_success ZLIB 'setup compressed logs' '
+    conmand_setup \
+            "global testopts=\"b:100,m:10,n:10,p:100\"" \
+            "global logopts=\"compress=gzip,maxsize=2k,keep=1\""
+'
+
+# Start the daemon and let the consoles fill several logs.
+#
+test_expect_success ZLIB 'start conmand' '
+    conmand_start &&
+    sleep 2
+'
+
+# Stop the daemon.
+#
+test_expect_success ZLIB 'stop conmand' '
+    conmand_stop
+'
+
+# Verify each compressed console log has been rotated into 1 log.
+#
+test_expect_success ZLIB 'check rotated compressed log names and count' '
+    ls -l ${CONMAND_CONSOLE_GLOB}* &&
+    for f in ${CONMAND_CONSOLE_GLOB}; do
+        test -s "$f.1" &&
+        test ! -e "$f.2" &&
+        test "$(ls "$f".* | wc -l)" -eq 1 || return 1
+    done
+'
+
+# Verify each rotated log was rotated once its decompressed data (rather than
+#   its compressed size) reached the size limit.
+#
+test_expect_success ZLIB 'check rotated compressed log sizes' '
+    for f in ${CONMAND_CONSOLE_GLOB}; do
+        test "$(gzip -dc "$f.1" | wc -c)" -ge 2048 &&
+        test "$(wc -c <"$f.1")" -lt 2048 || return 1
+    done
+'
+
+# Check the logfile for errors.
+#
+test_expect_success ZLIB 'check logfile for errors' '
+    ! grep -E -i "(EMERGENCY|ALERT|CRITICAL|ERROR):" "${CONMAND_LOGFILE}"
+'
+
+# Perform housekeeping to clean up afterwards.
+#
+test_expect_success 'cleanup' '
+    conmand_cleanup
+'
+
+test_done
@@ -0,0 +1,140 @@
+#!/bin/sh
+
+test_description="Check console log time indexes"
+
+: "${SHARNESS_TEST_SRCDIR:=$(cd "$(dirname "$0")" && pwd)}"
+. "${SHARNESS_TEST_SRCDIR}/sharness.sh"
+
+# Compressed logs require conmand to have been built with zlib.
+#
+if "${CONMAND}" -V | grep ZLIB >/dev/null; then
+    test_set_prereq ZLIB
+fi
+
+# Check the time index [idx] of the log [log] written between the times [t0]
+#   and [t1].  Each entry must be a 32-byte line of a 10-digit time and
+#   a 20-digit offset.  Times must be increasing and within [t0, t1], and
+#   offsets must be non-decreasing and within the log.  The first entry must
+#   be for the start of the log.
+#
+check_index()
+{
+    local idx log t0 t1 size
+    idx=$1 log=$2 t0=$3 t1=$4
+    size=$(wc -c <"${log}")
+    test_debug "echo \"${idx}:\"; cat \"${idx}\""
+    test -s "${idx}" &&
+    test "$(($(wc -c <"${idx}") % 32))" -eq 0 &&
+    awk -v size="${size}" -v t0="${t0}" -v t1="${t1}" '
+        NF != 2 || length($1) != 10 || length($2) != 20 { exit 1 }
+        $1 !~ /^[0-9]+$/ || $2 !~ /^[0-9]+$/ { exit 1 }
+        $1 + 0 < t0 + 0 || $1 + 0 > t1 + 0 || $2 + 0 >= size + 0 { exit 1 }
+        NR == 1 && $2 + 0 != 0 { exit 1 }
+        NR > 1 && ($1 + 0 <= t + 0 || $2 + 0 < o + 0) { exit 1 }
+        { t = $1; o = $2 }
+    ' "${idx}"
+}
+
+# Set up the environment with test consoles that output 10KB/s into logs that
+#   are indexed every second and rotated at 16KB, keeping 1 rotated log.
+#
+test_expect_success 'setup' '
+    conmand_setup \
+            "global testopts=\"b:100,m:10,n:10,p:100\"" \
+            "global logopts=\"index=1,maxsize=16k,keep=1\""
+'
+
+# Start the daemon and let the consoles fill more than one log.
+#
+test_expect_success 'start conmand' '
+    T0=$(date +%s) &&
+    conmand_start &&
+    sleep 3
+'
+
+# Stop the daemon.
+#
+test_expect_success 'stop conmand' '
+    conmand_stop &&
+    T1=$(date +%s)
+'
+
+# Verify each console log and its rotated log has a valid time index.
+#
+test_expect_success 'check time indexes' '
+    ls -l ${CONMAND_CONSOLE_GLOB}* &&
+    for f in ${CONMAND_CONSOLE_GLOB}; do
+        check_index "$f.idx" "$f" "${T0}" "${T1}" &&
+        check_index "$f.1.idx" "$f.1" "${T0}" "${T1}" || return 1
+    done
+'
+
+# Verify the indexes have entries for more than one interval.
+#
+test_expect_success 'check time index entry count' '
+    for f in ${CONMAND_CONSOLE_GLOB}; do
+        test "$(cat "$f.idx" "$f.1.idx" | wc -l)" -ge 3 || return 1
+    done
+'
+
+# Check the logfile for errors.
+#
+test_expect_success 'check logfile for errors' '
+    ! grep -E -i "(EMERGENCY|ALERT|CRITICAL|ERROR):" "${CONMAND_LOGFILE}"
+'
+
+# Clean up before restarting the daemon with compressed logs.
+#
+test_expect_success 'cleanup' '
+    conmand_cleanup
+'
+
+# Set up the environment with compressed logs starting a new frame every
+#   second, each of which is indexed.
+#
+test_expect_success ZLIB 'setup compressed logs' '
+    conmand_setup "global logopts=\"compress=gzip,frame=1,index\""
+'
+
+# Start the daemon and let the consoles write their logs over several frames.
+#
+test_expect_success ZLIB 'start conmand' '
+    T0=$(date +%s) &&
+    conmand_start &&
+    sleep 3
+'
+
+# Stop the daemon.
+#
+test_expect_success ZLIB 'stop conmand' '
+    conmand_stop &&
+    T1=$(date +%s)
+'
+
+# Verify each compressed console log has a valid time index with an entry
+#   for each frame, each of which must start with a gzip header.
+#
+test_expect_success ZLIB 'check compressed time indexes' '
+    for f in ${CONMAND_CONSOLE_GLOB}; do
+        check_index "$f.idx" "$f" "${T0}" "${T1}" &&
+        test "$(wc -l <"$f.idx")" -ge 2 || return 1
+        for off in $(awk "{ print \$2 + 0 }" "$f.idx"); do
+            test "$(tail -c +$((off + 1)) "$f" | head -c 3 | od -An -tx1 |
+                    tr -d " \n")" = 1f8b08 || return 1
+        done
+    done
+'
+
+# Check the logfile for errors.
+#
+test_expect_success ZLIB 'check logfile for errors' '
+    ! grep -E -i "(EMERGENCY|ALERT|CRITICAL|ERROR):" "${CONMAND_LOGFILE}"
+'
+
+# Perform housekeeping to clean up afterwards.
+#
+test_expect_success 'cleanup' '
+    conmand_cleanup
+'
+
+test_done
@@ -0,0 +1,198 @@
+#!/bin/sh
+
+test_description="Check replaying console logs from disk"
+
+: "${SHARNESS_TEST_SRCDIR:=$(cd "$(dirname "$0")" && pwd)}"
+. "${SHARNESS_TEST_SRCDIR}/sharness.sh"
+
+# The client requires a terminal (cf. conman_client()).
+#
+if ! test_have_prereq SCRIPT; then
+    skip_all='skipping replay test; util-linux script not installed'
+    test_done
+fi
+
+# Compressed logs require conmand to have been built with zlib, and the gzip
+#   executable to decompress them.
+#
+if "${CONMAND}" -V | grep ZLIB >/dev/null \
+        && command -v gzip >/dev/null 2>&1; then
+    test_set_prereq ZLIB
+fi
+
+# Provide the log of the console named [console].
+#
+console_log()
+{
+    echo "${CONMAND_CONSOLE_GLOB}" | sed -e "s/\*/$1/"
+}
+
+# Replay the log of the console named [console] as specified by [spec] via
+#   the client in monitor mode, writing the client's output to [file].
+#   The session is closed by the client's escape sequence once the replay has
+#   had time to finish.
+#
+conman_replay()
+{
+    (sleep 1; printf "&.") | conman_client -R "$2" -m "$1" >"$3" 2>&1
+    test_debug "cat \"$3\""
+}
+
+# Extract the replayed log data between the messages marking the beginning
+#   and end of the replay from the client's output in [file], removing the
+#   carriage-returns and the newline preceding the end message.
+#
+replay_body()
+{
+    tr -d "\r" <"$1" |
+    sed -n -e "/Begin log replay of console/,/End log replay of console/p" |
+    sed -e "1d" -e "\$d" | sed -e "\$d"
+}
+
+# Create a process console that outputs 50 lines, then another 50 lines
+#   2 seconds later.
+# Provide [GEN].
+#
+test_expect_success 'create process console' '
+    GEN=$(conmand_script gen <<-EOF
+	#!/bin/sh
+	awk "BEGIN { for (i = 1; i <= 50; i++) print \"line-\" i }"
+	sleep 2
+	awk "BEGIN { for (i = 51; i <= 100; i++) print \"line-\" i }"
+	exec sleep 60
+	EOF
+    ) &&
+    awk "BEGIN { for (i = 1; i <= 100; i++) print \"line-\" i }" >lines.exp &&
+    awk "BEGIN { for (i = 96; i <= 100; i++) print \"line-\" i }" >last5.exp
+'
+
+# Set up the environment with the process console logged in 3 ways:
+#   "lines" is indexed every second, "deferred" has its writes deferred for
+#   a minute, and "zipped" (if zlib is available) is compressed and indexed.
+#
+test_expect_success 'setup' '
+    conmand_setup \
+            "console name=\"lines\" dev=\"${GEN}\" logopts=\"index=1\"" \
+            "console name=\"deferred\" dev=\"${GEN}\" logopts=\"flush=60s\"" &&
+    if test_have_prereq ZLIB; then
+        sed -i -e "/^console name=\"deferred\"/a\\
+console name=\"zipped\" dev=\"${GEN}\" logopts=\"compress=gzip,frame=1,index=1\"" \
+                "${CONMAND_CONFIG}"
+    fi
+'
+
+# Start the daemon and let the process consoles output all of their lines.
+#
+test_expect_success 'start conmand' '
+    conmand_start &&
+    sleep 3
+'
+
+# Replay the last 5 lines.
+#
+test_expect_success 'replay last lines' '
+    conman_replay lines 5l out.lines &&
+    replay_body out.lines >body.lines &&
+    test_cmp last5.exp body.lines
+'
+
+# Replay the number of bytes in the last 2 lines.
+#
+test_expect_success 'replay last bytes' '
+    n=$(tail -n 2 "$(console_log lines)" | wc -c) &&
+    conman_replay lines "${n}" out.bytes &&
+    replay_body out.bytes >body.bytes &&
+    printf "line-99\nline-100\n" >bytes.exp &&
+    test_cmp bytes.exp body.bytes
+'
+
+# Replay the entire log.
+#
+test_expect_success 'replay entire log' '
+    conman_replay lines @0 out.all &&
+    replay_body out.all >body.all &&
+    tr -d "\r" <"$(console_log lines)" >all.exp &&
+    test_cmp all.exp body.all &&
+    grep "^line-" body.all >body.all.lines &&
+    test_cmp lines.exp body.all.lines
+'
+
+# Replay the log since the time of its last index entry, which must start at
+#   the offset of that entry.
+#
+test_expect_success 'replay log since a given time' '
+    log=$(console_log lines) &&
+    t=$(tail -n 1 "${log}.idx" | awk "{ print \$1 + 0 }") &&
+    off=$(tail -n 1 "${log}.idx" | awk "{ print \$2 + 0 }") &&
+    conman_replay lines "@${t}" out.time &&
+    replay_body out.time >body.time &&
+    tail -c +$((off + 1)) "${log}" | tr -d "\r" >time.exp &&
+    test_cmp time.exp body.time &&
+    grep "^line-100\$" body.time
+'
+
+# Replay the last 5 lines of the log whose writes are deferred, which have
+#   yet to be written out when the replay starts.
+#
+test_expect_success 'replay deferred log data' '
+    ! grep "^line-" "$(console_log deferred)" &&
+    conman_replay deferred 5l out.deferred &&
+    replay_body out.deferred >body.deferred &&
+    test_cmp last5.exp body.deferred
+'
+
+# Replay the entire compressed log.
+# Since its current frame has yet to end, gzip will complain of the truncated
+#   data once it has decompressed the rest.
+#
+test_expect_success ZLIB 'replay entire compressed log' '
+    conman_replay zipped @0 out.zipped &&
+    replay_body out.zipped >body.zipped &&
+    gzip -dc "$(console_log zipped)" 2>/dev/null | tr -d "\r" >zipped.exp &&
+    test_cmp zipped.exp body.zipped &&
+    grep "^line-" body.zipped >body.zipped.lines &&
+    test_cmp lines.exp body.zipped.lines
+'
+
+# Replay the compressed log since the time of its last index entry, which must
+#   start with the frame at the offset of that entry.
+#
+test_expect_success ZLIB 'replay compressed log since a given time' '
+    log=$(console_log zipped) &&
+    t=$(tail -n 1 "${log}.idx" | awk "{ print \$1 + 0 }") &&
+    off=$(tail -n 1 "${log}.idx" | awk "{ print \$2 + 0 }") &&
+    conman_replay zipped "@${t}" out.ztime &&
+    replay_body out.ztime >body.ztime &&
+    tail -c +$((off + 1)) "${log}" | gzip -dc 2>/dev/null |
+            tr -d "\r" >ztime.exp &&
+    test_cmp ztime.exp body.ztime &&
+    grep "^line-100\$" body.ztime
+'
+
+# Verify replaying the last lines of a compressed log is refused.
+#
+test_expect_success ZLIB 'replay compressed log lines fails' '
+    conman_replay zipped 5l out.zlines &&
+    grep "compressed logs can only be replayed since a given time" out.zlines &&
+    ! grep "Begin log replay" out.zlines
+'
+
+# Stop the daemon.
+#
+test_expect_success 'stop conmand' '
+    conmand_stop
+'
+
+# Check the logfile for errors.
+#
+test_expect_success 'check logfile for errors' '
+    ! grep -E -i "(EMERGENCY|ALERT|CRITICAL|ERROR):" "${CONMAND_LOGFILE}"
+'
+
+# Perform housekeeping to clean up afterwards.
+#
+test_expect_success 'cleanup' '
+    conmand_cleanup
+'
+
+test_done
@@ -0,0 +1,105 @@
+#!/bin/sh
+#
+# Benchmark for batching console logfile writes via the "flush" logopt.
+#
+# Usage: bench-flush.sh [-c consoles] [-f flush] [-s secs] [builddir]
+#
+# Runs conmand with the given number of test consoles (default: 256) that
+#   each trickle a few bytes of output every 10-20ms, first with "noflush"
+#   and then with the given "flush" logopt value (default: 1s).  For each run,
+#   measures the number of write system calls made by conmand per second
+#   (from /proc/<pid>/io) along with the rate at which data is written to the
+#   console logfiles and the CPU time consumed over the given number of
+#   seconds (default: 5).  Output deferred at the end of a run is flushed
+#   when conmand exits, so it is not counted here.
+# The builddir defaults to the parent of the directory containing this script.
+
+consoles=256
+flush=1s
+secs=5
+
+while getopts "c:f:s:" opt; do
+    case "${opt}" in
+        c) consoles="${OPTARG}" ;;
+        f) flush="${OPTARG}" ;;
+        s) secs="${OPTARG}" ;;
+        *) echo "Usage: $0 [-c consoles] [-f flush] [-s secs] [builddir]" >&2
+           exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+builddir="${1:-"$(cd "$(dirname "$0")/.." && pwd)"}"
+conmand="${builddir}/conmand"
+if test ! -x "${conmand}"; then
+    echo "ERROR: ConMan has not been built: ${conmand} not found." >&2
+    exit 1
+fi
+tmpdir=$(mktemp -d "${TMPDIR:-"/tmp"}/bench-flush.XXXXXX") || exit 1
+trap 'rm -rf "${tmpdir}"' EXIT
+clk_tck=$(getconf CLK_TCK)
+
+# Print the CPU time (in clock ticks) consumed by process [$1].
+#
+cpu_ticks()
+{
+    sed -e 's/.*) //' "/proc/$1/stat" | awk '{ print $12 + $13 }'
+}
+
+# Print the number of write system calls made by process [$1].
+#
+write_calls()
+{
+    sed -n -e 's/^syscw: //p' "/proc/$1/io"
+}
+
+# Print the total size (in bytes) of the console logfiles.
+#
+log_bytes()
+{
+    cat "${tmpdir}"/console.*.log | wc -c
+}
+
+printf "%-12s %8s %12s %10s %12s\n" \
+    "logopts" "consoles" "writes/sec" "log (KB/s)" "cpu (%)"
+
+for logopts in noflush "flush=${flush}"; do
+    rm -f "${tmpdir}"/*
+    cat > "${tmpdir}/conmand.conf" <<-EOF
+	server logfile="${tmpdir}/conmand.log"
+	server pidfile="${tmpdir}/conmand.pid"
+	server loopback=on
+	server port=0
+	global log="${tmpdir}/console.%N.log"
+	global logopts="${logopts}"
+	global testopts="b:64,m:20,n:10,p:100"
+	EOF
+    i=1
+    while test "${i}" -le "${consoles}"; do
+        echo "console name=\"test${i}\" dev=\"test:\"" \
+            >> "${tmpdir}/conmand.conf"
+        i=$((i + 1))
+    done
+
+    "${conmand}" -c "${tmpdir}/conmand.conf" || exit 1
+    pid=$(cat "${tmpdir}/conmand.pid")
+    sleep 1
+    b0=$(log_bytes)
+    c0=$(cpu_ticks "${pid}")
+    w0=$(write_calls "${pid}")
+    sleep "${secs}"
+    b1=$(log_bytes)
+    c1=$(cpu_ticks "${pid}")
+    w1=$(write_calls "${pid}")
+    "${conmand}" -c "${tmpdir}/conmand.conf" -k
+    while kill -0 "${pid}" 2>/dev/null; do
+        sleep 0.1
+    done
+
+    awk -v o="${logopts}" -v n="${consoles}" -v w="$((w1 - w0))" \
+            -v b="$((b1 - b0))" -v c="$((c1 - c0))" -v s="${secs}" \
+            -v hz="${clk_tck}" 'BEGIN {
+        printf "%-12s %8d %12.0f %10.1f %12.1f\n", o, n, w / s,
+            b / 1024 / s, 100 * c / hz / s;
+    }'
+done
@@ -0,0 +1,107 @@
+#!/bin/sh
+#
+# Benchmark for console logfile throughput with and without io_uring.
+#
+# Usage: bench-io.sh [-c consoles] [-s secs] [-t threads] [builddir]
+#
+# For each I/O engine (read/writev, then io_uring), runs conmand with the
+#   given number of test consoles (default: 16) that continuously output data
+#   as fast as they are scheduled, and measures the rate at which that data is
+#   written to the console logfiles over the given number of seconds
+#   (default: 5).  The CPU time consumed by conmand is reported as well since
+#   batching I/O via io_uring primarily reduces the number of system calls.
+# If io_uring is not supported, conmand falls back to read/writev and logs
+#   a warning; that run is then reported as "fallback".
+# The builddir defaults to the parent of the directory containing this script.
+
+consoles=16
+secs=5
+threads=1
+
+while getopts "c:s:t:" opt; do
+    case "${opt}" in
+        c) consoles="${OPTARG}" ;;
+        s) secs="${OPTARG}" ;;
+        t) threads="${OPTARG}" ;;
+        *) echo "Usage: $0 [-c consoles] [-s secs] [-t threads] [builddir]" >&2
+           exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+builddir="${1:-"$(cd "$(dirname "$0")/.." && pwd)"}"
+conmand="${builddir}/conmand"
+if test ! -x "${conmand}"; then
+    echo "ERROR: ConMan has not been built: ${conmand} not found." >&2
+    exit 1
+fi
+tmpdir=$(mktemp -d "${TMPDIR:-"/tmp"}/bench-io.XXXXXX") || exit 1
+trap 'rm -rf "${tmpdir}"' EXIT
+clk_tck=$(getconf CLK_TCK)
+
+# Print the CPU time (in clock ticks) consumed by process [$1].
+#
+cpu_ticks()
+{
+    sed -e 's/.*) //' "/proc/$1/stat" | awk '{ print $12 + $13 }'
+}
+
+# Print the total size (in bytes) of the console logfiles.
+#
+log_bytes()
+{
+    cat "${tmpdir}"/console.*.log | wc -c
+}
+
+printf "%-11s %8s %8s %12s %10s %14s\n" \
+    "engine" "consoles" "threads" "log (MB/s)" "cpu (%)" "MB per cpu-sec"
+
+for iouring in off on; do
+    rm -f "${tmpdir}"/*
+    cat > "${tmpdir}/conmand.conf" <<-EOF
+	server logfile="${tmpdir}/conmand.log"
+	server pidfile="${tmpdir}/conmand.pid"
+	server loopback=on
+	server port=0
+	server iouring=${iouring}
+	server threads=${threads}
+	global log="${tmpdir}/console.%N.log"
+	global testopts="b:2000000000,m:0,n:0,p:100"
+	EOF
+    i=1
+    while test "${i}" -le "${consoles}"; do
+        echo "console name=\"test${i}\" dev=\"test:\"" \
+            >> "${tmpdir}/conmand.conf"
+        i=$((i + 1))
+    done
+
+    "${conmand}" -c "${tmpdir}/conmand.conf" || exit 1
+    pid=$(cat "${tmpdir}/conmand.pid")
+    sleep 1
+    b0=$(log_bytes)
+    c0=$(cpu_ticks "${pid}")
+    sleep "${secs}"
+    b1=$(log_bytes)
+    c1=$(cpu_ticks "${pid}")
+    "${conmand}" -c "${tmpdir}/conmand.conf" -k
+    while kill -0 "${pid}" 2>/dev/null; do
+        sleep 0.1
+    done
+
+    engine="read/writev"
+    if test "${iouring}" = on; then
+        if grep "Unable to use io_uring" "${tmpdir}/conmand.log" >/dev/null
+        then
+            engine="fallback"
+        else
+            engine="io_uring"
+        fi
+    fi
+    awk -v e="${engine}" -v n="${consoles}" -v t="${threads}" \
+            -v b="$((b1 - b0))" -v c="$((c1 - c0))" -v s="${secs}" \
+            -v hz="${clk_tck}" 'BEGIN {
+        mb = b / 1048576; cpu = c / hz;
+        printf "%-11s %8d %8d %12.1f %10.1f %14.1f\n", e, n, t, mb / s,
+            100 * cpu / s, (cpu > 0) ? mb / cpu : 0;
+    }'
+done
@@ -0,0 +1,414 @@
+/*****************************************************************************
+ *  Written by Chris Dunlap <cdunlap@llnl.gov>.
+ *  Copyright (C) 2007-2023 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2001-2007 The Regents of the University of California.
+ *  UCRL-CODE-2002-009.
+ *
+ *  This file is part of ConMan: The Console Manager.
+ *  For details, see <https://dun.github.io/conman/>.
+ *
+ *  ConMan is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  ConMan is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with ConMan.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************
+ *  Benchmark for processing console output written to sanitized logfiles.
+ *
+ *  Usage: bench-logscan [-f file] [-m megabytes] [-t]
+ *
+ *  Processes the specified amount of console output (default: 256 MB) in
+ *    4 KB reads through the newline state machine and sanitizer used by
+ *    write_log_data(), first one char at a time and then with runs of
+ *    printable chars located via span_printable_string() and copied in bulk.
+ *    Both outputs are compared to ensure they are identical.
+ *  If timestamps are enabled (-t), each line is timestamped as well and the
+ *    runs instead compare formatting each timestamp via localtime_r() and
+ *    strftime() against copying it from the per-second cache maintained by
+ *    write_time_string().
+ *  The console output is generated for several typical boot-log corpora
+ *    (kernel messages, systemd status lines with ANSI color sequences, and
+ *    firmware setup screens dominated by cursor-positioning sequences),
+ *    or is read from the specified file (eg, a saved console log).
+ *  The throughput is reported in bytes per CPU cycle on x86 (via the TSC),
+ *    and in bytes per nanosecond elsewhere.
+ *****************************************************************************/
+
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+#  define BENCH_UNIT "B/cycle"
+#else  /* !x86 */
+#  define BENCH_UNIT "B/ns"
+#endif /* !x86 */
+#include "log.h"
+#include "util-str.h"
+
+
+#define READ_LEN 4096
+#define MAX_EXPANSION 24                /* max output bytes per input byte */
+
+#define PROC_SCAN       0x01            /* copy printable runs in bulk     */
+#define PROC_TIMESTAMP  0x02            /* timestamp each line             */
+#define PROC_CACHED     0x04            /* copy timestamps from the cache  */
+
+enum line_state { LINE_INIT, LINE_DATA, LINE_CR, LINE_LF };
+
+static unsigned char * create_corpus (const char *type, size_t len);
+static unsigned char * read_corpus (const char *file, size_t *lenp);
+static size_t process (unsigned char *dst, const unsigned char *src,
+    size_t len, int *statep, int flags);
+static int put_time (unsigned char *dst, int flags);
+static void verify (const unsigned char *src, size_t len);
+static double bench (const unsigned char *src, size_t len, size_t total,
+    unsigned char *dst, int flags);
+static double get_ticks (void);
+
+
+int
+main (int argc, char *argv[])
+{
+    const char *types[] = { "kernel", "systemd", "firmware", NULL };
+    const char *file = NULL;
+    size_t total = 256;
+    unsigned char *src;
+    unsigned char *dst;
+    size_t len;
+    int flags0 = 0;
+    int flags1 = PROC_SCAN;
+    double t0, t1;
+    int c;
+    int i;
+
+    log_set_file (stderr, LOG_WARNING, 0);
+
+    while ((c = getopt (argc, argv, "f:m:t")) != -1) {
+        switch (c) {
+        case 'f':
+            file = optarg;
+            break;
+        case 'm':
+            total = strtoul (optarg, NULL, 10);
+            break;
+        case 't':
+            flags0 = PROC_SCAN | PROC_TIMESTAMP;
+            flags1 = PROC_SCAN | PROC_TIMESTAMP | PROC_CACHED;
+            break;
+        default:
+            fprintf (stderr, "Usage: %s [-f file] [-m megabytes] [-t]\n",
+                argv[0]);
+            exit (1);
+        }
+    }
+    if (total == 0) {
+        log_err (0, "Invalid number of megabytes");
+    }
+    total *= 1024 * 1024;
+
+    if (!(dst = malloc (READ_LEN * MAX_EXPANSION))) {
+        log_err (0, "Out of memory");
+    }
+    printf ("%-10s %12s %12s %8s\n", "corpus",
+        (flags0 & PROC_TIMESTAMP) ? "strftime" : "bytewise",
+        (flags1 & PROC_CACHED) ? "cached" : "scan", "speedup");
+    printf ("%-10s %12s %12s %8s\n", "", BENCH_UNIT, BENCH_UNIT, "");
+
+    for (i = 0; file || types[ i ]; i++) {
+        if (file) {
+            src = read_corpus (file, &len);
+        }
+        else {
+            len = 1024 * 1024;
+            src = create_corpus (types[ i ], len);
+        }
+        verify (src, len);
+        t0 = bench (src, len, total, dst, flags0);
+        t1 = bench (src, len, total, dst, flags1);
+        printf ("%-10s %12.3f %12.3f %7.1fx\n", file ? "file" : types[ i ],
+            total / t0, total / t1, t0 / t1);
+        free (src);
+        if (file) {
+            break;
+        }
+    }
+    free (dst);
+    exit (0);
+}
+
+
+static unsigned char *
+create_corpus (const char *type, size_t len)
+{
+/*  Creates a buffer of [len] bytes of console output of the given [type].
+ */
+    static const char *units[] = { "network", "udev", "journald", "sshd",
+        "NetworkManager", "systemd-logind", "chronyd", "Load Kernel Modules" };
+    static const char *drivers[] = { "pci 0000:00:1f.2", "ACPI", "usb 1-1",
+        "e1000e 0000:00:19.0 eth0", "EXT4-fs (sda1)", "ata1.00", "nvme0n1" };
+    unsigned char *buf;
+    char line[512];
+    size_t n = 0;
+    int k;
+    int m;
+
+    if (!(buf = malloc (len))) {
+        log_err (0, "Out of memory");
+    }
+    srandom (1);
+    for (k = 0; n < len; k++) {
+        if (!strcmp (type, "kernel")) {
+            m = snprintf (line, sizeof (line),
+                "[%5d.%06ld] %s: %s %d at 0x%08lx (%ld MB)\r\n",
+                k / 100, random () % 1000000,
+                drivers[ random () % 7 ],
+                (random () % 2) ? "registered device" : "found controller",
+                (int) (random () % 16), random (), random () % 65536);
+        }
+        else if (!strcmp (type, "systemd")) {
+            m = snprintf (line, sizeof (line),
+                "[\033[0;32m  OK  \033[0m] %s \033[0;1;39m%s\033[0m.\r\n",
+                (random () % 2) ? "Started" : "Reached target",
+                units[ random () % 8 ]);
+        }
+        else {
+            m = snprintf (line, sizeof (line),
+                "\033[%d;%dH\033[1;37;44m%-20s\033[0m\033[%d;%dH%c %s",
+                (int) (random () % 24) + 1, (int) (random () % 40) + 1,
+                (random () % 2) ? "Boot Configuration" : "Memory Test",
+                (int) (random () % 24) + 1, (int) (random () % 40) + 41,
+                (random () % 2) ? 0x10 : '>',
+                (random () % 2) ? "Enabled" : "[Disabled]");
+        }
+        if ((size_t) m > len - n) {
+            m = len - n;
+        }
+        memcpy (buf + n, line, m);
+        n += m;
+    }
+    return (buf);
+}
+
+
+static unsigned char *
+read_corpus (const char *file, size_t *lenp)
+{
+/*  Reads the console output in [file] into a new buffer,
+ *    storing its length in [lenp].
+ */
+    FILE *fp;
+    unsigned char *buf;
+    long len;
+
+    if (!(fp = fopen (file, "r"))) {
+        log_err (errno, "Unable to open \"%s\"", file);
+    }
+    if ((fseek (fp, 0, SEEK_END) < 0) || ((len = ftell (fp)) <= 0)) {
+        log_err (0, "Unable to determine size of \"%s\"", file);
+    }
+    rewind (fp);
+    if (!(buf = malloc (len))) {
+        log_err (0, "Out of memory");
+    }
+    if (fread (buf, 1, len, fp) != (size_t) len) {
+        log_err (0, "Unable to read \"%s\"", file);
+    }
+    (void) fclose (fp);
+    *lenp = len;
+    return (buf);
+}
+
+
+static size_t
+process (unsigned char *dst, const unsigned char *src, size_t len,
+    int *statep, int flags)
+{
+/*  Processes [len] bytes of console output in [src] into [dst] as done by
+ *    write_log_data() for a sanitized logfile, using the newline state in
+ *    [statep].  If PROC_SCAN is set in [flags], runs of printable chars are
+ *    located via span_printable_string() and copied in bulk.  If
+ *    PROC_TIMESTAMP is set, each line is timestamped (cf. put_time()).
+ *  Returns the number of bytes written into [dst].
+ */
+    const unsigned char *p;
+    unsigned char *q;
+    size_t m;
+    int c;
+
+    for (p = src, q = dst; len > 0; p++, len--) {
+        if ((flags & PROC_SCAN) && (*statep == LINE_DATA)) {
+            m = span_printable_string (p, len);
+            if (m > 0) {
+                memcpy (q, p, m);
+                q += m;
+                p += m;
+                len -= m;
+                if (len == 0) {
+                    break;
+                }
+            }
+        }
+        if (*p == '\r') {
+            if (*statep == LINE_INIT) {
+                q += put_time (q, flags);
+            }
+            if ((*statep == LINE_DATA) || (*statep == LINE_INIT)) {
+                *statep = LINE_CR;
+            }
+        }
+        else if (*p == '\n') {
+            if ((*statep == LINE_INIT) || (*statep == LINE_LF)) {
+                q += put_time (q, flags);
+            }
+            *q++ = '\r';
+            *q++ = '\n';
+            *statep = LINE_LF;
+        }
+        else if ((*p == '\0')
+                && ((*statep == LINE_CR) || (*statep == LINE_LF))) {
+            ;
+        }
+        else {
+            if (*statep == LINE_CR) {
+                *q++ = '\r';
+                *q++ = '\n';
+            }
+            if (*statep != LINE_DATA) {
+                q += put_time (q, flags);
+            }
+            *statep = LINE_DATA;
+            c = *p & 0x7F;
+            if (c < 0x20) {
+                *q++ = (*p & 0x80) ? '~' : '^';
+                *q++ = c + '@';
+            }
+            else if (c == 0x7F) {
+                *q++ = (*p & 0x80) ? '~' : '^';
+                *q++ = '?';
+            }
+            else {
+                if (*p & 0x80) {
+                    *q++ = '`';
+                }
+                *q++ = c;
+            }
+        }
+    }
+    return (q - dst);
+}
+
+
+static int
+put_time (unsigned char *dst, int flags)
+{
+/*  Writes the current timestamp into [dst] if PROC_TIMESTAMP is set
+ *    in [flags], either via write_time_string() if PROC_CACHED is set or
+ *    by formatting it as write_time_string() did before it was cached.
+ *  Returns the number of bytes written into [dst].
+ */
+    time_t t;
+    struct tm tm;
+
+    if (!(flags & PROC_TIMESTAMP)) {
+        return (0);
+    }
+    if (flags & PROC_CACHED) {
+        return (write_time_string (0, (char *) dst, MAX_EXPANSION));
+    }
+    t = 0;
+    get_localtime (&t, &tm);
+    return (strftime ((char *) dst, MAX_EXPANSION, "%Y-%m-%d %H:%M:%S ", &tm));
+}
+
+
+static void
+verify (const unsigned char *src, size_t len)
+{
+/*  Checks that processing the [len] bytes of [src] in chunks of READ_LEN
+ *    bytes produces identical output with and without the scan.
+ */
+    unsigned char *dst0, *dst1;
+    size_t n0 = 0, n1 = 0;
+    size_t pos;
+    size_t n;
+    int state0 = LINE_INIT;
+    int state1 = LINE_INIT;
+
+    if (!(dst0 = malloc (len * MAX_EXPANSION))
+            || !(dst1 = malloc (len * MAX_EXPANSION))) {
+        log_err (0, "Out of memory");
+    }
+    for (pos = 0; pos < len; pos += n) {
+        n = (len - pos > READ_LEN) ? READ_LEN : len - pos;
+        n0 += process (dst0 + n0, src + pos, n, &state0, 0);
+        n1 += process (dst1 + n1, src + pos, n, &state1, PROC_SCAN);
+    }
+    if ((n0 != n1) || (memcmp (dst0, dst1, n0) != 0)) {
+        log_err (0, "Output differs with and without the scan");
+    }
+    free (dst0);
+    free (dst1);
+    return;
+}
+
+
+static double
+bench (const unsigned char *src, size_t len, size_t total,
+    unsigned char *dst, int flags)
+{
+/*  Processes [total] bytes of console output by repeatedly reading the [len]
+ *    bytes of [src] in chunks of READ_LEN bytes.
+ *  Returns the elapsed time in cycles (x86) or nanoseconds.
+ */
+    size_t done = 0;
+    size_t pos = 0;
+    size_t n;
+    int state = LINE_INIT;
+    double t0;
+
+    t0 = get_ticks ();
+    while (done < total) {
+        n = len - pos;
+        if (n > READ_LEN) {
+            n = READ_LEN;
+        }
+        (void) process (dst, src + pos, n, &state, flags);
+        done += n;
+        pos = (pos + n < len) ? pos + n : 0;
+    }
+    return (get_ticks () - t0);
+}
+
+
+static double
+get_ticks (void)
+{
+/*  Returns the current time in cycles (x86) or nanoseconds.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+    return ((double) __rdtsc ());
+#else  /* !x86 */
+    struct timespec ts;
+
+    if (clock_gettime (CLOCK_MONOTONIC, &ts) < 0) {
+        log_err (errno, "Unable to get time");
+    }
+    return ((double) ts.tv_sec * 1e9 + ts.tv_nsec);
+#endif /* !x86 */
+}
@@ -0,0 +1,206 @@
+/*****************************************************************************
+ *  Written by Chris Dunlap <cdunlap@llnl.gov>.
+ *  Copyright (C) 2007-2023 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2001-2007 The Regents of the University of California.
+ *  UCRL-CODE-2002-009.
+ *
+ *  This file is part of ConMan: The Console Manager.
+ *  For details, see <https://dun.github.io/conman/>.
+ *
+ *  ConMan is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  ConMan is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with ConMan.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************
+ *  Benchmark for tpoll timers.
+ *
+ *  Usage: bench-timers [-n timers]
+ *
+ *  Arms the specified number of timers (default: 100000) with expiration
+ *    times spread randomly over the next hour, then measures the cost of
+ *    setting them, of re-arming them (canceling and setting each timer in
+ *    random order, as occurs during mass reconnects), of canceling them, and
+ *    of dispatching them once they have expired.
+ *****************************************************************************/
+
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "log.h"
+#include "tpoll.h"
+
+
+static void callback (void *arg);
+static void shuffle (int *a, int n);
+static double diff_usec (struct timeval *tv1, struct timeval *tv0);
+
+static int num_callbacks = 0;
+
+
+int
+main (int argc, char *argv[])
+{
+    tpoll_t         tp;
+    int             num_timers = 100000;
+    int            *ids;
+    int            *order;
+    struct timeval *tvs;
+    struct timeval  now;
+    struct timeval  t0, t1;
+    int             c;
+    int             i;
+    int             n;
+
+    log_set_file (stderr, LOG_WARNING, 0);
+
+    while ((c = getopt (argc, argv, "n:")) != -1) {
+        switch (c) {
+        case 'n':
+            num_timers = atoi (optarg);
+            break;
+        default:
+            fprintf (stderr, "Usage: %s [-n timers]\n", argv[0]);
+            exit (1);
+        }
+    }
+    if (num_timers <= 0) {
+        log_err (0, "Invalid number of timers: %d", num_timers);
+    }
+    if (!(tp = tpoll_create (0))) {
+        log_err (errno, "Unable to create tpoll object");
+    }
+    if (!(ids = malloc (num_timers * sizeof (int)))) {
+        log_err (0, "Out of memory");
+    }
+    if (!(order = malloc (num_timers * sizeof (int)))) {
+        log_err (0, "Out of memory");
+    }
+    if (!(tvs = malloc (num_timers * sizeof (struct timeval)))) {
+        log_err (0, "Out of memory");
+    }
+    srandom (1);
+    gettimeofday (&now, NULL);
+    for (i = 0; i < num_timers; i++) {
+        tvs[ i ].tv_sec = now.tv_sec + 1 + (random () % 3600);
+        tvs[ i ].tv_usec = random () % 1000000;
+        order[ i ] = i;
+    }
+    printf ("%-10s %8s %12s\n", "operation", "timers", "usec/timer");
+
+    gettimeofday (&t0, NULL);
+    for (i = 0; i < num_timers; i++) {
+        if ((ids[ i ] = tpoll_timeout_absolute (tp, callback, NULL,
+                &tvs[ i ])) < 0) {
+            log_err (errno, "Unable to set timer #%d", i);
+        }
+    }
+    gettimeofday (&t1, NULL);
+    printf ("%-10s %8d %12.3f\n", "set", num_timers,
+        diff_usec (&t1, &t0) / num_timers);
+
+    shuffle (order, num_timers);
+    gettimeofday (&t0, NULL);
+    for (i = 0; i < num_timers; i++) {
+        n = order[ i ];
+        if (tpoll_timeout_cancel (tp, ids[ n ]) != 1) {
+            log_err (0, "Unable to cancel timer id=%d", ids[ n ]);
+        }
+        tvs[ n ].tv_sec = now.tv_sec + 1 + (random () % 3600);
+        if ((ids[ n ] = tpoll_timeout_absolute (tp, callback, NULL,
+                &tvs[ n ])) < 0) {
+            log_err (errno, "Unable to set timer #%d", n);
+        }
+    }
+    gettimeofday (&t1, NULL);
+    printf ("%-10s %8d %12.3f\n", "re-arm", num_timers,
+        diff_usec (&t1, &t0) / num_timers);
+
+    shuffle (order, num_timers);
+    gettimeofday (&t0, NULL);
+    for (i = 0; i < num_timers; i++) {
+        if (tpoll_timeout_cancel (tp, ids[ order[ i ] ]) != 1) {
+            log_err (0, "Unable to cancel timer id=%d", ids[ order[ i ] ]);
+        }
+    }
+    gettimeofday (&t1, NULL);
+    printf ("%-10s %8d %12.3f\n", "cancel", num_timers,
+        diff_usec (&t1, &t0) / num_timers);
+
+    /*  Set timers that have already expired so tpoll() dispatches them all.
+     */
+    for (i = 0; i < num_timers; i++) {
+        tvs[ i ].tv_sec = now.tv_sec - 1 - (random () % 3600);
+        if (tpoll_timeout_absolute (tp, callback, NULL, &tvs[ i ]) < 0) {
+            log_err (errno, "Unable to set timer #%d", i);
+        }
+    }
+    gettimeofday (&t0, NULL);
+    (void) tpoll (tp, 0);
+    gettimeofday (&t1, NULL);
+    if (num_callbacks != num_timers) {
+        log_err (0, "Expected %d callbacks but got %d",
+            num_timers, num_callbacks);
+    }
+    printf ("%-10s %8d %12.3f\n", "dispatch", num_timers,
+        diff_usec (&t1, &t0) / num_timers);
+
+    tpoll_destroy (tp);
+    free (ids);
+    free (order);
+    free (tvs);
+    exit (0);
+}
+
+
+static void
+callback (void *arg)
+{
+/*  Counts the number of timers dispatched.
+ */
+    num_callbacks++;
+    return;
+}
+
+
+static void
+shuffle (int *a, int n)
+{
+/*  Shuffles the [n] elements of array [a].
+ */
+    int i;
+    int j;
+    int tmp;
+
+    for (i = n - 1; i > 0; i--) {
+        j = random () % (i + 1);
+        tmp = a[ i ];
+        a[ i ] = a[ j ];
+        a[ j ] = tmp;
+    }
+    return;
+}
+
+
+static double
+diff_usec (struct timeval *tv1, struct timeval *tv0)
+{
+/*  Returns the microsecond difference between [tv1] and [tv0].
+ */
+    return (((tv1->tv_sec - tv0->tv_sec) * 1e6)
+        + (tv1->tv_usec - tv0->tv_usec));
+}
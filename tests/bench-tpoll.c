@@ -0,0 +1,229 @@
+/*****************************************************************************
+ *  Written by Chris Dunlap <cdunlap@llnl.gov>.
+ *  Copyright (C) 2007-2023 Lawrence Livermore National Security, LLC.
+ *  Copyright (C) 2001-2007 The Regents of the University of California.
+ *  UCRL-CODE-2002-009.
+ *
+ *  This file is part of ConMan: The Console Manager.
+ *  For details, see <https://dun.github.io/conman/>.
+ *
+ *  ConMan is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  ConMan is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ *  for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with ConMan.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************
+ *  Benchmark for the tpoll backends.
+ *
+ *  Usage: bench-tpoll [-i iterations] [nfds ...]
+ *
+ *  For each number of fds (default: 1000 10000 50000), registers that many
+ *    idle fds for POLLIN plus a single active pipe at the highest fd, then
+ *    measures the cost of a tpoll() wakeup when only the active pipe is
+ *    ready.  Each backend compiled into tpoll is measured in turn.
+ *  The idle fds are dup()s of the read end of a pipe that is never written,
+ *    so each one costs a single fd.  Fd counts exceeding RLIMIT_NOFILE are
+ *    skipped.
+ *****************************************************************************/
+
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "log.h"
+#include "tpoll.h"
+
+
+static int bench (tpoll_backend_t backend, int nfds, int iterations);
+static double diff_usec (struct timeval *tv1, struct timeval *tv0);
+static const char * backend_name (tpoll_backend_t backend);
+
+
+int
+main (int argc, char *argv[])
+{
+    tpoll_backend_t backends[] = { TPOLL_BACKEND_POLL, TPOLL_BACKEND_EPOLL };
+    int             sizes_default[] = { 1000, 10000, 50000 };
+    int            *sizes = sizes_default;
+    int             num_sizes = sizeof (sizes_default) / sizeof (int);
+    int             iterations = 1000;
+    int             c;
+    int             i;
+    int             j;
+    struct rlimit   limit;
+
+    log_set_file (stderr, LOG_WARNING, 0);
+
+    while ((c = getopt (argc, argv, "i:")) != -1) {
+        switch (c) {
+        case 'i':
+            iterations = atoi (optarg);
+            break;
+        default:
+            fprintf (stderr, "Usage: %s [-i iterations] [nfds ...]\n",
+                argv[0]);
+            exit (1);
+        }
+    }
+    if (iterations <= 0) {
+        log_err (0, "Invalid number of iterations: %d", iterations);
+    }
+    if (optind < argc) {
+        num_sizes = argc - optind;
+        if (!(sizes = malloc (num_sizes * sizeof (int)))) {
+            log_err (0, "Out of memory");
+        }
+        for (i = 0; i < num_sizes; i++) {
+            sizes[ i ] = atoi (argv[ optind + i ]);
+        }
+    }
+    if (getrlimit (RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        (void) setrlimit (RLIMIT_NOFILE, &limit);
+        (void) getrlimit (RLIMIT_NOFILE, &limit);
+    }
+    printf ("%-8s %8s %12s %14s\n", "backend", "nfds", "set (usec)",
+        "wakeup (usec)");
+
+    for (i = 0; i < num_sizes; i++) {
+        if ((rlim_t) sizes[ i ] + 64 > limit.rlim_cur) {
+            printf ("%-8s %8d skipped: RLIMIT_NOFILE is %lu\n", "-",
+                sizes[ i ], (unsigned long) limit.rlim_cur);
+            continue;
+        }
+        for (j = 0; j < (int) (sizeof (backends) / sizeof (backends[0]));
+                j++) {
+            (void) bench (backends[ j ], sizes[ i ], iterations);
+        }
+    }
+    if (sizes != sizes_default) {
+        free (sizes);
+    }
+    exit (0);
+}
+
+
+static int
+bench (tpoll_backend_t backend, int nfds, int iterations)
+{
+/*  Measures tpoll() wakeups using [backend] with [nfds] idle fds registered
+ *    and a single active fd over [iterations].
+ *  Returns 0 on success, or -1 if the backend is not supported.
+ */
+    tpoll_t         tp;
+    int             fd_idle[ 2 ];
+    int             fd_active[ 2 ];
+    int            *fds;
+    int             i;
+    int             j;
+    int             n;
+    char            c = 0;
+    struct timeval  t0, t1, t2;
+
+    if (!(tp = tpoll_create_backend (nfds + 64, backend))) {
+        if (errno == ENOSYS) {
+            printf ("%-8s %8d skipped: backend not supported\n",
+                backend_name (backend), nfds);
+            return (-1);
+        }
+        log_err (errno, "Unable to create tpoll object");
+    }
+    if (!(fds = malloc (nfds * sizeof (int)))) {
+        log_err (0, "Out of memory");
+    }
+    if (pipe (fd_idle) < 0) {
+        log_err (errno, "Unable to create pipe");
+    }
+    fds[ 0 ] = fd_idle[ 0 ];
+    for (i = 1; i < nfds; i++) {
+        if ((fds[ i ] = dup (fd_idle[ 0 ])) < 0) {
+            log_err (errno, "Unable to dup fd #%d", i);
+        }
+    }
+    if (pipe (fd_active) < 0) {
+        log_err (errno, "Unable to create pipe");
+    }
+    gettimeofday (&t0, NULL);
+    for (i = 0; i < nfds; i++) {
+        if (tpoll_set (tp, fds[ i ], POLLIN) < 0) {
+            log_err (errno, "Unable to set fd %d", fds[ i ]);
+        }
+    }
+    if (tpoll_set (tp, fd_active[ 0 ], POLLIN) < 0) {
+        log_err (errno, "Unable to set fd %d", fd_active[ 0 ]);
+    }
+    gettimeofday (&t1, NULL);
+
+    for (i = 0; i < iterations; i++) {
+        if (write (fd_active[ 1 ], &c, 1) != 1) {
+            log_err (errno, "Unable to write to pipe");
+        }
+        if ((n = tpoll (tp, -1)) != 1) {
+            log_err (errno, "Expected 1 fd ready but got %d", n);
+        }
+        j = 0;
+        if (tpoll_next_ready (tp, &j, NULL) != fd_active[ 0 ]) {
+            log_err (0, "Expected fd %d to be ready", fd_active[ 0 ]);
+        }
+        if (read (fd_active[ 0 ], &c, 1) != 1) {
+            log_err (errno, "Unable to read from pipe");
+        }
+    }
+    gettimeofday (&t2, NULL);
+
+    printf ("%-8s %8d %12.3f %14.3f\n", backend_name (tpoll_get_backend (tp)),
+        nfds, diff_usec (&t1, &t0) / (nfds + 1),
+        diff_usec (&t2, &t1) / iterations);
+
+    tpoll_destroy (tp);
+    for (i = 0; i < nfds; i++) {
+        (void) close (fds[ i ]);
+    }
+    (void) close (fd_idle[ 1 ]);
+    (void) close (fd_active[ 0 ]);
+    (void) close (fd_active[ 1 ]);
+    free (fds);
+    return (0);
+}
+
+
+static double
+diff_usec (struct timeval *tv1, struct timeval *tv0)
+{
+/*  Returns the microsecond difference between [tv1] and [tv0].
+ */
+    return (((tv1->tv_sec - tv0->tv_sec) * 1e6)
+        + (tv1->tv_usec - tv0->tv_usec));
+}
+
+
+static const char *
+backend_name (tpoll_backend_t backend)
+{
+/*  Returns a string describing the tpoll [backend].
+ */
+    switch (backend) {
+    case TPOLL_BACKEND_POLL:
+        return ("poll");
+    case TPOLL_BACKEND_EPOLL:
+        return ("epoll");
+    default:
+        return ("default");
+    }
+}
@@ -1,5 +1,7 @@
 # Set up the environment for running conmand.
 # Create a config with 2 test consoles that output 1 byte every 10ms.
+# Any arguments are added to the config as lines preceding the consoles
+#   (eg, 'global logopts="..."').
 # Relocate the config and logfiles to [TMPDIR] if [root] has not been set since
 #   the sharness trash directory (which defaults to the cwd) may reside in NFS
 #   which can cause problems with advisory lockfiles.  It is not necessary to
@@ -10,7 +12,7 @@
 #
 conmand_setup()
 {
-    local prefix
+    local prefix line
 
     if test "x${root}" = x; then
         prefix="${TMPDIR:-"/tmp"}/"
@@ -32,6 +34,11 @@ conmand_setup()
 	server port=0
 	global log="${prefix}console.%N.log.$$"
 	global testopts="b:1,m:10,n:10,p:100"
+	EOF
+    for line in "$@"; do
+        echo "${line}" >> "${CONMAND_CONFIG}"
+    done
+    cat >> "${CONMAND_CONFIG}" <<-EOF
 	console name="test1" dev="test:"
 	console name="test2" dev="test:"
 	EOF
@@ -39,9 +46,45 @@ conmand_setup()
     CONMAND_CONSOLE_COUNT=$(grep -i ^console "${CONMAND_CONFIG}" | wc -l)
 }
 
+# Create an executable script named [name] from stdin for use as a process
+#   console.  The console device cannot contain whitespace, so the script is
+#   created outside the sharness trash directory.
+# Output the pathname of the script.
+#
+conmand_script()
+{
+    local file
+
+    file="${TMPDIR:-"/tmp"}/conmand.$1.$$"
+    cat > "${file}" && chmod +x "${file}" && echo "${file}"
+}
+
+# Check the output of a test console in [file] (eg, its logfile) for missing,
+#   duplicated, or reordered data.  A test console outputs the printable ASCII
+#   chars (other than space) in ascending order, wrapping around after '~'.
+#   The ConMan messages interspersed with this output are skipped, as is the
+#   client's echo of the "&." escape sequence ending its session.
+# Output the number of chars checked.
+#
+check_test_console_data()
+{
+    tr -d '\r' < "$1" | grep -v '^<ConMan> ' | sed -e 's/&\.$//' |
+    tr -d '\n' | awk '
+        BEGIN { for (i = 33; i <= 126; i++) ord[sprintf("%c", i)] = i }
+        {
+            for (j = 1; j <= length($0); j++) {
+                c = ord[substr($0, j, 1)]
+                if ((n++ > 0) && (c != ((p < 126) ? p + 1 : 33))) bad++
+                p = c
+            }
+        }
+        END { print n + 0; exit ((n == 0) || (bad > 0)) }'
+}
+
 # Start the daemon process after ensuring the previous daemon process has
 #   exited.
-# Provide [CONMAND_PORT].
+# Provide [CONMAND_PORT], which is taken from the last message of the logfile
+#   noting the port since the logfile is appended to when restarting.
 #
 conmand_start()
 {
@@ -50,7 +93,7 @@ conmand_start()
     "${CONMAND}" -c "${CONMAND_CONFIG}" "$@"
     cat "${CONMAND_LOGFILE}"
     CONMAND_PORT=$(sed -n -e '/Listening/ s/.*port \([0-9]*\)/\1/p' \
-            < "${CONMAND_LOGFILE}")
+            < "${CONMAND_LOGFILE}" | tail -n 1)
     test_debug "echo CONMAND_PORT=\"${CONMAND_PORT}\""
     test "x${CONMAND_PORT}" != x
 }
@@ -106,12 +149,14 @@ conmand_kill()
 #   process.  It must be at the start of any &&-chain to ensure it cannot be
 #   prevented from running by a preceding failure in the chain.
 # Remove files outside the sharness trash directory unless [debug] is set.
+#   This includes the rotated logs and time indexes of the console logs, and
+#   the scripts created by conmand_script().
 #
 conmand_cleanup()
 {
     conmand_kill
     if test "x${root}" = x && test "x${debug}" != xt; then
         rm -f "${CONMAND_CONFIG}" "${CONMAND_LOGFILE}" "${CONMAND_PIDFILE}" \
-                ${CONMAND_CONSOLE_GLOB}
+                ${CONMAND_CONSOLE_GLOB}* "${TMPDIR:-"/tmp"}"/conmand.*.$$
     fi
 }
@@ -0,0 +1,24 @@
+# Is the util-linux script executable available?
+# The client requires a terminal, so tests connecting the client to a console
+#   run it via script and require the SCRIPT prereq.
+#
+if script -qfc true /dev/null >/dev/null 2>&1; then
+    test_set_prereq SCRIPT
+fi
+
+# Run the client with the arguments [args] via the util-linux script
+#   executable to provide it with a terminal.  The client's input is read from
+#   stdin, and its output is written to stdout.  The input should end with the
+#   client's "&." escape sequence to close the session.
+# [CONMAND_PORT] is set in conmand_start().
+#
+conman_client()
+{
+    local cmd arg
+
+    cmd="\"${CONMAN}\" -d \"127.0.0.1:${CONMAND_PORT}\""
+    for arg in "$@"; do
+        cmd="${cmd} \"${arg}\""
+    done
+    script -qfc "${cmd}" /dev/null
+}